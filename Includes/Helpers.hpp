@@ -1,13 +1,38 @@
 #ifndef HELPERS_HPP
 #define HELPERS_HPP
 
+#include "Helpers/ActionReplay.hpp"
+#include "Helpers/ArmCode.hpp"
 #include "Helpers/AutoRegion.hpp"
+#include "Helpers/CheatDatabase.hpp"
+#include "Helpers/EntryState.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/Format.hpp"
+#include "Helpers/FrameScheduler.hpp"
+#include "Helpers/FreezeTable.hpp"
 #include "Helpers/HoldKey.hpp"
+#include "Helpers/Hook.hpp"
+#include "Helpers/InputDispatcher.hpp"
+#include "Helpers/InputRecorder.hpp"
 #include "Helpers/KeySequence.hpp"
+#include "Helpers/MemorySearch.hpp"
+#include "Helpers/MemorySnapshot.hpp"
+#include "Helpers/MenuSearch.hpp"
 #include "Helpers/MenuEntryHelpers.hpp"
 #include "Helpers/OSDManager.hpp"
+#include "Helpers/OSDRaster.hpp"
+#include "Helpers/PatchBatch.hpp"
+#include "Helpers/PointerChain.hpp"
+#include "Helpers/PointerScanner.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include "Helpers/Profiler.hpp"
 #include "Helpers/QuickMenu.hpp"
+#include "Helpers/RegionMap.hpp"
+#include "Helpers/SettingsStore.hpp"
+#include "Helpers/Signature.hpp"
+#include "Helpers/StringID.hpp"
 #include "Helpers/Strings.hpp"
+#include "Helpers/Ticks.hpp"
 #include "Helpers/Wrappers.hpp"
 
 #endif
@@ -0,0 +1,150 @@
+#ifndef HELPERS_ACTIONREPLAY_HPP
+#define HELPERS_ACTIONREPLAY_HPP
+
+#include "types.h"
+#include "Helpers/RegionMap.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief The memory read and written by the codes \n
+     * Every access is checked: an invalid read returns 0 and makes a condition false,
+     * an invalid write is dropped. The regions come from RegionMap::Game(), the last one found
+     * is cached until the memory layout changes so the codes working in the same region don't
+     * search it again.
+     */
+    class ARMemory
+    {
+    public:
+        /**
+         * \brief The memory of the process
+         */
+        ARMemory(void);
+
+        /**
+         * \brief A copy of the memory, every address outside of it is invalid
+         * \param memory The copy of the memory
+         * \param base The address of memory[0]
+         * \param size The size of the copy
+         */
+        ARMemory(u8 *memory, u32 base, u32 size);
+
+        template <typename T>
+        bool    Read(u32 address, T &out)
+        {
+            if (!Check(address, sizeof(T), false))
+            {
+                out = 0;
+                return (false);
+            }
+
+            std::memcpy(&out, Pointer(address), sizeof(T));
+            return (true);
+        }
+
+        template <typename T>
+        bool    Write(u32 address, T value)
+        {
+            if (!Check(address, sizeof(T), true))
+                return (false);
+
+            std::memcpy(Pointer(address), &value, sizeof(T));
+            return (true);
+        }
+
+        bool    Copy(u32 address, const u8 *data, u32 size);
+
+    private:
+        bool    Check(u32 address, u32 size, bool write)
+        {
+            bool    cached = address - _start < _end - _start && _end - address >= size && (_writable || !write);
+
+            return ((cached && (!_process || _generation == RegionMap::Game().Generation()))
+                    || Query(address, size, write));
+        }
+
+        u8      *Pointer(u32 address) const
+        {
+            return (reinterpret_cast<u8 *>(reinterpret_cast<uintptr_t>(_memory) + (address - _base)));
+        }
+
+        // Find the region of an address when it isn't the cached one
+        bool    Query(u32 address, u32 size, bool write);
+
+        u8      *_memory;
+        u32     _base;
+        u32     _start;     ///< The cached region
+        u32     _end;
+        u32     _generation;    ///< Of the RegionMap when the region was cached
+        bool    _writable;
+        bool    _process;
+    };
+
+    /**
+     * \brief An Action Replay code compiled once and run every frame \n
+     * Compile validates the code and turns it into instructions with their operands decoded,
+     * the jumps of the conditions and the loop resolved, and the offset and data registers
+     * folded into the addresses and values wherever they're known when compiling. \n
+     * The supported code types are the Gateway ones:
+     *  - 0, 1, 2: 32, 16 and 8 bits writes
+     *  - 3 to 6: 32 bits conditions (value >, <, ==, != the memory), 7 to A: 16 bits conditions with a mask
+     *  - B: load the offset, C: loop, D0: end if, D1: end loop, D2: end all and clear the registers
+     *  - D3 to DC: offset and data registers, DD: keys condition, E: copy the following bytes \n
+     * Interpret runs a code line by line and is the reference for Execute.
+     */
+    class ARProgram
+    {
+    public:
+        ARProgram(void);
+
+        /**
+         * \brief Compile a code
+         * \param words The code, two words per line
+         * \param count The amount of words
+         * \return If the code is valid
+         */
+        bool    Compile(const u32 *words, u32 count);
+
+        /**
+         * \brief Run the compiled code, the registers start at 0
+         * \param keys The keys held, for the DD conditions
+         */
+        void    Execute(ARMemory &memory, u32 keys) const;
+
+        /**
+         * \brief Run a code without compiling it \n
+         * The code must be valid, Compile checks it
+         */
+        static void     Interpret(const u32 *words, u32 count, ARMemory &memory, u32 keys);
+
+        bool    IsValid(void) const;
+
+        /**
+         * \brief The line Compile failed at
+         */
+        u32     ErrorLine(void) const;
+
+        // Amount of instructions
+        u32     Size(void) const;
+
+    private:
+        struct Instruction
+        {
+            u8      opcode;
+            u8      relative;   ///< 1 if the address is added to the offset register
+            u16     target;     ///< Jump of the conditions and the loops, size of a copy
+            u32     address;
+            u32     value;      ///< Operand, for the 16 bits conditions the mask is in the upper half
+        };
+
+        std::vector<Instruction>    _code;
+        std::vector<u8>             _bytes;     ///< The data of the copies
+        u32                         _error;
+        bool                        _valid;
+    };
+}
+
+#endif
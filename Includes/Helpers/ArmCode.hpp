@@ -0,0 +1,68 @@
+#ifndef HELPERS_ARMCODE_HPP
+#define HELPERS_ARMCODE_HPP
+
+#include "types.h"
+
+namespace CTRPluginFramework
+{
+    /**
+     * ARM / Thumb encoding helpers used to build hooks \n
+     * Thumb is limited to the ARMv6K instruction set (16 bits + BL / BLX pairs)
+     */
+    namespace ArmCode
+    {
+        const u32   Nop = 0xE1A00000;       ///< mov r0, r0
+        const u16   ThumbNop = 0x46C0;      ///< mov r8, r8
+
+        /**
+         * \brief Encode B / BL from an address to another one
+         * \return The instruction, 0 if the destination is out of range (+/- 32MB)
+         */
+        u32     Branch(u32 from, u32 to, bool link = false);
+
+        /**
+         * \brief Encode ldr rd, [pc, #offset] with offset relative to the instruction + 8
+         */
+        u32     LoadLiteral(u32 rd, s32 offset, u32 cond = 0xE);
+
+        /**
+         * \brief Return the destination of a B / BL / BLX (immediate), 0 if it isn't one \n
+         * The destination of a BLX has its Thumb bit set
+         */
+        u32     BranchTarget(u32 insn, u32 address);
+
+        /**
+         * \brief Copy ARM instructions to another address, rewriting the ones relative to PC \n
+         * B, BL, BLX, LDR / LDRB [pc, #imm] and ADD / SUB rd, pc, #imm are rewritten with
+         * absolute addresses kept in a literal pool after the code.
+         * \param code The instructions to copy
+         * \param from The address of the instructions
+         * \param count The amount of instructions
+         * \param out Receive the relocated instructions and their literals, the result only
+         * uses relative addressing and can be executed from any address
+         * \param capacity The size of out in words
+         * \param jumpBack Whether to jump to the instruction following the copied ones
+         * \return The amount of words written, 0 if an instruction can't be relocated or out is too small
+         */
+        u32     RelocateArm(const u32 *code, u32 from, u32 count, u32 *out, u32 capacity, bool jumpBack);
+
+        /**
+         * \brief Copy Thumb instructions to another address, rewriting the ones relative to PC \n
+         * B, B<cond>, BL, BLX, LDR [pc, #imm] and ADD rd, pc, #imm are rewritten, the jumps use a
+         * sequence preserving every register.
+         * \param code The instructions to copy, an instruction starting before size is copied whole
+         * \param from The address of the instructions
+         * \param size The minimum amount of bytes to copy
+         * \param out Receive the relocated instructions and their literals, must be executed
+         * from an address aligned to 4
+         * \param capacity The size of out in halfwords
+         * \param jumpBack Whether to jump to the instruction following the copied ones
+         * \param consumed Receive the amount of bytes copied from code
+         * \return The amount of halfwords written, 0 if an instruction can't be relocated or out is too small
+         */
+        u32     RelocateThumb(const u16 *code, u32 from, u32 size, u16 *out, u32 capacity,
+                              bool jumpBack, u32 &consumed);
+    }
+}
+
+#endif
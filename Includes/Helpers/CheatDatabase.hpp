@@ -0,0 +1,142 @@
+#ifndef HELPERS_CHEATDATABASE_HPP
+#define HELPERS_CHEATDATABASE_HPP
+
+#include "CTRPluginFramework.hpp"
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief A piece of text in the database buffer, not NUL terminated
+     */
+    struct TextView
+    {
+        const char  *data;
+        u32         size;
+
+        bool        empty(void) const { return (size == 0); }
+        std::string ToString(void) const { return (std::string(data, size)); }
+    };
+
+    struct CheatCategory
+    {
+        TextView    name;
+        u32         count;      ///< Amount of codes in the category
+    };
+
+    struct CheatCode
+    {
+        enum State : u8
+        {
+            Pending,    ///< The body wasn't parsed yet
+            Ready,
+            Invalid
+        };
+
+        TextView    name;
+        TextView    note;
+        TextView    body;       ///< The lines of the code, parsed by Compile
+        u16         category;   ///< Index in the categories, 0 for the codes without one
+        State       state;
+        u32         words;      ///< Offset of the parsed words
+        u32         wordCount;
+    };
+
+    /**
+     * \brief Index a cheat text database without copying it \n
+     * The database is a text file with one section per game:
+     *  - `@0004000000055D00 Title` starts the codes of a title id
+     *  - `#Category` starts a category, the codes before the first one have none
+     *  - `[Name]` starts a code, followed by an optional `{note}` and the lines of the code
+     *  - empty lines and lines starting with `;` are ignored \n
+     * Names, notes and bodies are views into the loaded buffer. Loading only finds the title
+     * lines; the codes of a title are indexed by Select and a body is only parsed when Compile
+     * is called, usually when the code is enabled.
+     */
+    class CheatDatabase
+    {
+    public:
+        // Size of the chunks read by LoadFile
+        static const u32    ChunkSize = 0x4000;
+
+        static CheatDatabase    &GetInstance(void);
+
+        /**
+         * \brief Use a database already in memory, like one embedded with bin2o \n
+         * The data must stay valid as long as the database is used
+         * \return If a title was found
+         */
+        bool    Load(const void *data, u32 size);
+
+        /**
+         * \brief Stream a database from a file, only the sections of a title are kept in memory \n
+         * The first load scans the whole file and saves the offsets of every title in path.idx,
+         * the next ones only read the sections of the title. The index is rebuilt when the size
+         * of the file changes or when a section isn't where the index says
+         * \param titleId The title to keep, usually Process::GetTitleID()
+         * \return If the title has codes in the file
+         */
+        bool    LoadFile(const std::string &path, u64 titleId);
+
+        void    Clear(void);
+
+        /**
+         * \brief Index the categories and the codes of a title
+         * \return If the title has codes
+         */
+        bool    Select(u64 titleId);
+
+        /**
+         * \brief Parse the body of a code, the words are kept until the database is cleared
+         * \param count Receive the amount of words
+         * \return The words of the code, nullptr if the body is invalid
+         */
+        const u32   *Compile(CheatCode &code, u32 &count);
+
+        /**
+         * \brief Add a folder per category and an entry per code of the selected title \n
+         * The arg of each entry is its CheatCode, use FromEntry to read it
+         * \param gameFunc The function of every entry
+         */
+        void    Populate(MenuFolder &root, FuncPointer gameFunc);
+
+        static CheatCode    *FromEntry(MenuEntry *entry);
+
+        std::vector<u64>    GetTitles(void) const;
+        const std::vector<CheatCategory>    &GetCategories(void) const;
+        std::vector<CheatCode>              &GetCodes(void);
+
+    private:
+        CheatDatabase(void);
+
+        struct Section
+        {
+            u64     titleId;
+            u32     begin;      ///< First line after the title line, the title line in path.idx
+            u32     end;
+        };
+
+        // Find the title lines of a database
+        void    Index(const char *data, u32 size);
+        void    IndexSection(const Section &section);
+
+        // Copy the sections of a title while finding the title lines of the whole file
+        bool    ScanFile(File &file, u64 titleId, std::vector<Section> &titles);
+
+        // Copy the sections of a title listed by path.idx, false if one isn't there
+        bool    ReadSections(File &file, u64 titleId, const std::vector<Section> &titles);
+
+        const char                  *_data;
+        u32                         _size;
+        std::vector<char>           _buffer;    ///< The sections kept by LoadFile
+        std::vector<Section>        _sections;
+        std::vector<CheatCategory>  _categories;
+        std::vector<CheatCode>      _codes;
+        std::vector<u32>            _words;
+
+        static CheatDatabase    _instance;
+    };
+}
+
+#endif
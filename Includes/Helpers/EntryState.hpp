@@ -0,0 +1,94 @@
+#ifndef HELPERS_ENTRYSTATE_HPP
+#define HELPERS_ENTRYSTATE_HPP
+
+#include "types.h"
+#include "CTRPluginFramework/Menu/MenuEntry.hpp"
+
+namespace CTRPluginFramework
+{
+    // Identify a type without RTTI: the address of a variable unique to each type
+    using TypeId = const void *;
+
+    template <typename T>
+    struct TypeIdOf
+    {
+        static char tag;
+    };
+
+    template <typename T>
+    char    TypeIdOf<T>::tag = 0;
+
+    template <typename T>
+    inline TypeId   GetTypeId(void)
+    {
+        return (&TypeIdOf<T>::tag);
+    }
+
+    // Destroy a state before its memory is released
+    using StateDestructor = void (*)(void *state);
+
+    struct EntryStateStats
+    {
+        u32     states;         ///< Live states
+        u32     used;           ///< Bytes used by the states, headers included
+        u32     arena;          ///< Bytes of the arena given to the size classes
+        u32     heap;           ///< Bytes of the states too large for the arena or allocated once it was full
+        u32     mismatches;     ///< States released because they were read as another type
+    };
+
+    /**
+     * \brief Storage of the per entry states given by GetArg \n
+     * The states are carved from slabs of a fixed arena, each slab serving one size class.
+     * Each state records its entry and its type, so a state read as another type is detected.
+     * The states of disabled entries are released by Collect, except the persistent ones, and so are
+     * the states of the entries no longer in the running menu
+     */
+    class EntryState
+    {
+    public:
+        static const u32    ArenaSize = 0x10000;
+        static const u32    SlabSize = 0x1000;
+
+        // Frames between two passes of Collect, a state is released after one or two periods
+        static const u32    CollectPeriod = 30;
+
+        /**
+         * \brief Get the state of an entry
+         * \param persistent Keep the state found when the entry is disabled
+         * \return The state, nullptr if the entry has none or if it has a state of another type,
+         * which is then released. An arg not created by EntryState is returned as is
+         */
+        static void     *Find(MenuEntry *entry, TypeId type, bool persistent = false);
+
+        /**
+         * \brief Allocate the state of an entry and set it as its arg \n
+         * The previous state of the entry must have been released
+         * \param persistent Keep the state when the entry is disabled
+         * \return The memory of the state, to construct it in place
+         */
+        static void     *Allocate(MenuEntry *entry, TypeId type, u32 size, StateDestructor destructor,
+                                  bool persistent);
+
+        /**
+         * \brief Destroy the state of an entry and clear its arg, call it before deleting an entry
+         */
+        static void     Release(MenuEntry *entry);
+
+        /**
+         * \brief Release the states of the entries disabled, call it once per frame \n
+         * An entry missing from the running menu may have been deleted: its state is dropped without
+         * reading the entry, so Release an entry before taking it out of the menu to keep it
+         */
+        static void     Collect(void);
+
+        static EntryStateStats  GetStats(void);
+    };
+
+    template <typename T>
+    void    DestroyState(void *state)
+    {
+        static_cast<T *>(state)->~T();
+    }
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef HELPERS_FILEIO_HPP
+#define HELPERS_FILEIO_HPP
+
+#include "CTRPluginFramework.hpp"
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Read a whole file, recovered first if a write was cut
+     * \param path The path of the file
+     * \param out Receive the content of the file
+     * \return If the file was read
+     */
+    bool    ReadFile(const std::string &path, std::vector<u8> &out);
+
+    /**
+     * \brief Replace the content of a file \n
+     * The data is written to path.tmp first, the old file is renamed to path.bak until the new
+     * one is in place, so a failed write or a crash never loses both, see RecoverFile
+     * \param path The path of the file
+     * \param data The new content
+     * \param size The size of the content
+     * \return If the file was written
+     */
+    bool    WriteFile(const std::string &path, const void *data, u32 size);
+
+    /**
+     * \brief Finish or undo a WriteFile cut by a crash \n
+     * When path is missing and path.bak exists, path.tmp was complete: it becomes the file,
+     * or path.bak is put back without it. Called by ReadFile
+     * \return If the file exists
+     */
+    bool    RecoverFile(const std::string &path);
+}
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef HELPERS_FORMAT_HPP
+#define HELPERS_FORMAT_HPP
+
+#include "types.h"
+#include <cstring>
+#include <string>
+
+namespace CTRPluginFramework
+{
+    /**
+     * Allocation free number formatting \n
+     * Every function writes a NUL terminated string into the buffer and returns
+     * the amount of characters written, the NUL terminator excluded. \n
+     * Buffer sizes needed: hex 17, decimal 21 + width, float 48 + precision + width. \n
+     * Widths are clamped to FormatMaxWidth
+     */
+    const u32   FormatMaxWidth = 32;
+
+    /**
+     * \brief Write a value in uppercase hexadecimal
+     * \param minDigits Minimum amount of digits, zero padded
+     */
+    u32     FormatHex(char *out, u32 value, u32 minDigits = 8);
+    u32     FormatHex(char *out, u64 value, u32 minDigits = 16);
+
+    /**
+     * \brief Write a value in decimal
+     * \param width Minimum amount of characters, padded on the left
+     * \param pad The character used to pad
+     */
+    u32     FormatDecimal(char *out, u32 value, u32 width = 0, char pad = ' ');
+    u32     FormatDecimal(char *out, s32 value, u32 width = 0, char pad = ' ');
+    u32     FormatDecimal(char *out, u64 value, u32 width = 0, char pad = ' ');
+    u32     FormatDecimal(char *out, s64 value, u32 width = 0, char pad = ' ');
+
+    /**
+     * \brief Write the value of a float in fixed notation \n
+     * Values too large for the fixed notation are written as d.ddde+XX, or d.ddde+XXX from 1e100
+     * \param precision Amount of decimals, up to 9
+     * \param width Minimum amount of characters, padded with spaces on the left
+     */
+    u32     FormatFloat(char *out, double value, u32 precision = 2, u32 width = 0);
+
+    /**
+     * \brief Write the IEEE-754 bit pattern of a float / double in hexadecimal
+     */
+    u32     FormatFloatBits(char *out, float value);
+    u32     FormatFloatBits(char *out, double value);
+
+    /**
+     * \brief Size needed by HexDump for a single row, NUL terminator excluded
+     */
+    u32     HexDumpRowSize(u32 bytesPerRow, bool ascii = true);
+
+    /**
+     * \brief Render a memory range as rows of "AAAAAAAA  XX XX XX ...  ascii\n"
+     * \param out The destination buffer
+     * \param outSize The size of the destination buffer, only complete rows are written
+     * \param data The data to render
+     * \param size The size of the data
+     * \param address The address displayed for the first byte
+     * \param bytesPerRow Amount of bytes per row
+     * \param ascii Whether to add the ascii column
+     * \return The amount of characters written
+     */
+    u32     HexDump(char *out, u32 outSize, const void *data, u32 size, u32 address,
+                    u32 bytesPerRow = 16, bool ascii = true);
+
+    /**
+     * \brief A string with a fixed capacity living on the stack
+     */
+    template <u32 Capacity>
+    class FixedString
+    {
+    public:
+        FixedString(void) : _length(0) { _data[0] = 0; }
+        FixedString(const char *str) : _length(0) { _data[0] = 0; Append(str); }
+
+        const char  *c_str(void) const { return (_data); }
+        u32         size(void) const { return (_length); }
+        bool        empty(void) const { return (_length == 0); }
+        u32         capacity(void) const { return (Capacity); }
+
+        void    Clear(void)
+        {
+            _length = 0;
+            _data[0] = 0;
+        }
+
+        /**
+         * \brief Append characters, truncated to the capacity
+         */
+        FixedString &Append(const char *str, u32 length)
+        {
+            if (length > Capacity - _length)
+                length = Capacity - _length;
+            std::memcpy(_data + _length, str, length);
+            _length += length;
+            _data[_length] = 0;
+            return (*this);
+        }
+
+        FixedString &Append(const char *str)
+        {
+            return (Append(str, std::strlen(str)));
+        }
+
+        FixedString &Append(char c)
+        {
+            return (Append(&c, 1));
+        }
+
+        FixedString &AppendHex(u32 value, u32 minDigits = 8)
+        {
+            char    buffer[17];
+
+            return (Append(buffer, FormatHex(buffer, value, minDigits)));
+        }
+
+        FixedString &AppendDecimal(s32 value, u32 width = 0, char pad = ' ')
+        {
+            char    buffer[FormatMaxWidth + 21];
+
+            return (Append(buffer, FormatDecimal(buffer, value, width, pad)));
+        }
+
+        FixedString &AppendDecimal(u32 value, u32 width = 0, char pad = ' ')
+        {
+            char    buffer[FormatMaxWidth + 21];
+
+            return (Append(buffer, FormatDecimal(buffer, value, width, pad)));
+        }
+
+        FixedString &AppendFloat(double value, u32 precision = 2, u32 width = 0)
+        {
+            char    buffer[FormatMaxWidth + 57];
+
+            return (Append(buffer, FormatFloat(buffer, value, precision, width)));
+        }
+
+        std::string ToString(void) const
+        {
+            return (std::string(_data, _length));
+        }
+
+    private:
+        char    _data[Capacity + 1];
+        u32     _length;
+    };
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef HELPERS_FRAMESCHEDULER_HPP
+#define HELPERS_FRAMESCHEDULER_HPP
+
+#include "CTRPluginFramework.hpp"
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief How often a task runs
+     */
+    struct TaskRate
+    {
+        u32     frames;     ///< Run every N frames, 0 to use the interval
+        u32     interval;   ///< Run every interval microseconds
+
+        static TaskRate EveryFrame(void) { return (TaskRate{ 1, 0 }); }
+        static TaskRate EveryFrames(u32 frames) { return (TaskRate{ frames ? frames : 1, 0 }); }
+        static TaskRate Every(Time interval) { return (TaskRate{ 0, static_cast<u32>(interval.AsMicroseconds()) }); }
+    };
+
+    /**
+     * \brief The expected cost of a task \n
+     * Light tasks always run when they are due, the others are deferred to a later frame
+     * when they don't fit in what's left of the budget
+     */
+    enum class TaskCost : u8
+    {
+        Light, Medium, Heavy
+    };
+
+    struct TaskStats
+    {
+        MenuEntry   *entry;
+        u32         average;    ///< Average run time in microseconds
+        u32         max;        ///< Longest run time in microseconds
+        u32         runs;
+        u32         deferrals;  ///< Times the task was pushed to a later frame
+        u32         overruns;   ///< Times the task pushed the frame over the budget
+    };
+
+    // Called when a task pushed the frame over the budget
+    using OverrunCallback = void (*)(MenuEntry *entry, u32 microseconds);
+
+    /**
+     * \brief Run the menu entries at their own rate within a time budget per frame \n
+     * A scheduled entry's function is called by the scheduler instead of the menu, while the
+     * entry is activated, then one last time once it's deactivated. Run must be called once per frame. \n
+     * The menu calls a shared trampoline for the scheduled entries instead, an entry without a game
+     * function couldn't be toggled. \n
+     * The tasks can add and remove tasks, the changes made during Run are applied at its end.
+     */
+    class FrameScheduler
+    {
+    public:
+        // A deferred task runs anyway after that many frames
+        static const u32    MaxDeferrals = 8;
+
+        static FrameScheduler   &GetInstance(void);
+
+        /**
+         * \brief The time the tasks may take per frame
+         */
+        void    SetBudget(u32 microseconds);
+        u32     GetBudget(void) const;
+
+        /**
+         * \brief Schedule an entry, the menu calls the trampoline instead of the entry's game function
+         * \param entry The entry, nullptr for a task always active
+         * \param func The function to run
+         * \param rate How often to run it
+         * \param cost Its expected cost
+         */
+        void    Add(MenuEntry *entry, FuncPointer func, TaskRate rate = TaskRate::EveryFrame(),
+                    TaskCost cost = TaskCost::Light);
+
+        /**
+         * \brief Schedule every entry of a folder and its subfolders with the same function
+         */
+        void    Add(MenuFolder &folder, FuncPointer func, TaskRate rate = TaskRate::EveryFrame(),
+                    TaskCost cost = TaskCost::Light);
+
+        /**
+         * \brief Stop scheduling an entry, its game function is given back to the menu
+         */
+        void    Remove(MenuEntry *entry);
+
+        /**
+         * \brief Run the tasks due this frame, call it from the frame callback
+         */
+        void    Run(void);
+
+        void    SetOverrunCallback(OverrunCallback callback);
+
+        /**
+         * \brief Read the statistics of every task
+         */
+        void    GetStats(std::vector<TaskStats> &out) const;
+
+        /**
+         * \brief Time taken by the last frame, amount of frames over the budget
+         */
+        u32     LastFrameTime(void) const;
+        u32     FramesOverBudget(void) const;
+
+    private:
+        FrameScheduler(void);
+
+        struct Task
+        {
+            MenuEntry   *entry;
+            FuncPointer func;
+            TaskRate    rate;
+            TaskCost    cost;
+            bool        active;
+            bool        stopped;    ///< Deactivated in the menu since the last Run
+            u8          deferred;   ///< Frames waited since the task was due
+            u32         lastFrame;
+            u64         lastTick;
+            u64         estimate;   ///< Moving average of the cost, in ticks
+            TaskStats   stats;
+        };
+
+        // The game function of the scheduled entries
+        static void     Trampoline(MenuEntry *entry);
+
+        bool    IsDue(const Task &task, u64 now) const;
+        void    Execute(Task &task, u64 frameStart);
+        void    Insert(const Task &task);
+        void    Erase(MenuEntry *entry);
+
+        std::vector<Task>   _tasks;
+        std::vector<Task>   _pending;   ///< Added during Run, a null func removes the entry's tasks
+        std::vector<u32>    _due;
+        u64                 _budget;
+        u32                 _frame;
+        u32                 _lastFrameTime;
+        u32                 _framesOverBudget;
+        OverrunCallback     _onOverrun;
+        bool                _running;
+
+        static FrameScheduler   _instance;
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef HELPERS_FREEZETABLE_HPP
+#define HELPERS_FREEZETABLE_HPP
+
+#include "types.h"
+#include "CTRPluginFramework/Menu/MenuEntry.hpp"
+#include <cstring>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    // Return if the locks using it must be written this frame
+    using FreezeCondition = bool (*)(void);
+
+    /**
+     * \brief A table of values written every frame \n
+     * The locks are compiled into runs sorted by address: adjacent locks are merged into a
+     * single copy, a run is only written when memory differs, and locks writing the same
+     * address are dropped except for the last one registered. Each run is checked with
+     * RegionMap::Game() when compiled and again when the memory layout changes, the runs in
+     * memory which isn't writable are skipped. \n
+     * Not thread safe, use it from the menu entries and the frame callback
+     */
+    class FreezeTable
+    {
+    public:
+        static const u32    InvalidHandle = 0xFFFFFFFF;
+
+        static FreezeTable  &GetInstance(void);
+
+        /**
+         * \brief Lock a value
+         * \param address The address to write
+         * \param value The value to write
+         * \param width The size of the value: 1, 2 or 4
+         * \param condition Only write the value when it returns true, nullptr to always write
+         * \return A handle to the lock, InvalidHandle if the parameters are invalid
+         */
+        u32     Add(u32 address, u32 value, u32 width = 4, FreezeCondition condition = nullptr);
+
+        /**
+         * \brief Lock a typed value
+         */
+        template <typename T>
+        u32     Add(u32 address, T value, FreezeCondition condition = nullptr)
+        {
+            u32     raw = 0;
+
+            static_assert(sizeof(T) <= 4, "FreezeTable only locks values up to 4 bytes");
+            std::memcpy(&raw, &value, sizeof(T));
+            return (Add(address, raw, sizeof(T), condition));
+        }
+
+        /**
+         * \brief Change the value of a lock
+         * \return If the handle is valid
+         */
+        bool    Set(u32 handle, u32 value);
+
+        /**
+         * \brief Change the address and the value of a lock, for values behind a pointer
+         * \return If the handle is valid and the address aligned
+         */
+        bool    Set(u32 handle, u32 address, u32 value);
+
+        void    Remove(u32 handle);
+        void    Clear(void);
+
+        /**
+         * \brief Write the locks, call it once per frame
+         * \return The amount of bytes written
+         */
+        u32     Apply(void);
+
+        /**
+         * \brief Write the locks to a copy of the memory, the runs out of the copy are skipped
+         * \param memory The copy of the memory
+         * \param base The address of memory[0]
+         * \param size The size of the copy
+         */
+        u32     Apply(u8 *memory, u32 base, u32 size);
+
+        /**
+         * \brief Amount of locks, amount of runs written by Apply
+         */
+        u32     Count(void) const;
+        u32     RunCount(void);
+
+    private:
+        FreezeTable(void);
+
+        struct Lock
+        {
+            u32             address;
+            u32             value;
+            FreezeCondition condition;
+            u32             serial;     ///< Registration order, the last lock on an address wins
+            u16             generation;
+            u8              width;
+            bool            used;
+        };
+
+        struct Run
+        {
+            u32             address;
+            u32             size;
+            u32             offset;     ///< Offset of the bytes in _image
+            FreezeCondition condition;
+            bool            writable;   ///< Checked against the memory the runs are written to
+        };
+
+        void    Compile(void);
+        u32     Write(u8 *memory, u32 base);
+
+        std::vector<Lock>   _locks;
+        std::vector<u32>    _freeSlots;
+        std::vector<Run>    _runs;
+        std::vector<u8>     _image;
+        u32                 _count;
+        u32                 _serial;
+        u32                 _checked;   ///< RegionMap generation of the writable flags, 0 if not checked
+        bool                _dirty;
+
+        static FreezeTable  _instance;
+    };
+
+    /**
+     * \brief Lock a value while the entry is activated, call it from the entry's function
+     */
+    void    FreezeEntry(MenuEntry *entry, u32 address, u32 value, u32 width = 4, FreezeCondition condition = nullptr);
+}
+
+#endif
@@ -9,12 +9,16 @@ namespace CTRPluginFramework
     {
     public:
         /**
-         * \brief A helping class to check if a key(s) is pressed for a period of time
+         * \brief A helping class to check if a key(s) is pressed for a period of time \n
+         * The keys are matched by the InputDispatcher, which must be updated once per frame
          * \param keys A key or a combo that have to be pressed
          * \param holdTime The time the key(s) need to be pressed
          */
         HoldKey(u32 keys, Time holdTime);
-        ~HoldKey(void) {};
+        ~HoldKey(void);
+
+        HoldKey(const HoldKey &) = delete;
+        HoldKey &operator=(const HoldKey &) = delete;
 
         /**
          * \brief Check if the key is pressed
@@ -27,11 +31,8 @@ namespace CTRPluginFramework
          */
         void    operator = (u32 newKeys);
     private:
-        Clock   _timer;
-        Time    _goal;
-        bool    _isHold;
-        u32     _keys;
+        u32     _handle;
     };
 };
 
-#endif
\ No newline at end of file
+#endif
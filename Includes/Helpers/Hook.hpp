@@ -0,0 +1,99 @@
+#ifndef HELPERS_HOOK_HPP
+#define HELPERS_HOOK_HPP
+
+#include "types.h"
+#include "Helpers/PatchBatch.hpp"
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief The registers of the game when a hooked function is called
+     */
+    struct HookContext
+    {
+        u32     cpsr;
+        u32     reserved;   ///< Keeps the stack aligned to 8 bytes
+        u32     r[13];
+        u32     lr;
+    };
+
+    /**
+     * \brief Called instead of the hooked function, the registers can be modified
+     * \return true to run the original function, false to return to the caller right away
+     * (r[0] holds the value returned)
+     */
+    using HookCallback = bool (*)(HookContext &context);
+
+    /**
+     * \brief A pool of executable memory for the code generated at runtime
+     */
+    class CodeCave
+    {
+    public:
+        static const u32    SlotSize = 64;
+        static const u32    SlotCount = 128;
+
+        /**
+         * \brief Allocate executable memory, aligned to SlotSize
+         * \return The memory, nullptr if the pool is full
+         */
+        static void     *Allocate(u32 size);
+
+        /**
+         * \brief Give back memory from Allocate
+         */
+        static void     Free(void *cave, u32 size);
+
+        /**
+         * \brief Amount of slots left in the pool
+         */
+        static u32      FreeSlots(void);
+    };
+
+    /**
+     * \brief Redirect a function of the game to a callback \n
+     * The first instructions of the function are replaced by a jump to a stub saving the
+     * registers and calling the callback, they are relocated to a trampoline so the
+     * original function can still run.
+     */
+    class Hook
+    {
+    public:
+        Hook(void);
+
+        // Uninstall the hook
+        ~Hook(void);
+
+        /**
+         * \brief Hook a function
+         * \param address The address of the function, with bit 0 set for Thumb code
+         * \param callback The function to call instead
+         * \return If the hook was installed
+         */
+        bool    Install(u32 address, HookCallback callback);
+
+        /**
+         * \brief Restore the function
+         */
+        void    Uninstall(void);
+
+        bool    IsInstalled(void) const;
+
+        /**
+         * \brief The address to call to run the original function, 0 if not installed
+         */
+        u32     Original(void) const;
+
+    private:
+        // Stub: 16 instructions + 2 literals, then room for the trampoline
+        static const u32    StubWords = 18;
+        static const u32    TrampolineWords = 30;
+        static const u32    CaveSize = (StubWords + TrampolineWords) * 4;
+
+        PatchBatch  _patch;
+        u32         *_cave;
+        u32         _original;
+    };
+}
+
+#endif
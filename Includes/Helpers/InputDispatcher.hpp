@@ -0,0 +1,176 @@
+#ifndef HELPERS_INPUTDISPATCHER_HPP
+#define HELPERS_INPUTDISPATCHER_HPP
+
+#include "CTRPluginFramework.hpp"
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    // Called when a binding fires
+    using InputCallback = void (*)(void *arg);
+
+    class InputRecorder;
+
+    /**
+     * \brief Where the dispatcher reads the keys down every frame
+     */
+    class InputSource
+    {
+    public:
+        virtual ~InputSource(void) {}
+
+        virtual u32     Sample(void) = 0;
+
+        /**
+         * \brief The time of the last sample in system ticks, the current tick by default
+         */
+        virtual u64     Ticks(void);
+
+        // The real controller
+        static InputSource  &Controller(void);
+    };
+
+    enum class InputTrigger : u8
+    {
+        Combo,      ///< All the keys are down, fires on the press completing the combo
+        Hold,       ///< All the keys stayed down for a duration
+        DoubleTap,  ///< A key pressed twice within a window
+        Sequence    ///< Keys pressed one after the other, each within a timeout of the previous one
+    };
+
+    /**
+     * \brief Sample the controller once per frame and match every key binding in one pass \n
+     * The bindings are indexed by key: a frame without any press or release only checks the
+     * holds currently down, so the cost follows the key transitions, not the amount of bindings. \n
+     * A binding fires its callback and sets a flag read by Fired until the next Update. \n
+     * Update must be called once per frame, not thread safe
+     */
+    class InputDispatcher
+    {
+    public:
+        static const u32    InvalidHandle = 0xFFFFFFFF;
+
+        static InputDispatcher  &GetInstance(void);
+
+        /**
+         * \brief Add a binding
+         * \param keys The keys of the combo or the hold
+         * \param callback Called when the binding fires, nullptr to only poll it with Fired
+         * \param arg Passed to the callback
+         * \return A handle to the binding, InvalidHandle if the parameters are invalid
+         */
+        u32     AddCombo(u32 keys, InputCallback callback = nullptr, void *arg = nullptr);
+
+        /**
+         * \param repeat Fire again every duration while the keys stay down
+         */
+        u32     AddHold(u32 keys, Time duration, bool repeat = false, InputCallback callback = nullptr,
+                        void *arg = nullptr);
+
+        /**
+         * \param key The key to tap
+         * \param window The maximum time between the two presses
+         */
+        u32     AddDoubleTap(u32 key, Time window, InputCallback callback = nullptr, void *arg = nullptr);
+
+        /**
+         * \param steps The keys (or combos) to press in order
+         * \param timeout The maximum time between two steps
+         */
+        u32     AddSequence(const std::vector<u32> &steps, Time timeout, InputCallback callback = nullptr,
+                            void *arg = nullptr);
+
+        /**
+         * \brief Change the keys of a combo, a hold or a double tap, its state is reset
+         * \return If the handle is valid
+         */
+        bool    SetKeys(u32 handle, u32 keys);
+
+        void    Remove(u32 handle);
+        void    Clear(void);
+
+        /**
+         * \brief Read and clear the flag set when the binding fired \n
+         * Only the fires of the last Update are reported, a fire nobody read is dropped
+         */
+        bool    Fired(u32 handle);
+
+        /**
+         * \brief Sample the source and dispatch, call it from the frame callback
+         */
+        void    Update(void);
+
+        /**
+         * \brief Dispatch a sample
+         * \param keys The keys down
+         * \param ticks The time of the sample in system ticks
+         */
+        void    Update(u32 keys, u64 ticks);
+
+        /**
+         * \brief The keys of the last sample: down, newly pressed, newly released
+         */
+        u32     Held(void) const;
+        u32     Pressed(void) const;
+        u32     Released(void) const;
+
+        u32     Count(void) const;
+
+        /**
+         * \brief Replace the controller, to replay a recording
+         * \param source The new source, nullptr to use the controller again
+         */
+        void    SetSource(InputSource *source);
+
+        /**
+         * \brief Record every sample read by Update(void)
+         * \param recorder The recorder, nullptr to stop recording
+         */
+        void    SetRecorder(InputRecorder *recorder);
+
+    private:
+        InputDispatcher(void);
+
+        struct Binding
+        {
+            bool            used;
+            bool            armed;      ///< Hold: the keys are down and the timer runs
+            bool            repeat;
+            InputTrigger    trigger;
+            u16             generation;
+            u16             step;       ///< Sequence: next step, DoubleTap: taps counted
+            u32             keys;       ///< Every key the binding listens to
+            u32             stamp;      ///< Last frame the binding was evaluated
+            u32             fired;      ///< Frame the binding fired, 0 once read
+            u64             duration;   ///< In ticks
+            u64             since;      ///< Start of the hold, last tap or last step
+            InputCallback   callback;
+            void            *arg;
+            std::vector<u32> steps;
+        };
+
+        u32     Add(InputTrigger trigger, u32 keys, u64 duration, InputCallback callback, void *arg);
+        Binding *Find(u32 handle);
+        void    Link(u32 slot);
+        void    Unlink(u32 slot);
+        void    Arm(u32 slot);
+        void    Disarm(u32 slot);
+        void    Evaluate(u32 slot);
+        void    Fire(u32 slot);
+
+        std::vector<Binding>    _bindings;
+        std::vector<u16>        _byKey[32];     ///< Slots listening to each key
+        std::vector<u16>        _armed;         ///< Holds waiting for their duration
+        std::vector<u16>        _touched;
+        std::vector<u32>        _fires;         ///< Handles fired during the update
+        InputSource             *_source;
+        InputRecorder           *_recorder;
+        u32                     _held;
+        u32                     _pressed;
+        u32                     _released;
+        u32                     _frame;
+        u64                     _now;
+    };
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef HELPERS_INPUTRECORDER_HPP
+#define HELPERS_INPUTRECORDER_HPP
+
+#include "Helpers/InputDispatcher.hpp"
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Record the keys down every frame \n
+     * Only the changes are stored: the amount of frames since the previous change as a varint,
+     * then one byte per key toggled, so a press costs about 2 bytes whatever its length. The
+     * average frame time is kept in the header so a replay runs on the same clock whenever it's played. \n
+     * Attach it with InputDispatcher::SetRecorder
+     */
+    class InputRecorder
+    {
+    public:
+        InputRecorder(void);
+
+        /**
+         * \brief Clear the recording and start a new one
+         */
+        void    Start(void);
+        void    Stop(void);
+        bool    IsRecording(void) const;
+
+        /**
+         * \brief Add the keys of a frame, ignored when not recording
+         * \param ticks The time of the frame in system ticks
+         */
+        void    Record(u32 keys, u64 ticks);
+
+        u32     FrameCount(void) const;
+
+        /**
+         * \brief The average time of a frame in system ticks, 1/60 s until two frames were recorded
+         */
+        u32     FrameTicks(void) const;
+
+        /**
+         * \brief The recording with its header, what Save writes
+         */
+        void    Serialize(std::vector<u8> &out) const;
+        bool    Save(const std::string &path) const;
+
+    private:
+        std::vector<u8>     _changes;
+        bool                _recording;
+        u32                 _frames;
+        u32                 _lastChange;
+        u32                 _keys;
+        u64                 _firstTick;
+        u64                 _lastTick;
+    };
+
+    /**
+     * \brief Feed a recording back to the InputDispatcher, frame by frame \n
+     * The frames are stamped with the frame time of the recording from the first sample on, so
+     * the holds and the timeouts fire on the same frames on every replay. \n
+     * Attach it with InputDispatcher::SetSource, the keys are released once the recording is over
+     */
+    class InputReplay : public InputSource
+    {
+    public:
+        InputReplay(void);
+
+        bool    Load(const std::string &path);
+
+        /**
+         * \brief Use a recording made by InputRecorder::Serialize
+         * \return If the recording is valid
+         */
+        bool    SetData(const std::vector<u8> &data);
+
+        /**
+         * \brief The keys of the next frame
+         */
+        u32     Sample(void) override;
+
+        /**
+         * \brief The time of the last sample on the clock of the recording
+         */
+        u64     Ticks(void) override;
+
+        /**
+         * \brief Restart from the first frame
+         */
+        void    Rewind(void);
+
+        bool    Finished(void) const;
+        u32     Frame(void) const;
+        u32     FrameCount(void) const;
+
+    private:
+        // Read the frame of the next change, stored relative to the last one
+        void    ReadChange(u32 lastChange);
+
+        std::vector<u8>     _data;
+        u32                 _position;
+        u32                 _frames;
+        u32                 _frame;
+        u32                 _nextChange;    ///< Frame of the next change, 0xFFFFFFFF if none
+        u32                 _keys;
+        u32                 _frameTicks;
+        u64                 _start;         ///< Tick of the first frame
+    };
+}
+
+#endif
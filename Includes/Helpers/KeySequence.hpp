@@ -15,8 +15,16 @@ namespace CTRPluginFramework
     {
     public:
 
-        KeySequence(KeyVector sequence);
-        ~KeySequence(){}
+        /**
+         * \brief Keys to press one after the other, matched by the InputDispatcher
+         * \param sequence The keys in order
+         * \param timeout The maximum time between two keys
+         */
+        KeySequence(KeyVector sequence, Time timeout = Seconds(1.f));
+        ~KeySequence(void);
+
+        KeySequence(const KeySequence &) = delete;
+        KeySequence &operator=(const KeySequence &) = delete;
 
         /**
          * \brief Check the sequence
@@ -26,11 +34,8 @@ namespace CTRPluginFramework
 
     private:
 
-        KeyVector   _sequence;
-        Clock       _timer;
-        int         _indexInSequence;
-        
+        u32     _handle;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,176 @@
+#ifndef HELPERS_MEMORYSEARCH_HPP
+#define HELPERS_MEMORYSEARCH_HPP
+
+#include "types.h"
+#include "Helpers/MemorySnapshot.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    enum class SearchType : u8
+    {
+        U8, U16, U32, Float
+    };
+
+    enum class SearchFilter : u8
+    {
+        Changed, Unchanged, Increased, Decreased
+    };
+
+    struct SearchHit
+    {
+        u32     address;
+        u32     value;      ///< Raw bits of the current value
+    };
+
+    /**
+     * \brief Return the raw bits of a float, to pass float values to MemorySearch
+     */
+    inline u32  SearchValue(float value)
+    {
+        u32     bits;
+
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (bits);
+    }
+
+    /**
+     * \brief A value searcher working on chunks of memory \n
+     * The candidates of each chunk are stored either as a bitmap or as delta encoded
+     * indexes, whichever is smaller, so millions of results stay within a few hundred KB. \n
+     * The previous values are only kept when a filter needs them: the chunks where most
+     * values are kept, like after an unknown value scan, are stored as compressed pages
+     * and a page which didn't change since the previous scan isn't compressed again.
+     */
+    class MemorySearch
+    {
+    public:
+        // Memory is scanned and stored by chunks of this size
+        static const u32    ChunkSize = MemorySnapshot::PageSize;
+
+        MemorySearch(void);
+
+        /**
+         * \brief Add a memory area to scan on the next first scan
+         * \param address The address of the area in the game
+         * \param data Where the area can be read, (const void *)address from the plugin
+         * \param size The size of the area, must be a multiple of 4
+         */
+        void    AddRegion(u32 address, const void *data, u32 size);
+
+        /**
+         * \brief Clear the regions and the results
+         */
+        void    Reset(void);
+
+        /**
+         * \brief Keep the previous values in path.0 and path.1 instead of the memory, clears the results \n
+         * For unknown value scans of more memory than the plugin has, the results themselves stay in memory
+         * \param path The files, created or truncated, an empty path keeps the values in memory
+         * \return If the files could be opened
+         */
+        bool    SetSwapFile(const std::string &path);
+
+        /**
+         * \brief First scans, search all the regions \n
+         * Values are raw bits, use SearchValue for floats
+         * \return The amount of results
+         */
+        u32     ExactScan(SearchType type, u32 value);
+        u32     RangeScan(SearchType type, u32 min, u32 max);
+        u32     UnknownScan(SearchType type);
+
+        /**
+         * \brief Next scans, only test the current results
+         * \return The amount of results
+         */
+        u32     Filter(SearchFilter filter);
+        u32     FilterExact(u32 value);
+        u32     FilterRange(u32 min, u32 max);
+
+        /**
+         * \brief Read some results with their current value
+         * \param index The index of the first result
+         * \param count The maximum amount of results to read
+         * \param out Receive the results
+         * \return The amount of results read
+         */
+        u32     GetResults(u32 index, u32 count, std::vector<SearchHit> &out) const;
+
+        u32         ResultCount(void) const;
+        SearchType  Type(void) const;
+
+        /**
+         * \brief Memory used to store the results and size of the swap files, in bytes
+         */
+        u32     MemoryUsage(void) const;
+        u32     FileUsage(void) const;
+
+    private:
+        enum Encoding : u8
+        {
+            All, Bitmap, Deltas
+        };
+
+        struct Region
+        {
+            u32         address;
+            const u8    *data;
+            u32         size;
+        };
+
+        struct Chunk
+        {
+            const u8    *memory;
+            u32         address;
+            u32         size;
+            u32         count;
+            u32         hitsOffset;
+            u32         hitsSize;
+            u32         valuesOffset;
+            u32         page;       ///< The values are in this page of the snapshot instead
+            Encoding    encoding;
+        };
+
+        // Test every region with kernel, which writes the indexes of the matches of a chunk
+        template <typename Kernel>
+        u32     Scan(SearchType type, const Kernel &kernel, bool storeValues, u32 uniformValue);
+
+        // Test the current results with test(current, previous), relational if test(x, x) is the same for any x
+        template <typename T, typename Test>
+        u32     Refine(Test test, bool storeValues, u32 uniformValue, bool relational = false);
+
+        template <typename T>
+        u32     Relational(SearchFilter filter);
+
+        // Call callback(elementIndex, resultIndexInChunk) for each result of the chunk
+        template <typename Callback>
+        void    ForEachIndex(const Chunk &chunk, Callback callback) const;
+
+        // Encode the _indices of a chunk into the new pool
+        void    Store(Chunk chunk, u32 count, bool storeValues, u32 samePage = MemorySnapshot::InvalidPage);
+        void    Commit(bool storeValues, u32 uniformValue);
+
+        u32     Width(void) const;
+
+        SearchType              _type;
+        bool                    _uniform;       ///< All results had the same value when they were stored
+        u32                     _uniformValue;
+        u32                     _resultCount;
+        std::vector<Region>     _regions;
+        std::vector<Chunk>      _chunks;
+        std::vector<u8>         _pool;
+        MemorySnapshot          _snapshot;
+
+        // Scratch buffers, released once a scan is committed
+        std::vector<Chunk>      _newChunks;
+        std::vector<u8>         _newPool;
+        MemorySnapshot          _newSnapshot;
+        std::vector<u16>        _indices;
+        std::vector<u8>         _page;
+    };
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef HELPERS_MEMORYSNAPSHOT_HPP
+#define HELPERS_MEMORYSNAPSHOT_HPP
+
+#include "CTRPluginFramework.hpp"
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Compressed copies of memory pages \n
+     * Pages filled with a single word (usually zero) take no space, the others are compressed
+     * with a small LZ77 coder or stored as is when they don't compress. A page known to be
+     * identical to a page of another snapshot is copied without compressing it again. \n
+     * With a file, the blocks are written to it once full: only the block being filled and the
+     * last block read stay in memory, so a snapshot can be larger than the memory of the plugin.
+     */
+    class MemorySnapshot
+    {
+    public:
+        static const u32    PageSize = 0x1000;
+        static const u32    InvalidPage = 0xFFFFFFFF;
+
+        // The pages are stored in blocks of this size, so the storage grows without copies
+        static const u32    BlockSize = 0x10000;
+
+        MemorySnapshot(void);
+        ~MemorySnapshot(void);
+
+        MemorySnapshot(const MemorySnapshot &) = delete;
+        MemorySnapshot &operator=(const MemorySnapshot &) = delete;
+
+        /**
+         * \brief Keep the full blocks in a file, clears the snapshot
+         * \param path The file, created or truncated, an empty path keeps the blocks in memory
+         * \return If the file could be opened, the blocks stay in memory otherwise
+         */
+        bool    SetFile(const std::string &path);
+
+        /**
+         * \brief Compress a page
+         * \param data The memory to copy
+         * \param size The size of the page, up to PageSize and a multiple of 4
+         * \return The index of the page
+         */
+        u32     Add(const u8 *data, u32 size);
+
+        /**
+         * \brief Add a page of another snapshot without compressing it again
+         */
+        u32     Copy(const MemorySnapshot &other, u32 page);
+
+        /**
+         * \brief Decompress a page
+         * \param out Receive the page, must hold its size
+         * \return The size of the page
+         */
+        u32     Read(u32 page, u8 *out) const;
+
+        void    Clear(void);
+        void    Swap(MemorySnapshot &other);
+
+        u32     Count(void) const;
+
+        /**
+         * \brief Size of the memory copied, size of the copy in memory and in the file
+         */
+        u32     LogicalSize(void) const;
+        u32     MemoryUsage(void) const;
+        u32     FileUsage(void) const;
+
+    private:
+        enum Kind : u8
+        {
+            Fill,       ///< Every word is offset
+            Raw,
+            Compressed
+        };
+
+        struct Page
+        {
+            u32     offset;     ///< Block << 16 | offset in the block, or the word of a Fill page
+            u16     stored;     ///< Size in the block
+            u16     size;
+            Kind    kind;
+        };
+
+        // Room for size bytes in the last block, return where they go
+        u8      *Reserve(u32 size, u32 &offset);
+        const u8    *Data(const Page &page) const;
+
+        std::vector<Page>               _pages;
+        std::vector<std::vector<u8>>    _blocks;    ///< Empty once written to the file, block n is at n * BlockSize
+        std::vector<u16>                _table;     ///< Last position of each hashed sequence, for Add
+        u32                             _logicalSize;
+        File                            *_file;
+        u32                             _fileSize;
+        mutable std::vector<u8>         _cache;     ///< The last block read from the file
+        mutable u32                     _cachedBlock;
+    };
+}
+
+#endif
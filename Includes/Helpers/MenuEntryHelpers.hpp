@@ -2,51 +2,81 @@
 #define MENUENTRYHELPERS_HPP
 
 #include "CTRPluginFramework/Menu/MenuEntry.hpp"
+#include "Helpers/EntryState.hpp"
+#include <new>
 
 namespace CTRPluginFramework
 {
+    /**
+     * \brief Return the state of an entry, see EntryState \n
+     * If the state doesn't exist, or if it was created with another type, a new one is
+     * constructed with args. The state is released once the entry is disabled
+     * \tparam T The type of the state
+     * \param entry The entry to get the state from
+     * \param persistent Keep the state when the entry is disabled
+     * \return A pointer to the state
+     */
+    template <typename T, typename... Args>
+    T   *GetState(MenuEntry *entry, bool persistent, Args... args)
+    {
+        static_assert(alignof(T) <= 8, "Entry states are aligned to 8 bytes");
+
+        void    *state = EntryState::Find(entry, GetTypeId<T>(), persistent);
+
+        if (state == nullptr)
+        {
+            state = EntryState::Allocate(entry, GetTypeId<T>(), sizeof(T), DestroyState<T>, persistent);
+            new (state) T(args...);
+        }
+
+        return (static_cast<T *>(state));
+    }
+
     /**
      * \brief Return the arg of an entry \n
-     * If the arg doesn't exist (nullptr) a new one is created calling the default type constructor
+     * If the arg doesn't exist (nullptr) a new one is created calling the default type constructor.
+     * It's released once the entry is disabled, use GetPersistentArg to keep it
      * \tparam T The type of the arg
      * \param entry The entry to get the arg from
-     * \return A pointer to the arg (like reinterpret_cast<T *>(entry->GetArg()))
+     * \return A pointer to the arg
      */
     template <typename T>
     T   *GetArg(MenuEntry *entry)
     {
-        T   *arg = reinterpret_cast<T *>(entry->GetArg());
-
-        if (arg == nullptr)
-        {
-            arg = new T();
-            entry->SetArg(arg);
-        }
-
-        return (arg);
+        return (GetState<T>(entry, false));
     }
 
     /**
     * \brief Return the arg of an entry \n
-    * If the arg doesn't exist (nullptr) a new one is created calling the default type constructor
+    * If the arg doesn't exist (nullptr) a new one is created calling the default type constructor.
+    * It's released once the entry is disabled, use GetPersistentArg to keep it
     * \tparam T The type of the arg
     * \param entry The entry to get the arg from
     * \param defaultValue The value to set to a newly created arg
-    * \return A pointer to the arg (like reinterpret_cast<T *>(entry->GetArg()))
+    * \return A pointer to the arg
     */
     template <typename T>
     T   *GetArg(MenuEntry *entry, T defaultValue)
     {
-        T   *arg = reinterpret_cast<T *>(entry->GetArg());
+        return (GetState<T>(entry, false, defaultValue));
+    }
 
-        if (arg == nullptr)
-        {
-            arg = new T(defaultValue);
-            entry->SetArg(arg);
-        }
+    /**
+     * \brief Like GetArg, but the arg is kept when the entry is disabled, for settings
+     */
+    template <typename T>
+    T   *GetPersistentArg(MenuEntry *entry, T defaultValue = T())
+    {
+        return (GetState<T>(entry, true, defaultValue));
+    }
 
-        return (arg);
+    /**
+     * \brief Destroy the arg of an entry created by GetArg, call it before deleting the entry
+     */
+    inline void     ReleaseArg(MenuEntry *entry)
+    {
+        EntryState::Release(entry);
     }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,71 @@
+#ifndef HELPERS_MENUSEARCH_HPP
+#define HELPERS_MENUSEARCH_HPP
+
+#include "types.h"
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Find items by name with a trigram index \n
+     * A query is a list of words which must all appear in the name, case insensitive.
+     * A query extending the previous one only filters the previous results, so typing
+     * character by character stays cheap. Other queries start from the rarest trigram
+     * of the query instead of scanning every name, and every candidate is first tested
+ * against a mask of the characters in its name.
+     */
+    class MenuSearch
+    {
+    public:
+        MenuSearch(void);
+
+        void    Clear(void);
+
+        /**
+         * \brief Add an item, Build must be called once every item is added
+         * \param name The name to search
+         * \param value A value returned with the item
+         * \return The index of the item
+         */
+        u32     Add(const std::string &name, u32 value);
+
+        /**
+         * \brief Index the items, the previous results are discarded
+         */
+        void    Build(void);
+
+        /**
+         * \brief Search the items
+         * \return The indexes of the matching items, in the order they were added
+         */
+        const std::vector<u32>  &Search(const std::string &query);
+
+        u32     Value(u32 item) const;
+        u32     Count(void) const;
+
+    private:
+        // Lowercase the query and split it in words
+        void    Normalize(const std::string &query, std::string &out) const;
+        bool    Matches(u32 item) const;
+
+        std::string         _names;     ///< Every name in lowercase, NUL terminated
+        std::vector<u32>    _offsets;
+        std::vector<u32>    _values;
+        std::vector<u64>    _masks;     ///< Characters found in each name
+
+        // Items containing _trigrams[i] are _postings[_starts[i]] to _postings[_starts[i + 1]]
+        std::vector<u32>    _trigrams;
+        std::vector<u32>    _starts;
+        std::vector<u32>    _postings;
+
+        std::string         _query;
+        std::vector<u32>    _words;     ///< Offsets of the words in _query, which is NUL separated
+        u64                 _queryMask;
+        std::vector<u32>    _results;
+        std::vector<u32>    _scratch;
+        bool                _hasResults;
+    };
+}
+
+#endif
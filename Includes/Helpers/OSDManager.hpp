@@ -3,16 +3,42 @@
 
 #include <3ds.h>
 #include "CTRPluginFramework.hpp"
+#include "Helpers/OSDRaster.hpp"
+#include "Helpers/StringID.hpp"
 
-#include <map>
+#include <atomic>
 #include <string>
 #include <tuple>
+#include <vector>
 
 namespace CTRPluginFramework
 {
     #define OSDManager (*_OSDManager::GetInstance())
 
     using OSDMITuple = std::tuple<bool, std::string, u32, u32, bool>;
+
+    // Return the raw bits of the watched value
+    using OSDWatchGetter = u32 (*)(void);
+
+    enum class OSDWatchType : u8
+    {
+        None, U8, U16, U32, S8, S16, S32, Float
+    };
+
+    enum class OSDWatchFormat : u8
+    {
+        Hex, Decimal, Float
+    };
+
+    template <typename T> struct OSDWatchTypeOf;
+    template <> struct OSDWatchTypeOf<u8> { static const OSDWatchType value = OSDWatchType::U8; };
+    template <> struct OSDWatchTypeOf<u16> { static const OSDWatchType value = OSDWatchType::U16; };
+    template <> struct OSDWatchTypeOf<u32> { static const OSDWatchType value = OSDWatchType::U32; };
+    template <> struct OSDWatchTypeOf<s8> { static const OSDWatchType value = OSDWatchType::S8; };
+    template <> struct OSDWatchTypeOf<s16> { static const OSDWatchType value = OSDWatchType::S16; };
+    template <> struct OSDWatchTypeOf<s32> { static const OSDWatchType value = OSDWatchType::S32; };
+    template <> struct OSDWatchTypeOf<float> { static const OSDWatchType value = OSDWatchType::Float; };
+
     struct OSDMI
     {
         OSDMI &operator=(const std::string &str);
@@ -21,34 +47,198 @@ namespace CTRPluginFramework
         OSDMI &SetScreen(bool topScreen);
         OSDMI &Enable(void);
         OSDMI &Disable(void);
+
+        /**
+         * \brief Bind the item to a value in memory \n
+         * The value is sampled once per frame and only formatted again when its bits change.
+         * The text of the item is displayed as a label in front of the value
+         * \param address The address of the value, checked with the RegionMap on every sample
+         * \param type The type of the value
+         * \param format How to display the value
+         * \param width Minimum amount of characters of the value (zero padded in hex)
+         * \param precision Amount of decimals displayed in OSDWatchFormat::Float
+         */
+        OSDMI &Watch(u32 address, OSDWatchType type, OSDWatchFormat format = OSDWatchFormat::Decimal,
+                     u8 width = 0, u8 precision = 2);
+
+        /**
+         * \brief Bind the item to a getter, see Watch(u32, ...)
+         * \param getter A function returning the raw bits of the value, called from the OSD callback
+         */
+        OSDMI &Watch(OSDWatchGetter getter, OSDWatchType type, OSDWatchFormat format = OSDWatchFormat::Decimal,
+                     u8 width = 0, u8 precision = 2);
+
+        /**
+         * \brief Bind the item to a typed value in memory, see Watch(u32, ...)
+         */
+        template <typename T>
+        OSDMI &Watch(const T *value, OSDWatchFormat format = OSDWatchFormat::Decimal, u8 width = 0, u8 precision = 2)
+        {
+            return (Watch(static_cast<u32>(reinterpret_cast<uintptr_t>(value)), OSDWatchTypeOf<T>::value, format, width, precision));
+        }
+
+        /**
+         * \brief Unbind the item, it displays its text again
+         */
+        OSDMI &Unwatch(void);
     private:
         friend class  _OSDManager;
-        explicit OSDMI(OSDMITuple &tuple);
+        explicit OSDMI(u32 handle);
 
-        OSDMITuple  &data;
+        OSDMI &Bind(u32 address, OSDWatchGetter getter, OSDWatchType type, OSDWatchFormat format,
+                    u8 width, u8 precision);
+
+        u32     handle;
     };
 
     class _OSDManager
     {
     public:
+        // Items allocated beforehand, the storage doubles when they're all used
+        static const u32    InitialItems = 64;
+
+        // Maximum amount of items the manager can hold at the same time, limited by the handles
+        static const u32    MaxItems = 0x10000;
+
         ~_OSDManager(void);
 
-        static _OSDManager  *GetInstance(void);      
-        
+        static _OSDManager  *GetInstance(void);
+
+        /**
+         * \brief Get an item, the item is created if it doesn't exist \n
+         * If the manager holds MaxItems items, the returned item ignores every operation
+         * \param id The id of the item, prefer OSDManager["name"_id] in hot paths
+         */
+        OSDMI   operator[](StringID id);
         OSDMI   operator[](const std::string &key);
+        void    Remove(StringID id);
         void    Remove(const std::string &key);
         void    Lock(void);
         void    Unlock(void);
+
+        /**
+         * \brief Enable or disable the retained mode (enabled by default) \n
+         * In retained mode, an item is only rendered again when its text, position or screen changed,
+         * otherwise its cached bitmap is copied to the screen
+         */
+        void    SetRetainedMode(bool retained);
+
+        /**
+         * \brief Get the areas of a screen that changed during the last callback \n
+         * Only meaningful when called from an OSD callback
+         * \param topScreen Which screen to get the areas from
+         */
+        const std::vector<DirtyRect>  &GetDirtyRects(bool topScreen) const;
     private:
+        friend struct OSDMI;
+
+        struct Item
+        {
+            Item(void);
+
+            bool        used;
+            bool        topScreen;
+            bool        enabled;
+            u16         generation;
+            u32         posX;
+            u32         posY;
+            u32         version;
+            std::string text;
+
+            // Binding of a watch item, the value is formatted by the callback
+            OSDWatchType    watchType;
+            OSDWatchFormat  watchFormat;
+            u8              watchWidth;
+            u8              watchPrecision;
+            u32             watchAddress;
+            OSDWatchGetter  watchGetter;
+        };
+
+        // Callback side state of a watch item
+        struct WatchState
+        {
+            WatchState(void);
+
+            u32         version;
+            u32         serial;
+            u32         raw;
+            bool        valid;
+            std::string text;
+        };
+
+        // Callback side copy of an item rendered in retained mode
+        struct RenderCache
+        {
+            RenderCache(void);
+
+            bool        drawn;
+            u32         version;
+            u32         watchSerial;
+            u32         posX;
+            u32         posY;
+            TextBitmap  bitmap;
+        };
+
+        struct HandleEntry
+        {
+            u32     id;
+            u32     handle;
+#ifdef HELPERS_DEBUG
+            std::string     source;     ///< The string the id was hashed from, empty if unknown
+#endif
+
+            bool    operator<(u32 other) const { return (id < other); }
+        };
+
+        // Immutable copy of the items read by the callback
+        struct Snapshot
+        {
+            u32                 count;
+            std::vector<Item>   items;
+        };
 
         _OSDManager(void);
 
+        // Must be called with the lock held
+        Item            *GetItem(u32 handle);
+        void            Publish(Item &item);
+
+        // Must only be called by the callback
+        const Snapshot  &AcquireSnapshot(void);
+
+        // Read and format the value of every watch item of the snapshot
+        void            SampleWatches(const Snapshot &snapshot);
+
+        // Grow the callback side state to the size of a snapshot, must only be called by the callback
+        void            GrowCallbackState(const Snapshot &snapshot);
+
         static bool     OSDCallback(const Screen &screen);
 
         static _OSDManager *_singleton;
 
-        LightLock   _lock;
-        std::map<std::string, std::tuple<bool, std::string, u32, u32, bool>> _items;
+        // Writers side, protected by the lock
+        LightLock                   _lock;
+        std::vector<HandleEntry>    _handles;   ///< Sorted by id
+        std::vector<Item>           _items;
+        std::vector<u32>            _freeSlots;
+        u32                         _count;
+        u32                         _serial;
+        u32                         _backIndex;
+
+        // Triple buffer shared with the callback: writers fill _snapshots[_backIndex]
+        // then exchange it with the pending one, the callback swaps its front with
+        // the pending one when it's flagged as dirty. Nobody ever waits.
+        Snapshot                    _snapshots[3];
+        std::atomic<u32>            _pendingIndex;
+        u32                         _frontIndex;
+
+        // Callback side
+        std::atomic<bool>           _retained;
+        std::vector<WatchState>     _watches;
+
+        // Callback side, one set per screen: [0] bottom, [1] top
+        std::vector<RenderCache>    _caches[2];
+        DirtyRegion                 _dirty[2];
     };
 }
 
@@ -0,0 +1,106 @@
+#ifndef HELPERS_OSDRASTER_HPP
+#define HELPERS_OSDRASTER_HPP
+
+#include "types.h"
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Describes a framebuffer in memory \n
+     * Steps are in bytes and can be negative, which allows to describe the rotated 3DS framebuffers
+     */
+    struct RasterSurface
+    {
+        u8      *base;          ///< Address of the pixel (0, 0)
+        s32     columnStep;     ///< Bytes between (x, y) and (x + 1, y)
+        s32     rowStep;        ///< Bytes between (x, y) and (x, y + 1)
+        u32     width;
+        u32     height;
+        u32     bytesPerPixel;
+        u32     format;         ///< GSPGPU_FramebufferFormat
+    };
+
+    struct DirtyRect
+    {
+        u32     x;
+        u32     y;
+        u32     width;
+        u32     height;
+    };
+
+    /**
+     * \brief Encode a color in a framebuffer format
+     * \param format The GSPGPU_FramebufferFormat of the framebuffer
+     * \param out Receive the encoded pixel, must be at least 4 bytes
+     * \return The size of the encoded pixel in bytes, 0 if the format is unknown
+     */
+    u32     EncodePixel(u32 format, u8 r, u8 g, u8 b, u8 a, u8 *out);
+
+    /**
+     * \brief A rendered text kept as a coverage mask, one bit per pixel \n
+     * The mask is stored column by column as the 3DS framebuffers are rotated
+     */
+    class TextBitmap
+    {
+    public:
+        // The OSD font is 10 pixels high, one u16 per column is enough
+        static const u32    MaxHeight = 16;
+
+        TextBitmap(void);
+
+        /**
+         * \brief Build the mask from a text that was just drawn on the surface
+         * \param surface The surface the text was drawn on
+         * \param posX, posY The position of the text
+         * \param width, height The size of the text box
+         * \param foreground The raw foreground pixel the text was drawn with
+         * \param background The raw background pixel the text was drawn with
+         * \return false if the box can't be captured
+         */
+        bool    Capture(const RasterSurface &surface, u32 posX, u32 posY, u32 width, u32 height,
+                        const u8 *foreground, const u8 *background);
+
+        /**
+         * \brief Redraw the captured text on a surface of the same format
+         */
+        void    Blit(const RasterSurface &surface, u32 posX, u32 posY) const;
+
+        void    Clear(void);
+        bool    IsEmpty(void) const;
+        u32     Width(void) const;
+        u32     Height(void) const;
+        u32     Format(void) const;
+
+        /**
+         * \brief Return whether the pixel at (x, y) of the box is foreground
+         */
+        bool    IsSet(u32 x, u32 y) const;
+
+    private:
+        std::vector<u16>    _columns;
+        u32                 _height;
+        u32                 _format;
+        u32                 _bytesPerPixel;
+        u8                  _foreground[4];
+        u8                  _background[4];
+    };
+
+    /**
+     * \brief A list of rectangles, overlapping rectangles are merged together
+     */
+    class DirtyRegion
+    {
+    public:
+        void    Add(const DirtyRect &rect);
+        void    Clear(void);
+        bool    IsEmpty(void) const;
+
+        const std::vector<DirtyRect>    &Rects(void) const;
+
+    private:
+        std::vector<DirtyRect>  _rects;
+    };
+}
+
+#endif
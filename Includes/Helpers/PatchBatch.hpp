@@ -0,0 +1,132 @@
+#ifndef HELPERS_PATCHBATCH_HPP
+#define HELPERS_PATCHBATCH_HPP
+
+#include "types.h"
+#include "CTRPluginFramework/Menu/MenuEntry.hpp"
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Where a PatchBatch reads, writes and maintains the caches \n
+     * Game() is the memory of the game, another target can be given to test the batches
+     */
+    class PatchTarget
+    {
+    public:
+        virtual ~PatchTarget(void) {}
+
+        virtual bool    Read(u32 address, void *out, u32 size) = 0;
+        virtual bool    Write(u32 address, const void *data, u32 size) = 0;
+
+        // Make the written range visible to the instruction fetches
+        virtual void    Flush(u32 address, u32 size) = 0;
+
+        static PatchTarget  &Game(void);
+    };
+
+    /**
+     * \brief A group of code edits applied and reverted together \n
+     * The edits are staged with Add, then Apply checks every original, writes every edit
+     * and merges the touched ranges so the caches are maintained with as few calls as possible. \n
+     * The original bytes are kept to revert the batch, PatchBatch::RevertAll reverts every applied batch.
+     */
+    class PatchBatch
+    {
+    public:
+        // Ranges closer than this are flushed with a single call
+        static const u32    CoalesceGap = 0x100;
+
+        explicit PatchBatch(PatchTarget &target = PatchTarget::Game());
+
+        // Revert the batch if it is still applied
+        ~PatchBatch(void);
+
+        PatchBatch(const PatchBatch &) = delete;
+        PatchBatch &operator=(const PatchBatch &) = delete;
+
+        /**
+         * \brief Stage an edit, can't be called while the batch is applied
+         * \param address The address to patch
+         * \param data The new bytes
+         * \param size The amount of bytes
+         * \param expected The bytes which must be at the address, nullptr to not check
+         */
+        PatchBatch  &Add(u32 address, const void *data, u32 size, const void *expected = nullptr);
+
+        /**
+         * \brief Stage a 32 bits edit
+         */
+        PatchBatch  &Add(u32 address, u32 value);
+        PatchBatch  &Add(u32 address, u32 value, u32 expected);
+
+        /**
+         * \brief Check the originals and apply every edit \n
+         * Nothing is written if an edit overlaps another one, can't be read or doesn't
+         * have its expected bytes
+         * \return If the batch was applied
+         */
+        bool    Apply(void);
+
+        /**
+         * \brief Restore the original bytes
+         */
+        void    Revert(void);
+
+        /**
+         * \brief Remove the staged edits, revert the batch first if it is applied
+         */
+        void    Clear(void);
+
+        bool    IsApplied(void) const;
+        u32     EditCount(void) const;
+
+        /**
+         * \brief Amount of cache maintenance calls done by the last Apply
+         */
+        u32     FlushCount(void) const;
+
+        /**
+         * \brief Revert every applied batch, call it from OnProcessExit
+         */
+        static void     RevertAll(void);
+
+    private:
+        struct Edit
+        {
+            u32     address;
+            u32     size;
+            u32     data;       ///< Offset of the new bytes in _bytes
+            u32     expected;   ///< Offset of the expected bytes in _bytes, NoExpected if none
+            u32     original;   ///< Offset of the original bytes in _bytes
+        };
+
+        struct Range
+        {
+            u32     address;
+            u32     size;
+        };
+
+        void    Merge(u32 count);
+        void    Flush(void);
+        void    Link(void);
+        void    Unlink(void);
+
+        static PatchBatch   *_firstApplied;
+
+        PatchTarget         &_target;
+        PatchBatch          *_nextApplied;
+        bool                _applied;
+        std::vector<Edit>   _edits;
+        std::vector<u8>     _bytes;
+        std::vector<Range>  _ranges;    ///< The merged ranges of the applied edits
+    };
+
+    /**
+     * \brief Apply the batch when the entry is activated and revert it when it's deactivated \n
+     * Call it from the entry's function, the entry is disabled if the batch can't be applied
+     */
+    void    TogglePatch(MenuEntry *entry, PatchBatch &batch);
+}
+
+#endif
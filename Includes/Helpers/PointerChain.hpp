@@ -0,0 +1,190 @@
+#ifndef HELPERS_POINTERCHAIN_HPP
+#define HELPERS_POINTERCHAIN_HPP
+
+#include "types.h"
+#include "Helpers/RegionMap.hpp"
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Changes every frame, a chain using it is followed again once per frame \n
+     * NextFrame is called by the frame callback
+     */
+    class FrameGeneration
+    {
+    public:
+        static u32      Get(void) { return (_frame); }
+        static void     NextFrame(void) { ++_frame; }
+
+    private:
+        static u32      _frame;
+    };
+
+    /**
+     * \brief Changes with the memory layout of the process, see RegionMap \n
+     * Only for the chains whose pointers don't change once the game set them, like the ones
+     * starting from a static manager: a pointer written again in the same memory isn't noticed
+     */
+    class LayoutGeneration
+    {
+    public:
+        static u32      Get(void) { return (RegionMap::Game().Generation()); }
+    };
+
+    /**
+     * \brief How long a PointerChain keeps the address it found
+     */
+    enum class ChainCache : u8
+    {
+        Frame,      ///< Until the next frame, see FrameGeneration
+        Layout      ///< Until the memory layout changes, see LayoutGeneration
+    };
+
+    template <u32... Offsets>
+    struct PointerWalk;
+
+    template <>
+    struct PointerWalk<>
+    {
+        static bool     Walk(RegionMap &, u32 &) { return (true); }
+    };
+
+    // Follow the pointer at address then add the offset, one level per offset
+    template <u32 Offset, u32... Rest>
+    struct PointerWalk<Offset, Rest...>
+    {
+        static bool     Walk(RegionMap &regions, u32 &address)
+        {
+            if ((address & 3) || !regions.IsReadable(address, 4))
+                return (false);
+
+            address = *reinterpret_cast<const vu32 *>(address) + Offset;
+            return (PointerWalk<Rest...>::Walk(regions, address));
+        }
+    };
+
+    /**
+     * \brief A value at the end of a pointer chain \n
+     * PointerChain<u16, 0x0812345C, 0x10, 0x48> is the u16 at *(*0x0812345C + 0x10) + 0x48: the pointer
+     * at the base is followed, then each offset is added and the result followed, except after the last.
+     * Every hop is checked with RegionMap::Game() and the final address is cached: with
+     * ChainCache::Frame the chain is followed at most once per frame whatever the amount of
+     * accesses, with ChainCache::Layout only when the memory layout changes. \n
+     * The offsets are template arguments, each hop compiles to a load and an add of a constant.
+     * \code
+     * PointerChain<float, 0x0812345C, 0x10, 0x48>  speed;
+     * PointerChain<u32, 0x08200000, 0x24>          money(ChainCache::Layout);
+     *
+     * speed.Modify([](float &value) { value *= 2.f; });
+     * \endcode
+     */
+    template <typename T, u32 Base, u32... Offsets>
+    class PointerChain
+    {
+    public:
+        static const u32    Depth = sizeof...(Offsets);
+
+        explicit PointerChain(ChainCache cache = ChainCache::Frame) :
+            _address(0), _generation(0), _cache(cache), _resolved(false), _writable(false) {}
+
+        /**
+         * \brief Follow the chain if the generation changed since the last time
+         * \return If the chain leads to a readable value
+         */
+        bool    Resolve(void)
+        {
+            u32     generation = _cache == ChainCache::Frame ? FrameGeneration::Get() : LayoutGeneration::Get();
+
+            if (_resolved && _generation == generation)
+                return (_address != 0);
+
+            RegionMap   &regions = RegionMap::Game();
+            u32         address = Base;
+
+            _generation = generation;
+            _resolved = true;
+            _writable = false;
+            _address = 0;
+
+            if (!PointerWalk<Offsets...>::Walk(regions, address) || !regions.IsReadable(address, sizeof(T)))
+                return (false);
+
+            _address = address;
+            _writable = regions.IsWritable(address, sizeof(T));
+            return (true);
+        }
+
+        /**
+         * \brief Follow the chain on the next access whatever the generation
+         */
+        void    Invalidate(void)
+        {
+            _resolved = false;
+        }
+
+        bool    Read(T &out)
+        {
+            if (!Resolve())
+                return (false);
+
+            std::memcpy(&out, reinterpret_cast<const void *>(_address), sizeof(T));
+            return (true);
+        }
+
+        /**
+         * \brief Read the value
+         * \param fallback Returned when the chain is broken
+         */
+        T       Get(T fallback = T())
+        {
+            T   value;
+
+            return (Read(value) ? value : fallback);
+        }
+
+        bool    Write(const T &value)
+        {
+            if (!Resolve() || !_writable)
+                return (false);
+
+            std::memcpy(reinterpret_cast<void *>(_address), &value, sizeof(T));
+            return (true);
+        }
+
+        /**
+         * \brief Read the value, let func change it and write it back
+         * \param func Called with a T &, only when the chain leads to a writable value
+         */
+        template <typename Func>
+        bool    Modify(Func func)
+        {
+            T   value;
+
+            if (!Resolve() || !_writable)
+                return (false);
+
+            std::memcpy(&value, reinterpret_cast<const void *>(_address), sizeof(T));
+            func(value);
+            std::memcpy(reinterpret_cast<void *>(_address), &value, sizeof(T));
+            return (true);
+        }
+
+        /**
+         * \brief The value in memory, nullptr when the chain is broken
+         */
+        T       *Pointer(void)
+        {
+            return (Resolve() ? reinterpret_cast<T *>(_address) : nullptr);
+        }
+
+    private:
+        u32         _address;   ///< 0 when the chain is broken
+        u32         _generation;
+        ChainCache  _cache;
+        bool        _resolved;
+        bool        _writable;
+    };
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef HELPERS_POINTERSCANNER_HPP
+#define HELPERS_POINTERSCANNER_HPP
+
+#include "types.h"
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief A chain of pointers starting from a static address \n
+     * address = base; for each offset: address = *(u32 *)address + offset
+     */
+    struct PointerPath
+    {
+        static const u32    MaxDepth = 6;
+
+        u32     base;
+        u32     depth;
+        u32     offsets[MaxDepth];
+    };
+
+    /**
+     * \brief Find the pointer chains leading to an address \n
+     * BuildIndex reads every region and keeps a "value -> location" index of the aligned words
+     * pointing inside a region: the locations are grouped in one bucket per BucketSize bytes of
+     * the regions they point to, 4 bytes per pointer. Scan then walks backward from the target,
+     * one level at a time, until it reaches a static region. The values are read again from the
+     * regions during the scan, a word changed since BuildIndex is skipped.
+     */
+    class PointerScanner
+    {
+    public:
+        // Bytes of the regions covered by one bucket of the index
+        static const u32    BucketSize = 0x1000;
+
+        PointerScanner(void);
+
+        /**
+         * \brief Add a memory area to index
+         * \param address The address of the area in the game, aligned to 4
+         * \param data Where the area can be read, (const void *)address from the plugin
+         * \param size The size of the area
+         * \param isStatic If the area doesn't move between sessions (code, data, bss)
+         */
+        void    AddRegion(u32 address, const void *data, u32 size, bool isStatic);
+
+        /**
+         * \brief Add every readable area of the game \n
+         * The areas below the plugin are static, the plugin's memory is skipped
+         */
+        void    AddProcessRegions(void);
+
+        /**
+         * \brief Clear the regions and the index
+         */
+        void    Reset(void);
+
+        /**
+         * \brief Read the regions and build the index, AddRegion drops it
+         * \return The amount of pointers found
+         */
+        u32     BuildIndex(void);
+
+        /**
+         * \brief Search the chains leading to target
+         * \param target The address to reach
+         * \param maxDepth Maximum amount of pointers in a chain, up to PointerPath::MaxDepth
+         * \param maxOffset Maximum offset added to each pointer
+         * \param maxResults Stop once that many chains were found
+         * \param out Receive the chains, shortest first
+         * \return The amount of chains found
+         */
+        u32     Scan(u32 target, u32 maxDepth, u32 maxOffset, u32 maxResults, std::vector<PointerPath> &out) const;
+
+        /**
+         * \brief Follow a chain in the current regions
+         * \return If every pointer of the chain could be read
+         */
+        bool    Resolve(const PointerPath &path, u32 &address) const;
+
+        /**
+         * \brief Keep the chains which still lead to target
+         * \return The amount of chains kept
+         */
+        u32     Rescan(std::vector<PointerPath> &paths, u32 target) const;
+
+        /**
+         * \brief Amount of pointers in the index
+         */
+        u32     IndexSize(void) const;
+
+        /**
+         * \brief Memory used by the index, in bytes
+         */
+        u32     MemoryUsage(void) const;
+
+        /**
+         * \brief Convert chains to / from the file format
+         */
+        static void Serialize(const std::vector<PointerPath> &paths, u32 target, std::vector<u8> &out);
+        static bool Deserialize(const u8 *data, u32 size, std::vector<PointerPath> &paths, u32 &target);
+
+        /**
+         * \brief Save / load chains to / from a file
+         */
+        static bool Save(const std::string &path, const std::vector<PointerPath> &paths, u32 target);
+        static bool Load(const std::string &path, std::vector<PointerPath> &paths, u32 &target);
+
+    private:
+        struct Region
+        {
+            u32         address;
+            const u8    *data;
+            u32         size;
+            bool        isStatic;
+            u32         firstBucket;    ///< Bucket of the first BucketSize bytes of the region
+        };
+
+        const Region    *FindRegion(u32 address) const;
+
+        // The bucket of a value pointing inside region
+        u32     BucketOf(const Region &region, u32 value) const
+        {
+            return (region.firstBucket + (value - region.address) / BucketSize);
+        }
+
+        std::vector<Region>     _regions;   ///< Sorted by address
+        std::vector<u32>        _buckets;   ///< Start of each bucket in _locations, one more for the end
+        std::vector<u32>        _locations; ///< Addresses of the pointers, grouped by bucket
+    };
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef HELPERS_POOLALLOCATOR_HPP
+#define HELPERS_POOLALLOCATOR_HPP
+
+#include "types.h"
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief What the memory is allocated for, set with MemoryTagScope
+     */
+    enum class MemoryTag : u8
+    {
+        General,
+        OSD,
+        Menu,
+        Search,
+        Cheats,
+        Settings,
+        Count
+    };
+
+    struct MemoryTagStats
+    {
+        u32     live;       ///< Bytes requested and not freed yet
+        u32     peak;
+        u32     count;      ///< Amount of live allocations
+    };
+
+    struct HeapStats
+    {
+        u32     live;           ///< Bytes requested and not freed yet
+        u32     peak;
+        u32     count;          ///< Amount of live allocations
+        u32     poolReserved;   ///< Bytes of the slabs of the pools
+        u32     poolUsed;       ///< Bytes of the blocks given from the slabs, headers included
+        u32     large;          ///< Bytes of the blocks too large for the pools, headers included
+        u32     heapSize;       ///< Bytes of the newlib heap
+        u32     heapFree;       ///< Bytes free in the newlib heap, between its blocks
+        u32     failures;       ///< Allocations the heap couldn't satisfy
+        u32     fragmentation;  ///< Percent of the memory taken from the heap which isn't requested
+
+        MemoryTagStats  tags[static_cast<u32>(MemoryTag::Count)];
+    };
+
+    /**
+     * \brief The global operator new and delete \n
+     * Blocks up to MaxPooledSize bytes come from size class pools: each class carves SlabSize slabs
+     * taken from the heap into blocks of the same size, so the small and short lived allocations
+     * (strings, map nodes) don't split the heap between the large ones. The larger blocks are
+     * taken from the heap directly. Every block starts with a HeaderSize bytes header holding
+     * its size, its class and its tag, which feed the statistics. \n
+     * An empty slab is given back to the heap, except one per class kept for the next allocations. \n
+     * When the heap is full operator new writes the statistics with svcOutputDebugString then
+     * calls svcBreak, its nothrow versions return nullptr.
+     */
+    class PoolAllocator
+    {
+    public:
+        static const u32    SlabSize = 0x1000;
+        static const u32    HeaderSize = 8;
+        static const u32    ClassCount = 11;
+        static const u32    MaxPooledSize = 512 - HeaderSize;
+
+        // Frames between two refreshes of the overlay
+        static const u32    OverlayPeriod = 30;
+
+        /**
+         * \brief Allocate a block aligned on 8 bytes
+         * \return The block, nullptr if the heap is full
+         */
+        static void     *Allocate(u32 size);
+        static void     Free(void *block);
+
+        /**
+         * \brief The size requested for a block
+         */
+        static u32      SizeOf(const void *block);
+
+        /**
+         * \brief Set the tag of the following allocations \n
+         * The tag is shared by every thread, an allocation of another thread in the meantime is
+         * counted in it too
+         * \return The previous tag
+         */
+        static MemoryTag    SetTag(MemoryTag tag);
+
+        static const char   *TagName(MemoryTag tag);
+
+        static void     GetStats(HeapStats &out);
+
+        /**
+         * \brief Give the empty slabs kept by the pools back to the heap
+         */
+        static void     Trim(void);
+
+        /**
+         * \brief Display the statistics with the OSDManager, refreshed every OverlayPeriod frames
+         */
+        static void     ShowOverlay(u32 posX = 10, u32 posY = 10);
+        static void     HideOverlay(void);
+        static bool     IsOverlayShown(void);
+
+        /**
+         * \brief Refresh the overlay, call it once per frame
+         */
+        static void     OnFrame(void);
+    };
+
+    /**
+     * \brief Tag the allocations until the end of the scope
+     */
+    class MemoryTagScope
+    {
+    public:
+        explicit MemoryTagScope(MemoryTag tag) : _previous(PoolAllocator::SetTag(tag)) {}
+        ~MemoryTagScope(void) { PoolAllocator::SetTag(_previous); }
+
+    private:
+        MemoryTag   _previous;
+    };
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef HELPERS_PROFILER_HPP
+#define HELPERS_PROFILER_HPP
+
+#include "types.h"
+#include "Helpers/StringID.hpp"
+#include "Helpers/Ticks.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Profiling zones, only compiled with -DPROFILER_ENABLED (see the Makefile) \n
+ * PROFILE_ZONE(name) times the rest of the scope. The zones are keyed by the hash of the name, which
+ * is copied when the records are collected: it must only live until the end of the frame. \n
+ * PROFILE_FRAME() collects the records and refreshes the overlay, call it once per frame.
+ */
+#ifdef PROFILER_ENABLED
+    #define PROFILE_CONCAT_(a, b)   a##b
+    #define PROFILE_CONCAT(a, b)    PROFILE_CONCAT_(a, b)
+    #define PROFILE_ZONE(name)      CTRPluginFramework::ProfileZone PROFILE_CONCAT(_profileZone, __LINE__)(name)
+    #define PROFILE_FRAME()         CTRPluginFramework::Profiler::OnFrame()
+#else
+    #define PROFILE_ZONE(name)      do {} while (false)
+    #define PROFILE_FRAME()         do {} while (false)
+#endif
+
+namespace CTRPluginFramework
+{
+    struct ProfileRecord
+    {
+        const char  *name;      ///< Only read by Collect
+        u32         id;         ///< StringID of the name
+        u32         duration;   ///< In ticks
+        u64         start;      ///< In ticks
+    };
+
+    struct ZoneStats
+    {
+        const char  *name;      ///< Kept by the profiler
+        u32         count;
+        u32         min;        ///< In microseconds
+        u32         average;
+        u32         p99;
+        u32         max;
+        u32         total;
+    };
+
+    /**
+     * \brief Collect the zones timed by PROFILE_ZONE \n
+     * Each thread writes its records into its own ring, the rings are aggregated by Collect
+     * into per zone statistics (p99 from a logarithmic histogram)
+     */
+    class Profiler
+    {
+    public:
+        static const u32    MaxThreads = 4;
+        static const u32    RingSize = 1024;
+        static const u32    MaxZones = 64;
+        static const u32    MaxNames = 128;
+        static const u32    NameSize = 32;
+
+        // Frames between two refreshes of the overlay
+        static const u32    OverlayPeriod = 30;
+
+        /**
+         * \brief Store a record in the ring of the calling thread
+         */
+        static void     Record(const char *name, u32 id, u64 start, u64 end);
+        static void     Record(const char *name, u64 start, u64 end);
+
+        /**
+         * \brief Aggregate the records written since the last call
+         */
+        static void     Collect(void);
+
+        /**
+         * \brief Get the statistics of the zones, the most expensive first
+         */
+        static void     GetStats(std::vector<ZoneStats> &out);
+
+        /**
+         * \brief Clear the statistics, the rings are kept
+         */
+        static void     Reset(void);
+
+        /**
+         * \brief Display the most expensive zones with the OSDManager \n
+         * The statistics are reset on every refresh, the overlay shows the last OverlayPeriod frames
+         * \param count The amount of zones to display
+         */
+        static void     ShowOverlay(u32 count = 5, u32 posX = 10, u32 posY = 10);
+        static void     HideOverlay(void);
+        static bool     IsOverlayShown(void);
+
+        /**
+         * \brief Collect and refresh the overlay, called by PROFILE_FRAME
+         */
+        static void     OnFrame(void);
+
+        /**
+         * \brief Write the statistics as CSV
+         */
+        static bool     DumpCsv(const std::string &path);
+
+        /**
+         * \brief Write the records still in the rings as a Chrome trace (chrome://tracing)
+         */
+        static bool     DumpChromeTrace(const std::string &path);
+    };
+
+    class ProfileZone
+    {
+    public:
+        explicit ProfileZone(const char *name) :
+            _name(name), _id(StringID::Compute(name, std::strlen(name))), _start(GetTicks()) {}
+        explicit ProfileZone(const std::string &name) :
+            _name(name.c_str()), _id(StringID::Compute(name.c_str(), name.size())), _start(GetTicks()) {}
+        ~ProfileZone(void) { Profiler::Record(_name, _id, _start, GetTicks()); }
+
+    private:
+        const char  *_name;
+        u32         _id;
+        u64         _start;
+    };
+}
+
+#endif
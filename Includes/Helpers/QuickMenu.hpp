@@ -2,9 +2,11 @@
 #define HELPERS_QUICKMENU_HPP
 #include "types.h"
 #include <string>
+#include <unordered_map>
 #include <vector>
-#include <stack>
 #include "HoldKey.hpp"
+#include "MenuSearch.hpp"
+#include "StringID.hpp"
 
 namespace CTRPluginFramework
 {
@@ -21,6 +23,7 @@ namespace CTRPluginFramework
         QuickMenuItem(const std::string &name, const ItemType itemType);
 
         std::string name;
+        const StringID    id;
         const ItemType    itemType;
     };
 
@@ -52,30 +55,154 @@ namespace CTRPluginFramework
         void    operator += (QuickMenuItem *item);
         void    operator -= (QuickMenuItem *item);
 
+        /**
+         * \brief Remove and destroy the item with the specified id
+         */
+        void    operator -= (StringID id);
+
+        /**
+         * \brief Find a direct child of the submenu
+         * \return The item or nullptr if there's no item with that id
+         */
+        QuickMenuItem   *Find(StringID id) const;
+
         std::vector<QuickMenuItem *>    items;
     };
 
+    /**
+     * \brief A menu opened with a hotkey, listing entries and submenus in a keyboard \n
+     * The items are stored in one array of nodes indexed by position, their names in a
+     * single buffer where each name is stored once. Every submenu keeps its list of children
+     * (rebuilt only after a change) and builds its options the first time it's opened, so
+     * navigating doesn't allocate or walk the tree.
+     * A node index stays valid until that node is removed. \n
+     * The items are found by the hash of their name: two names with the same hash break
+     * with HELPERS_DEBUG, like with the OSDManager.
+     */
     class QuickMenu
     {
-    public:        
-        ~QuickMenu();        
+    public:
+        // The node of the root menu, always present
+        static const u32    Root = 0;
+        static const u32    InvalidNode = 0xFFFFFFFF;
+
+        ~QuickMenu();
         static QuickMenu &GetInstance(void);
 
         void     ChangeHotkey(u32 newHotkey);
 
+        /**
+         * \brief Add an item to the root, the item and its children are copied then destroyed \n
+         * The QuickMenu doesn't keep the item: the pointer is invalid after the call,
+         * the item is removed with its id or with its node
+         */
         void    operator += (QuickMenuItem *item);
-        void    operator -= (QuickMenuItem *item);
+
+        /**
+         * \brief Remove the root item with the specified id
+         */
+        void    operator -= (StringID id);
         void    operator () (void);
 
+        /**
+         * \brief Add an item to a submenu, the item and its children are copied then destroyed
+         * like with +=
+         * \param parent The node of the submenu
+         * \return The node of the item, InvalidNode if parent isn't a submenu
+         */
+        u32     Add(u32 parent, QuickMenuItem *item);
+
+        /**
+         * \brief Add an item to a submenu without building a QuickMenuItem
+         * \return The node of the item, InvalidNode if parent isn't a submenu
+         */
+        u32     AddSubMenu(u32 parent, const std::string &name);
+        u32     AddEntry(u32 parent, const std::string &name, VoidMethod method);
+        u32     AddEntry(u32 parent, const std::string &name, ArgMethod method, void *arg);
+
+        /**
+         * \brief Remove a node and its children, the root can't be removed
+         */
+        void    Remove(u32 node);
+
+        /**
+         * \brief Find a direct child of a submenu
+         * \return The node or InvalidNode if there's no item with that id
+         */
+        u32     Find(StringID id, u32 parent = Root) const;
+
+        const char  *GetName(u32 node) const;
+        bool        IsSubMenu(u32 node) const;
+
+        /**
+         * \brief Amount of items, the root excluded
+         */
+        u32     Count(void) const;
+
+        /**
+         * \brief Add an entry to the root which searches every item by name \n
+         * The results are refined while typing and listed like a submenu:
+         * an entry is executed, a submenu is opened
+         * \param label The name of the search entry
+         */
+        void    EnableSearch(const std::string &label = "Search");
+
+        /**
+         * \brief Also search the entries of the plugin menu, toggled when selected
+         */
+        void    AddSearchEntries(const PluginMenu &menu);
+
     private:
         QuickMenu(u32 hotkey);
 
-        HoldKey                         _hotkey;
-        QuickMenuSubMenu                *_subMenuOpened;
-        std::vector<QuickMenuItem *>    _root;
-        std::stack<QuickMenuSubMenu *>  _submenus;
+        struct Node
+        {
+            StringID    id;
+            u32         name;           ///< Offset in _names
+            u32         parent;
+            u32         firstChild;
+            u32         lastChild;
+            u32         nextSibling;
+            u32         children;       ///< Offset of the children in _children
+            u32         childCount;
+            u32         options;        ///< Index of the options in _options, built when opened
+            bool        used;
+            QuickMenuItem::ItemType     itemType;
+            QuickMenuEntry::MethodType  methodType;
+            union
+            {
+                VoidMethod  voidMethod;
+                ArgMethod   argMethod;
+            };
+            void        *methodArg;
+        };
+
+        u32     NewNode(u32 parent, const std::string &name, QuickMenuItem::ItemType type);
+        u32     Intern(const std::string &name, StringID id);
+        void    Rebuild(void);
+        const StringVector  &Options(u32 node);
+        void    Execute(u32 node);
+
+        // Let the user search an item, return the submenu to open or InvalidNode
+        u32     Search(void);
+        static void     OnSearchEvent(Keyboard &keyboard, KeyboardEvent &event);
+        void    AddSearchFolder(const MenuFolder &folder);
+
+        HoldKey                     _hotkey;
+        bool                        _dirty;     ///< The children and options must be rebuilt
+        u32                         _count;
+        std::vector<Node>           _nodes;
+        std::vector<u32>            _free;
+        std::string                 _names;     ///< Every name, NUL terminated
+        std::unordered_map<u32, u32>    _interned;  ///< Offset in _names of each name id
+        std::vector<u32>            _children;
+        std::vector<StringVector>   _options;   ///< Empty until the submenu is opened
+
+        u32                         _searchNode;
+        std::vector<MenuEntry *>    _searchEntries;
+        MenuSearch                  _search;
 
-        static QuickMenu                _instance;
+        static QuickMenu            _instance;
     };
 }
 
@@ -0,0 +1,115 @@
+#ifndef HELPERS_REGIONMAP_HPP
+#define HELPERS_REGIONMAP_HPP
+
+#include <3ds.h>
+#include "types.h"
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    struct MemoryRegion
+    {
+        u32     start;
+        u32     end;
+        u32     perm;       ///< MEMPERM_READ, MEMPERM_WRITE, MEMPERM_EXECUTE
+    };
+
+    /**
+     * \brief Where a RegionMap finds the regions \n
+     * Process() queries the kernel, another source can be given to test the map
+     */
+    class RegionSource
+    {
+    public:
+        virtual ~RegionSource(void) {}
+
+        /**
+         * \brief Append the accessible regions, sorted by address
+         */
+        virtual void    Enumerate(std::vector<MemoryRegion> &out) = 0;
+
+        static RegionSource     &Process(void);
+    };
+
+    /**
+     * \brief The accessible memory regions, to check an access without querying the kernel \n
+     * The regions are enumerated into a sorted array, merging the contiguous regions with the
+     * same permissions, and each check is a binary search. The array is an immutable snapshot:
+     * Invalidate enumerates the regions into a new one and publishes it, the checks only pin the
+     * current snapshot, so they never block nor query the kernel. Generation changes once the new
+     * snapshot is published so the users caching a region know it may be gone. \n
+     * Game() is invalidated by the event of PROCESSOP_GET_ON_MEMORY_CHANGE_EVENT, which the kernel
+     * signals each time the memory layout of the process changes.
+     */
+    class RegionMap
+    {
+    public:
+        explicit RegionMap(RegionSource &source);
+        ~RegionMap(void);
+
+        RegionMap(const RegionMap &) = delete;
+        RegionMap &operator=(const RegionMap &) = delete;
+
+        static RegionMap    &Game(void);
+
+        /**
+         * \brief Check if every byte of [address, address + size) has the permissions
+         * \param perm MEMPERM_READ, MEMPERM_WRITE or both
+         */
+        bool    Check(u32 address, u32 size, u32 perm);
+
+        bool    IsReadable(u32 address, u32 size = 1);
+        bool    IsWritable(u32 address, u32 size = 1);
+
+        /**
+         * \brief Get the region containing an address
+         * \return If the address is in a region
+         */
+        bool    Find(u32 address, MemoryRegion &out);
+
+        /**
+         * \brief Enumerate the regions again and publish them \n
+         * Waits for the checks still reading the previous regions before freeing them
+         */
+        void    Invalidate(void);
+
+        u32     Generation(void) const
+        {
+            return (__atomic_load_n(&_generation, __ATOMIC_ACQUIRE));
+        }
+
+        // Copy of the regions
+        std::vector<MemoryRegion>   GetRegions(void);
+
+#ifdef HELPERS_DEBUG
+        // Called by the checks before they count themselves, then once the snapshot is pinned, to test the races
+        static void     (*AcquireHook)(bool pinned);
+#endif
+
+    private:
+        // The regions of a generation, never changed once published
+        struct Snapshot
+        {
+            u32                         generation;
+            std::vector<MemoryRegion>   regions;
+        };
+
+        // Pin the current snapshot until Release, without blocking
+        const Snapshot  *Acquire(u32 &slot) const;
+        void            Release(u32 slot) const;
+
+        // Enumerate the regions into a new snapshot
+        Snapshot        *Enumerate(u32 generation);
+
+        static const MemoryRegion   *Lookup(const Snapshot &snapshot, u32 address);
+
+        RegionSource    &_source;
+        Snapshot        *_snapshot;
+        mutable u32     _readers[2];    ///< Checks running, by epoch
+        u32             _epoch;         ///< Changed by each Invalidate, the checks count in _readers[_epoch & 1]
+        LightLock       _lock;          ///< Serializes Invalidate, the checks don't take it
+        u32             _generation;
+    };
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef HELPERS_SETTINGSSTORE_HPP
+#define HELPERS_SETTINGSSTORE_HPP
+
+#include "CTRPluginFramework.hpp"
+#include "CTRPluginFramework/Menu/MenuFolder.hpp"
+#include "Helpers/StringID.hpp"
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief Binary key/value settings saved as they change \n
+     * The file starts with a sorted index of the values written at the last compaction,
+     * opening it only reads that index: the values are read when they are first requested.
+     * Every change is then appended as a checksummed record and flushed, so a crash loses
+     * at most the record being written. The records are merged back in the index by Compact,
+     * which rewrites the file through a temporary one.
+     */
+    class SettingsStore
+    {
+    public:
+        // Compact when the records are larger than this and than the indexed values
+        static const u32    CompactThreshold = 0x1000;
+
+        static SettingsStore    &GetInstance(void);
+
+        /**
+         * \brief Open or create the settings file
+         * \return If the file could be opened, the store still works in memory otherwise
+         */
+        bool    Open(const std::string &path);
+
+        /**
+         * \brief Compact if needed and close the file, call it from OnProcessExit
+         */
+        void    Close(void);
+
+        /**
+         * \brief Read a value
+         * \param size The size of the value, must be the size it was written with
+         * \return If the value exists with that size
+         */
+        bool    Get(StringID key, void *out, u32 size);
+        bool    Get(StringID key, std::string &out);
+
+        template <typename T>
+        bool    Get(StringID key, T &out)
+        {
+            return (Get(key, &out, sizeof(T)));
+        }
+
+        /**
+         * \brief Read a value or return defaultValue if it doesn't exist
+         */
+        template <typename T>
+        T       GetOr(StringID key, T defaultValue)
+        {
+            Get(key, &defaultValue, sizeof(T));
+            return (defaultValue);
+        }
+
+        /**
+         * \brief Write a value, a record is only appended when the value changed
+         * \return If the value is saved
+         */
+        bool    Set(StringID key, const void *data, u32 size);
+        bool    Set(StringID key, const std::string &value);
+
+        template <typename T>
+        bool    Set(StringID key, const T &value)
+        {
+            return (Set(key, &value, sizeof(T)));
+        }
+
+        bool    Remove(StringID key);
+        bool    Has(StringID key) const;
+
+        /**
+         * \brief Save if an entry is enabled, keyed by its name \n
+         * Call it from the entry when it's enabled and on its last call once disabled
+         */
+        bool    SaveEntry(MenuEntry *entry);
+
+        /**
+         * \brief Enable the entries of a folder and of its subfolders that were saved enabled
+         */
+        void    RestoreEntries(MenuFolder &folder);
+
+        /**
+         * \brief Rewrite the file with only the current values
+         */
+        bool    Compact(void);
+
+        u32     Count(void) const;
+
+        /**
+         * \brief Size of the records appended since the last compaction
+         */
+        u32     LogSize(void) const;
+
+    private:
+        SettingsStore(void);
+
+        struct Value
+        {
+            u32             key;
+            u32             offset;     ///< Position of the data in the file
+            u32             size;
+            u32             checksum;
+            bool            loaded;
+            std::vector<u8> data;
+        };
+
+        Value   *Find(u32 key);
+        Value   &Insert(u32 key);
+        bool    Load(Value &value);
+        bool    Append(u32 key, u32 size, const void *data);
+        bool    ReadAt(u32 offset, void *out, u32 size);
+        bool    Reset(void);
+
+        std::string         _path;
+        File                _file;
+        bool                _open;
+        u32                 _dataSize;  ///< Size of the indexed values
+        u32                 _logStart;
+        u32                 _logEnd;
+        std::vector<Value>  _values;    ///< Sorted by key
+
+        static SettingsStore    _instance;
+    };
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef HELPERS_SIGNATURE_HPP
+#define HELPERS_SIGNATURE_HPP
+
+#include "types.h"
+#include "Helpers/AutoRegion.hpp"
+
+namespace CTRPluginFramework
+{
+    enum class SignatureType : u8
+    {
+        Address,    ///< The address of the match + offset
+        ArmBranch,  ///< The destination of the B / BL / BLX at match + offset
+        LdrLiteral, ///< The value loaded by the LDR Rd, [PC, #imm] at match + offset
+        Pointer     ///< The word at match + offset
+    };
+
+    /**
+     * \brief An address found by searching a byte pattern in the code \n
+     * Declare signatures as globals, they register themselves:
+     * Signature   g_healthCode("?? ?? 90 E5 00 00 50 E3 ?? ?? ?? EB", 8, SignatureType::ArmBranch); \n
+     * Signature::ResolveAll resolves every signature in a single pass over the code,
+     * the results are cached on the SD per title ID and code hash.
+     */
+    class Signature
+    {
+    public:
+        /**
+         * \param pattern Hex bytes in memory order separated by spaces, ?? for a wildcard byte \n
+         * Two consecutive known bytes are required
+         * \param offset Added to the address of the match
+         * \param type How the address is read from the match
+         */
+        Signature(const char *pattern, s32 offset = 0, SignatureType type = SignatureType::Address);
+
+        /**
+         * \param fallback The address to use if the pattern isn't found
+         */
+        Signature(const char *pattern, s32 offset, SignatureType type, const AutoRegion &fallback);
+
+        // A signature which isn't global unregisters itself
+        ~Signature(void);
+
+        Signature(const Signature &) = delete;
+        Signature &operator=(const Signature &) = delete;
+
+        // Return the resolved address, or the fallback if the pattern wasn't found
+        u32     operator()(void) const;
+
+        bool        IsResolved(void) const;
+        const char  *Pattern(void) const;
+
+        /**
+         * \brief Resolve every signature in the game's code, call it from PatchProcess
+         * \return The amount of signatures resolved
+         */
+        static u32  ResolveAll(void);
+
+        /**
+         * \brief Resolve the unresolved signatures in a code image
+         * \param code The code to search
+         * \param address The address of the code in the game
+         * \param size The size of the code
+         * \return The amount of signatures resolved by this call
+         */
+        static u32  ResolveAll(const u8 *code, u32 address, u32 size);
+
+    private:
+        // Identify the signature in the cache
+        u32     Key(void) const;
+
+        static Signature    *_first;
+
+        Signature           *_next;
+        const char          *_pattern;
+        s32                 _offset;
+        SignatureType       _type;
+        bool                _resolved;
+        u32                 _address;
+        AutoRegion          _fallback;
+    };
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef HELPERS_STRINGID_HPP
+#define HELPERS_STRINGID_HPP
+
+#include "types.h"
+#include <string>
+
+namespace CTRPluginFramework
+{
+    /**
+     * \brief A 32 bits FNV-1a hash of a string, used as a compact identifier \n
+     * The hash of a literal is computed at compile time with the _id suffix: "hp_display"_id \n
+     * With HELPERS_DEBUG defined, the id also points to the string it was hashed from so the users
+     * can detect two strings sharing a hash. The pointer is only valid as long as that string is.
+     */
+    class StringID
+    {
+    public:
+        static const u32    OffsetBasis = 2166136261u;
+        static const u32    Prime = 16777619u;
+
+#ifdef HELPERS_DEBUG
+        constexpr StringID(void) : _value(0), _source(nullptr), _length(0) {}
+        constexpr explicit StringID(u32 value) : _value(value), _source(nullptr), _length(0) {}
+        constexpr StringID(u32 value, const char *source, size_t length) :
+            _value(value), _source(source), _length(length) {}
+
+        /**
+         * \brief Hash a string at runtime
+         */
+        explicit StringID(const std::string &str) :
+            _value(Compute(str.c_str(), str.size())), _source(str.c_str()), _length(str.size()) {}
+
+        /**
+         * \brief The string the id was hashed from, nullptr if unknown
+         */
+        constexpr const char    *Source(void) const { return (_source); }
+        constexpr size_t        Length(void) const { return (_length); }
+#else
+        constexpr StringID(void) : _value(0) {}
+        constexpr explicit StringID(u32 value) : _value(value) {}
+        constexpr StringID(u32 value, const char *source, size_t length) : _value(value) {}
+
+        /**
+         * \brief Hash a string at runtime
+         */
+        explicit StringID(const std::string &str) : _value(Compute(str.c_str(), str.size())) {}
+#endif
+
+        constexpr u32   Value(void) const { return (_value); }
+
+        constexpr bool  operator==(const StringID &right) const { return (_value == right._value); }
+        constexpr bool  operator!=(const StringID &right) const { return (_value != right._value); }
+        constexpr bool  operator<(const StringID &right) const { return (_value < right._value); }
+
+        /**
+         * \brief Compile time version of the hash
+         */
+        static constexpr u32    Hash(const char *str, size_t length, u32 hash = OffsetBasis)
+        {
+            return (length == 0 ? hash : Hash(str + 1, length - 1, (hash ^ static_cast<u8>(*str)) * Prime));
+        }
+
+        /**
+         * \brief Runtime version of the hash
+         */
+        static u32      Compute(const char *str, size_t length)
+        {
+            u32     hash = OffsetBasis;
+
+            while (length--)
+                hash = (hash ^ static_cast<u8>(*str++)) * Prime;
+
+            return (hash);
+        }
+
+    private:
+        u32     _value;
+#ifdef HELPERS_DEBUG
+        const char  *_source;
+        size_t      _length;
+#endif
+    };
+
+    constexpr StringID  operator"" _id(const char *str, size_t length)
+    {
+        return (StringID(StringID::Hash(str, length), str, length));
+    }
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef STRINGS_HPP
 #define STRINGS_HPP
 
+#include "types.h"
 #include <string>
 
 namespace CTRPluginFramework
@@ -9,8 +10,9 @@ namespace CTRPluginFramework
     std::string     Hex(u16 x);
     std::string     Hex(u32 x);
     std::string     Hex(u64 x);
+    // The float overloads return the IEEE-754 bit pattern of the value
     std::string     Hex(float x);
     std::string     Hex(double x);    
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,27 @@
+#ifndef HELPERS_TICKS_HPP
+#define HELPERS_TICKS_HPP
+
+#include <3ds.h>
+
+namespace CTRPluginFramework
+{
+    // The system tick runs at the ARM11 clock
+    const u32   TicksPerMicrosecond = SYSCLOCK_ARM11 / 1000000;
+
+    inline u64  GetTicks(void)
+    {
+        return (svcGetSystemTick());
+    }
+
+    inline u32  TicksToMicroseconds(u64 ticks)
+    {
+        return (ticks / TicksPerMicrosecond);
+    }
+
+    inline u64  MicrosecondsToTicks(u32 microseconds)
+    {
+        return (static_cast<u64>(microseconds) * TicksPerMicrosecond);
+    }
+}
+
+#endif
@@ -9,5 +9,25 @@ namespace CTRPluginFramework
 {
     using StringVector = std::vector<std::string>;
 
+    // Run the Action Replay code of an entry added by CheatDatabase::Populate
+    void    ActionReplayEntry(MenuEntry *entry);
+
+    // Show or hide the statistics of the PoolAllocator
+    void    HeapStatistics(MenuEntry *entry);
+
+    // Choose the hotkey of the QuickMenu, it's saved in the SettingsStore
+    void    QuickMenuHotkey(MenuEntry *entry);
+
+    // The hotkey chosen with QuickMenuHotkey, Start by default
+    u32     SavedQuickMenuHotkey(void);
+
+#ifdef PROFILER_ENABLED
+    // Show or hide the most expensive zones of the Profiler
+    void    ProfilerOverlay(MenuEntry *entry);
+
+    // Write the zones of the Profiler to the SD card, as CSV and as a Chrome trace
+    void    ProfilerDump(MenuEntry *entry);
+#endif
+
 }
 #endif
@@ -0,0 +1,682 @@
+#include "Helpers/ActionReplay.hpp"
+#include <3ds.h>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        enum Opcode : u8
+        {
+            End,
+            Write32, Write16, Write8,
+            StoreData32, StoreData16, StoreData8,   ///< Write the data register, advance a relative offset
+            IfGreater32, IfLess32, IfEqual32, IfNotEqual32,
+            IfGreater16, IfLess16, IfEqual16, IfNotEqual16,
+            IfKeys,
+            LoadOffset,
+            LoadData32, LoadData16, LoadData8,
+            SetOffset, AddOffset, SetData, AddData,
+            LoopStart, LoopEnd,
+            Reset,
+            Copy
+        };
+
+        // Code types, the D codes are 0xD0 to 0xDD
+        u32     TypeOf(u32 left)
+        {
+            u32     type = left >> 28;
+
+            return (type == 0xD ? left >> 24 : type);
+        }
+
+        bool    IsCondition(u32 type)
+        {
+            return ((type >= 0x3 && type <= 0xA) || type == 0xDD);
+        }
+
+        // Amount of lines holding the data of an E code
+        u32     CopyLines(u32 size)
+        {
+            return (size / 8 + ((size & 7) != 0));
+        }
+
+        bool    Compare(u32 type, u32 value, u32 memory)
+        {
+            switch (type & 3)
+            {
+            case 3: return (value > memory);
+            case 0: return (value < memory);
+            case 1: return (value == memory);
+            default: return (value != memory);
+            }
+        }
+
+        // The type of a 16 bits condition has the same comparison as its 32 bits one
+        u32     Condition16(u32 type)
+        {
+            return (type - 4);
+        }
+    }
+
+    ARMemory::ARMemory(void) :
+        _memory(nullptr), _base(0), _start(0), _end(0), _generation(0), _writable(false), _process(true)
+    {
+    }
+
+    ARMemory::ARMemory(u8 *memory, u32 base, u32 size) :
+        _memory(memory), _base(base), _start(base), _end(base + size), _generation(0), _writable(true), _process(false)
+    {
+    }
+
+    bool    ARMemory::Query(u32 address, u32 size, bool write)
+    {
+        if (!_process)
+            return (false);
+
+        RegionMap       &regions = RegionMap::Game();
+        MemoryRegion    region;
+
+        // Read the generation first, a change while searching only makes the next check search again
+        _generation = regions.Generation();
+        if (!regions.Find(address, region))
+        {
+            _start = _end = 0;
+            return (false);
+        }
+
+        _start = region.start;
+        _end = region.end;
+        _writable = region.perm & MEMPERM_WRITE;
+
+        return (address - _start < _end - _start && _end - address >= size && (_writable || !write));
+    }
+
+    bool    ARMemory::Copy(u32 address, const u8 *data, u32 size)
+    {
+        if (size == 0)
+            return (true);
+
+        if (!Check(address, size, true))
+            return (false);
+
+        std::memcpy(Pointer(address), data, size);
+        return (true);
+    }
+
+    ARProgram::ARProgram(void) :
+        _error(0), _valid(false)
+    {
+    }
+
+    void    ARProgram::Interpret(const u32 *words, u32 count, ARMemory &memory, u32 keys)
+    {
+        u32     lines = count / 2;
+        u32     offset = 0;
+        u32     data = 0;
+        u32     skip = 0;       ///< Blocks opened since the condition which failed
+        u32     loopStart = 0;
+        u32     loopCount = 0;
+        bool    loop = false;
+
+        for (u32 line = 0; line < lines; ++line)
+        {
+            u32     left = words[line * 2];
+            u32     right = words[line * 2 + 1];
+            u32     type = TypeOf(left);
+            u32     address = (left & 0x0FFFFFFF) + offset;
+
+            if (skip != 0)
+            {
+                if (IsCondition(type) || type == 0xC)
+                    ++skip;
+                else if (type == 0xD0 || type == 0xD1)
+                    --skip;
+                else if (type == 0xD2)
+                {
+                    skip = 0;
+                    loop = false;
+                    offset = data = 0;
+                }
+                else if (type == 0xE)
+                    line += CopyLines(right);
+                continue;
+            }
+
+            switch (type)
+            {
+            case 0x0:
+                memory.Write<u32>(address, right);
+                break;
+            case 0x1:
+                memory.Write<u16>(address, right);
+                break;
+            case 0x2:
+                memory.Write<u8>(address, right);
+                break;
+            case 0x3: case 0x4: case 0x5: case 0x6:
+            {
+                u32     value;
+
+                if (!memory.Read(address, value) || !Compare(type, right, value))
+                    skip = 1;
+                break;
+            }
+            case 0x7: case 0x8: case 0x9: case 0xA:
+            {
+                u16     value;
+
+                if (!memory.Read(address, value)
+                    || !Compare(Condition16(type), right & 0xFFFF, value & ~(right >> 16) & 0xFFFF))
+                    skip = 1;
+                break;
+            }
+            case 0xB:
+                memory.Read(address, offset);
+                break;
+            case 0xC:
+                if (right == 0)
+                    skip = 1;
+                else
+                {
+                    loop = true;
+                    loopStart = line;
+                    loopCount = right;
+                }
+                break;
+            case 0xD0:
+                break;
+            case 0xD1:
+                if (loop && --loopCount != 0)
+                    line = loopStart;
+                else
+                    loop = false;
+                break;
+            case 0xD2:
+                if (loop && --loopCount != 0)
+                {
+                    line = loopStart;
+                    break;
+                }
+                loop = false;
+                offset = data = 0;
+                break;
+            case 0xD3:
+                offset = right;
+                break;
+            case 0xD4:
+                data += right;
+                break;
+            case 0xD5:
+                data = right;
+                break;
+            case 0xD6:
+                memory.Write<u32>(right + offset, data);
+                offset += 4;
+                break;
+            case 0xD7:
+                memory.Write<u16>(right + offset, data);
+                offset += 2;
+                break;
+            case 0xD8:
+                memory.Write<u8>(right + offset, data);
+                offset += 1;
+                break;
+            case 0xD9:
+                memory.Read(right + offset, data);
+                break;
+            case 0xDA:
+            {
+                u16     value;
+
+                memory.Read(right + offset, value);
+                data = value;
+                break;
+            }
+            case 0xDB:
+            {
+                u8      value;
+
+                memory.Read(right + offset, value);
+                data = value;
+                break;
+            }
+            case 0xDC:
+                offset += right;
+                break;
+            case 0xDD:
+                if ((keys & right) != right)
+                    skip = 1;
+                break;
+            case 0xE:
+                memory.Copy(address, reinterpret_cast<const u8 *>(words + line * 2 + 2), right);
+                line += CopyLines(right);
+                break;
+            default:
+                return;
+            }
+        }
+    }
+
+    bool    ARProgram::Compile(const u32 *words, u32 count)
+    {
+        // A register is known when its value only depends on the code, not on the memory
+        struct Register
+        {
+            bool    known;
+            bool    synced;     ///< The register of Execute holds the known value
+            u32     value;
+        };
+
+        struct Block
+        {
+            bool        loop;
+            bool        dead;       ///< Opened in a loop running 0 times
+            u32         at;         ///< The condition, or the first instruction of the loop
+            Register    offset;     ///< At the start of the block
+            Register    data;
+        };
+
+        u32                 lines = count / 2;
+        u32                 dead = 0;
+        u32                 loopBlocks = 0;
+        std::vector<Block>  blocks;
+        Register            offset = { true, true, 0 };
+        Register            data = { true, true, 0 };
+
+        _code.clear();
+        _bytes.clear();
+        _valid = false;
+        _error = 0;
+
+        auto    emit = [this](u8 opcode, u8 relative, u32 address, u32 value, u16 target)
+        {
+            Instruction     instruction = { opcode, relative, target, address, value };
+
+            _code.push_back(instruction);
+        };
+
+        // Store the known registers before a jump or a jump target
+        auto    flush = [&](void)
+        {
+            if (offset.known && !offset.synced)
+                emit(SetOffset, 0, 0, offset.value, 0);
+            if (data.known && !data.synced)
+                emit(SetData, 0, 0, data.value, 0);
+            offset.synced = data.synced = true;
+        };
+
+        auto    merge = [](Register &current, const Register &other)
+        {
+            current.known = current.known && other.known && current.value == other.value;
+            current.synced = true;
+        };
+
+        // The address of a code, folded with the offset when it's known
+        auto    relative = [&](void) -> u8 { return (!offset.known); };
+        auto    fold = [&](u32 address) -> u32 { return (offset.known ? address + offset.value : address); };
+
+        for (u32 line = 0; line < lines; ++line)
+        {
+            u32     left = words[line * 2];
+            u32     right = words[line * 2 + 1];
+            u32     type = TypeOf(left);
+            u32     address = left & 0x0FFFFFFF;
+
+            _error = line;
+
+            if (_code.size() >= 0xFFFF || (type >= 0xDE && type <= 0xDF) || type == 0xF)
+                return (false);
+
+            if (type == 0xE && (right > 0xFFFF || CopyLines(right) > lines - line - 1))
+                return (false);
+
+            if (type == 0xC && loopBlocks != 0)
+                return (false);
+
+            if ((type == 0xD0 && !blocks.empty() && blocks.back().loop)
+                || (type == 0xD1 && !blocks.empty() && !blocks.back().loop))
+                return (false);
+
+            // Blocks are still tracked in a loop running 0 times, nothing is emitted
+            if (dead != 0)
+            {
+                if (IsCondition(type) || type == 0xC)
+                {
+                    Block   block = { type == 0xC, true, 0, offset, data };
+
+                    loopBlocks += block.loop;
+                    blocks.push_back(block);
+                    ++dead;
+                }
+                else if (type == 0xD0 || type == 0xD1)
+                {
+                    loopBlocks -= blocks.back().loop;
+                    blocks.pop_back();
+                    --dead;
+                }
+                else if (type == 0xD2)
+                {
+                    u32     reset = _code.size();
+
+                    dead = 0;
+                    emit(Reset, 0, 0, 0, 0);
+                    for (Block &block : blocks)
+                        if (!block.dead && !block.loop)
+                            _code[block.at].target = reset;
+                    blocks.clear();
+                    loopBlocks = 0;
+                    offset = data = Register{ true, true, 0 };
+                }
+                else if (type == 0xE)
+                    line += CopyLines(right);
+                continue;
+            }
+
+            switch (type)
+            {
+            case 0x0: case 0x1: case 0x2:
+                emit(Write32 + type, relative(), fold(address), right, 0);
+                break;
+            case 0x3: case 0x4: case 0x5: case 0x6:
+            case 0x7: case 0x8: case 0x9: case 0xA:
+            case 0xDD:
+            {
+                static const u8     conditions[] =
+                {
+                    IfGreater32, IfLess32, IfEqual32, IfNotEqual32,
+                    IfGreater16, IfLess16, IfEqual16, IfNotEqual16
+                };
+
+                flush();
+
+                Block   block = { false, false, static_cast<u32>(_code.size()), offset, data };
+
+                if (type == 0xDD)
+                    emit(IfKeys, 0, 0, right, 0);
+                else
+                    emit(conditions[type - 3], relative(), fold(address), right, 0);
+                blocks.push_back(block);
+                break;
+            }
+            case 0xB:
+                emit(LoadOffset, relative(), fold(address), 0, 0);
+                offset.known = false;
+                break;
+            case 0xC:
+            {
+                Block   block = { true, right == 0, 0, offset, data };
+
+                blocks.push_back(block);
+                ++loopBlocks;
+
+                if (right == 0)
+                {
+                    dead = 1;
+                    break;
+                }
+
+                flush();
+                emit(LoopStart, 0, 0, right, 0);
+                blocks.back().at = _code.size();
+                blocks.back().offset = offset;
+                blocks.back().data = data;
+
+                // The registers changed by the body aren't known at its start
+                for (u32 next = line + 1; next < lines; ++next)
+                {
+                    u32     bodyType = TypeOf(words[next * 2]);
+
+                    if (bodyType == 0xD1 || bodyType == 0xD2)
+                        break;
+                    if (bodyType == 0xB || bodyType == 0xD3 || bodyType == 0xDC
+                        || (bodyType >= 0xD6 && bodyType <= 0xD8))
+                        offset.known = false;
+                    if (bodyType == 0xD4 || bodyType == 0xD5 || (bodyType >= 0xD9 && bodyType <= 0xDB))
+                        data.known = false;
+                    if (bodyType == 0xE)
+                        next += CopyLines(words[next * 2 + 1]);
+                }
+                break;
+            }
+            case 0xD0:
+                if (blocks.empty())
+                    break;
+
+                flush();
+                _code[blocks.back().at].target = _code.size();
+                merge(offset, blocks.back().offset);
+                merge(data, blocks.back().data);
+                blocks.pop_back();
+                break;
+            case 0xD1:
+                if (blocks.empty())
+                    break;
+
+                // The loop runs at least once, the registers are the ones at the end of the body
+                flush();
+                emit(LoopEnd, 0, 0, 0, blocks.back().at);
+                blocks.pop_back();
+                --loopBlocks;
+                break;
+            case 0xD2:
+            {
+                flush();
+                for (const Block &block : blocks)
+                    if (block.loop)
+                        emit(LoopEnd, 0, 0, 0, block.at);
+
+                u32     reset = _code.size();
+
+                emit(Reset, 0, 0, 0, 0);
+                for (const Block &block : blocks)
+                    if (!block.loop)
+                        _code[block.at].target = reset;
+                blocks.clear();
+                loopBlocks = 0;
+                offset = data = Register{ true, true, 0 };
+                break;
+            }
+            case 0xD3:
+                offset = Register{ true, false, right };
+                break;
+            case 0xD4:
+                if (data.known)
+                {
+                    data.value += right;
+                    data.synced = false;
+                }
+                else
+                    emit(AddData, 0, 0, right, 0);
+                break;
+            case 0xD5:
+                data = Register{ true, false, right };
+                break;
+            case 0xD6: case 0xD7: case 0xD8:
+            {
+                u32     width = 4 >> (type - 0xD6);
+
+                if (data.known)
+                {
+                    emit(Write32 + type - 0xD6, relative(), fold(right), data.value, 0);
+                    if (!offset.known)
+                        emit(AddOffset, 0, 0, width, 0);
+                }
+                else
+                    emit(StoreData32 + type - 0xD6, relative(), fold(right), 0, 0);
+
+                // StoreData advances a relative offset by itself
+                if (offset.known)
+                {
+                    offset.value += width;
+                    offset.synced = false;
+                }
+                break;
+            }
+            case 0xD9: case 0xDA: case 0xDB:
+                emit(LoadData32 + type - 0xD9, relative(), fold(right), 0, 0);
+                data.known = false;
+                break;
+            case 0xDC:
+                if (offset.known)
+                {
+                    offset.value += right;
+                    offset.synced = false;
+                }
+                else
+                    emit(AddOffset, 0, 0, right, 0);
+                break;
+            case 0xE:
+            {
+                const u8    *bytes = reinterpret_cast<const u8 *>(words + line * 2 + 2);
+
+                emit(Copy, relative(), fold(address), _bytes.size(), right);
+                _bytes.insert(_bytes.end(), bytes, bytes + right);
+                line += CopyLines(right);
+                break;
+            }
+            }
+        }
+
+        // The conditions still open jump to the end
+        u32     end = _code.size();
+
+        emit(End, 0, 0, 0, 0);
+        for (const Block &block : blocks)
+            if (!block.dead && !block.loop)
+                _code[block.at].target = end;
+
+        _error = 0;
+        _valid = _code.size() <= 0xFFFF;
+        return (_valid);
+    }
+
+    void    ARProgram::Execute(ARMemory &memory, u32 keys) const
+    {
+        if (!_valid)
+            return;
+
+        const Instruction   *code = _code.data();
+        const u8            *bytes = _bytes.data();
+        u32                 offset = 0;
+        u32                 data = 0;
+        u32                 counter = 0;
+        u32                 pc = 0;
+
+        while (true)
+        {
+            const Instruction   &instruction = code[pc++];
+            u32                 address = instruction.address + (instruction.relative ? offset : 0);
+
+            switch (instruction.opcode)
+            {
+            case End:
+                return;
+            case Write32:
+                memory.Write<u32>(address, instruction.value);
+                break;
+            case Write16:
+                memory.Write<u16>(address, instruction.value);
+                break;
+            case Write8:
+                memory.Write<u8>(address, instruction.value);
+                break;
+            case StoreData32:
+                memory.Write<u32>(address, data);
+                offset += instruction.relative ? 4 : 0;
+                break;
+            case StoreData16:
+                memory.Write<u16>(address, data);
+                offset += instruction.relative ? 2 : 0;
+                break;
+            case StoreData8:
+                memory.Write<u8>(address, data);
+                offset += instruction.relative ? 1 : 0;
+                break;
+            case IfGreater32: case IfLess32: case IfEqual32: case IfNotEqual32:
+            {
+                u32     value;
+
+                if (!memory.Read(address, value) || !Compare(instruction.opcode - IfGreater32 + 3, instruction.value, value))
+                    pc = instruction.target;
+                break;
+            }
+            case IfGreater16: case IfLess16: case IfEqual16: case IfNotEqual16:
+            {
+                u16     value;
+
+                if (!memory.Read(address, value)
+                    || !Compare(instruction.opcode - IfGreater16 + 3, instruction.value & 0xFFFF,
+                                value & ~(instruction.value >> 16) & 0xFFFF))
+                    pc = instruction.target;
+                break;
+            }
+            case IfKeys:
+                if ((keys & instruction.value) != instruction.value)
+                    pc = instruction.target;
+                break;
+            case LoadOffset:
+                memory.Read(address, offset);
+                break;
+            case LoadData32:
+                memory.Read(address, data);
+                break;
+            case LoadData16:
+            {
+                u16     value;
+
+                memory.Read(address, value);
+                data = value;
+                break;
+            }
+            case LoadData8:
+            {
+                u8      value;
+
+                memory.Read(address, value);
+                data = value;
+                break;
+            }
+            case SetOffset:
+                offset = instruction.value;
+                break;
+            case AddOffset:
+                offset += instruction.value;
+                break;
+            case SetData:
+                data = instruction.value;
+                break;
+            case AddData:
+                data += instruction.value;
+                break;
+            case LoopStart:
+                counter = instruction.value;
+                break;
+            case LoopEnd:
+                if (--counter != 0)
+                    pc = instruction.target;
+                break;
+            case Reset:
+                offset = data = 0;
+                break;
+            case Copy:
+                memory.Copy(address, bytes + instruction.value, instruction.target);
+                break;
+            }
+        }
+    }
+
+    bool    ARProgram::IsValid(void) const
+    {
+        return (_valid);
+    }
+
+    u32     ARProgram::ErrorLine(void) const
+    {
+        return (_error);
+    }
+
+    u32     ARProgram::Size(void) const
+    {
+        return (_code.size());
+    }
+}
@@ -0,0 +1,408 @@
+#include "Helpers/ArmCode.hpp"
+
+namespace CTRPluginFramework
+{
+    namespace ArmCode
+    {
+        namespace
+        {
+            const u32   MaxLiterals = 32;
+            const u32   AL = 0xE;
+
+            inline s32  SignExtend(u32 value, u32 bits)
+            {
+                return (static_cast<s32>(value << (32 - bits)) >> (32 - bits));
+            }
+
+            // Write the code, then the literals loaded by the code
+            struct ArmEmitter
+            {
+                u32     *out;
+                u32     capacity;
+                u32     size;
+                u32     literals[MaxLiterals];
+                u32     loads[MaxLiterals];     ///< The instruction loading each literal
+                u32     literalCount;
+                bool    failed;
+
+                void    Emit(u32 insn)
+                {
+                    if (size < capacity)
+                        out[size] = insn;
+                    else
+                        failed = true;
+                    ++size;
+                }
+
+                // ldr<cond> rd, =value
+                void    EmitLoad(u32 cond, u32 rd, u32 value)
+                {
+                    if (literalCount == MaxLiterals)
+                    {
+                        failed = true;
+                        return;
+                    }
+
+                    literals[literalCount] = value;
+                    loads[literalCount++] = size;
+                    Emit(LoadLiteral(rd, 0, cond));
+                }
+
+                u32     Finish(void)
+                {
+                    u32     pool = size;
+
+                    for (u32 i = 0; i < literalCount; ++i)
+                        Emit(literals[i]);
+
+                    if (failed)
+                        return (0);
+
+                    // The last literal can be behind the pc of its load
+                    for (u32 i = 0; i < literalCount; ++i)
+                    {
+                        u32     insn = out[loads[i]];
+                        s32     offset = (static_cast<s32>(pool + i) - static_cast<s32>(loads[i]) - 2) * 4;
+
+                        out[loads[i]] = LoadLiteral((insn >> 12) & 0xF, offset, insn >> 28);
+                    }
+
+                    return (size);
+                }
+            };
+
+            struct ThumbEmitter
+            {
+                u16     *out;
+                u32     capacity;
+                u32     size;
+                u32     literals[MaxLiterals];
+                u32     loads[MaxLiterals];
+                u32     literalCount;
+                u32     veneers[MaxLiterals];   ///< Destination of each veneer
+                u32     calls[MaxLiterals];     ///< The BL pair calling each veneer
+                u32     veneerCount;
+                bool    failed;
+
+                void    Emit(u16 insn)
+                {
+                    if (size < capacity)
+                        out[size] = insn;
+                    else
+                        failed = true;
+                    ++size;
+                }
+
+                // ldr rd, =value, rd is a low register
+                void    EmitLoad(u32 rd, u32 value)
+                {
+                    if (literalCount == MaxLiterals)
+                    {
+                        failed = true;
+                        return;
+                    }
+
+                    literals[literalCount] = value;
+                    loads[literalCount++] = size;
+                    Emit(0x4800 | (rd << 8));
+                }
+
+                // Jump anywhere without touching a register: the destination is popped into pc
+                void    EmitJump(u32 target)
+                {
+                    Emit(0xB403);           // push {r0, r1}
+                    EmitLoad(0, target);    // ldr r0, =target
+                    Emit(0x9001);           // str r0, [sp, #4]
+                    Emit(0xBD01);           // pop {r0, pc}
+                }
+
+                // bl to a veneer jumping to target, lr stays in the relocated code
+                void    EmitCall(u32 target)
+                {
+                    if (veneerCount == MaxLiterals)
+                    {
+                        failed = true;
+                        return;
+                    }
+
+                    veneers[veneerCount] = target;
+                    calls[veneerCount++] = size;
+                    Emit(0xF000);
+                    Emit(0xF800);
+                }
+
+                u32     Finish(void)
+                {
+                    for (u32 i = 0; i < veneerCount; ++i)
+                    {
+                        u32     offset = (size - calls[i] - 2) * 2;
+
+                        if (calls[i] + 1 < capacity)
+                        {
+                            out[calls[i]] |= (offset >> 12) & 0x7FF;
+                            out[calls[i] + 1] |= (offset >> 1) & 0x7FF;
+                        }
+                        EmitJump(veneers[i]);
+                    }
+
+                    // The literals must be aligned to 4, like out
+                    if (size & 1)
+                        Emit(ThumbNop);
+
+                    u32     pool = size;
+
+                    for (u32 i = 0; i < literalCount; ++i)
+                    {
+                        Emit(literals[i] & 0xFFFF);
+                        Emit(literals[i] >> 16);
+                    }
+
+                    if (failed)
+                        return (0);
+
+                    // Offset from the instruction + 4 aligned down to 4
+                    for (u32 i = 0; i < literalCount; ++i)
+                        out[loads[i]] |= (pool + i * 2 - ((loads[i] + 2) & ~1u)) / 2;
+
+                    return (size);
+                }
+            };
+
+            // Whether an instruction doesn't read pc and can be copied as is
+            bool    IsPositionIndependent(u32 insn)
+            {
+                u32     cond = insn >> 28;
+                u32     rn = (insn >> 16) & 0xF;
+                u32     rm = insn & 0xF;
+
+                // Unconditional instructions (pld...) and coprocessor transfers (vldr...)
+                if (cond == 0xF || (insn & 0x0E000000) == 0x0C000000)
+                    return (rn != 15);
+
+                // LDR / STR / LDRB / STRB
+                if ((insn & 0x0C000000) == 0x04000000)
+                    return (rn != 15 && (!(insn & 0x02000000) || rm != 15));
+
+                // LDM / STM
+                if ((insn & 0x0E000000) == 0x08000000)
+                    return (rn != 15);
+
+                // Data processing, multiplies and the misc instructions
+                if ((insn & 0x0C000000) == 0)
+                {
+                    u32     opcode = (insn >> 21) & 0xF;
+                    bool    ignoresRn = opcode == 0xD || opcode == 0xF;
+
+                    // MSR / MRS, the rn field isn't a register
+                    if ((insn & 0x0FB00000) == 0x03200000 || (insn & 0x0FB000F0) == 0x01200000
+                        || (insn & 0x0FBF0FFF) == 0x010F0000)
+                        ignoresRn = true;
+
+                    if (rn == 15 && !ignoresRn)
+                        return (false);
+
+                    // Register forms: neither rm nor rs may be pc
+                    if (!(insn & 0x02000000) && (rm == 15 || ((insn & 0x10) && ((insn >> 8) & 0xF) == 15)))
+                        return (false);
+                }
+
+                return (true);
+            }
+
+            bool    RelocateArmInstruction(ArmEmitter &emitter, u32 insn, u32 pc)
+            {
+                u32     cond = insn >> 28;
+                u32     rn = (insn >> 16) & 0xF;
+                u32     rd = (insn >> 12) & 0xF;
+
+                // B / BL / BLX
+                if ((insn & 0x0E000000) == 0x0A000000)
+                {
+                    u32     target = BranchTarget(insn, pc);
+
+                    if (cond == 0xF)
+                    {
+                        emitter.Emit(0xE28FE000);               // add lr, pc, #0
+                        emitter.EmitLoad(AL, 15, target);       // ldr pc, =target
+                    }
+                    else
+                    {
+                        if (insn & 0x01000000)
+                            emitter.Emit((cond << 28) | 0x028FE000);
+                        emitter.EmitLoad(cond, 15, target);
+                    }
+                    return (true);
+                }
+
+                // LDR / LDRB rd, [pc, #imm]: load the address, then the value
+                if ((insn & 0x0E100000) == 0x04100000 && rn == 15 && rd != 15 && cond != 0xF)
+                {
+                    u32     address = insn & 0x00800000 ? pc + 8 + (insn & 0xFFF) : pc + 8 - (insn & 0xFFF);
+
+                    emitter.EmitLoad(cond, rd, address);
+                    emitter.Emit((insn & 0xFF70F000) | 0x00800000 | (rd << 16));
+                    return (true);
+                }
+
+                // ADR: add / sub rd, pc, #imm
+                if ((insn & 0x0DEF0000) == 0x008F0000 || (insn & 0x0DEF0000) == 0x004F0000)
+                {
+                    if (!(insn & 0x02000000) || (insn & 0x00100000) || rd == 15 || cond == 0xF)
+                        return (false);
+
+                    u32     rotate = ((insn >> 8) & 0xF) * 2;
+                    u32     value = insn & 0xFF;
+
+                    value = rotate ? (value >> rotate) | (value << (32 - rotate)) : value;
+                    emitter.EmitLoad(cond, rd, insn & 0x00800000 ? pc + 8 + value : pc + 8 - value);
+                    return (true);
+                }
+
+                if (!IsPositionIndependent(insn))
+                    return (false);
+
+                emitter.Emit(insn);
+                return (true);
+            }
+
+            bool    RelocateThumbInstruction(ThumbEmitter &emitter, const u16 *code, u32 pc, u32 &length)
+            {
+                u16     insn = code[0];
+                u32     base = (pc + 4) & ~3u;
+
+                length = 2;
+
+                // LDR rd, [pc, #imm]: load the address, then the value
+                if ((insn & 0xF800) == 0x4800)
+                {
+                    u32     rd = (insn >> 8) & 7;
+
+                    emitter.EmitLoad(rd, base + (insn & 0xFF) * 4);
+                    emitter.Emit(0x6800 | (rd << 3) | rd);  // ldr rd, [rd]
+                    return (true);
+                }
+
+                // ADD rd, pc, #imm
+                if ((insn & 0xF800) == 0xA000)
+                {
+                    emitter.EmitLoad((insn >> 8) & 7, base + (insn & 0xFF) * 4);
+                    return (true);
+                }
+
+                // B<cond>: skip the jump when the condition fails
+                if ((insn & 0xF000) == 0xD000 && ((insn >> 8) & 0xF) < 0xE)
+                {
+                    u32     target = pc + 4 + SignExtend(insn & 0xFF, 8) * 2;
+
+                    emitter.Emit(0xD003 | ((insn ^ 0x0100) & 0x0F00));
+                    emitter.EmitJump(target | 1);
+                    return (true);
+                }
+
+                // B
+                if ((insn & 0xF800) == 0xE000)
+                {
+                    emitter.EmitJump((pc + 4 + SignExtend(insn & 0x7FF, 11) * 2) | 1);
+                    return (true);
+                }
+
+                // BL / BLX pair
+                if ((insn & 0xF800) == 0xF000)
+                {
+                    u16     low = code[1];
+
+                    if ((low & 0xE800) != 0xE800)
+                        return (false);
+
+                    u32     target = pc + 4 + (SignExtend(insn & 0x7FF, 11) << 12) + ((low & 0x7FF) << 1);
+
+                    length = 4;
+                    emitter.EmitCall((low & 0x1000) ? target | 1 : target & ~3u);
+                    return (true);
+                }
+
+                // ADD / CMP / MOV / BX with high registers reading pc
+                if ((insn & 0xFC00) == 0x4400)
+                {
+                    u32     op = (insn >> 8) & 3;
+                    u32     rm = (insn >> 3) & 0xF;
+                    u32     rd = (insn & 7) | ((insn >> 4) & 8);
+
+                    if (rm == 15 || (rd == 15 && op <= 1))
+                        return (false);
+                }
+
+                emitter.Emit(insn);
+                return (true);
+            }
+        }
+
+        u32     Branch(u32 from, u32 to, bool link)
+        {
+            s32     offset = static_cast<s32>(to - from - 8);
+
+            if (offset < -0x2000000 || offset >= 0x2000000 || (offset & 3))
+                return (0);
+
+            return ((link ? 0xEB000000 : 0xEA000000) | ((offset >> 2) & 0xFFFFFF));
+        }
+
+        u32     LoadLiteral(u32 rd, s32 offset, u32 cond)
+        {
+            u32     insn = (cond << 28) | 0x051F0000 | (rd << 12);
+
+            if (offset >= 0)
+                return (insn | 0x00800000 | (offset & 0xFFF));
+            return (insn | (-offset & 0xFFF));
+        }
+
+        u32     BranchTarget(u32 insn, u32 address)
+        {
+            if ((insn & 0x0E000000) != 0x0A000000)
+                return (0);
+
+            u32     target = address + 8 + (SignExtend(insn & 0xFFFFFF, 24) << 2);
+
+            // BLX: the H bit selects the halfword, the destination is Thumb
+            if ((insn >> 28) == 0xF)
+                target += ((insn >> 23) & 2) | 1;
+
+            return (target);
+        }
+
+        u32     RelocateArm(const u32 *code, u32 from, u32 count, u32 *out, u32 capacity, bool jumpBack)
+        {
+            ArmEmitter  emitter = { out, capacity, 0, {}, {}, 0, false };
+
+            for (u32 i = 0; i < count; ++i)
+                if (!RelocateArmInstruction(emitter, code[i], from + i * 4))
+                    return (0);
+
+            if (jumpBack)
+                emitter.EmitLoad(AL, 15, from + count * 4);
+
+            return (emitter.Finish());
+        }
+
+        u32     RelocateThumb(const u16 *code, u32 from, u32 size, u16 *out, u32 capacity,
+                              bool jumpBack, u32 &consumed)
+        {
+            ThumbEmitter    emitter = { out, capacity, 0, {}, {}, 0, {}, {}, 0, false };
+
+            consumed = 0;
+            while (consumed < size)
+            {
+                u32     length;
+
+                if (!RelocateThumbInstruction(emitter, code + consumed / 2, from + consumed, length))
+                    return (0);
+                consumed += length;
+            }
+
+            if (jumpBack)
+                emitter.EmitJump((from + consumed) | 1);
+
+            return (emitter.Finish());
+        }
+    }
+}
@@ -0,0 +1,567 @@
+#include "Helpers/CheatDatabase.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include "Helpers/StringID.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    CheatDatabase   CheatDatabase::_instance;
+
+    namespace
+    {
+        bool    IsSpace(char c)
+        {
+            return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+        }
+
+        s32     HexValue(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return (c - '0');
+            c |= 0x20;
+            if (c >= 'a' && c <= 'f')
+                return (c - 'a' + 10);
+            return (-1);
+        }
+
+        // Next line without its blanks, returns the start of the following line
+        const char  *NextLine(const char *line, const char *end, TextView &out)
+        {
+            const char  *eol = static_cast<const char *>(std::memchr(line, '\n', end - line));
+            const char  *next = eol != nullptr ? eol + 1 : end;
+
+            if (eol == nullptr)
+                eol = end;
+
+            while (line < eol && IsSpace(*line))
+                ++line;
+            while (eol > line && IsSpace(eol[-1]))
+                --eol;
+
+            out.data = line;
+            out.size = eol - line;
+            return (next);
+        }
+
+        // The title id of a title line, without the '@'
+        bool    ParseTitleId(const char *str, const char *end, u64 &titleId)
+        {
+            u32     digits = 0;
+
+            titleId = 0;
+            for (; str < end && digits < 16; ++str, ++digits)
+            {
+                s32     value = HexValue(*str);
+
+                if (value < 0)
+                    break;
+                titleId = (titleId << 4) | value;
+            }
+
+            return (digits == 16);
+        }
+
+        // Next '@' starting a line, or end
+        const char  *FindTitleLine(const char *str, const char *begin, const char *end)
+        {
+            while (str < end)
+            {
+                const char  *at = static_cast<const char *>(std::memchr(str, '@', end - str));
+
+                if (at == nullptr)
+                    return (end);
+                if (at == begin || at[-1] == '\n')
+                    return (at);
+                str = at + 1;
+            }
+
+            return (end);
+        }
+
+        const u32   IndexMagic = 0x58444943; ///< CIDX
+        const u32   IndexVersion = 1;
+
+        // path.idx: the header then the sections of every title, sorted by title id
+        struct IndexHeader
+        {
+            u32     magic;
+            u32     version;
+            u32     fileSize;   ///< Size of the database the index was built from
+            u32     count;
+            u32     checksum;   ///< Of the sections
+        };
+
+        // FNV-1a, like the other caches of the plugin
+        u32     Checksum(const void *data, u32 size)
+        {
+            const u8    *bytes = static_cast<const u8 *>(data);
+            u32         hash = StringID::OffsetBasis;
+
+            while (size--)
+                hash = (hash ^ *bytes++) * StringID::Prime;
+
+            return (hash);
+        }
+    }
+
+    CheatDatabase::CheatDatabase(void) :
+        _data(nullptr), _size(0)
+    {
+    }
+
+    CheatDatabase   &CheatDatabase::GetInstance(void)
+    {
+        return (_instance);
+    }
+
+    void    CheatDatabase::Clear(void)
+    {
+        _data = nullptr;
+        _size = 0;
+        _buffer.clear();
+        _buffer.shrink_to_fit();
+        _sections.clear();
+        _categories.clear();
+        _codes.clear();
+        _words.clear();
+    }
+
+    bool    CheatDatabase::Load(const void *data, u32 size)
+    {
+        Clear();
+        Index(static_cast<const char *>(data), size);
+        return (!_sections.empty());
+    }
+
+    void    CheatDatabase::Index(const char *data, u32 size)
+    {
+        const char  *end = data + size;
+
+        _data = data;
+        _size = size;
+
+        // Only the title lines are read, the sections are indexed by Select
+        for (const char *at = FindTitleLine(data, data, end); at != end; at = FindTitleLine(at + 1, data, end))
+        {
+            Section     section;
+            TextView    line;
+
+            if (!_sections.empty() && _sections.back().end == size)
+                _sections.back().end = at - data;
+
+            section.begin = NextLine(at, end, line) - data;
+            section.end = size;
+            // The codes after an invalid title line are ignored
+            if (ParseTitleId(at + 1, end, section.titleId))
+                _sections.push_back(section);
+        }
+    }
+
+    bool    CheatDatabase::LoadFile(const std::string &path, u64 titleId)
+    {
+        MemoryTagScope  scope(MemoryTag::Cheats);
+
+        File    file;
+
+        Clear();
+        if (File::Open(file, path, File::READ) != 0)
+            return (false);
+
+        u32                     fileSize = file.GetSize();
+        std::string             indexPath = path + ".idx";
+        std::vector<u8>         cache;
+        std::vector<Section>    titles;
+
+        // Seek straight to the sections of the title when the index matches the file
+        if (ReadFile(indexPath, cache) && cache.size() >= sizeof(IndexHeader))
+        {
+            IndexHeader     header;
+
+            std::memcpy(&header, cache.data(), sizeof(header));
+
+            // The count is checked first, multiplied it could wrap to the size of the file
+            if (header.magic == IndexMagic && header.version == IndexVersion && header.fileSize == fileSize
+                && header.count <= (cache.size() - sizeof(header)) / sizeof(Section)
+                && cache.size() == sizeof(header) + header.count * sizeof(Section)
+                && Checksum(cache.data() + sizeof(header), header.count * sizeof(Section)) == header.checksum)
+            {
+                titles.resize(header.count);
+                std::memcpy(titles.data(), cache.data() + sizeof(header), header.count * sizeof(Section));
+
+                if (ReadSections(file, titleId, titles))
+                {
+                    file.Close();
+                    if (_buffer.empty())
+                        return (false);
+
+                    Index(_buffer.data(), _buffer.size());
+                    return (Select(titleId));
+                }
+            }
+
+            // Stale, built again below
+            titles.clear();
+            _buffer.clear();
+        }
+
+        cache.clear();
+        cache.shrink_to_fit();
+
+        if (file.Seek(0, File::SET) != 0 || !ScanFile(file, titleId, titles))
+        {
+            Clear();
+            return (false);
+        }
+
+        file.Close();
+
+        // Save the index for the next boot
+        std::stable_sort(titles.begin(), titles.end(), [](const Section &left, const Section &right)
+        {
+            return (left.titleId < right.titleId);
+        });
+
+        std::vector<u8> buffer(sizeof(IndexHeader) + titles.size() * sizeof(Section));
+        IndexHeader     header = { IndexMagic, IndexVersion, fileSize, static_cast<u32>(titles.size()),
+                                   Checksum(titles.data(), titles.size() * sizeof(Section)) };
+
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        std::memcpy(buffer.data() + sizeof(header), titles.data(), titles.size() * sizeof(Section));
+        WriteFile(indexPath, buffer.data(), buffer.size());
+
+        if (_buffer.empty())
+            return (false);
+
+        Index(_buffer.data(), _buffer.size());
+        return (Select(titleId));
+    }
+
+    bool    CheatDatabase::ReadSections(File &file, u64 titleId, const std::vector<Section> &titles)
+    {
+        std::vector<Section>::const_iterator    it = std::lower_bound(titles.begin(), titles.end(), titleId,
+            [](const Section &section, u64 id) { return (section.titleId < id); });
+        u32     fileSize = file.GetSize();
+
+        for (; it != titles.end() && it->titleId == titleId; ++it)
+        {
+            u32     offset = _buffer.size();
+            u32     size = it->end - it->begin;
+
+            if (it->begin >= it->end || it->end > fileSize)
+                return (false);
+
+            _buffer.resize(offset + size);
+            if (file.Seek(it->begin, File::SET) != 0 || file.Read(_buffer.data() + offset, size) != 0)
+                return (false);
+
+            // The file changed without changing its size
+            const char  *begin = _buffer.data() + offset;
+            const char  *end = begin + size;
+            u64         id;
+
+            if (*begin != '@' || !ParseTitleId(begin + 1, end, id) || id != titleId
+                || FindTitleLine(begin + 1, begin, end) != end)
+                return (false);
+
+            if (end[-1] != '\n')
+                _buffer.push_back('\n');
+        }
+
+        return (true);
+    }
+
+    bool    CheatDatabase::ScanFile(File &file, u64 titleId, std::vector<Section> &titles)
+    {
+        std::vector<char>   window(ChunkSize);
+        u32                 fileSize = file.GetSize();
+        u32                 remaining = fileSize;
+        u32                 carry = 0;
+        u32                 position = 0;   ///< Offset of the window in the file
+        bool                keep = false;
+
+        // Read the file by chunks of whole lines, only the sections of the title are copied
+        while (remaining != 0 || carry != 0)
+        {
+            u32     size = remaining < ChunkSize ? remaining : ChunkSize;
+
+            window.resize(carry + ChunkSize);
+            if (size != 0 && file.Read(window.data() + carry, size) != 0)
+                return (false);
+
+            remaining -= size;
+            size += carry;
+
+            u32     limit = size;
+
+            if (remaining != 0)
+            {
+                while (limit > 0 && window[limit - 1] != '\n')
+                    --limit;
+
+                // A line longer than the window, read more of it
+                if (limit == 0)
+                {
+                    carry = size;
+                    continue;
+                }
+            }
+
+            const char  *begin = window.data();
+            const char  *end = begin + limit;
+            const char  *str = begin;
+
+            while (str < end)
+            {
+                const char  *at = FindTitleLine(str, begin, end);
+
+                if (keep)
+                    _buffer.insert(_buffer.end(), str, at);
+                if (at == end)
+                    break;
+
+                TextView    line;
+                const char  *next = NextLine(at, end, line);
+                u32         offset = position + (at - begin);
+                Section     section;
+
+                // Every title line ends the section before it
+                if (!titles.empty() && titles.back().end == fileSize)
+                    titles.back().end = offset;
+
+                bool        valid = ParseTitleId(at + 1, end, section.titleId);
+
+                keep = valid && section.titleId == titleId;
+                if (valid)
+                {
+                    section.begin = offset;
+                    section.end = fileSize;
+                    titles.push_back(section);
+                }
+                if (keep)
+                {
+                    _buffer.insert(_buffer.end(), at, next);
+                    // The last line of the file may not end with a new line
+                    if (next[-1] != '\n')
+                        _buffer.push_back('\n');
+                }
+                str = next;
+            }
+
+            position += limit;
+            carry = size - limit;
+            std::memmove(window.data(), window.data() + limit, carry);
+        }
+
+        return (true);
+    }
+
+    bool    CheatDatabase::Select(u64 titleId)
+    {
+        MemoryTagScope  scope(MemoryTag::Cheats);
+
+        CheatCategory   none = { { "", 0 }, 0 };
+
+        _categories.clear();
+        _codes.clear();
+        _words.clear();
+        _categories.push_back(none);
+
+        for (const Section &section : _sections)
+            if (section.titleId == titleId)
+                IndexSection(section);
+
+        return (!_codes.empty());
+    }
+
+    void    CheatDatabase::IndexSection(const Section &section)
+    {
+        const char  *str = _data + section.begin;
+        const char  *end = _data + section.end;
+        u32         category = 0;
+        u32         code = 0xFFFFFFFF;
+
+        while (str < end)
+        {
+            TextView    line;
+            const char  *next = NextLine(str, end, line);
+
+            if (line.empty() || *line.data == ';')
+            {
+                str = next;
+                continue;
+            }
+
+            if (*line.data == '#' && _categories.size() < 0x10000)
+            {
+                CheatCategory   entry = { { line.data + 1, line.size - 1 }, 0 };
+
+                category = _categories.size();
+                _categories.push_back(entry);
+                code = 0xFFFFFFFF;
+            }
+            else if (*line.data == '[')
+            {
+                const char  *close = static_cast<const char *>(std::memchr(line.data, ']', line.size));
+                CheatCode   entry;
+
+                entry.name.data = line.data + 1;
+                entry.name.size = (close != nullptr ? close : line.data + line.size) - entry.name.data;
+                entry.note = entry.body = { nullptr, 0 };
+                entry.category = category;
+                entry.state = CheatCode::Pending;
+                entry.words = entry.wordCount = 0;
+
+                code = _codes.size();
+                _codes.push_back(entry);
+                ++_categories[category].count;
+            }
+            else if (code != 0xFFFFFFFF)
+            {
+                CheatCode   &entry = _codes[code];
+
+                if (*line.data == '{' && entry.note.data == nullptr && entry.body.data == nullptr)
+                {
+                    // The note may span several lines
+                    const char  *close = static_cast<const char *>(std::memchr(line.data, '}', end - line.data));
+
+                    if (close == nullptr)
+                        close = end;
+
+                    entry.note.data = line.data + 1;
+                    entry.note.size = close - entry.note.data;
+                    next = close != end ? NextLine(close, end, line) : end;
+                }
+                else
+                {
+                    if (entry.body.data == nullptr)
+                        entry.body.data = line.data;
+                    entry.body.size = line.data + line.size - entry.body.data;
+                }
+            }
+
+            str = next;
+        }
+    }
+
+    const u32   *CheatDatabase::Compile(CheatCode &code, u32 &count)
+    {
+        MemoryTagScope  scope(MemoryTag::Cheats);
+
+        count = 0;
+        if (code.state == CheatCode::Invalid)
+            return (nullptr);
+
+        if (code.state == CheatCode::Pending)
+        {
+            const char  *str = code.body.data;
+            const char  *end = str + code.body.size;
+            u32         start = _words.size();
+
+            code.state = CheatCode::Ready;
+            while (str < end)
+            {
+                if (IsSpace(*str))
+                {
+                    ++str;
+                    continue;
+                }
+
+                // A comment inside the body
+                if (*str == ';')
+                {
+                    const char  *eol = static_cast<const char *>(std::memchr(str, '\n', end - str));
+
+                    str = eol != nullptr ? eol : end;
+                    continue;
+                }
+
+                u32     word = 0;
+                u32     digits = 0;
+
+                for (; str < end && HexValue(*str) >= 0; ++str, ++digits)
+                    word = (word << 4) | HexValue(*str);
+
+                if (digits != 8 || (str < end && !IsSpace(*str)))
+                {
+                    code.state = CheatCode::Invalid;
+                    break;
+                }
+
+                _words.push_back(word);
+            }
+
+            // Every line is a pair of words
+            u32     size = _words.size() - start;
+
+            if (size == 0 || (size & 1))
+                code.state = CheatCode::Invalid;
+
+            if (code.state == CheatCode::Invalid)
+            {
+                _words.resize(start);
+                return (nullptr);
+            }
+
+            code.words = start;
+            code.wordCount = size;
+        }
+
+        count = code.wordCount;
+        return (_words.data() + code.words);
+    }
+
+    void    CheatDatabase::Populate(MenuFolder &root, FuncPointer gameFunc)
+    {
+        std::vector<MenuFolder *>   folders(_categories.size(), nullptr);
+
+        for (CheatCode &code : _codes)
+        {
+            MenuEntry   *entry = new MenuEntry(code.name.ToString(), gameFunc, code.note.ToString());
+
+            entry->SetArg(&code);
+            if (code.category == 0)
+            {
+                root.Append(entry);
+                continue;
+            }
+
+            MenuFolder  *&folder = folders[code.category];
+
+            if (folder == nullptr)
+            {
+                folder = new MenuFolder(_categories[code.category].name.ToString());
+                root.Append(folder);
+            }
+
+            folder->Append(entry);
+        }
+    }
+
+    CheatCode   *CheatDatabase::FromEntry(MenuEntry *entry)
+    {
+        return (static_cast<CheatCode *>(entry->GetArg()));
+    }
+
+    std::vector<u64>    CheatDatabase::GetTitles(void) const
+    {
+        std::vector<u64>    titles;
+
+        for (const Section &section : _sections)
+            if (std::find(titles.begin(), titles.end(), section.titleId) == titles.end())
+                titles.push_back(section.titleId);
+
+        return (titles);
+    }
+
+    const std::vector<CheatCategory>    &CheatDatabase::GetCategories(void) const
+    {
+        return (_categories);
+    }
+
+    std::vector<CheatCode>  &CheatDatabase::GetCodes(void)
+    {
+        return (_codes);
+    }
+}
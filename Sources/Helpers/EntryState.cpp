@@ -0,0 +1,278 @@
+#include "Helpers/EntryState.hpp"
+#include "CTRPluginFramework/Menu/MenuFolder.hpp"
+#include "CTRPluginFramework/Menu/PluginMenu.hpp"
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        // A free block only overwrites next, so entry stays nullptr
+        struct Header
+        {
+            Header          *next;
+            Header          *previous;
+            MenuEntry       *entry;
+            TypeId          type;
+            StateDestructor destructor;
+            u8              sizeClass;
+            bool            persistent;
+            bool            marked;     ///< The entry was disabled at the last Collect
+        };
+
+        // Large states are allocated on the heap behind their size
+        const u32   HeapPrefix = 8;
+
+        // Sizes of the blocks, header included
+        const u32   ClassSizes[] = { 32, 48, 64, 96, 128, 192, 256, 512 };
+        const u32   ClassCount = sizeof(ClassSizes) / sizeof(ClassSizes[0]);
+        const u32   SlabCount = EntryState::ArenaSize / EntryState::SlabSize;
+        const u8    HeapClass = 0xFF;
+
+        struct FreeBlock
+        {
+            FreeBlock   *next;
+        };
+
+        alignas(8) u8   g_arena[EntryState::ArenaSize];
+        u8              g_slabClasses[SlabCount];
+        u32             g_slabsUsed = 0;
+        FreeBlock       *g_free[ClassCount];
+        Header          *g_states = nullptr;
+        std::vector<Header *>       g_heapStates;   ///< The headers of the large states, sorted
+        std::vector<MenuEntry *>    g_liveEntries;  ///< The entries of the menu at the last Collect, sorted
+        u32             g_frames = 0;
+        EntryStateStats g_stats = { 0, 0, 0, 0, 0 };
+
+        u32     ClassOf(u32 size)
+        {
+            for (u32 i = 0; i < ClassCount; ++i)
+                if (size <= ClassSizes[i])
+                    return (i);
+
+            return (HeapClass);
+        }
+
+        // Give a free slab to a size class
+        bool    Grow(u32 sizeClass)
+        {
+            if (g_slabsUsed >= SlabCount)
+                return (false);
+
+            u32     slab = g_slabsUsed++;
+            u32     size = ClassSizes[sizeClass];
+            u8      *block = g_arena + slab * EntryState::SlabSize;
+            u8      *end = block + EntryState::SlabSize - size;
+
+            g_slabClasses[slab] = sizeClass;
+            g_stats.arena += EntryState::SlabSize;
+
+            for (; block <= end; block += size)
+            {
+                FreeBlock   *free = reinterpret_cast<FreeBlock *>(block);
+
+                free->next = g_free[sizeClass];
+                g_free[sizeClass] = free;
+            }
+
+            return (true);
+        }
+
+        Header  *HeaderOf(void *state)
+        {
+            if (state == nullptr)
+                return (nullptr);
+
+            u8      *block = static_cast<u8 *>(state) - sizeof(Header);
+
+            if (block >= g_arena && block < g_arena + sizeof(g_arena))
+            {
+                u32     offset = block - g_arena;
+                u32     slab = offset / EntryState::SlabSize;
+
+                if (slab >= g_slabsUsed || (offset % EntryState::SlabSize) % ClassSizes[g_slabClasses[slab]] != 0)
+                    return (nullptr);
+
+                Header  *header = reinterpret_cast<Header *>(block);
+
+                return (header->entry != nullptr ? header : nullptr);
+            }
+
+            // Not in the arena, it may be a large state
+            Header  *header = reinterpret_cast<Header *>(block);
+            std::vector<Header *>::iterator it = std::lower_bound(g_heapStates.begin(), g_heapStates.end(), header);
+
+            return (it != g_heapStates.end() && *it == header ? header : nullptr);
+        }
+
+        bool    InArena(void *state)
+        {
+            return (state >= g_arena && state < g_arena + sizeof(g_arena));
+        }
+
+        // Add the entries of a folder and of its subfolders
+        void    GatherEntries(const std::vector<MenuEntry *> &entries, const std::vector<MenuFolder *> &folders)
+        {
+            g_liveEntries.insert(g_liveEntries.end(), entries.begin(), entries.end());
+            for (MenuFolder *folder : folders)
+                GatherEntries(folder->GetEntryList(), folder->GetFolderList());
+        }
+
+        // The entry isn't touched when it may be deleted
+        void    Free(Header *header, bool entryAlive = true)
+        {
+            u32     size = header->sizeClass == HeapClass ? 0 : ClassSizes[header->sizeClass];
+
+            header->destructor(header + 1);
+
+            if (header->previous != nullptr)
+                header->previous->next = header->next;
+            else
+                g_states = header->next;
+            if (header->next != nullptr)
+                header->next->previous = header->previous;
+
+            // Unless the entry was given another arg since
+            if (entryAlive && header->entry->GetArg() == header + 1)
+                header->entry->SetArg(nullptr);
+            header->entry = nullptr;
+            --g_stats.states;
+
+            if (header->sizeClass == HeapClass)
+            {
+                g_heapStates.erase(std::lower_bound(g_heapStates.begin(), g_heapStates.end(), header));
+
+                u8  *base = reinterpret_cast<u8 *>(header) - HeapPrefix;
+
+                g_stats.heap -= *reinterpret_cast<u32 *>(base);
+                ::operator delete(base);
+                return;
+            }
+
+            FreeBlock   *free = reinterpret_cast<FreeBlock *>(header);
+
+            g_stats.used -= size;
+            free->next = g_free[header->sizeClass];
+            g_free[header->sizeClass] = free;
+        }
+    }
+
+    void    *EntryState::Find(MenuEntry *entry, TypeId type, bool persistent)
+    {
+        void    *state = entry->GetArg();
+        Header  *header = HeaderOf(state);
+
+        // A block released by Collect while the entry was out of the menu, maybe given to another entry since
+        if ((header == nullptr && InArena(state)) || (header != nullptr && header->entry != entry))
+        {
+            entry->SetArg(nullptr);
+            return (nullptr);
+        }
+
+        // An arg that isn't a state
+        if (header == nullptr)
+            return (state);
+
+        if (header->type == type)
+        {
+            header->persistent |= persistent;
+            return (state);
+        }
+
+        ++g_stats.mismatches;
+        Free(header);
+        return (nullptr);
+    }
+
+    void    *EntryState::Allocate(MenuEntry *entry, TypeId type, u32 size, StateDestructor destructor,
+                                  bool persistent)
+    {
+        u32     total = sizeof(Header) + ((size + 7) & ~7);
+        u32     sizeClass = ClassOf(total);
+        Header  *header = nullptr;
+
+        if (sizeClass != HeapClass && (g_free[sizeClass] != nullptr || Grow(sizeClass)))
+        {
+            header = reinterpret_cast<Header *>(g_free[sizeClass]);
+            g_free[sizeClass] = g_free[sizeClass]->next;
+            g_stats.used += ClassSizes[sizeClass];
+        }
+        else
+        {
+            // Too large for a size class or the arena is full
+            u8  *base = static_cast<u8 *>(::operator new(HeapPrefix + total));
+
+            *reinterpret_cast<u32 *>(base) = total;
+            header = reinterpret_cast<Header *>(base + HeapPrefix);
+            sizeClass = HeapClass;
+            g_stats.heap += total;
+            g_heapStates.insert(std::lower_bound(g_heapStates.begin(), g_heapStates.end(), header), header);
+        }
+
+        header->entry = entry;
+        header->type = type;
+        header->destructor = destructor;
+        header->sizeClass = sizeClass;
+        header->persistent = persistent;
+        header->marked = false;
+        header->previous = nullptr;
+        header->next = g_states;
+        if (g_states != nullptr)
+            g_states->previous = header;
+        g_states = header;
+        ++g_stats.states;
+
+        entry->SetArg(header + 1);
+        return (header + 1);
+    }
+
+    void    EntryState::Release(MenuEntry *entry)
+    {
+        Header  *header = HeaderOf(entry->GetArg());
+
+        if (header != nullptr && header->entry == entry)
+            Free(header);
+    }
+
+    void    EntryState::Collect(void)
+    {
+        if (++g_frames < CollectPeriod)
+            return;
+
+        PluginMenu  *menu = PluginMenu::GetRunningInstance();
+
+        g_frames = 0;
+        if (g_states == nullptr || menu == nullptr)
+            return;
+
+        // An entry deleted without Release is no longer in the menu, its state is dropped
+        // without reading the entry
+        g_liveEntries.clear();
+        GatherEntries(menu->GetEntryList(), menu->GetFolderList());
+        std::sort(g_liveEntries.begin(), g_liveEntries.end());
+
+        // Mark the disabled entries, release them if they're still disabled on the next pass
+        for (Header *header = g_states; header != nullptr;)
+        {
+            Header  *next = header->next;
+
+            if (!std::binary_search(g_liveEntries.begin(), g_liveEntries.end(), header->entry))
+                Free(header, false);
+            else if (header->persistent || header->entry->IsActivated())
+                header->marked = false;
+            else if (header->marked)
+                Free(header);
+            else
+                header->marked = true;
+
+            header = next;
+        }
+    }
+
+    EntryStateStats EntryState::GetStats(void)
+    {
+        return (g_stats);
+    }
+}
@@ -0,0 +1,88 @@
+#include "Helpers/FileIO.hpp"
+
+namespace CTRPluginFramework
+{
+    bool    ReadFile(const std::string &path, std::vector<u8> &out)
+    {
+        File    file;
+
+        if (!RecoverFile(path) || File::Open(file, path, File::READ) != 0)
+            return (false);
+
+        u32     size = file.GetSize();
+
+        out.resize(size);
+        if (size && file.Read(out.data(), size) != 0)
+        {
+            out.clear();
+            return (false);
+        }
+
+        return (true);
+    }
+
+    bool    WriteFile(const std::string &path, const void *data, u32 size)
+    {
+        std::string     temp = path + ".tmp";
+
+        {
+            File    file;
+
+            if (File::Open(file, temp, File::WRITE | File::CREATE | File::TRUNCATE) != 0)
+                return (false);
+
+            if (size && file.Write(data, size) != 0)
+            {
+                file.Close();
+                File::Remove(temp);
+                return (false);
+            }
+
+            file.Flush();
+        }
+
+        // Renaming doesn't replace a file: keep the old one aside until the new one is in place
+        std::string     backup = path + ".bak";
+
+        if (File::Exists(backup) == 1)
+            File::Remove(backup);
+        if (File::Exists(path) == 1 && File::Rename(path, backup) != 0)
+            return (false);
+
+        if (File::Rename(temp, path) != 0)
+        {
+            File::Rename(backup, path);
+            return (false);
+        }
+
+        File::Remove(backup);
+        return (true);
+    }
+
+    bool    RecoverFile(const std::string &path)
+    {
+        std::string     backup = path + ".bak";
+
+        if (File::Exists(path) == 1)
+        {
+            // Cut after the new file was in place
+            if (File::Exists(backup) == 1)
+                File::Remove(backup);
+            return (true);
+        }
+
+        if (File::Exists(backup) != 1)
+            return (false);
+
+        // The old file is only moved once path.tmp is written and flushed
+        std::string     temp = path + ".tmp";
+
+        if (File::Exists(temp) == 1 && File::Rename(temp, path) == 0)
+        {
+            File::Remove(backup);
+            return (true);
+        }
+
+        return (File::Rename(backup, path) == 0);
+    }
+}
@@ -0,0 +1,362 @@
+#include "Helpers/Format.hpp"
+#include <cmath>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        // The two hexadecimal digits of every byte
+        const char  g_hexPairs[] =
+            "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+            "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+            "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+            "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+            "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+            "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+            "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+            "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+        // The two decimal digits of every number below 100
+        const char  g_decimalPairs[] =
+            "0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        const u32   g_powersOf10[] =
+        {
+            1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+        };
+
+        inline void     CopyPair(char *out, const char *pair)
+        {
+            out[0] = pair[0];
+            out[1] = pair[1];
+        }
+
+        // Write the digits backward from end, return the amount of digits
+        u32     WriteDecimal32(char *end, u32 value)
+        {
+            char    *p = end;
+
+            while (value >= 100)
+            {
+                u32 pair = value % 100;
+
+                value /= 100;
+                p -= 2;
+                CopyPair(p, g_decimalPairs + pair * 2);
+            }
+
+            if (value >= 10)
+            {
+                p -= 2;
+                CopyPair(p, g_decimalPairs + value * 2);
+            }
+            else
+                *--p = '0' + value;
+
+            return (end - p);
+        }
+
+        u32     WriteDecimal64(char *end, u64 value)
+        {
+            char    *p = end;
+
+            // 64 bits divisions are slow on the ARM11, split in 8 digits chunks
+            while (value > 0xFFFFFFFF)
+            {
+                u32     chunk = value % 100000000;
+                u32     digits = WriteDecimal32(p, chunk);
+
+                value /= 100000000;
+                for (p -= digits; digits < 8; ++digits)
+                    *--p = '0';
+            }
+
+            p -= WriteDecimal32(p, value);
+            return (end - p);
+        }
+
+        // Copy the digits with the sign and the padding
+        u32     Finish(char *out, const char *digits, u32 length, bool negative, u32 width, char pad)
+        {
+            char    *p = out;
+            u32     total = length + negative;
+            u32     padding = 0;
+
+            if (width > FormatMaxWidth)
+                width = FormatMaxWidth;
+            if (width > total)
+                padding = width - total;
+
+            // -0042 but   -42
+            if (negative && pad == '0')
+                *p++ = '-';
+            while (padding--)
+                *p++ = pad;
+            if (negative && pad != '0')
+                *p++ = '-';
+
+            std::memcpy(p, digits, length);
+            p += length;
+            *p = 0;
+            return (p - out);
+        }
+
+        u32     FormatInteger(char *out, u64 magnitude, bool negative, u32 width, char pad)
+        {
+            char    buffer[24];
+            char    *end = buffer + sizeof(buffer);
+            u32     length = magnitude > 0xFFFFFFFF ? WriteDecimal64(end, magnitude)
+                                                    : WriteDecimal32(end, magnitude);
+
+            return (Finish(out, end - length, length, negative, width, pad));
+        }
+
+        // Write the integer and fractional parts of a positive value
+        char    *WriteFixed(char *p, u64 integer, u32 fraction, u32 precision)
+        {
+            char    buffer[24];
+            char    *end = buffer + sizeof(buffer);
+            u32     length = WriteDecimal64(end, integer);
+
+            std::memcpy(p, end - length, length);
+            p += length;
+
+            if (precision > 0)
+            {
+                *p++ = '.';
+                length = WriteDecimal32(end, fraction);
+                for (u32 i = length; i < precision; ++i)
+                    *p++ = '0';
+                std::memcpy(p, end - length, length);
+                p += length;
+            }
+
+            return (p);
+        }
+    }
+
+    u32     FormatHex(char *out, u32 value, u32 minDigits)
+    {
+        u32     digits = 1;
+
+        for (u32 v = value >> 4; v != 0; v >>= 4)
+            ++digits;
+
+        if (minDigits > 8)
+            minDigits = 8;
+        if (digits < minDigits)
+            digits = minDigits;
+
+        char    *p = out + digits;
+        u32     count = digits;
+
+        *p = 0;
+
+        // One byte at a time from the end
+        for (; count >= 2; count -= 2, value >>= 8)
+        {
+            p -= 2;
+            CopyPair(p, g_hexPairs + (value & 0xFF) * 2);
+        }
+
+        if (count)
+            *--p = g_hexPairs[(value & 0xF) * 2 + 1];
+
+        return (digits);
+    }
+
+    u32     FormatHex(char *out, u64 value, u32 minDigits)
+    {
+        u32     high = value >> 32;
+
+        if (minDigits > 16)
+            minDigits = 16;
+
+        if (high == 0 && minDigits <= 8)
+            return (FormatHex(out, static_cast<u32>(value), minDigits));
+
+        u32     length = FormatHex(out, high, minDigits > 8 ? minDigits - 8 : 1);
+
+        return (length + FormatHex(out + length, static_cast<u32>(value), 8));
+    }
+
+    u32     FormatDecimal(char *out, u32 value, u32 width, char pad)
+    {
+        return (FormatInteger(out, value, false, width, pad));
+    }
+
+    u32     FormatDecimal(char *out, s32 value, u32 width, char pad)
+    {
+        u32     magnitude = value < 0 ? 0u - static_cast<u32>(value) : value;
+
+        return (FormatInteger(out, magnitude, value < 0, width, pad));
+    }
+
+    u32     FormatDecimal(char *out, u64 value, u32 width, char pad)
+    {
+        return (FormatInteger(out, value, false, width, pad));
+    }
+
+    u32     FormatDecimal(char *out, s64 value, u32 width, char pad)
+    {
+        u64     magnitude = value < 0 ? 0ull - static_cast<u64>(value) : value;
+
+        return (FormatInteger(out, magnitude, value < 0, width, pad));
+    }
+
+    u32     FormatFloat(char *out, double value, u32 precision, u32 width)
+    {
+        char    buffer[64];
+        char    *p = buffer;
+        bool    negative = std::signbit(value);
+        double  magnitude = negative ? -value : value;
+
+        if (precision > 9)
+            precision = 9;
+
+        if (std::isnan(value))
+        {
+            std::memcpy(p, "nan", 3);
+            p += 3;
+            negative = false;
+        }
+        else if (std::isinf(value))
+        {
+            std::memcpy(p, "inf", 3);
+            p += 3;
+        }
+        else if (magnitude < 1e19)
+        {
+            u32     scale = g_powersOf10[precision];
+            u64     integer = static_cast<u64>(magnitude);
+            u32     fraction = static_cast<u32>((magnitude - integer) * scale + 0.5);
+
+            // The rounding carried into the integer part
+            if (fraction >= scale)
+            {
+                ++integer;
+                fraction -= scale;
+            }
+
+            p = WriteFixed(p, integer, fraction, precision);
+        }
+        else
+        {
+            u32     exponent = 0;
+            u32     scale = g_powersOf10[precision];
+
+            while (magnitude >= 10.0)
+            {
+                magnitude /= 10.0;
+                ++exponent;
+            }
+
+            u32     integer = static_cast<u32>(magnitude);
+            u32     fraction = static_cast<u32>((magnitude - integer) * scale + 0.5);
+
+            if (fraction >= scale)
+            {
+                fraction -= scale;
+                if (++integer == 10)
+                {
+                    integer = 1;
+                    ++exponent;
+                }
+            }
+
+            p = WriteFixed(p, integer, fraction, precision);
+            *p++ = 'e';
+            *p++ = '+';
+            if (exponent >= 100)
+                *p++ = '0' + exponent / 100;
+            CopyPair(p, g_decimalPairs + (exponent % 100) * 2);
+            p += 2;
+        }
+
+        return (Finish(out, buffer, p - buffer, negative, width, ' '));
+    }
+
+    u32     FormatFloatBits(char *out, float value)
+    {
+        u32     bits;
+
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (FormatHex(out, bits, 8));
+    }
+
+    u32     FormatFloatBits(char *out, double value)
+    {
+        u64     bits;
+
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (FormatHex(out, bits, 16));
+    }
+
+    u32     HexDumpRowSize(u32 bytesPerRow, bool ascii)
+    {
+        // Address, 2 spaces, "XX " per byte, optional space + ascii column, new line
+        return (10 + bytesPerRow * 3 + (ascii ? 1 + bytesPerRow : 0) + 1);
+    }
+
+    u32     HexDump(char *out, u32 outSize, const void *data, u32 size, u32 address,
+                    u32 bytesPerRow, bool ascii)
+    {
+        if (outSize == 0)
+            return (0);
+
+        if (bytesPerRow == 0)
+            bytesPerRow = 16;
+
+        const u8    *src = static_cast<const u8 *>(data);
+        u32         rowSize = HexDumpRowSize(bytesPerRow, ascii);
+        char        *p = out;
+
+        for (u32 offset = 0; offset < size; offset += bytesPerRow)
+        {
+            // Keep room for the NUL terminator
+            if (static_cast<u32>(p - out) + rowSize >= outSize)
+                break;
+
+            u32     count = size - offset < bytesPerRow ? size - offset : bytesPerRow;
+            char    *text = p + 10 + bytesPerRow * 3 + 1;
+
+            p += FormatHex(p, address + offset, 8);
+            *p++ = ' ';
+            *p++ = ' ';
+
+            for (u32 i = 0; i < bytesPerRow; ++i, p += 3)
+            {
+                if (i < count)
+                {
+                    u8  byte = src[offset + i];
+
+                    CopyPair(p, g_hexPairs + byte * 2);
+                    if (ascii)
+                        text[i] = byte >= 0x20 && byte < 0x7F ? byte : '.';
+                }
+                else
+                {
+                    p[0] = p[1] = ' ';
+                    if (ascii)
+                        text[i] = ' ';
+                }
+                p[2] = ' ';
+            }
+
+            if (ascii)
+            {
+                *p = ' ';
+                p += 1 + bytesPerRow;
+            }
+
+            *p++ = '\n';
+        }
+
+        *p = 0;
+        return (p - out);
+    }
+}
@@ -0,0 +1,282 @@
+#include "Helpers/FrameScheduler.hpp"
+#include "Helpers/Profiler.hpp"
+#include "Helpers/Ticks.hpp"
+#include <algorithm>
+
+namespace CTRPluginFramework
+{
+    FrameScheduler  FrameScheduler::_instance;
+
+    namespace
+    {
+        const u32   DefaultBudget = 2000;
+
+        // Estimated cost of a task before it was measured, in microseconds
+        const u32   InitialEstimates[] = { 20, 250, 1000 };
+    }
+
+    FrameScheduler::FrameScheduler(void) :
+        _budget(MicrosecondsToTicks(DefaultBudget)), _frame(0), _lastFrameTime(0),
+        _framesOverBudget(0), _onOverrun(nullptr), _running(false)
+    {
+    }
+
+    FrameScheduler  &FrameScheduler::GetInstance(void)
+    {
+        return (_instance);
+    }
+
+    void    FrameScheduler::SetBudget(u32 microseconds)
+    {
+        _budget = MicrosecondsToTicks(microseconds);
+    }
+
+    u32     FrameScheduler::GetBudget(void) const
+    {
+        return (TicksToMicroseconds(_budget));
+    }
+
+    void    FrameScheduler::Add(MenuEntry *entry, FuncPointer func, TaskRate rate, TaskCost cost)
+    {
+        if (func == nullptr)
+            return;
+
+        Task    task;
+
+        task.entry = entry;
+        task.func = func;
+        task.rate = rate;
+        task.cost = cost;
+        task.active = false;
+        task.stopped = false;
+        task.deferred = 0;
+        task.lastFrame = 0;
+        task.lastTick = 0;
+        task.estimate = MicrosecondsToTicks(InitialEstimates[static_cast<u32>(cost)]);
+        task.stats = TaskStats{ entry, 0, 0, 0, 0, 0 };
+
+        // The tasks of Run are referenced until it returns
+        if (_running)
+            _pending.push_back(task);
+        else
+            Insert(task);
+    }
+
+    void    FrameScheduler::Add(MenuFolder &folder, FuncPointer func, TaskRate rate, TaskCost cost)
+    {
+        for (MenuEntry *entry : folder.GetEntryList())
+            Add(entry, func, rate, cost);
+
+        for (MenuFolder *subfolder : folder.GetFolderList())
+            Add(*subfolder, func, rate, cost);
+    }
+
+    void    FrameScheduler::Remove(MenuEntry *entry)
+    {
+        if (_running)
+        {
+            Task    removal = Task();
+
+            removal.entry = entry;
+            _pending.push_back(removal);
+        }
+        else
+            Erase(entry);
+    }
+
+    void    FrameScheduler::Run(void)
+    {
+        u64     start = GetTicks();
+
+        ++_frame;
+        _due.clear();
+        _running = true;
+
+        for (u32 i = 0; i < _tasks.size(); ++i)
+        {
+            Task    &task = _tasks[i];
+            bool    active = task.entry == nullptr || task.entry->IsActivated();
+
+            if (!active)
+            {
+                // Like the menu: one last call once the entry is deactivated
+                if (task.active)
+                {
+                    task.active = false;
+                    task.func(task.entry);
+                }
+                task.stopped = false;
+                continue;
+            }
+
+            // Switched off and on again since the last frame, it starts over
+            if (task.active && task.stopped)
+            {
+                task.active = false;
+                task.func(task.entry);
+            }
+
+            if (!task.active)
+            {
+                // Start now, but stagger the tasks sharing a period across its frames
+                task.active = true;
+                task.stopped = false;
+                task.deferred = 0;
+                task.lastFrame = task.rate.frames ? _frame - task.rate.frames + i % task.rate.frames : 0;
+                task.lastTick = start - MicrosecondsToTicks(task.rate.interval);
+            }
+
+            if (IsDue(task, start))
+                _due.push_back(i);
+        }
+
+        // Light tasks first, then the ones waiting the longest, then the cheapest
+        std::sort(_due.begin(), _due.end(), [this](u32 left, u32 right)
+        {
+            const Task  &a = _tasks[left];
+            const Task  &b = _tasks[right];
+
+            if ((a.cost == TaskCost::Light) != (b.cost == TaskCost::Light))
+                return (a.cost == TaskCost::Light);
+            if (a.deferred != b.deferred)
+                return (a.deferred > b.deferred);
+            return (a.estimate < b.estimate);
+        });
+
+        for (u32 index : _due)
+        {
+            Task    &task = _tasks[index];
+            u64     elapsed = GetTicks() - start;
+
+            if (task.cost != TaskCost::Light && task.deferred < MaxDeferrals && elapsed + task.estimate > _budget)
+            {
+                ++task.deferred;
+                ++task.stats.deferrals;
+                continue;
+            }
+
+            Execute(task, start);
+        }
+
+        _running = false;
+
+        // Applied in their order, an entry added then removed ends up removed
+        for (const Task &task : _pending)
+        {
+            if (task.func != nullptr)
+                Insert(task);
+            else
+                Erase(task.entry);
+        }
+
+        _pending.clear();
+
+        u64     total = GetTicks() - start;
+
+        _lastFrameTime = TicksToMicroseconds(total);
+        if (total > _budget)
+            ++_framesOverBudget;
+    }
+
+    void    FrameScheduler::SetOverrunCallback(OverrunCallback callback)
+    {
+        _onOverrun = callback;
+    }
+
+    void    FrameScheduler::GetStats(std::vector<TaskStats> &out) const
+    {
+        out.clear();
+        for (const Task &task : _tasks)
+        {
+            out.push_back(task.stats);
+            out.back().average = TicksToMicroseconds(task.estimate);
+        }
+    }
+
+    u32     FrameScheduler::LastFrameTime(void) const
+    {
+        return (_lastFrameTime);
+    }
+
+    u32     FrameScheduler::FramesOverBudget(void) const
+    {
+        return (_framesOverBudget);
+    }
+
+    void    FrameScheduler::Insert(const Task &task)
+    {
+        if (task.entry != nullptr)
+            task.entry->SetGameFunc(Trampoline);
+
+        _tasks.push_back(task);
+    }
+
+    void    FrameScheduler::Erase(MenuEntry *entry)
+    {
+        auto    isEntry = [entry](const Task &task) { return (task.entry == entry); };
+        auto    first = std::find_if(_tasks.begin(), _tasks.end(), isEntry);
+
+        if (first == _tasks.end())
+            return;
+
+        // The menu calls the entry again
+        if (entry != nullptr)
+            entry->SetGameFunc(first->func);
+
+        _tasks.erase(std::remove_if(first, _tasks.end(), isEntry), _tasks.end());
+    }
+
+    void    FrameScheduler::Trampoline(MenuEntry *entry)
+    {
+        // Called by the menu every frame while the entry is activated, Run does the work.
+        // Only the last call, once it's deactivated, tells something Run could miss
+        if (entry->IsActivated())
+            return;
+
+        for (Task &task : _instance._tasks)
+            if (task.entry == entry)
+                task.stopped = true;
+    }
+
+    bool    FrameScheduler::IsDue(const Task &task, u64 now) const
+    {
+        if (task.deferred > 0)
+            return (true);
+
+        if (task.rate.frames)
+            return (_frame - task.lastFrame >= task.rate.frames);
+
+        return (now - task.lastTick >= MicrosecondsToTicks(task.rate.interval));
+    }
+
+    void    FrameScheduler::Execute(Task &task, u64 frameStart)
+    {
+        PROFILE_ZONE(task.entry ? task.entry->Name().c_str() : "FrameScheduler");
+
+        u64     before = GetTicks();
+
+        task.func(task.entry);
+
+        u64     after = GetTicks();
+        u64     cost = after - before;
+        u32     microseconds = TicksToMicroseconds(cost);
+
+        // Moving average over ~8 runs
+        task.estimate = (task.estimate * 7 + cost) / 8;
+        task.deferred = 0;
+        task.lastFrame = _frame;
+        task.lastTick = before;
+
+        ++task.stats.runs;
+        if (microseconds > task.stats.max)
+            task.stats.max = microseconds;
+
+        // The task crossed the budget
+        if (after - frameStart > _budget && before - frameStart <= _budget)
+        {
+            ++task.stats.overruns;
+            if (_onOverrun != nullptr)
+                _onOverrun(task.entry, microseconds);
+        }
+    }
+}
@@ -0,0 +1,295 @@
+#include "Helpers/FreezeTable.hpp"
+#include "Helpers/MenuEntryHelpers.hpp"
+#include "Helpers/Profiler.hpp"
+#include "Helpers/RegionMap.hpp"
+#include <algorithm>
+
+namespace CTRPluginFramework
+{
+    FreezeTable     FreezeTable::_instance;
+
+    namespace
+    {
+        // The lowest address of the game, Apply writes relative to it
+        const u32   GameBase = 0x00100000;
+
+        struct SortKey
+        {
+            FreezeCondition condition;
+            u32             address;
+            u32             serial;
+            u32             slot;
+        };
+    }
+
+    FreezeTable::FreezeTable(void) :
+        _count(0), _serial(0), _checked(0), _dirty(false)
+    {
+    }
+
+    FreezeTable     &FreezeTable::GetInstance(void)
+    {
+        return (_instance);
+    }
+
+    u32     FreezeTable::Add(u32 address, u32 value, u32 width, FreezeCondition condition)
+    {
+        if ((width != 1 && width != 2 && width != 4) || (address & (width - 1)))
+            return (InvalidHandle);
+
+        u32     slot;
+
+        if (!_freeSlots.empty())
+        {
+            slot = _freeSlots.back();
+            _freeSlots.pop_back();
+        }
+        else
+        {
+            slot = _locks.size();
+            _locks.push_back(Lock{ 0, 0, nullptr, 0, 0, 0, false });
+        }
+
+        Lock    &lock = _locks[slot];
+
+        lock.address = address;
+        lock.value = value;
+        lock.condition = condition;
+        lock.serial = _serial++;
+        lock.width = width;
+        lock.used = true;
+
+        ++_count;
+        _dirty = true;
+        return ((static_cast<u32>(lock.generation) << 16) | slot);
+    }
+
+    bool    FreezeTable::Set(u32 handle, u32 value)
+    {
+        u32     slot = handle & 0xFFFF;
+
+        if (slot >= _locks.size() || !_locks[slot].used || _locks[slot].generation != handle >> 16)
+            return (false);
+
+        if (_locks[slot].value != value)
+        {
+            _locks[slot].value = value;
+            _dirty = true;
+        }
+
+        return (true);
+    }
+
+    bool    FreezeTable::Set(u32 handle, u32 address, u32 value)
+    {
+        u32     slot = handle & 0xFFFF;
+
+        if (slot >= _locks.size() || !_locks[slot].used || _locks[slot].generation != handle >> 16
+            || (address & (_locks[slot].width - 1)))
+            return (false);
+
+        if (_locks[slot].address != address)
+        {
+            _locks[slot].address = address;
+            _dirty = true;
+        }
+
+        return (Set(handle, value));
+    }
+
+    void    FreezeTable::Remove(u32 handle)
+    {
+        u32     slot = handle & 0xFFFF;
+
+        if (slot >= _locks.size() || !_locks[slot].used || _locks[slot].generation != handle >> 16)
+            return;
+
+        _locks[slot].used = false;
+        ++_locks[slot].generation;
+        _freeSlots.push_back(slot);
+        --_count;
+        _dirty = true;
+    }
+
+    void    FreezeTable::Clear(void)
+    {
+        for (u32 slot = 0; slot < _locks.size(); ++slot)
+            if (_locks[slot].used)
+                Remove((static_cast<u32>(_locks[slot].generation) << 16) | slot);
+    }
+
+    u32     FreezeTable::Apply(void)
+    {
+        PROFILE_ZONE("FreezeTable");
+
+        RegionMap   &regions = RegionMap::Game();
+        u32         generation = regions.Generation();
+
+        if (_dirty)
+            Compile();
+
+        // Only checked again when the memory layout changed, a frame costs no lookup otherwise
+        if (_checked != generation)
+        {
+            for (Run &run : _runs)
+                run.writable = run.address >= GameBase && regions.IsWritable(run.address, run.size);
+            _checked = generation;
+        }
+
+        return (Write(reinterpret_cast<u8 *>(GameBase), GameBase));
+    }
+
+    u32     FreezeTable::Apply(u8 *memory, u32 base, u32 size)
+    {
+        PROFILE_ZONE("FreezeTable");
+
+        if (_dirty)
+            Compile();
+
+        for (Run &run : _runs)
+            run.writable = run.address >= base && run.address - base + run.size <= size;
+
+        // The flags no longer describe the game
+        _checked = 0;
+        return (Write(memory, base));
+    }
+
+    u32     FreezeTable::Write(u8 *memory, u32 base)
+    {
+        // Locals: the writes to memory could alias the members otherwise
+        const Run       *run = _runs.data();
+        const Run       *end = run + _runs.size();
+        const u8        *image = _image.data();
+        FreezeCondition condition = nullptr;
+        bool            enabled = true;
+        u32             written = 0;
+
+        for (; run != end; ++run)
+        {
+            // The runs are grouped by condition, each condition is called once
+            if (run->condition != condition)
+            {
+                condition = run->condition;
+                enabled = condition == nullptr || condition();
+            }
+
+            if (!enabled || !run->writable)
+                continue;
+
+            u8          *dst = memory + (run->address - base);
+            const u8    *src = image + run->offset;
+            u32         size = run->size;
+
+            // Compare and write word per word, only the words which differ are written
+            if (((run->address | size) & 3) == 0)
+            {
+                u32         *dstWords = reinterpret_cast<u32 *>(dst);
+                const u32   *srcWords = reinterpret_cast<const u32 *>(src);
+
+                for (u32 i = 0; i < size / 4; ++i)
+                {
+                    if (dstWords[i] != srcWords[i])
+                    {
+                        dstWords[i] = srcWords[i];
+                        written += 4;
+                    }
+                }
+            }
+            else
+            {
+                for (u32 i = 0; i < size; ++i)
+                {
+                    if (dst[i] != src[i])
+                    {
+                        dst[i] = src[i];
+                        ++written;
+                    }
+                }
+            }
+        }
+
+        return (written);
+    }
+
+    u32     FreezeTable::Count(void) const
+    {
+        return (_count);
+    }
+
+    u32     FreezeTable::RunCount(void)
+    {
+        if (_dirty)
+            Compile();
+
+        return (_runs.size());
+    }
+
+    void    FreezeTable::Compile(void)
+    {
+        std::vector<SortKey>    keys;
+
+        keys.reserve(_count);
+        for (u32 slot = 0; slot < _locks.size(); ++slot)
+            if (_locks[slot].used)
+                keys.push_back(SortKey{ _locks[slot].condition, _locks[slot].address, _locks[slot].serial, slot });
+
+        std::sort(keys.begin(), keys.end(), [](const SortKey &left, const SortKey &right)
+        {
+            if (left.condition != right.condition)
+                return (left.condition < right.condition);
+            if (left.address != right.address)
+                return (left.address < right.address);
+            return (left.serial < right.serial);
+        });
+
+        _runs.clear();
+        _image.clear();
+
+        for (const SortKey &key : keys)
+        {
+            const Lock  &lock = _locks[key.slot];
+            Run         *run = _runs.empty() ? nullptr : &_runs.back();
+
+            // Starts a new run unless it touches the previous one
+            if (run == nullptr || run->condition != lock.condition || lock.address > run->address + run->size)
+            {
+                // Keep the bytes of each run aligned for the word copies
+                _image.resize((_image.size() + 3) & ~3u);
+                _runs.push_back(Run{ lock.address, 0, static_cast<u32>(_image.size()), lock.condition, false });
+                run = &_runs.back();
+            }
+
+            u32     end = lock.address + lock.width;
+
+            if (end > run->address + run->size)
+            {
+                _image.resize(_image.size() + end - (run->address + run->size));
+                run->size = end - run->address;
+            }
+
+            // Overlapping locks: the last one wins, little endian like the game
+            std::memcpy(_image.data() + run->offset + (lock.address - run->address), &lock.value, lock.width);
+        }
+
+        _checked = 0;
+        _dirty = false;
+    }
+
+    void    FreezeEntry(MenuEntry *entry, u32 address, u32 value, u32 width, FreezeCondition condition)
+    {
+        FreezeTable &table = FreezeTable::GetInstance();
+        u32         *handle = GetArg<u32>(entry, FreezeTable::InvalidHandle);
+
+        if (!entry->IsActivated())
+        {
+            table.Remove(*handle);
+            *handle = FreezeTable::InvalidHandle;
+            return;
+        }
+
+        if (*handle == FreezeTable::InvalidHandle)
+            *handle = table.Add(address, value, width, condition);
+        else
+            table.Set(*handle, address, value);
+    }
+}
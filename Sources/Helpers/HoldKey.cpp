@@ -1,40 +1,25 @@
 #include "Helpers/HoldKey.hpp"
+#include "Helpers/InputDispatcher.hpp"
 
 namespace CTRPluginFramework
 {
     HoldKey::HoldKey(u32 keys, Time holdTime) :
-        _goal(holdTime), _isHold(false), _keys(keys)
+        _handle(InputDispatcher::GetInstance().AddHold(keys, holdTime, true))
     {
     }
 
-    bool    HoldKey::operator()(void)
+    HoldKey::~HoldKey(void)
     {
-        bool isHold = Controller::IsKeysDown(_keys);
-
-        // If currently hold
-        if (isHold && _isHold && _timer.HasTimePassed(_goal))
-        {
-            _isHold = false;
-            return (true);
-        }
-        
-        
-
-        if (isHold && !_isHold)
-        {
-            _isHold = true;
-            _timer.Restart();
-        }
-        else if (_isHold && !isHold)
-            _isHold = false;
+        InputDispatcher::GetInstance().Remove(_handle);
+    }
 
-        return (false);
+    bool    HoldKey::operator()(void)
+    {
+        return (InputDispatcher::GetInstance().Fired(_handle));
     }
 
     void HoldKey::operator=(u32 newKeys)
     {
-        _keys = newKeys;
-        _isHold = false;
-        _timer.Restart();
+        InputDispatcher::GetInstance().SetKeys(_handle, newKeys);
     }
 }
@@ -0,0 +1,218 @@
+#include "Helpers/Hook.hpp"
+#include "Helpers/ArmCode.hpp"
+#include "CTRPluginFramework.hpp"
+#include "csvc.h"
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        u32     g_caveMemory[CodeCave::SlotCount * CodeCave::SlotSize / 4] __attribute__((aligned(CodeCave::SlotSize)));
+        u32     g_caveUsed[CodeCave::SlotCount / 32];
+        bool    g_caveExecutable = false;
+
+        inline bool     IsUsed(u32 slot)
+        {
+            return ((g_caveUsed[slot >> 5] >> (slot & 31)) & 1);
+        }
+
+        void    SetUsed(u32 first, u32 count, bool used)
+        {
+            for (u32 slot = first; slot < first + count; ++slot)
+            {
+                if (used)
+                    g_caveUsed[slot >> 5] |= 1u << (slot & 31);
+                else
+                    g_caveUsed[slot >> 5] &= ~(1u << (slot & 31));
+            }
+        }
+
+        // Saves the registers, calls the callback, then either runs the trampoline or returns
+        const u32   g_stub[] =
+        {
+            0xE92D5FFF,     // stmfd sp!, {r0-r12, lr}
+            0xE10F0000,     // mrs r0, cpsr
+            0xE52D0008,     // str r0, [sp, #-8]!
+            0xE1A0000D,     // mov r0, sp
+            0xE59FC028,     // ldr r12, =callback
+            0xE12FFF3C,     // blx r12
+            0xE3500000,     // cmp r0, #0
+            0x0A000003,     // beq skip
+            0xE49D1008,     // ldr r1, [sp], #8
+            0xE128F001,     // msr cpsr_f, r1
+            0xE8BD5FFF,     // ldmfd sp!, {r0-r12, lr}
+            0xE59FF010,     // ldr pc, =trampoline
+                            // skip:
+            0xE49D1008,     // ldr r1, [sp], #8
+            0xE128F001,     // msr cpsr_f, r1
+            0xE8BD5FFF,     // ldmfd sp!, {r0-r12, lr}
+            0xE12FFF1E,     // bx lr
+        };
+
+        const u32   StubCallback = 16;
+        const u32   StubTrampoline = 17;
+    }
+
+    void    *CodeCave::Allocate(u32 size)
+    {
+        u32     count = (size + SlotSize - 1) / SlotSize;
+
+        if (count == 0 || count > SlotCount)
+            return (nullptr);
+
+        // The plugin's memory must be executable
+        if (!g_caveExecutable)
+        {
+            svcControlProcess(Process::GetHandle(), PROCESSOP_SET_MMU_TO_RWX, 0, 0);
+            g_caveExecutable = true;
+        }
+
+        for (u32 first = 0; first + count <= SlotCount; ++first)
+        {
+            u32     run = 0;
+
+            while (run < count && !IsUsed(first + run))
+                ++run;
+
+            if (run == count)
+            {
+                SetUsed(first, count, true);
+                return (reinterpret_cast<u8 *>(g_caveMemory) + first * SlotSize);
+            }
+
+            first += run;
+        }
+
+        return (nullptr);
+    }
+
+    void    CodeCave::Free(void *cave, u32 size)
+    {
+        u32     offset = static_cast<u8 *>(cave) - reinterpret_cast<u8 *>(g_caveMemory);
+
+        if (cave == nullptr || offset >= sizeof(g_caveMemory))
+            return;
+
+        SetUsed(offset / SlotSize, (size + SlotSize - 1) / SlotSize, false);
+    }
+
+    u32     CodeCave::FreeSlots(void)
+    {
+        u32     count = 0;
+
+        for (u32 slot = 0; slot < SlotCount; ++slot)
+            count += !IsUsed(slot);
+
+        return (count);
+    }
+
+    Hook::Hook(void) :
+        _cave(nullptr), _original(0)
+    {
+    }
+
+    Hook::~Hook(void)
+    {
+        Uninstall();
+    }
+
+    bool    Hook::Install(u32 address, HookCallback callback)
+    {
+        if (_cave != nullptr || callback == nullptr)
+            return (false);
+
+        bool    thumb = address & 1;
+
+        address &= ~1u;
+
+        // ARM: ldr pc, [pc, #-4]; .word stub
+        // Thumb: bx pc must be aligned to 4 to switch to the ARM jump
+        u32     detourSize = thumb ? (address & 2 ? 14 : 12) : 8;
+        u8      original[16];
+
+        if (!PatchTarget::Game().Read(address, original, sizeof(original)))
+            return (false);
+
+        u32     *cave = static_cast<u32 *>(CodeCave::Allocate(CaveSize));
+
+        if (cave == nullptr)
+            return (false);
+
+        u32     *trampoline = cave + StubWords;
+        u32     consumed = detourSize;
+        u32     written;
+
+        if (thumb)
+            written = ArmCode::RelocateThumb(reinterpret_cast<const u16 *>(original), address, detourSize,
+                        reinterpret_cast<u16 *>(trampoline), TrampolineWords * 2, true, consumed);
+        else
+            written = ArmCode::RelocateArm(reinterpret_cast<const u32 *>(original), address, 2,
+                        trampoline, TrampolineWords, true);
+
+        if (written == 0)
+        {
+            CodeCave::Free(cave, CaveSize);
+            return (false);
+        }
+
+        u32     stub = static_cast<u32>(reinterpret_cast<uintptr_t>(cave));
+
+        std::memcpy(cave, g_stub, sizeof(g_stub));
+        cave[StubCallback] = static_cast<u32>(reinterpret_cast<uintptr_t>(callback));
+        cave[StubTrampoline] = static_cast<u32>(reinterpret_cast<uintptr_t>(trampoline)) | thumb;
+        PatchTarget::Game().Flush(stub, CaveSize);
+
+        u16     detour[8];
+        u32     count = 0;
+
+        if (thumb)
+        {
+            if (address & 2)
+                detour[count++] = ArmCode::ThumbNop;
+            detour[count++] = 0x4778;   // bx pc
+            detour[count++] = ArmCode::ThumbNop;
+        }
+
+        detour[count++] = 0xF004;       // ldr pc, [pc, #-4]
+        detour[count++] = 0xE51F;
+        detour[count++] = stub & 0xFFFF;
+        detour[count++] = stub >> 16;
+
+        // A relocated instruction may go past the detour
+        while (count * 2 < consumed)
+            detour[count++] = ArmCode::ThumbNop;
+
+        if (!_patch.Add(address, detour, consumed, original).Apply())
+        {
+            _patch.Clear();
+            CodeCave::Free(cave, CaveSize);
+            return (false);
+        }
+
+        _cave = cave;
+        _original = static_cast<u32>(reinterpret_cast<uintptr_t>(trampoline)) | thumb;
+        return (true);
+    }
+
+    void    Hook::Uninstall(void)
+    {
+        if (_cave == nullptr)
+            return;
+
+        _patch.Clear();
+        CodeCave::Free(_cave, CaveSize);
+        _cave = nullptr;
+        _original = 0;
+    }
+
+    bool    Hook::IsInstalled(void) const
+    {
+        return (_cave != nullptr);
+    }
+
+    u32     Hook::Original(void) const
+    {
+        return (_original);
+    }
+}
@@ -0,0 +1,428 @@
+#include "Helpers/InputDispatcher.hpp"
+#include "Helpers/InputRecorder.hpp"
+#include "Helpers/Ticks.hpp"
+#include <algorithm>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        u64     ToTicks(Time time)
+        {
+            s64     microseconds = time.AsMicroseconds();
+
+            return (microseconds > 0 ? static_cast<u64>(microseconds) * TicksPerMicrosecond : 0);
+        }
+
+        void    Erase(std::vector<u16> &slots, u32 slot)
+        {
+            std::vector<u16>::iterator  it = std::find(slots.begin(), slots.end(), slot);
+
+            if (it != slots.end())
+            {
+                *it = slots.back();
+                slots.pop_back();
+            }
+        }
+
+        class ControllerSource : public InputSource
+        {
+        public:
+            u32     Sample(void) override
+            {
+                return (CTRPluginFramework::Controller::GetKeysDown());
+            }
+        };
+    }
+
+    u64     InputSource::Ticks(void)
+    {
+        return (GetTicks());
+    }
+
+    InputSource &InputSource::Controller(void)
+    {
+        static ControllerSource     controller;
+
+        return (controller);
+    }
+
+    InputDispatcher::InputDispatcher(void) :
+        _source(nullptr), _recorder(nullptr), _held(0), _pressed(0), _released(0), _frame(0), _now(0)
+    {
+    }
+
+    InputDispatcher &InputDispatcher::GetInstance(void)
+    {
+        // Constructed on first use: HoldKey and KeySequence register from static constructors
+        static InputDispatcher  instance;
+
+        return (instance);
+    }
+
+    u32     InputDispatcher::Add(InputTrigger trigger, u32 keys, u64 duration, InputCallback callback, void *arg)
+    {
+        if (keys == 0)
+            return (InvalidHandle);
+
+        u32     slot = 0;
+
+        while (slot < _bindings.size() && _bindings[slot].used)
+            ++slot;
+
+        if (slot == _bindings.size())
+        {
+            if (slot > 0xFFFF)
+                return (InvalidHandle);
+
+            _bindings.push_back(Binding());
+            _bindings[slot].generation = 0;
+        }
+
+        Binding     &binding = _bindings[slot];
+
+        binding.used = true;
+        binding.fired = 0;
+        binding.armed = false;
+        binding.repeat = false;
+        binding.trigger = trigger;
+        binding.step = 0;
+        binding.keys = keys;
+        binding.stamp = _frame;
+        binding.duration = duration;
+        binding.since = 0;
+        binding.callback = callback;
+        binding.arg = arg;
+        binding.steps.clear();
+
+        Link(slot);
+        Arm(slot);
+        return ((static_cast<u32>(binding.generation) << 16) | slot);
+    }
+
+    u32     InputDispatcher::AddCombo(u32 keys, InputCallback callback, void *arg)
+    {
+        return (Add(InputTrigger::Combo, keys, 0, callback, arg));
+    }
+
+    u32     InputDispatcher::AddHold(u32 keys, Time duration, bool repeat, InputCallback callback, void *arg)
+    {
+        u32     handle = Add(InputTrigger::Hold, keys, ToTicks(duration), callback, arg);
+
+        if (handle != InvalidHandle)
+            _bindings[handle & 0xFFFF].repeat = repeat;
+        return (handle);
+    }
+
+    u32     InputDispatcher::AddDoubleTap(u32 key, Time window, InputCallback callback, void *arg)
+    {
+        return (Add(InputTrigger::DoubleTap, key, ToTicks(window), callback, arg));
+    }
+
+    u32     InputDispatcher::AddSequence(const std::vector<u32> &steps, Time timeout, InputCallback callback, void *arg)
+    {
+        u32     keys = 0;
+
+        for (u32 step : steps)
+        {
+            if (step == 0)
+                return (InvalidHandle);
+            keys |= step;
+        }
+
+        u32     handle = Add(InputTrigger::Sequence, keys, ToTicks(timeout), callback, arg);
+
+        if (handle != InvalidHandle)
+            _bindings[handle & 0xFFFF].steps = steps;
+        return (handle);
+    }
+
+    InputDispatcher::Binding    *InputDispatcher::Find(u32 handle)
+    {
+        u32     slot = handle & 0xFFFF;
+
+        if (slot >= _bindings.size() || !_bindings[slot].used || _bindings[slot].generation != handle >> 16)
+            return (nullptr);
+
+        return (&_bindings[slot]);
+    }
+
+    bool    InputDispatcher::SetKeys(u32 handle, u32 keys)
+    {
+        Binding     *binding = Find(handle);
+        u32         slot = handle & 0xFFFF;
+
+        if (binding == nullptr || keys == 0 || binding->trigger == InputTrigger::Sequence)
+            return (false);
+
+        Disarm(slot);
+        Unlink(slot);
+        binding->keys = keys;
+        binding->step = 0;
+        binding->fired = 0;
+        Link(slot);
+        Arm(slot);
+        return (true);
+    }
+
+    void    InputDispatcher::Remove(u32 handle)
+    {
+        Binding     *binding = Find(handle);
+        u32         slot = handle & 0xFFFF;
+
+        if (binding == nullptr)
+            return;
+
+        Disarm(slot);
+        Unlink(slot);
+        binding->used = false;
+        binding->callback = nullptr;
+        binding->steps.clear();
+        ++binding->generation;
+    }
+
+    void    InputDispatcher::Clear(void)
+    {
+        for (u32 slot = 0; slot < _bindings.size(); ++slot)
+            if (_bindings[slot].used)
+                Remove((static_cast<u32>(_bindings[slot].generation) << 16) | slot);
+    }
+
+    bool    InputDispatcher::Fired(u32 handle)
+    {
+        Binding     *binding = Find(handle);
+
+        // A flag older than the last update is stale
+        if (binding == nullptr || binding->fired == 0 || binding->fired != _frame)
+            return (false);
+
+        binding->fired = 0;
+        return (true);
+    }
+
+    void    InputDispatcher::Update(void)
+    {
+        InputSource &source = _source != nullptr ? *_source : InputSource::Controller();
+        u32         keys = source.Sample();
+        u64         ticks = source.Ticks();
+
+        if (_recorder != nullptr)
+            _recorder->Record(keys, ticks);
+
+        Update(keys, ticks);
+    }
+
+    void    InputDispatcher::Update(u32 keys, u64 ticks)
+    {
+        _pressed = keys & ~_held;
+        _released = _held & ~keys;
+        _held = keys;
+        _now = ticks;
+        ++_frame;
+
+        // Gather the bindings listening to a key that changed, once each
+        _touched.clear();
+        for (u32 changed = _pressed | _released; changed != 0; changed &= changed - 1)
+        {
+            for (u16 slot : _byKey[__builtin_ctz(changed)])
+            {
+                Binding     &binding = _bindings[slot];
+
+                if (binding.stamp != _frame)
+                {
+                    binding.stamp = _frame;
+                    _touched.push_back(slot);
+                }
+            }
+        }
+
+        for (u16 slot : _touched)
+            Evaluate(slot);
+
+        // Then the holds whose keys are down
+        for (u32 i = 0; i < _armed.size();)
+        {
+            u32         slot = _armed[i];
+            Binding     &binding = _bindings[slot];
+
+            if (_now - binding.since < binding.duration)
+            {
+                ++i;
+                continue;
+            }
+
+            Fire(slot);
+            if (binding.repeat)
+            {
+                binding.since = _now;
+                ++i;
+            }
+            else
+            {
+                binding.armed = false;
+                _armed[i] = _armed.back();
+                _armed.pop_back();
+            }
+        }
+
+        if (_fires.empty())
+            return;
+
+        // Callbacks run last so they can add or remove bindings
+        for (u32 i = 0; i < _fires.size(); ++i)
+        {
+            Binding     *binding = Find(_fires[i]);
+
+            if (binding != nullptr && binding->callback != nullptr)
+                binding->callback(binding->arg);
+        }
+
+        _fires.clear();
+    }
+
+    void    InputDispatcher::Evaluate(u32 slot)
+    {
+        Binding     &binding = _bindings[slot];
+        bool        down = (_held & binding.keys) == binding.keys;
+
+        switch (binding.trigger)
+        {
+        case InputTrigger::Combo:
+            if (down && (_pressed & binding.keys))
+                Fire(slot);
+            break;
+
+        case InputTrigger::Hold:
+            if (down && !binding.armed && (_pressed & binding.keys))
+            {
+                binding.armed = true;
+                binding.since = _now;
+                _armed.push_back(slot);
+            }
+            else if (!down)
+                Disarm(slot);
+            break;
+
+        case InputTrigger::DoubleTap:
+            if (!(_pressed & binding.keys))
+                break;
+
+            if (binding.step == 1 && _now - binding.since <= binding.duration)
+            {
+                binding.step = 0;
+                Fire(slot);
+            }
+            else
+            {
+                binding.step = 1;
+                binding.since = _now;
+            }
+            break;
+
+        case InputTrigger::Sequence:
+        {
+            if (!(_pressed & binding.keys))
+                break;
+
+            if (binding.step > 0 && _now - binding.since > binding.duration)
+                binding.step = 0;
+
+            u32     expected = binding.steps[binding.step];
+
+            // A wrong key restarts the sequence, maybe as its first step
+            if (!(_pressed & expected) || (_held & expected) != expected)
+            {
+                binding.step = 0;
+                expected = binding.steps[0];
+                if (!(_pressed & expected) || (_held & expected) != expected)
+                    break;
+            }
+
+            binding.since = _now;
+            if (++binding.step >= binding.steps.size())
+            {
+                binding.step = 0;
+                Fire(slot);
+            }
+            break;
+        }
+        }
+    }
+
+    void    InputDispatcher::Fire(u32 slot)
+    {
+        Binding     &binding = _bindings[slot];
+
+        binding.fired = _frame;
+        if (binding.callback != nullptr)
+            _fires.push_back((static_cast<u32>(binding.generation) << 16) | slot);
+    }
+
+    void    InputDispatcher::Link(u32 slot)
+    {
+        for (u32 keys = _bindings[slot].keys; keys != 0; keys &= keys - 1)
+            _byKey[__builtin_ctz(keys)].push_back(slot);
+    }
+
+    void    InputDispatcher::Unlink(u32 slot)
+    {
+        for (u32 keys = _bindings[slot].keys; keys != 0; keys &= keys - 1)
+            Erase(_byKey[__builtin_ctz(keys)], slot);
+    }
+
+    // A hold whose keys are already down counts from now, no key will change to arm it
+    void    InputDispatcher::Arm(u32 slot)
+    {
+        Binding     &binding = _bindings[slot];
+
+        if (binding.trigger != InputTrigger::Hold || binding.armed || (_held & binding.keys) != binding.keys)
+            return;
+
+        binding.armed = true;
+        binding.since = _now;
+        _armed.push_back(slot);
+    }
+
+    void    InputDispatcher::Disarm(u32 slot)
+    {
+        if (!_bindings[slot].armed)
+            return;
+
+        _bindings[slot].armed = false;
+        Erase(_armed, slot);
+    }
+
+    void    InputDispatcher::SetSource(InputSource *source)
+    {
+        _source = source;
+    }
+
+    void    InputDispatcher::SetRecorder(InputRecorder *recorder)
+    {
+        _recorder = recorder;
+    }
+
+    u32     InputDispatcher::Held(void) const
+    {
+        return (_held);
+    }
+
+    u32     InputDispatcher::Pressed(void) const
+    {
+        return (_pressed);
+    }
+
+    u32     InputDispatcher::Released(void) const
+    {
+        return (_released);
+    }
+
+    u32     InputDispatcher::Count(void) const
+    {
+        u32     count = 0;
+
+        for (const Binding &binding : _bindings)
+            count += binding.used;
+        return (count);
+    }
+}
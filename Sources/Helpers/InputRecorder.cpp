@@ -0,0 +1,227 @@
+#include "Helpers/InputRecorder.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/Ticks.hpp"
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        const u32   Magic = 0x32455249; ///< IRE2: frame count, frame time
+        const u32   HeaderSize = 12;
+        const u32   DefaultFrameTicks = SYSCLOCK_ARM11 / 60;
+
+        // A toggle byte: the index of the key, the high bit when another toggle follows
+        const u8    MoreToggles = 0x80;
+
+        void    WriteVarint(std::vector<u8> &out, u32 value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back((value & 0x7F) | 0x80);
+                value >>= 7;
+            }
+            out.push_back(value);
+        }
+    }
+
+    InputRecorder::InputRecorder(void) :
+        _recording(false), _frames(0), _lastChange(0), _keys(0), _firstTick(0), _lastTick(0)
+    {
+    }
+
+    void    InputRecorder::Start(void)
+    {
+        _changes.clear();
+        _recording = true;
+        _frames = 0;
+        _lastChange = 0;
+        _keys = 0;
+        _firstTick = 0;
+        _lastTick = 0;
+    }
+
+    void    InputRecorder::Stop(void)
+    {
+        _recording = false;
+    }
+
+    bool    InputRecorder::IsRecording(void) const
+    {
+        return (_recording);
+    }
+
+    void    InputRecorder::Record(u32 keys, u64 ticks)
+    {
+        if (!_recording)
+            return;
+
+        if (_frames == 0)
+            _firstTick = ticks;
+        _lastTick = ticks;
+
+        u32     toggled = keys ^ _keys;
+
+        if (toggled != 0)
+        {
+            WriteVarint(_changes, _frames - _lastChange);
+            for (; toggled != 0; toggled &= toggled - 1)
+            {
+                u8  toggle = __builtin_ctz(toggled);
+
+                _changes.push_back((toggled & (toggled - 1)) ? toggle | MoreToggles : toggle);
+            }
+
+            _lastChange = _frames;
+            _keys = keys;
+        }
+
+        ++_frames;
+    }
+
+    u32     InputRecorder::FrameCount(void) const
+    {
+        return (_frames);
+    }
+
+    u32     InputRecorder::FrameTicks(void) const
+    {
+        if (_frames < 2 || _lastTick <= _firstTick)
+            return (DefaultFrameTicks);
+
+        return ((_lastTick - _firstTick) / (_frames - 1));
+    }
+
+    void    InputRecorder::Serialize(std::vector<u8> &out) const
+    {
+        u32     frameTicks = FrameTicks();
+
+        out.resize(HeaderSize);
+        std::memcpy(out.data(), &Magic, 4);
+        std::memcpy(out.data() + 4, &_frames, 4);
+        std::memcpy(out.data() + 8, &frameTicks, 4);
+        out.insert(out.end(), _changes.begin(), _changes.end());
+    }
+
+    bool    InputRecorder::Save(const std::string &path) const
+    {
+        std::vector<u8>     data;
+
+        Serialize(data);
+        return (WriteFile(path, data.data(), data.size()));
+    }
+
+    InputReplay::InputReplay(void) :
+        _position(0), _frames(0), _frame(0), _nextChange(0xFFFFFFFF), _keys(0),
+        _frameTicks(DefaultFrameTicks), _start(0)
+    {
+    }
+
+    bool    InputReplay::Load(const std::string &path)
+    {
+        std::vector<u8>     data;
+
+        return (ReadFile(path, data) && SetData(data));
+    }
+
+    bool    InputReplay::SetData(const std::vector<u8> &data)
+    {
+        u32     magic;
+
+        if (data.size() < HeaderSize)
+            return (false);
+
+        std::memcpy(&magic, data.data(), 4);
+        if (magic != Magic)
+            return (false);
+
+        _data = data;
+        std::memcpy(&_frames, _data.data() + 4, 4);
+        std::memcpy(&_frameTicks, _data.data() + 8, 4);
+        if (_frameTicks == 0)
+            _frameTicks = DefaultFrameTicks;
+        Rewind();
+        return (true);
+    }
+
+    void    InputReplay::ReadChange(u32 lastChange)
+    {
+        u32     delta = 0;
+        u32     shift = 0;
+
+        _nextChange = 0xFFFFFFFF;
+
+        while (_position < _data.size() && shift < 32)
+        {
+            u8  byte = _data[_position++];
+
+            delta |= static_cast<u32>(byte & 0x7F) << shift;
+            shift += 7;
+            if (!(byte & 0x80))
+            {
+                _nextChange = lastChange + delta;
+                return;
+            }
+        }
+    }
+
+    u32     InputReplay::Sample(void)
+    {
+        // The clock of the replay starts with its first frame, after the frames played live
+        if (_frame == 0)
+            _start = GetTicks();
+
+        if (_frame >= _frames)
+        {
+            ++_frame;
+            return (0);
+        }
+
+        if (_frame == _nextChange)
+        {
+            u8  toggle;
+
+            do
+            {
+                if (_position >= _data.size())
+                    break;
+
+                toggle = _data[_position++];
+                _keys ^= 1u << (toggle & 0x1F);
+            } while (toggle & MoreToggles);
+
+            ReadChange(_frame);
+        }
+
+        ++_frame;
+        return (_keys);
+    }
+
+    u64     InputReplay::Ticks(void)
+    {
+        return (_start + static_cast<u64>(_frame ? _frame - 1 : 0) * _frameTicks);
+    }
+
+    void    InputReplay::Rewind(void)
+    {
+        _position = HeaderSize;
+        _frame = 0;
+        _keys = 0;
+        ReadChange(0);
+    }
+
+    bool    InputReplay::Finished(void) const
+    {
+        return (_frame >= _frames);
+    }
+
+    u32     InputReplay::Frame(void) const
+    {
+        return (_frame < _frames ? _frame : _frames);
+    }
+
+    u32     InputReplay::FrameCount(void) const
+    {
+        return (_frames);
+    }
+}
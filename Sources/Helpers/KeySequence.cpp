@@ -1,33 +1,20 @@
 #include "Helpers/KeySequence.hpp"
+#include "Helpers/InputDispatcher.hpp"
 
 namespace CTRPluginFramework
 {
-    KeySequence::KeySequence(KeyVector sequence) : 
-    _sequence(sequence), _indexInSequence(0)
-    {            
+    KeySequence::KeySequence(KeyVector sequence, Time timeout) :
+    _handle(InputDispatcher::GetInstance().AddSequence(std::vector<u32>(sequence.begin(), sequence.end()), timeout))
+    {
     }
 
-    bool  KeySequence::operator()(void)
+    KeySequence::~KeySequence(void)
     {
-        if (Controller::IsKeyDown(_sequence[_indexInSequence]))
-        {
-            _indexInSequence++;
-
-            if (_indexInSequence >= _sequence.size())
-            {
-                _indexInSequence = 0;
-                return (true);
-            }
-
-            _timer.Restart();
-        }
-
-        if (_timer.HasTimePassed(Seconds(1.f)))
-        {
-            _indexInSequence = 0;
-            _timer.Restart();
-        }
+        InputDispatcher::GetInstance().Remove(_handle);
+    }
 
-        return (false);
+    bool  KeySequence::operator()(void)
+    {
+        return (InputDispatcher::GetInstance().Fired(_handle));
     }
 }
@@ -0,0 +1,644 @@
+#include "Helpers/MemorySearch.hpp"
+#include "Helpers/PoolAllocator.hpp"
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        template <typename T>
+        inline T    Load(const u8 *src)
+        {
+            T   value;
+
+            std::memcpy(&value, src, sizeof(T));
+            return (value);
+        }
+
+        template <typename T>
+        inline T    FromRaw(u32 raw)
+        {
+            T   value;
+
+            std::memcpy(&value, &raw, sizeof(T));
+            return (value);
+        }
+
+        template <>
+        inline u8   FromRaw<u8>(u32 raw)
+        {
+            return (raw);
+        }
+
+        template <>
+        inline u16  FromRaw<u16>(u32 raw)
+        {
+            return (raw);
+        }
+
+        // Kernels: test a whole chunk and write the index of each match, return the amount of matches
+
+        // A word has a zero byte if (w - 0x01010101) & ~w & 0x80808080, so only
+        // the words containing the searched byte need to be looked at byte per byte
+        struct ExactU8Kernel
+        {
+            u32     pattern;
+
+            u32     operator()(const u8 *memory, u32 size, u16 *indices) const
+            {
+                u32     count = 0;
+                u8      value = pattern;
+
+                for (u32 i = 0; i < size; i += 4)
+                {
+                    u32     word = Load<u32>(memory + i) ^ pattern;
+
+                    if (((word - 0x01010101) & ~word & 0x80808080) == 0)
+                        continue;
+
+                    for (u32 j = i; j < i + 4; ++j)
+                        if (memory[j] == value)
+                            indices[count++] = j;
+                }
+
+                return (count);
+            }
+        };
+
+        struct ExactU16Kernel
+        {
+            u32     pattern;
+
+            u32     operator()(const u8 *memory, u32 size, u16 *indices) const
+            {
+                u32     count = 0;
+                u16     value = pattern;
+
+                for (u32 i = 0; i < size; i += 4)
+                {
+                    u32     word = Load<u32>(memory + i) ^ pattern;
+
+                    if (((word - 0x00010001) & ~word & 0x80008000) == 0)
+                        continue;
+
+                    if (Load<u16>(memory + i) == value)
+                        indices[count++] = i >> 1;
+                    if (Load<u16>(memory + i + 2) == value)
+                        indices[count++] = (i >> 1) + 1;
+                }
+
+                return (count);
+            }
+        };
+
+        struct ExactU32Kernel
+        {
+            u32     value;
+
+            u32     operator()(const u8 *memory, u32 size, u16 *indices) const
+            {
+                u32     count = 0;
+                u32     elements = size >> 2;
+                u32     i = 0;
+
+                for (; i + 4 <= elements; i += 4)
+                {
+                    const u8 *p = memory + (i << 2);
+
+                    // Most words don't match, test 4 of them with a single branch
+                    if (Load<u32>(p) != value && Load<u32>(p + 4) != value
+                        && Load<u32>(p + 8) != value && Load<u32>(p + 12) != value)
+                        continue;
+
+                    for (u32 j = i; j < i + 4; ++j)
+                        if (Load<u32>(memory + (j << 2)) == value)
+                            indices[count++] = j;
+                }
+
+                for (; i < elements; ++i)
+                    if (Load<u32>(memory + (i << 2)) == value)
+                        indices[count++] = i;
+
+                return (count);
+            }
+        };
+
+        template <typename T, typename Predicate>
+        struct PredicateKernel
+        {
+            Predicate   predicate;
+
+            u32     operator()(const u8 *memory, u32 size, u16 *indices) const
+            {
+                u32     count = 0;
+                u32     elements = size / sizeof(T);
+
+                for (u32 i = 0; i < elements; ++i)
+                    if (predicate(Load<T>(memory + i * sizeof(T))))
+                        indices[count++] = i;
+
+                return (count);
+            }
+        };
+
+        // Every value matches, the indexes aren't needed as the chunk is stored as a whole
+        struct UnknownKernel
+        {
+            u32     width;
+
+            u32     operator()(const u8 *, u32 size, u16 *) const
+            {
+                return (size / width);
+            }
+        };
+
+        // A single unsigned compare: v - min wraps around when v < min
+        struct RangeTest
+        {
+            u32     min;
+            u32     span;
+
+            template <typename T>
+            bool    operator()(T value) const { return (static_cast<u32>(value - min) <= span); }
+        };
+
+        struct FloatRangeTest
+        {
+            float   min;
+            float   max;
+
+            bool    operator()(float value) const { return (value >= min && value <= max); }
+        };
+
+        template <typename T, typename Predicate>
+        PredicateKernel<T, Predicate>   MakeKernel(Predicate predicate)
+        {
+            PredicateKernel<T, Predicate>   kernel = { predicate };
+
+            return (kernel);
+        }
+
+        u32     VarintSize(u32 value)
+        {
+            return (value < 0x80 ? 1 : (value < 0x4000 ? 2 : 3));
+        }
+    }
+
+    MemorySearch::MemorySearch(void) :
+        _type(SearchType::U32), _uniform(false), _uniformValue(0), _resultCount(0)
+    {
+    }
+
+    void    MemorySearch::AddRegion(u32 address, const void *data, u32 size)
+    {
+        Region  region = { address, static_cast<const u8 *>(data), size & ~3u };
+
+        if (region.size)
+            _regions.push_back(region);
+    }
+
+    void    MemorySearch::Reset(void)
+    {
+        _regions.clear();
+        _chunks.clear();
+        _pool.clear();
+        _newChunks.clear();
+        _newPool.clear();
+        _snapshot.Clear();
+        _newSnapshot.Clear();
+        _uniform = false;
+        _resultCount = 0;
+    }
+
+    bool    MemorySearch::SetSwapFile(const std::string &path)
+    {
+        bool    opened;
+
+        _chunks.clear();
+        _pool.clear();
+        _uniform = false;
+        _resultCount = 0;
+
+        opened = _snapshot.SetFile(path.empty() ? path : path + ".0");
+        opened = _newSnapshot.SetFile(path.empty() ? path : path + ".1") && opened;
+        return (opened);
+    }
+
+    u32     MemorySearch::ExactScan(SearchType type, u32 value)
+    {
+        switch (type)
+        {
+        case SearchType::U8:
+            value &= 0xFF;
+            return (Scan(type, ExactU8Kernel{ value * 0x01010101 }, false, value));
+        case SearchType::U16:
+            value &= 0xFFFF;
+            return (Scan(type, ExactU16Kernel{ value * 0x00010001 }, false, value));
+        default:
+            // Floats are matched on their bits
+            return (Scan(type, ExactU32Kernel{ value }, false, value));
+        }
+    }
+
+    u32     MemorySearch::RangeScan(SearchType type, u32 min, u32 max)
+    {
+        RangeTest       range = { min, max - min };
+        FloatRangeTest  floatRange = { FromRaw<float>(min), FromRaw<float>(max) };
+
+        switch (type)
+        {
+        case SearchType::U8:
+            return (Scan(type, MakeKernel<u8>(range), true, 0));
+        case SearchType::U16:
+            return (Scan(type, MakeKernel<u16>(range), true, 0));
+        case SearchType::U32:
+            return (Scan(type, MakeKernel<u32>(range), true, 0));
+        default:
+            return (Scan(type, MakeKernel<float>(floatRange), true, 0));
+        }
+    }
+
+    u32     MemorySearch::UnknownScan(SearchType type)
+    {
+        _type = type;
+        return (Scan(type, UnknownKernel{ Width() }, true, 0));
+    }
+
+    u32     MemorySearch::Filter(SearchFilter filter)
+    {
+        switch (_type)
+        {
+        case SearchType::U8:
+            return (Relational<u8>(filter));
+        case SearchType::U16:
+            return (Relational<u16>(filter));
+        case SearchType::U32:
+            return (Relational<u32>(filter));
+        default:
+            // Compare the bits of the floats to detect a change, NaN != NaN otherwise
+            if (filter == SearchFilter::Changed || filter == SearchFilter::Unchanged)
+                return (Relational<u32>(filter));
+            return (Relational<float>(filter));
+        }
+    }
+
+    u32     MemorySearch::FilterExact(u32 value)
+    {
+        switch (_type)
+        {
+        case SearchType::U8:
+            value &= 0xFF;
+            return (Refine<u8>([value](u8 current, u8) { return (current == value); }, false, value));
+        case SearchType::U16:
+            value &= 0xFFFF;
+            return (Refine<u16>([value](u16 current, u16) { return (current == value); }, false, value));
+        default:
+            return (Refine<u32>([value](u32 current, u32) { return (current == value); }, false, value));
+        }
+    }
+
+    u32     MemorySearch::FilterRange(u32 min, u32 max)
+    {
+        RangeTest       range = { min, max - min };
+        FloatRangeTest  floatRange = { FromRaw<float>(min), FromRaw<float>(max) };
+
+        switch (_type)
+        {
+        case SearchType::U8:
+            return (Refine<u8>([range](u8 current, u8) { return (range(current)); }, true, 0));
+        case SearchType::U16:
+            return (Refine<u16>([range](u16 current, u16) { return (range(current)); }, true, 0));
+        case SearchType::U32:
+            return (Refine<u32>([range](u32 current, u32) { return (range(current)); }, true, 0));
+        default:
+            return (Refine<float>([floatRange](float current, float) { return (floatRange(current)); }, true, 0));
+        }
+    }
+
+    u32     MemorySearch::GetResults(u32 index, u32 count, std::vector<SearchHit> &out) const
+    {
+        u32     width = Width();
+        u32     first = 0;
+        u32     read = 0;
+
+        for (const Chunk &chunk : _chunks)
+        {
+            if (read >= count)
+                break;
+
+            // Skip the whole chunk
+            if (first + chunk.count <= index)
+            {
+                first += chunk.count;
+                continue;
+            }
+
+            ForEachIndex(chunk, [&](u32 element, u32 ordinal)
+            {
+                if (first + ordinal < index || read >= count)
+                    return;
+
+                const u8    *src = chunk.memory + element * width;
+                SearchHit   hit = { chunk.address + element * width, 0 };
+
+                hit.value = width == 1 ? *src : (width == 2 ? Load<u16>(src) : Load<u32>(src));
+                out.push_back(hit);
+                ++read;
+            });
+
+            first += chunk.count;
+        }
+
+        return (read);
+    }
+
+    u32     MemorySearch::ResultCount(void) const
+    {
+        return (_resultCount);
+    }
+
+    SearchType  MemorySearch::Type(void) const
+    {
+        return (_type);
+    }
+
+    u32     MemorySearch::MemoryUsage(void) const
+    {
+        return (_pool.capacity() + _chunks.capacity() * sizeof(Chunk) + _snapshot.MemoryUsage()
+            + _newPool.capacity() + _newChunks.capacity() * sizeof(Chunk) + _newSnapshot.MemoryUsage()
+            + _indices.capacity() * sizeof(u16) + _page.capacity());
+    }
+
+    u32     MemorySearch::FileUsage(void) const
+    {
+        return (_snapshot.FileUsage() + _newSnapshot.FileUsage());
+    }
+
+    template <typename Kernel>
+    u32     MemorySearch::Scan(SearchType type, const Kernel &kernel, bool storeValues, u32 uniformValue)
+    {
+        MemoryTagScope  scope(MemoryTag::Search);
+
+        _type = type;
+        _newChunks.clear();
+        _newPool.clear();
+        _newSnapshot.Clear();
+        _indices.resize(ChunkSize);
+
+        for (const Region &region : _regions)
+        {
+            for (u32 offset = 0; offset < region.size; offset += ChunkSize)
+            {
+                Chunk   chunk = { region.data + offset, region.address + offset, 0, 0, 0, 0, 0,
+                                      MemorySnapshot::InvalidPage, All };
+
+                chunk.size = region.size - offset < ChunkSize ? region.size - offset : ChunkSize;
+                Store(chunk, kernel(chunk.memory, chunk.size, _indices.data()), storeValues);
+            }
+        }
+
+        Commit(storeValues, uniformValue);
+        return (_resultCount);
+    }
+
+    template <typename T, typename Test>
+    u32     MemorySearch::Refine(Test test, bool storeValues, u32 uniformValue, bool relational)
+    {
+        MemoryTagScope  scope(MemoryTag::Search);
+
+        _newChunks.clear();
+        _newPool.clear();
+        _newSnapshot.Clear();
+        _indices.resize(ChunkSize);
+        _page.resize(ChunkSize);
+
+        T       uniform = FromRaw<T>(_uniformValue);
+        u16     *indices = _indices.data();
+        u8      *page = _page.data();
+        bool    unchanged = test(T(), T());
+
+        for (const Chunk &chunk : _chunks)
+        {
+            const u8    *values = _uniform ? nullptr : _pool.data() + chunk.valuesOffset;
+            u32         count = 0;
+
+            if (chunk.page != MemorySnapshot::InvalidPage)
+            {
+                _snapshot.Read(chunk.page, page);
+
+                // A page which didn't change gives the same result for every value, and isn't compressed again
+                if (relational && std::memcmp(page, chunk.memory, chunk.size) == 0)
+                {
+                    if (unchanged)
+                        ForEachIndex(chunk, [&](u32 element, u32) { indices[count++] = element; });
+                    Store(chunk, count, storeValues, chunk.page);
+                    continue;
+                }
+
+                ForEachIndex(chunk, [&](u32 element, u32)
+                {
+                    if (test(Load<T>(chunk.memory + element * sizeof(T)), Load<T>(page + element * sizeof(T))))
+                        indices[count++] = element;
+                });
+
+                Store(chunk, count, storeValues);
+                continue;
+            }
+
+            ForEachIndex(chunk, [&](u32 element, u32 ordinal)
+            {
+                T   current = Load<T>(chunk.memory + element * sizeof(T));
+                T   previous = values != nullptr ? Load<T>(values + ordinal * sizeof(T)) : uniform;
+
+                if (test(current, previous))
+                    indices[count++] = element;
+            });
+
+            Store(chunk, count, storeValues);
+        }
+
+        Commit(storeValues, uniformValue);
+        return (_resultCount);
+    }
+
+    template <typename T>
+    u32     MemorySearch::Relational(SearchFilter filter)
+    {
+        switch (filter)
+        {
+        case SearchFilter::Changed:
+            return (Refine<T>([](T current, T previous) { return (current != previous); }, true, 0, true));
+        case SearchFilter::Unchanged:
+            return (Refine<T>([](T current, T previous) { return (current == previous); }, true, 0, true));
+        case SearchFilter::Increased:
+            return (Refine<T>([](T current, T previous) { return (current > previous); }, true, 0, true));
+        default:
+            return (Refine<T>([](T current, T previous) { return (current < previous); }, true, 0, true));
+        }
+    }
+
+    template <typename Callback>
+    void    MemorySearch::ForEachIndex(const Chunk &chunk, Callback callback) const
+    {
+        const u8    *hits = _pool.data() + chunk.hitsOffset;
+
+        if (chunk.encoding == All)
+        {
+            for (u32 i = 0; i < chunk.count; ++i)
+                callback(i, i);
+        }
+        else if (chunk.encoding == Bitmap)
+        {
+            u32     ordinal = 0;
+
+            for (u32 byte = 0; byte < chunk.hitsSize; ++byte)
+            {
+                for (u32 bits = hits[byte]; bits != 0; bits &= bits - 1)
+                    callback((byte << 3) + __builtin_ctz(bits), ordinal++);
+            }
+        }
+        else
+        {
+            const u8    *end = hits + chunk.hitsSize;
+            u32         element = 0xFFFFFFFF;
+            u32         ordinal = 0;
+
+            while (hits < end)
+            {
+                u32     delta = 0;
+                u32     shift = 0;
+                u8      byte;
+
+                do
+                {
+                    byte = *hits++;
+                    delta |= (byte & 0x7F) << shift;
+                    shift += 7;
+                } while (byte & 0x80);
+
+                element += delta;
+                callback(element, ordinal++);
+            }
+        }
+    }
+
+    void    MemorySearch::Store(Chunk chunk, u32 count, bool storeValues, u32 samePage)
+    {
+        if (count == 0)
+            return;
+
+        u32     width = Width();
+        u32     elements = chunk.size / width;
+        const u16 *indices = _indices.data();
+
+        chunk.count = count;
+        chunk.hitsOffset = _newPool.size();
+        chunk.hitsSize = 0;
+        chunk.page = MemorySnapshot::InvalidPage;
+
+        if (count == elements)
+            chunk.encoding = All;
+        else
+        {
+            u32     bitmapSize = (elements + 7) >> 3;
+            u32     deltasSize = 0;
+            u32     previous = 0xFFFFFFFF;
+
+            for (u32 i = 0; i < count; previous = indices[i++])
+                deltasSize += VarintSize(indices[i] - previous);
+
+            if (deltasSize < bitmapSize)
+            {
+                chunk.encoding = Deltas;
+                chunk.hitsSize = deltasSize;
+                _newPool.resize(chunk.hitsOffset + deltasSize);
+
+                u8  *out = _newPool.data() + chunk.hitsOffset;
+
+                previous = 0xFFFFFFFF;
+                for (u32 i = 0; i < count; previous = indices[i++])
+                {
+                    u32     delta = indices[i] - previous;
+
+                    while (delta >= 0x80)
+                    {
+                        *out++ = (delta & 0x7F) | 0x80;
+                        delta >>= 7;
+                    }
+                    *out++ = delta;
+                }
+            }
+            else
+            {
+                chunk.encoding = Bitmap;
+                chunk.hitsSize = bitmapSize;
+                _newPool.resize(chunk.hitsOffset + bitmapSize, 0);
+
+                u8  *out = _newPool.data() + chunk.hitsOffset;
+
+                for (u32 i = 0; i < count; ++i)
+                    out[indices[i] >> 3] |= 1 << (indices[i] & 7);
+            }
+        }
+
+        // Most values are kept, the whole page compresses better than the values alone
+        if (storeValues && count * width >= chunk.size / 4)
+        {
+            if (samePage != MemorySnapshot::InvalidPage)
+                chunk.page = _newSnapshot.Copy(_snapshot, samePage);
+            else
+                chunk.page = _newSnapshot.Add(chunk.memory, chunk.size);
+        }
+        else if (storeValues)
+        {
+            chunk.valuesOffset = _newPool.size();
+            _newPool.resize(chunk.valuesOffset + count * width);
+
+            u8  *out = _newPool.data() + chunk.valuesOffset;
+
+            if (chunk.encoding == All)
+                std::memcpy(out, chunk.memory, count * width);
+            else
+            {
+                for (u32 i = 0; i < count; ++i, out += width)
+                    std::memcpy(out, chunk.memory + indices[i] * width, width);
+            }
+        }
+
+        _newChunks.push_back(chunk);
+    }
+
+    void    MemorySearch::Commit(bool storeValues, u32 uniformValue)
+    {
+        _chunks.swap(_newChunks);
+        _pool.swap(_newPool);
+        _snapshot.Swap(_newSnapshot);
+
+        // Only the results stay until the next scan
+        _chunks.shrink_to_fit();
+        _pool.shrink_to_fit();
+        std::vector<Chunk>().swap(_newChunks);
+        std::vector<u8>().swap(_newPool);
+        std::vector<u16>().swap(_indices);
+        std::vector<u8>().swap(_page);
+        _newSnapshot.Clear();
+
+        _uniform = !storeValues;
+        _uniformValue = uniformValue;
+        _resultCount = 0;
+        for (const Chunk &chunk : _chunks)
+            _resultCount += chunk.count;
+    }
+
+    u32     MemorySearch::Width(void) const
+    {
+        switch (_type)
+        {
+        case SearchType::U8:
+            return (1);
+        case SearchType::U16:
+            return (2);
+        default:
+            return (4);
+        }
+    }
+}
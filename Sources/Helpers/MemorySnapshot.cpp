@@ -0,0 +1,361 @@
+#include "Helpers/MemorySnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        const u32   HashBits = 11;
+        const u32   MinMatch = 4;
+        const u32   MaxOffset = 0xFFFF;
+
+        // The last bytes are always literals so the decoder never reads a match past the page
+        const u32   LastLiterals = 8;
+
+        inline u32  Load32(const u8 *src)
+        {
+            u32     value;
+
+            std::memcpy(&value, src, sizeof(value));
+            return (value);
+        }
+
+        inline u32  Hash(u32 sequence)
+        {
+            return ((sequence * 2654435761u) >> (32 - HashBits));
+        }
+
+        u8      *WriteLength(u8 *out, u32 length)
+        {
+            for (; length >= 255; length -= 255)
+                *out++ = 255;
+            *out++ = length;
+            return (out);
+        }
+
+        // A sequence: token (literals << 4 | match - MinMatch), literals, offset, the lengths above 15 follow
+        u8      *WriteSequence(u8 *out, const u8 *literals, u32 literalCount, u32 offset, u32 match)
+        {
+            u8      *token = out++;
+            u32     matchCode = match ? match - MinMatch : 0;
+
+            *token = (literalCount < 15 ? literalCount : 15) << 4 | (matchCode < 15 ? matchCode : 15);
+            if (literalCount >= 15)
+                out = WriteLength(out, literalCount - 15);
+
+            std::memcpy(out, literals, literalCount);
+            out += literalCount;
+
+            if (match == 0)
+                return (out);
+
+            *out++ = offset;
+            *out++ = offset >> 8;
+            if (matchCode >= 15)
+                out = WriteLength(out, matchCode - 15);
+            return (out);
+        }
+
+        // Return the size of the compressed data, 0 if it's not smaller than the source
+        u32     Compress(const u8 *src, u32 size, u8 *dst, u16 *table)
+        {
+            u8          *out = dst;
+            u8          *outLimit = dst + size;
+            const u8    *anchor = src;
+            const u8    *ip = src;
+            const u8    *matchLimit = src + (size > LastLiterals ? size - LastLiterals : 0);
+
+            // The table isn't cleared, a position from another page is only used if its bytes match
+            while (ip + MinMatch <= matchLimit)
+            {
+                u32         sequence = Load32(ip);
+                u32         hash = Hash(sequence);
+                u32         position = ip - src;
+                const u8    *candidate = src + table[hash];
+
+                table[hash] = position;
+
+                if (candidate >= ip || position - (candidate - src) > MaxOffset || Load32(candidate) != sequence)
+                {
+                    // Skip faster through data which doesn't compress
+                    ip += 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+
+                const u8    *end = ip + MinMatch;
+                const u8    *from = candidate + MinMatch;
+
+                while (end < matchLimit && *end == *from)
+                {
+                    ++end;
+                    ++from;
+                }
+
+                while (ip > anchor && candidate > src && ip[-1] == candidate[-1])
+                {
+                    --ip;
+                    --candidate;
+                }
+
+                // Worst case of the sequence: token, literals and their length, offset, match length
+                if (out + 1 + (ip - anchor) + (ip - anchor) / 255 + 3 + (end - ip) / 255 + 1 >= outLimit)
+                    return (0);
+
+                out = WriteSequence(out, anchor, ip - anchor, ip - candidate, end - ip);
+                ip = anchor = end;
+            }
+
+            u32     literals = src + size - anchor;
+
+            if (out + 1 + literals + literals / 255 + 1 >= outLimit)
+                return (0);
+
+            out = WriteSequence(out, anchor, literals, 0, 0);
+            return (out - dst);
+        }
+
+        void    Decompress(const u8 *in, u8 *out, u32 size)
+        {
+            u8      *end = out + size;
+
+            while (true)
+            {
+                u32     token = *in++;
+                u32     literals = token >> 4;
+                u32     match = token & 15;
+                u32     byte;
+
+                if (literals == 15)
+                    do { byte = *in++; literals += byte; } while (byte == 255);
+
+                std::memcpy(out, in, literals);
+                out += literals;
+                in += literals;
+
+                if (out >= end)
+                    return;
+
+                u32     offset = in[0] | (in[1] << 8);
+
+                in += 2;
+                if (match == 15)
+                    do { byte = *in++; match += byte; } while (byte == 255);
+                match += MinMatch;
+
+                const u8    *from = out - offset;
+
+                // The match may overlap what it writes
+                if (offset >= match)
+                    std::memcpy(out, from, match);
+                else
+                    for (u32 i = 0; i < match; ++i)
+                        out[i] = from[i];
+                out += match;
+            }
+        }
+    }
+
+    MemorySnapshot::MemorySnapshot(void) :
+        _logicalSize(0), _file(nullptr), _fileSize(0), _cachedBlock(InvalidPage)
+    {
+    }
+
+    MemorySnapshot::~MemorySnapshot(void)
+    {
+        delete _file;
+    }
+
+    bool    MemorySnapshot::SetFile(const std::string &path)
+    {
+        Clear();
+        delete _file;
+        _file = nullptr;
+
+        if (path.empty())
+            return (true);
+
+        _file = new File();
+        if (File::Open(*_file, path, File::RWC | File::TRUNCATE) != 0)
+        {
+            delete _file;
+            _file = nullptr;
+            return (false);
+        }
+
+        return (true);
+    }
+
+    u8      *MemorySnapshot::Reserve(u32 size, u32 &offset)
+    {
+        if (_blocks.empty() || _blocks.back().size() + size > BlockSize)
+        {
+            // The full block goes to the file, a failed write keeps it in memory
+            if (_file != nullptr && !_blocks.empty())
+            {
+                std::vector<u8>     &full = _blocks.back();
+                u32                 position = (_blocks.size() - 1) * BlockSize;
+
+                if (_file->Seek(position, File::SET) == 0 && _file->Write(full.data(), full.size()) == 0)
+                {
+                    _fileSize = position + full.size();
+                    std::vector<u8>().swap(full);
+                }
+            }
+
+            _blocks.push_back(std::vector<u8>());
+            _blocks.back().reserve(BlockSize);
+        }
+
+        std::vector<u8>     &block = _blocks.back();
+
+        offset = (_blocks.size() - 1) << 16 | block.size();
+        block.resize(block.size() + size);
+        return (block.data() + (offset & 0xFFFF));
+    }
+
+    const u8    *MemorySnapshot::Data(const Page &page) const
+    {
+        u32     block = page.offset >> 16;
+
+        if (!_blocks[block].empty())
+            return (_blocks[block].data() + (page.offset & 0xFFFF));
+
+        // The pages are usually read in order, a whole block is read at once
+        if (_cachedBlock != block)
+        {
+            u32     position = block * BlockSize;
+            u32     size = _fileSize - position < BlockSize ? _fileSize - position : BlockSize;
+
+            _cache.resize(BlockSize);
+            _cachedBlock = InvalidPage;
+            if (_file->Seek(position, File::SET) != 0 || _file->Read(_cache.data(), size) != 0)
+                std::memset(_cache.data(), 0, BlockSize);
+            else
+                _cachedBlock = block;
+        }
+
+        return (_cache.data() + (page.offset & 0xFFFF));
+    }
+
+    u32     MemorySnapshot::Add(const u8 *data, u32 size)
+    {
+        Page    page = { 0, 0, static_cast<u16>(size), Fill };
+        u32     first = size ? Load32(data) : 0;
+        u32     i = 4;
+
+        while (i < size && Load32(data + i) == first)
+            i += 4;
+
+        _logicalSize += size;
+
+        if (i >= size)
+        {
+            page.offset = first;
+            _pages.push_back(page);
+            return (_pages.size() - 1);
+        }
+
+        if (_table.empty())
+            _table.resize(1 << HashBits, 0);
+
+        u8      *out = Reserve(size, page.offset);
+        u32     stored = Compress(data, size, out, _table.data());
+
+        if (stored == 0)
+        {
+            page.kind = Raw;
+            page.stored = size;
+            std::memcpy(out, data, size);
+        }
+        else
+        {
+            page.kind = Compressed;
+            page.stored = stored;
+            _blocks.back().resize((page.offset & 0xFFFF) + stored);
+        }
+
+        _pages.push_back(page);
+        return (_pages.size() - 1);
+    }
+
+    u32     MemorySnapshot::Copy(const MemorySnapshot &other, u32 index)
+    {
+        Page    page = other._pages[index];
+
+        if (page.kind != Fill)
+            std::memcpy(Reserve(page.stored, page.offset), other.Data(other._pages[index]), page.stored);
+
+        _logicalSize += page.size;
+        _pages.push_back(page);
+        return (_pages.size() - 1);
+    }
+
+    u32     MemorySnapshot::Read(u32 index, u8 *out) const
+    {
+        const Page  &page = _pages[index];
+
+        switch (page.kind)
+        {
+        case Fill:
+            for (u32 i = 0; i < page.size; i += 4)
+                std::memcpy(out + i, &page.offset, 4);
+            break;
+        case Raw:
+            std::memcpy(out, Data(page), page.size);
+            break;
+        case Compressed:
+            Decompress(Data(page), out, page.size);
+            break;
+        }
+
+        return (page.size);
+    }
+
+    void    MemorySnapshot::Clear(void)
+    {
+        std::vector<Page>().swap(_pages);
+        std::vector<std::vector<u8>>().swap(_blocks);
+        std::vector<u8>().swap(_cache);
+        _cachedBlock = InvalidPage;
+        _logicalSize = 0;
+        _fileSize = 0;
+    }
+
+    void    MemorySnapshot::Swap(MemorySnapshot &other)
+    {
+        _pages.swap(other._pages);
+        _blocks.swap(other._blocks);
+        _cache.swap(other._cache);
+        std::swap(_logicalSize, other._logicalSize);
+        std::swap(_file, other._file);
+        std::swap(_fileSize, other._fileSize);
+        std::swap(_cachedBlock, other._cachedBlock);
+    }
+
+    u32     MemorySnapshot::Count(void) const
+    {
+        return (_pages.size());
+    }
+
+    u32     MemorySnapshot::LogicalSize(void) const
+    {
+        return (_logicalSize);
+    }
+
+    u32     MemorySnapshot::MemoryUsage(void) const
+    {
+        u32     blocks = 0;
+
+        for (const std::vector<u8> &block : _blocks)
+            blocks += block.capacity();
+
+        return (_pages.capacity() * sizeof(Page) + _blocks.capacity() * sizeof(std::vector<u8>) + blocks
+                + _table.capacity() * sizeof(u16) + _cache.capacity());
+    }
+
+    u32     MemorySnapshot::FileUsage(void) const
+    {
+        return (_fileSize);
+    }
+}
@@ -0,0 +1,250 @@
+#include "Helpers/MenuSearch.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        inline char     Lower(char c)
+        {
+            return (c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        }
+
+        // One bit per letter and digit, the other characters share the remaining bits
+        inline u64      CharacterBit(char c)
+        {
+            u8  byte = c;
+
+            if (byte >= 'a' && byte <= 'z')
+                return (1ull << (byte - 'a'));
+            if (byte >= '0' && byte <= '9')
+                return (1ull << (26 + byte - '0'));
+            return (1ull << (36 + byte % 28));
+        }
+
+        inline u32      Trigram(const char *str)
+        {
+            return ((static_cast<u8>(str[0]) << 16) | (static_cast<u8>(str[1]) << 8) | static_cast<u8>(str[2]));
+        }
+    }
+
+    MenuSearch::MenuSearch(void) :
+        _queryMask(0), _hasResults(false)
+    {
+    }
+
+    void    MenuSearch::Clear(void)
+    {
+        _names.clear();
+        _offsets.clear();
+        _values.clear();
+        _masks.clear();
+        _trigrams.clear();
+        _starts.clear();
+        _postings.clear();
+        _hasResults = false;
+    }
+
+    u32     MenuSearch::Add(const std::string &name, u32 value)
+    {
+        _offsets.push_back(_names.size());
+        _values.push_back(value);
+
+        u64     mask = 0;
+
+        for (char c : name)
+        {
+            _names += Lower(c);
+            mask |= CharacterBit(Lower(c));
+        }
+        _names += '\0';
+        _masks.push_back(mask);
+
+        return (_offsets.size() - 1);
+    }
+
+    void    MenuSearch::Build(void)
+    {
+        MemoryTagScope  scope(MemoryTag::Menu);
+
+        // (trigram, item) pairs, sorted by trigram then item
+        std::vector<u64>    pairs;
+
+        for (u32 item = 0; item < _offsets.size(); ++item)
+        {
+            const char  *name = _names.c_str() + _offsets[item];
+            u32         length = std::strlen(name);
+
+            for (u32 i = 0; i + 3 <= length; ++i)
+                pairs.push_back((static_cast<u64>(Trigram(name + i)) << 32) | item);
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        _trigrams.clear();
+        _starts.clear();
+        _postings.clear();
+        _postings.reserve(pairs.size());
+
+        for (u64 pair : pairs)
+        {
+            u32     trigram = pair >> 32;
+
+            if (_trigrams.empty() || _trigrams.back() != trigram)
+            {
+                _trigrams.push_back(trigram);
+                _starts.push_back(_postings.size());
+            }
+            _postings.push_back(static_cast<u32>(pair));
+        }
+
+        _starts.push_back(_postings.size());
+        _hasResults = false;
+    }
+
+    void    MenuSearch::Normalize(const std::string &query, std::string &out) const
+    {
+        out.clear();
+        for (char c : query)
+        {
+            if (c == ' ')
+            {
+                if (!out.empty() && out.back() != ' ')
+                    out += ' ';
+            }
+            else
+                out += Lower(c);
+        }
+
+        if (!out.empty() && out.back() == ' ')
+            out.pop_back();
+    }
+
+    bool    MenuSearch::Matches(u32 item) const
+    {
+        if ((_masks[item] & _queryMask) != _queryMask)
+            return (false);
+
+        const char  *name = _names.c_str() + _offsets[item];
+
+        for (u32 word : _words)
+        {
+            const char  *str = _query.c_str() + word;
+
+            // The mask is exact for a single letter or digit
+            if (str[1] == '\0' && CharacterBit(str[0]) < (1ull << 36))
+                continue;
+            if (std::strstr(name, str) == nullptr)
+                return (false);
+        }
+
+        return (true);
+    }
+
+    const std::vector<u32>  &MenuSearch::Search(const std::string &query)
+    {
+        std::string     normalized;
+
+        Normalize(query, normalized);
+        if (_hasResults && normalized == _query)
+            return (_results);
+
+        // Every word of the previous query is contained in a word of the new one
+        bool    narrow = _hasResults && normalized.compare(0, _query.size(), _query) == 0;
+
+        _query = normalized;
+        _queryMask = 0;
+        for (char c : _query)
+            if (c != ' ')
+                _queryMask |= CharacterBit(c);
+
+        _words.clear();
+        for (u32 i = 0, start = 0; i <= _query.size(); ++i)
+        {
+            if (i == _query.size() || _query[i] == ' ')
+            {
+                if (i > start)
+                    _words.push_back(start);
+                start = i + 1;
+            }
+        }
+
+        // Split the words in place so they can be compared as C strings
+        std::replace(_query.begin(), _query.end(), ' ', '\0');
+
+        _scratch.clear();
+        if (narrow)
+        {
+            for (u32 item : _results)
+                if (Matches(item))
+                    _scratch.push_back(item);
+        }
+        else
+        {
+            // The rarest trigram of the query bounds the candidates
+            const u32   *first = nullptr;
+            const u32   *last = nullptr;
+
+            for (u32 word : _words)
+            {
+                const char  *str = _query.c_str() + word;
+                u32         length = std::strlen(str);
+
+                for (u32 i = 0; i + 3 <= length; ++i)
+                {
+                    std::vector<u32>::const_iterator    it = std::lower_bound(_trigrams.begin(), _trigrams.end(), Trigram(str + i));
+                    u32     index = it - _trigrams.begin();
+
+                    if (it == _trigrams.end() || *it != Trigram(str + i))
+                    {
+                        first = last = _postings.data();
+                        break;
+                    }
+
+                    if (first == nullptr || _starts[index + 1] - _starts[index] < static_cast<u32>(last - first))
+                    {
+                        first = _postings.data() + _starts[index];
+                        last = _postings.data() + _starts[index + 1];
+                    }
+                }
+
+                if (first != nullptr && first == last)
+                    break;
+            }
+
+            if (first != nullptr)
+            {
+                for (; first != last; ++first)
+                    if (Matches(*first))
+                        _scratch.push_back(*first);
+            }
+            else
+            {
+                // Words shorter than a trigram
+                for (u32 item = 0; item < _offsets.size(); ++item)
+                    if (Matches(item))
+                        _scratch.push_back(item);
+            }
+        }
+
+        // Restore the separators so the next query can be compared
+        std::replace(_query.begin(), _query.end(), '\0', ' ');
+
+        _results.swap(_scratch);
+        _hasResults = true;
+        return (_results);
+    }
+
+    u32     MenuSearch::Value(u32 item) const
+    {
+        return (_values[item]);
+    }
+
+    u32     MenuSearch::Count(void) const
+    {
+        return (_offsets.size());
+    }
+}
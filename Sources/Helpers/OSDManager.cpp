@@ -1,67 +1,305 @@
 #include "Helpers/OSDManager.hpp"
+#include "Helpers/Format.hpp"
+#include "Helpers/Profiler.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include "Helpers/RegionMap.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace CTRPluginFramework
 {
     _OSDManager*  _OSDManager::_singleton = nullptr;
 
+    namespace
+    {
+        const u32   InvalidHandle = 0xFFFFFFFF;
+        const u32   DirtyFlag = 0x80000000;
+        const u32   IndexMask = 0x3;
+
+        // Height of a line drawn by Screen::Draw
+        const u32   FontHeight = 10;
+
+        u32     MakeHandle(u32 slot, u16 generation)
+        {
+            return ((static_cast<u32>(generation) << 16) | slot);
+        }
+
+        // Read the raw bits of a watched value
+        bool    ReadWatch(u32 address, OSDWatchGetter getter, OSDWatchType type, u32 &raw)
+        {
+            if (getter != nullptr)
+            {
+                raw = getter();
+                return (true);
+            }
+
+            u32     size = type == OSDWatchType::U8 || type == OSDWatchType::S8 ? 1
+                           : type == OSDWatchType::U16 || type == OSDWatchType::S16 ? 2 : 4;
+
+            // The value may have been unmapped since the last frame
+            if (address == 0 || !RegionMap::Game().IsReadable(address, size))
+                return (false);
+
+            switch (type)
+            {
+            case OSDWatchType::U8:
+            case OSDWatchType::S8:
+                raw = *reinterpret_cast<const vu8 *>(address);
+                return (true);
+            case OSDWatchType::U16:
+            case OSDWatchType::S16:
+                raw = *reinterpret_cast<const vu16 *>(address);
+                return (true);
+            case OSDWatchType::U32:
+            case OSDWatchType::S32:
+            case OSDWatchType::Float:
+                raw = *reinterpret_cast<const vu32 *>(address);
+                return (true);
+            default:
+                return (false);
+            }
+        }
+
+        s32     SignExtend(OSDWatchType type, u32 raw)
+        {
+            if (type == OSDWatchType::S8)
+                return (static_cast<s8>(raw));
+            if (type == OSDWatchType::S16)
+                return (static_cast<s16>(raw));
+            return (static_cast<s32>(raw));
+        }
+
+        u32     FormatWatch(OSDWatchType type, OSDWatchFormat format, u8 width, u8 precision,
+                            u32 raw, char *out)
+        {
+            bool    isSigned = type == OSDWatchType::S8 || type == OSDWatchType::S16 || type == OSDWatchType::S32;
+
+            if (format == OSDWatchFormat::Hex)
+                return (FormatHex(out, raw, width));
+
+            if (format == OSDWatchFormat::Decimal && type != OSDWatchType::Float)
+            {
+                if (isSigned)
+                    return (FormatDecimal(out, SignExtend(type, raw), width));
+                return (FormatDecimal(out, raw, width));
+            }
+
+            double  value;
+
+            if (type == OSDWatchType::Float)
+            {
+                float   f;
+
+                std::memcpy(&f, &raw, sizeof(f));
+                value = f;
+            }
+            else
+                value = isSigned ? SignExtend(type, raw) : raw;
+
+            if (format == OSDWatchFormat::Decimal)
+                precision = 0;
+
+            return (FormatFloat(out, value, precision, width));
+        }
+
+#ifdef HELPERS_DEBUG
+        // Two strings sharing a hash would silently share the item
+        void    CheckCollision(const std::string &known, StringID id)
+        {
+            if (id.Source() != nullptr && !known.empty()
+                && known.compare(0, std::string::npos, id.Source(), id.Length()) != 0)
+                svcBreak(USERBREAK_ASSERT);
+        }
+#endif
+
+        bool    GetSurface(const Screen &screen, bool rightFb, RasterSurface &surface)
+        {
+            u8  *origin = screen.GetFramebufferAddress(0, 0, rightFb);
+
+            if (origin == nullptr)
+                return (false);
+
+            // Let the framework tell us how the framebuffer is laid out
+            surface.base = origin;
+            surface.columnStep = screen.GetFramebufferAddress(1, 0, rightFb) - origin;
+            surface.rowStep = screen.GetFramebufferAddress(0, 1, rightFb) - origin;
+            surface.width = screen.IsTop ? 400 : 320;
+            surface.height = 240;
+            surface.bytesPerPixel = screen.BytesPerPixel;
+            surface.format = static_cast<u32>(screen.Format);
+            return (true);
+        }
+    }
+
     OSDMI&  OSDMI::operator=(const std::string &str)
     {
-        OSDManager.Lock();
-        std::get<1>(data) = str;
-        std::get<4>(data) = true;
-        OSDManager.Unlock();
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        // Don't publish anything if the item is already up to date
+        if (item != nullptr && (!item->enabled || item->text != str))
+        {
+            item->text = str;
+            item->enabled = true;
+            manager.Publish(*item);
+        }
+        manager.Unlock();
         return (*this);
     }
 
     OSDMI&  OSDMI::operator=(const OSDMITuple &tuple)
     {
-        OSDManager.Lock();
-        data = tuple;
-        OSDManager.Unlock();
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        if (item != nullptr)
+        {
+            item->topScreen = std::get<0>(tuple);
+            item->text = std::get<1>(tuple);
+            item->posX = std::get<2>(tuple);
+            item->posY = std::get<3>(tuple);
+            item->enabled = std::get<4>(tuple);
+            manager.Publish(*item);
+        }
+        manager.Unlock();
         return (*this);
     }
 
     OSDMI&  OSDMI::SetPos(u32 posX, u32 posY)
     {
-        OSDManager.Lock();
-        std::get<2>(data) = posX;
-        std::get<3>(data) = posY;
-        OSDManager.Unlock();
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        if (item != nullptr && (item->posX != posX || item->posY != posY))
+        {
+            item->posX = posX;
+            item->posY = posY;
+            manager.Publish(*item);
+        }
+        manager.Unlock();
         return (*this);
     }
 
     OSDMI&  OSDMI::SetScreen(bool topScreen)
     {
-        OSDManager.Lock();
-        std::get<0>(data) = topScreen;
-        OSDManager.Unlock();
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        if (item != nullptr && item->topScreen != topScreen)
+        {
+            item->topScreen = topScreen;
+            manager.Publish(*item);
+        }
+        manager.Unlock();
         return (*this);
     }
 
     OSDMI&  OSDMI::Enable(void)
     {
-        OSDManager.Lock();
-        std::get<4>(data) = true;
-        OSDManager.Unlock();
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        if (item != nullptr && !item->enabled)
+        {
+            item->enabled = true;
+            manager.Publish(*item);
+        }
+        manager.Unlock();
         return (*this);
     }
 
     OSDMI&  OSDMI::Disable(void)
     {
-        OSDManager.Lock();
-        std::get<4>(data) = false;
-        OSDManager.Unlock();
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        if (item != nullptr && item->enabled)
+        {
+            item->enabled = false;
+            manager.Publish(*item);
+        }
+        manager.Unlock();
         return (*this);
     }
 
-    OSDMI::OSDMI(OSDMITuple &tuple) : data(tuple)
+    OSDMI&  OSDMI::Watch(u32 address, OSDWatchType type, OSDWatchFormat format, u8 width, u8 precision)
+    {
+        return (Bind(address, nullptr, type, format, width, precision));
+    }
+
+    OSDMI&  OSDMI::Watch(OSDWatchGetter getter, OSDWatchType type, OSDWatchFormat format, u8 width, u8 precision)
+    {
+        return (Bind(0, getter, type, format, width, precision));
+    }
+
+    OSDMI&  OSDMI::Unwatch(void)
+    {
+        return (Bind(0, nullptr, OSDWatchType::None, OSDWatchFormat::Decimal, 0, 0));
+    }
+
+    OSDMI&  OSDMI::Bind(u32 address, OSDWatchGetter getter, OSDWatchType type, OSDWatchFormat format,
+                        u8 width, u8 precision)
+    {
+        _OSDManager &manager = OSDManager;
+
+        manager.Lock();
+        _OSDManager::Item *item = manager.GetItem(handle);
+
+        if (item != nullptr)
+        {
+            item->watchType = type;
+            item->watchFormat = format;
+            item->watchWidth = width;
+            item->watchPrecision = precision;
+            item->watchAddress = address;
+            item->watchGetter = getter;
+            if (type != OSDWatchType::None)
+                item->enabled = true;
+            manager.Publish(*item);
+        }
+        manager.Unlock();
+        return (*this);
+    }
+
+    OSDMI::OSDMI(u32 handle_) : handle(handle_)
+    {
+
+    }
+
+    _OSDManager::Item::Item(void) :
+        used(false), topScreen(false), enabled(false), generation(0),
+        posX(0), posY(0), version(0), watchType(OSDWatchType::None),
+        watchFormat(OSDWatchFormat::Decimal), watchWidth(0), watchPrecision(0),
+        watchAddress(0), watchGetter(nullptr)
+    {
+    }
+
+    _OSDManager::WatchState::WatchState(void) :
+        version(0), serial(0), raw(0), valid(false)
+    {
+    }
+
+    _OSDManager::RenderCache::RenderCache(void) :
+        drawn(false), version(0), watchSerial(0), posX(0), posY(0)
     {
-       
     }
 
     _OSDManager::~_OSDManager(void)
     {
         OSD::Stop(OSDCallback);
+        _handles.clear();
         _items.clear();
     }
 
@@ -82,61 +320,331 @@ namespace CTRPluginFramework
         LightLock_Unlock(&_lock);
     }
 
-    OSDMI   _OSDManager::operator[](const std::string &key)
+    OSDMI   _OSDManager::operator[](StringID id)
     {
+        MemoryTagScope  scope(MemoryTag::OSD);
+
+        u32     handle = InvalidHandle;
+
         Lock();
-        OSDMI i(_items[key]);
+
+        auto it = std::lower_bound(_handles.begin(), _handles.end(), id.Value());
+
+        if (it != _handles.end() && it->id == id.Value())
+        {
+#ifdef HELPERS_DEBUG
+            CheckCollision(it->source, id);
+#endif
+            handle = it->handle;
+        }
+        else
+        {
+            u32     slot = InvalidHandle;
+
+            // Reuse a removed slot first, so the callback's range stays small
+            if (!_freeSlots.empty())
+            {
+                slot = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            else if (_count < MaxItems)
+            {
+                // The callback only reads the snapshots, which are grown when they're published
+                if (_count == _items.size())
+                    _items.resize(_items.size() * 2);
+                slot = _count++;
+            }
+
+#ifdef HELPERS_DEBUG
+            if (slot == InvalidHandle)
+                svcOutputDebugString("OSDManager: MaxItems reached", 28);
+#endif
+            if (slot != InvalidHandle)
+            {
+                Item &item = _items[slot];
+
+                item.used = true;
+                handle = MakeHandle(slot, item.generation);
+#ifdef HELPERS_DEBUG
+                _handles.insert(it, HandleEntry{ id.Value(), handle,
+                                                 id.Source() ? std::string(id.Source(), id.Length()) : std::string() });
+#else
+                _handles.insert(it, HandleEntry{ id.Value(), handle });
+#endif
+            }
+        }
+
         Unlock();
-        return (i);
+        return (OSDMI(handle));
     }
 
-    void    _OSDManager::Remove(const std::string& key)
+    OSDMI   _OSDManager::operator[](const std::string &key)
+    {
+        return ((*this)[StringID(key)]);
+    }
+
+    void    _OSDManager::Remove(StringID id)
     {
         Lock();
-        _items.erase(key);
+
+        auto it = std::lower_bound(_handles.begin(), _handles.end(), id.Value());
+
+        if (it != _handles.end() && it->id == id.Value())
+        {
+#ifdef HELPERS_DEBUG
+            CheckCollision(it->source, id);
+#endif
+            u32     slot = it->handle & 0xFFFF;
+            Item    &item = _items[slot];
+
+            // Reset the item and invalidate every OSDMI still pointing to it
+            item.used = false;
+            item.topScreen = false;
+            item.enabled = false;
+            item.posX = item.posY = 0;
+            item.text.clear();
+            item.watchType = OSDWatchType::None;
+            item.watchAddress = 0;
+            item.watchGetter = nullptr;
+            item.generation++;
+            Publish(item);
+
+            _freeSlots.push_back(slot);
+            _handles.erase(it);
+        }
+
         Unlock();
     }
 
-    _OSDManager::_OSDManager(void)
+    void    _OSDManager::Remove(const std::string &key)
+    {
+        Remove(StringID(key));
+    }
+
+    _OSDManager::_OSDManager(void) :
+        _count(0), _serial(0), _backIndex(0), _pendingIndex(1), _frontIndex(2), _retained(true)
     {
         LightLock_Init(&_lock);
+
+        // Allocate the usual amount of items now, the callback only allocates when they're outgrown
+        _items.resize(InitialItems);
+        _handles.reserve(InitialItems);
+        _freeSlots.reserve(InitialItems);
+        for (Snapshot &snapshot : _snapshots)
+        {
+            snapshot.count = 0;
+            snapshot.items.resize(InitialItems);
+        }
+        _watches.resize(InitialItems);
+        for (WatchState &watch : _watches)
+            watch.text.reserve(32);
+        _caches[0].resize(InitialItems);
+        _caches[1].resize(InitialItems);
+
         OSD::Run(OSDCallback);
     }
 
+    _OSDManager::Item   *_OSDManager::GetItem(u32 handle)
+    {
+        u32     slot = handle & 0xFFFF;
+
+        if (slot >= _count)
+            return (nullptr);
+
+        Item    &item = _items[slot];
+
+        // The item was removed since the handle was obtained
+        if (!item.used || MakeHandle(slot, item.generation) != handle)
+            return (nullptr);
+
+        return (&item);
+    }
+
+    void    _OSDManager::Publish(Item &item)
+    {
+        item.version = ++_serial;
+
+        Snapshot    &back = _snapshots[_backIndex];
+
+        // The back buffer belongs to the writers until it's exchanged
+        if (back.items.size() < _items.size())
+            back.items.resize(_items.size());
+
+        // Only copy the items that changed since this buffer was last published
+        for (u32 i = 0; i < _count; ++i)
+        {
+            const Item  &src = _items[i];
+            Item        &dst = back.items[i];
+
+            if (dst.version != src.version)
+                dst = src;
+        }
+
+        back.count = _count;
+        _backIndex = _pendingIndex.exchange(_backIndex | DirtyFlag, std::memory_order_acq_rel) & IndexMask;
+    }
+
+    const _OSDManager::Snapshot &_OSDManager::AcquireSnapshot(void)
+    {
+        if (_pendingIndex.load(std::memory_order_acquire) & DirtyFlag)
+            _frontIndex = _pendingIndex.exchange(_frontIndex, std::memory_order_acq_rel) & IndexMask;
+
+        return (_snapshots[_frontIndex]);
+    }
+
+    void    _OSDManager::SetRetainedMode(bool retained)
+    {
+        _retained.store(retained, std::memory_order_relaxed);
+    }
+
+    const std::vector<DirtyRect>    &_OSDManager::GetDirtyRects(bool topScreen) const
+    {
+        return (_dirty[topScreen].Rects());
+    }
+
+    void    _OSDManager::GrowCallbackState(const Snapshot &snapshot)
+    {
+        u32     size = snapshot.items.size();
+
+        if (_watches.size() < size)
+        {
+            u32     old = _watches.size();
+
+            _watches.resize(size);
+            for (u32 i = old; i < size; ++i)
+                _watches[i].text.reserve(32);
+        }
+
+        for (std::vector<RenderCache> &caches : _caches)
+            if (caches.size() < size)
+                caches.resize(size);
+    }
+
+    void    _OSDManager::SampleWatches(const Snapshot &snapshot)
+    {
+        char    buffer[FormatMaxWidth + 64];
+
+        for (u32 i = 0; i < snapshot.count; ++i)
+        {
+            const Item  &item = snapshot.items[i];
+
+            if (!item.used || item.watchType == OSDWatchType::None)
+                continue;
+
+            WatchState  &watch = _watches[i];
+            u32         raw = 0;
+            bool        valid = ReadWatch(item.watchAddress, item.watchGetter, item.watchType, raw);
+
+            // Same binding and same bits, nothing to do
+            if (watch.version == item.version && watch.valid == valid && (!valid || watch.raw == raw))
+                continue;
+
+            watch.version = item.version;
+            watch.valid = valid;
+            watch.raw = raw;
+            watch.serial++;
+
+            // The capacity reserved beforehand avoids any allocation here
+            watch.text.assign(item.text);
+            if (!valid)
+                watch.text.append("???");
+            else
+                watch.text.append(buffer, FormatWatch(item.watchType, item.watchFormat, item.watchWidth,
+                                                      item.watchPrecision, raw, buffer));
+        }
+    }
+
     bool    _OSDManager::OSDCallback(const Screen &screen)
     {
+        PROFILE_ZONE("OSDCallback");
+        MemoryTagScope  scope(MemoryTag::OSD);
+
         _OSDManager &manager = OSDManager;
-        
-        manager.Lock();
+        const Snapshot &snapshot = manager.AcquireSnapshot();
+
+        manager.GrowCallbackState(snapshot);
+
+        std::vector<RenderCache> &caches = manager._caches[screen.IsTop];
+        DirtyRegion &dirty = manager._dirty[screen.IsTop];
+
+        dirty.Clear();
 
         // If there's no item to draw
-        if (manager._items.empty())
-        {
-            manager.Unlock();
+        if (snapshot.count == 0)
             return (false);
-        }
 
-        bool    fbEdited = false;
+        // The top screen callback starts a new frame, sample all the watches at once
+        if (screen.IsTop)
+            manager.SampleWatches(snapshot);
+
+        RasterSurface   left;
+        RasterSurface   right;
+        bool            retained = manager._retained.load(std::memory_order_relaxed)
+                                    && GetSurface(screen, false, left);
+        bool            stereo = retained && screen.IsTop && screen.Is3DEnabled
+                                    && GetSurface(screen, true, right);
+        u8              foreground[4];
+        u8              background[4];
+        bool            fbEdited = false;
+
+        if (retained)
+        {
+            // Screen::Draw default colors
+            EncodePixel(left.format, 255, 255, 255, 255, foreground);
+            EncodePixel(left.format, 0, 0, 0, 255, background);
+        }
 
         // Iterate through all our items
-        for (auto item : manager._items)
+        for (u32 i = 0; i < snapshot.count; ++i)
         {
-            auto &t = item.second;
-            std::string &str = std::get<1>(t);
+            const Item  &item = snapshot.items[i];
+            RenderCache &cache = caches[i];
+            bool        isWatch = item.watchType != OSDWatchType::None;
+            const std::string &text = isWatch ? manager._watches[i].text : item.text;
+            u32         watchSerial = isWatch ? manager._watches[i].serial : 0;
+            bool        visible = item.used && item.enabled && !text.empty()
+                                    && item.topScreen == screen.IsTop;
+
+            // The area previously covered by the item has to be redrawn
+            if (cache.drawn && (!visible || cache.version != item.version || cache.watchSerial != watchSerial))
+            {
+                dirty.Add(DirtyRect{ cache.posX, cache.posY, cache.bitmap.Width(), cache.bitmap.Height() });
+                cache.drawn = false;
+            }
 
-            // If item is disabled or if the item is empty
-            if (!std::get<4>(t) || str.empty())
+            // If item is disabled, empty or for the other screen
+            if (!visible)
                 continue;
 
-            // If wanted screen correspond to the screen received, draw the item
-            if (std::get<0>(t) == screen.IsTop)
-            {                
-                screen.Draw(str, std::get<2>(t), std::get<3>(t));
-                fbEdited = true;
+            fbEdited = true;
+
+            // Nothing changed, copy the cached bitmap
+            if (retained && cache.drawn && cache.bitmap.Format() == left.format)
+            {
+                cache.bitmap.Blit(left, item.posX, item.posY);
+                if (stereo)
+                    cache.bitmap.Blit(right, item.posX, item.posY);
+                continue;
+            }
+
+            screen.Draw(text, item.posX, item.posY);
+
+            if (!retained)
+                continue;
+
+            u32     width = static_cast<u32>(OSD::GetTextWidth(false, text) + 0.5f);
+
+            if (cache.bitmap.Capture(left, item.posX, item.posY, width, FontHeight, foreground, background))
+            {
+                cache.drawn = true;
+                cache.version = item.version;
+                cache.watchSerial = watchSerial;
+                cache.posX = item.posX;
+                cache.posY = item.posY;
+                dirty.Add(DirtyRect{ item.posX, item.posY, cache.bitmap.Width(), cache.bitmap.Height() });
             }
         }
 
-        manager.Unlock();
         return (fbEdited);
     }
 }
@@ -0,0 +1,222 @@
+#include "Helpers/OSDRaster.hpp"
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    u32     EncodePixel(u32 format, u8 r, u8 g, u8 b, u8 a, u8 *out)
+    {
+        u16     half;
+
+        switch (format)
+        {
+        case 0: // RGBA8
+            out[0] = a;
+            out[1] = b;
+            out[2] = g;
+            out[3] = r;
+            return (4);
+        case 1: // BGR8
+            out[0] = b;
+            out[1] = g;
+            out[2] = r;
+            return (3);
+        case 2: // RGB565
+            half = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+            break;
+        case 3: // RGB5A1
+            half = ((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) | (a >> 7);
+            break;
+        case 4: // RGBA4
+            half = ((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) | (a >> 4);
+            break;
+        default:
+            return (0);
+        }
+
+        out[0] = half & 0xFF;
+        out[1] = half >> 8;
+        return (2);
+    }
+
+    TextBitmap::TextBitmap(void) :
+        _height(0), _format(0), _bytesPerPixel(0)
+    {
+        std::memset(_foreground, 0, sizeof(_foreground));
+        std::memset(_background, 0, sizeof(_background));
+    }
+
+    bool    TextBitmap::Capture(const RasterSurface &surface, u32 posX, u32 posY, u32 width, u32 height,
+                                const u8 *foreground, const u8 *background)
+    {
+        u32     bpp = surface.bytesPerPixel;
+
+        if (bpp < 2 || bpp > 4 || posX >= surface.width || posY >= surface.height)
+        {
+            Clear();
+            return (false);
+        }
+
+        // Clip the box to the surface
+        if (posX + width > surface.width)
+            width = surface.width - posX;
+        if (posY + height > surface.height)
+            height = surface.height - posY;
+        if (height > MaxHeight)
+            height = MaxHeight;
+
+        _columns.resize(width);
+        _height = height;
+        _format = surface.format;
+        _bytesPerPixel = bpp;
+        std::memcpy(_foreground, foreground, bpp);
+        std::memcpy(_background, background, bpp);
+
+        for (u32 x = 0; x < width; ++x)
+        {
+            const u8    *pixel = surface.base + static_cast<s32>(posX + x) * surface.columnStep
+                                              + static_cast<s32>(posY) * surface.rowStep;
+            u16         bits = 0;
+
+            for (u32 y = 0; y < height; ++y, pixel += surface.rowStep)
+            {
+                if (std::memcmp(pixel, foreground, bpp) == 0)
+                    bits |= 1 << y;
+            }
+
+            _columns[x] = bits;
+        }
+
+        return (true);
+    }
+
+    void    TextBitmap::Blit(const RasterSurface &surface, u32 posX, u32 posY) const
+    {
+        u32     bpp = _bytesPerPixel;
+
+        if (_columns.empty() || surface.format != _format || surface.bytesPerPixel != bpp
+            || posX >= surface.width || posY >= surface.height)
+            return;
+
+        u32     width = _columns.size();
+        u32     height = _height;
+
+        if (posX + width > surface.width)
+            width = surface.width - posX;
+        if (posY + height > surface.height)
+            height = surface.height - posY;
+
+        for (u32 x = 0; x < width; ++x)
+        {
+            u8      *pixel = surface.base + static_cast<s32>(posX + x) * surface.columnStep
+                                          + static_cast<s32>(posY) * surface.rowStep;
+            u32     bits = _columns[x];
+
+            for (u32 y = 0; y < height; ++y, bits >>= 1, pixel += surface.rowStep)
+            {
+                const u8 *color = (bits & 1) ? _foreground : _background;
+
+                pixel[0] = color[0];
+                pixel[1] = color[1];
+                if (bpp > 2)
+                    pixel[2] = color[2];
+                if (bpp > 3)
+                    pixel[3] = color[3];
+            }
+        }
+    }
+
+    void    TextBitmap::Clear(void)
+    {
+        _columns.clear();
+        _height = 0;
+    }
+
+    bool    TextBitmap::IsEmpty(void) const
+    {
+        return (_columns.empty());
+    }
+
+    u32     TextBitmap::Width(void) const
+    {
+        return (_columns.size());
+    }
+
+    u32     TextBitmap::Height(void) const
+    {
+        return (_height);
+    }
+
+    u32     TextBitmap::Format(void) const
+    {
+        return (_format);
+    }
+
+    bool    TextBitmap::IsSet(u32 x, u32 y) const
+    {
+        if (x >= _columns.size() || y >= _height)
+            return (false);
+        return ((_columns[x] >> y) & 1);
+    }
+
+    static bool     Overlaps(const DirtyRect &a, const DirtyRect &b)
+    {
+        return (a.x <= b.x + b.width && b.x <= a.x + a.width
+            && a.y <= b.y + b.height && b.y <= a.y + a.height);
+    }
+
+    void    DirtyRegion::Add(const DirtyRect &rect)
+    {
+        if (rect.width == 0 || rect.height == 0)
+            return;
+
+        DirtyRect   merged = rect;
+
+        // Absorb every rect touching the new one, repeat as the union grows
+        for (u32 i = 0; i < _rects.size();)
+        {
+            const DirtyRect &other = _rects[i];
+
+            if (!Overlaps(merged, other))
+            {
+                ++i;
+                continue;
+            }
+
+            u32 right = merged.x + merged.width;
+            u32 bottom = merged.y + merged.height;
+
+            if (other.x + other.width > right)
+                right = other.x + other.width;
+            if (other.y + other.height > bottom)
+                bottom = other.y + other.height;
+            if (other.x < merged.x)
+                merged.x = other.x;
+            if (other.y < merged.y)
+                merged.y = other.y;
+
+            merged.width = right - merged.x;
+            merged.height = bottom - merged.y;
+
+            _rects[i] = _rects.back();
+            _rects.pop_back();
+            i = 0;
+        }
+
+        _rects.push_back(merged);
+    }
+
+    void    DirtyRegion::Clear(void)
+    {
+        _rects.clear();
+    }
+
+    bool    DirtyRegion::IsEmpty(void) const
+    {
+        return (_rects.empty());
+    }
+
+    const std::vector<DirtyRect>    &DirtyRegion::Rects(void) const
+    {
+        return (_rects);
+    }
+}
@@ -0,0 +1,246 @@
+#include "Helpers/PatchBatch.hpp"
+#include "Helpers/RegionMap.hpp"
+#include "CTRPluginFramework.hpp"
+#include "csvc.h"
+#include <algorithm>
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    PatchBatch  *PatchBatch::_firstApplied = nullptr;
+
+    namespace
+    {
+        const u32   NoExpected = 0xFFFFFFFF;
+
+        class GameTarget : public PatchTarget
+        {
+        public:
+            bool    Read(u32 address, void *out, u32 size) override
+            {
+                if (!RegionMap::Game().IsReadable(address, size))
+                    return (false);
+
+                std::memcpy(out, reinterpret_cast<const void *>(address), size);
+                return (true);
+            }
+
+            bool    Write(u32 address, const void *data, u32 size) override
+            {
+                RegionMap   &regions = RegionMap::Game();
+
+                // Read only ranges like the code are left to CheckAddress, as before
+                if (!regions.IsWritable(address, size)
+                    && !(regions.IsReadable(address, size)
+                         && Process::CheckAddress(address, MEMPERM_READ | MEMPERM_WRITE)
+                         && Process::CheckAddress(address + size - 1, MEMPERM_READ | MEMPERM_WRITE)))
+                    return (false);
+
+                std::memcpy(reinterpret_cast<void *>(address), data, size);
+                return (true);
+            }
+
+            void    Flush(u32 address, u32 size) override
+            {
+                svcFlushDataCacheRange(reinterpret_cast<void *>(address), size);
+                svcInvalidateInstructionCacheRange(reinterpret_cast<void *>(address), size);
+            }
+        };
+    }
+
+    PatchTarget     &PatchTarget::Game(void)
+    {
+        static GameTarget   target;
+
+        return (target);
+    }
+
+    PatchBatch::PatchBatch(PatchTarget &target) :
+        _target(target), _nextApplied(nullptr), _applied(false)
+    {
+    }
+
+    PatchBatch::~PatchBatch(void)
+    {
+        Revert();
+    }
+
+    PatchBatch  &PatchBatch::Add(u32 address, const void *data, u32 size, const void *expected)
+    {
+        if (_applied || size == 0)
+            return (*this);
+
+        Edit    edit = { address, size, static_cast<u32>(_bytes.size()), NoExpected, 0 };
+
+        _bytes.insert(_bytes.end(), static_cast<const u8 *>(data), static_cast<const u8 *>(data) + size);
+
+        if (expected != nullptr)
+        {
+            edit.expected = _bytes.size();
+            _bytes.insert(_bytes.end(), static_cast<const u8 *>(expected), static_cast<const u8 *>(expected) + size);
+        }
+
+        // Room for the original bytes, read by Apply
+        edit.original = _bytes.size();
+        _bytes.resize(_bytes.size() + size);
+
+        _edits.push_back(edit);
+        return (*this);
+    }
+
+    PatchBatch  &PatchBatch::Add(u32 address, u32 value)
+    {
+        return (Add(address, &value, sizeof(value)));
+    }
+
+    PatchBatch  &PatchBatch::Add(u32 address, u32 value, u32 expected)
+    {
+        return (Add(address, &value, sizeof(value), &expected));
+    }
+
+    bool    PatchBatch::Apply(void)
+    {
+        if (_applied)
+            return (true);
+
+        if (_edits.empty())
+            return (false);
+
+        std::sort(_edits.begin(), _edits.end(),
+            [](const Edit &left, const Edit &right) { return (left.address < right.address); });
+
+        // Check everything before writing anything
+        for (u32 i = 0; i < _edits.size(); ++i)
+        {
+            const Edit  &edit = _edits[i];
+
+            if (i > 0 && _edits[i - 1].address + _edits[i - 1].size > edit.address)
+                return (false);
+
+            if (!_target.Read(edit.address, &_bytes[edit.original], edit.size))
+                return (false);
+
+            if (edit.expected != NoExpected
+                && std::memcmp(&_bytes[edit.original], &_bytes[edit.expected], edit.size) != 0)
+                return (false);
+        }
+
+        for (u32 i = 0; i < _edits.size(); ++i)
+        {
+            const Edit  &edit = _edits[i];
+
+            if (!_target.Write(edit.address, &_bytes[edit.data], edit.size))
+            {
+                // Undo the edits already written, the caches may hold them already
+                for (u32 k = i; k-- > 0;)
+                    _target.Write(_edits[k].address, &_bytes[_edits[k].original], _edits[k].size);
+                Merge(i);
+                Flush();
+                _ranges.clear();
+                return (false);
+            }
+        }
+
+        Merge(_edits.size());
+        Flush();
+        _applied = true;
+        Link();
+        return (true);
+    }
+
+    void    PatchBatch::Revert(void)
+    {
+        if (!_applied)
+            return;
+
+        for (u32 i = _edits.size(); i-- > 0;)
+            _target.Write(_edits[i].address, &_bytes[_edits[i].original], _edits[i].size);
+
+        Flush();
+        _applied = false;
+        Unlink();
+    }
+
+    void    PatchBatch::Clear(void)
+    {
+        Revert();
+        _edits.clear();
+        _bytes.clear();
+        _ranges.clear();
+    }
+
+    bool    PatchBatch::IsApplied(void) const
+    {
+        return (_applied);
+    }
+
+    u32     PatchBatch::EditCount(void) const
+    {
+        return (_edits.size());
+    }
+
+    u32     PatchBatch::FlushCount(void) const
+    {
+        return (_ranges.size());
+    }
+
+    void    PatchBatch::RevertAll(void)
+    {
+        while (_firstApplied != nullptr)
+            _firstApplied->Revert();
+    }
+
+    // The ranges of the first count edits, the close ones merged
+    void    PatchBatch::Merge(u32 count)
+    {
+        _ranges.clear();
+        for (u32 i = 0; i < count; ++i)
+        {
+            const Edit  &edit = _edits[i];
+
+            if (!_ranges.empty() && edit.address <= _ranges.back().address + _ranges.back().size + CoalesceGap)
+                _ranges.back().size = edit.address + edit.size - _ranges.back().address;
+            else
+            {
+                Range   range = { edit.address, edit.size };
+
+                _ranges.push_back(range);
+            }
+        }
+    }
+
+    void    PatchBatch::Flush(void)
+    {
+        for (const Range &range : _ranges)
+            _target.Flush(range.address, range.size);
+    }
+
+    void    PatchBatch::Link(void)
+    {
+        _nextApplied = _firstApplied;
+        _firstApplied = this;
+    }
+
+    void    PatchBatch::Unlink(void)
+    {
+        PatchBatch  **link = &_firstApplied;
+
+        while (*link != nullptr && *link != this)
+            link = &(*link)->_nextApplied;
+
+        if (*link == this)
+            *link = _nextApplied;
+        _nextApplied = nullptr;
+    }
+
+    void    TogglePatch(MenuEntry *entry, PatchBatch &batch)
+    {
+        if (entry->IsActivated())
+        {
+            if (!batch.IsApplied() && !batch.Apply())
+                entry->Disable();
+        }
+        else
+            batch.Revert();
+    }
+}
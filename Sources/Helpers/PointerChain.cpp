@@ -0,0 +1,6 @@
+#include "Helpers/PointerChain.hpp"
+
+namespace CTRPluginFramework
+{
+    u32     FrameGeneration::_frame = 0;
+}
@@ -0,0 +1,444 @@
+#include "Helpers/PointerScanner.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include <3ds.h>
+#include <algorithm>
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        const u32   FileMagic = 0x53525450; ///< PTRS
+        const u32   FileVersion = 1;
+
+        // The plugin lives there, its memory must not be indexed
+        const u32   PluginStart = 0x07000000;
+        const u32   PluginEnd = 0x08000000;
+
+        // Granularity of the coarse "is this value inside a region" bitmaps
+        const u32   PageShift = 16;
+        const u32   PageCount = 1 << (32 - PageShift);
+
+        const u32   NoParent = 0xFFFFFFFF;
+
+        struct FileHeader
+        {
+            u32     magic;
+            u32     version;
+            u32     target;
+            u32     count;
+        };
+
+        // A location found while walking backward from the target
+        struct Node
+        {
+            u32     address;
+            u32     offset;     ///< *address + offset = parent's address
+            u32     parent;
+
+            bool    operator<(const Node &right) const
+            {
+                return (address < right.address);
+            }
+        };
+
+        inline bool     TestBit(const std::vector<u32> &bits, u32 index)
+        {
+            return ((bits[index >> 5] >> (index & 31)) & 1);
+        }
+
+        inline void     SetBit(std::vector<u32> &bits, u32 index)
+        {
+            bits[index >> 5] |= 1u << (index & 31);
+        }
+
+        inline u32      Read32(const u8 *src)
+        {
+            u32     value;
+
+            std::memcpy(&value, src, sizeof(value));
+            return (value);
+        }
+
+        void    Append32(std::vector<u8> &out, u32 value)
+        {
+            u32     size = out.size();
+
+            out.resize(size + 4);
+            std::memcpy(out.data() + size, &value, 4);
+        }
+    }
+
+    PointerScanner::PointerScanner(void)
+    {
+    }
+
+    void    PointerScanner::AddRegion(u32 address, const void *data, u32 size, bool isStatic)
+    {
+        Region  region = { address, static_cast<const u8 *>(data), size & ~3u, isStatic, 0 };
+
+        if (region.size == 0)
+            return;
+
+        // The buckets are numbered from the regions, the index must be built again
+        _buckets.clear();
+        _locations.clear();
+
+        _regions.insert(std::upper_bound(_regions.begin(), _regions.end(), region,
+            [](const Region &left, const Region &right) { return (left.address < right.address); }), region);
+    }
+
+    void    PointerScanner::AddProcessRegions(void)
+    {
+        MemInfo     info;
+        PageInfo    page;
+        u32         address = 0x00100000;
+
+        while (address < 0x40000000)
+        {
+            if (R_FAILED(svcQueryMemory(&info, &page, address)) || info.size == 0)
+                break;
+
+            bool    readable = (info.perm & MEMPERM_READ) && info.state != MEMSTATE_FREE
+                                && info.state != MEMSTATE_RESERVED && info.state != MEMSTATE_IO;
+            bool    isPlugin = info.base_addr >= PluginStart && info.base_addr < PluginEnd;
+
+            if (readable && !isPlugin)
+                AddRegion(info.base_addr, reinterpret_cast<const void *>(info.base_addr), info.size,
+                          info.base_addr < PluginStart);
+
+            address = info.base_addr + info.size;
+        }
+    }
+
+    void    PointerScanner::Reset(void)
+    {
+        _regions.clear();
+        _buckets.clear();
+        _buckets.shrink_to_fit();
+        _locations.clear();
+        _locations.shrink_to_fit();
+    }
+
+    u32     PointerScanner::BuildIndex(void)
+    {
+        MemoryTagScope  scope(MemoryTag::Search);
+
+        // Pages touched by a region, most of the words which aren't pointers fail there
+        std::vector<u32>    mapped(PageCount / 32, 0);
+
+        for (const Region &region : _regions)
+        {
+            u32     first = region.address >> PageShift;
+            u32     last = (region.address + region.size - 1) >> PageShift;
+
+            for (u32 page = first; page <= last; ++page)
+                SetBit(mapped, page);
+        }
+
+        // Number the buckets region after region
+        u32     bucketCount = 0;
+
+        for (Region &region : _regions)
+        {
+            region.firstBucket = bucketCount;
+            bucketCount += (region.size + BucketSize - 1) / BucketSize;
+        }
+
+        _buckets.assign(bucketCount + 1, 0);
+        _locations.clear();
+        _locations.shrink_to_fit();
+
+        // Count the pointers of each bucket, then read everything again to place them: the
+        // index is allocated once at its size instead of growing
+        std::vector<u32>    cursors;
+
+        for (u32 pass = 0; pass < 2; ++pass)
+        {
+            for (const Region &region : _regions)
+            {
+                for (u32 offset = 0; offset < region.size; offset += 4)
+                {
+                    u32     value = Read32(region.data + offset);
+
+                    if (!TestBit(mapped, value >> PageShift))
+                        continue;
+
+                    const Region    *target = FindRegion(value);
+
+                    if (target == nullptr)
+                        continue;
+
+                    u32     bucket = BucketOf(*target, value);
+
+                    if (pass == 0)
+                        ++_buckets[bucket + 1];
+                    // The game runs meanwhile, a bucket may have grown since it was counted
+                    else if (cursors[bucket] < _buckets[bucket + 1])
+                        _locations[cursors[bucket]++] = region.address + offset;
+                }
+            }
+
+            if (pass == 0)
+            {
+                for (u32 i = 1; i <= bucketCount; ++i)
+                    _buckets[i] += _buckets[i - 1];
+                _locations.resize(_buckets[bucketCount]);
+                cursors.assign(_buckets.begin(), _buckets.end() - 1);
+            }
+        }
+
+        // Or shrunk, close the gaps
+        u32     size = 0;
+
+        for (u32 i = 0; i < bucketCount; ++i)
+        {
+            u32     start = _buckets[i];
+
+            _buckets[i] = size;
+            for (u32 j = start; j < cursors[i]; ++j)
+                _locations[size++] = _locations[j];
+        }
+
+        _buckets[bucketCount] = size;
+        _locations.resize(size);
+        return (_locations.size());
+    }
+
+    u32     PointerScanner::Scan(u32 target, u32 maxDepth, u32 maxOffset, u32 maxResults, std::vector<PointerPath> &out) const
+    {
+        MemoryTagScope  scope(MemoryTag::Search);
+
+        std::vector<Node>   nodes;
+        std::vector<Node>   found;
+        std::vector<u32>    visited;
+        u32                 results = 0;
+
+        if (maxDepth > PointerPath::MaxDepth)
+            maxDepth = PointerPath::MaxDepth;
+
+        if (_buckets.empty())
+            return (0);
+
+        Node    root = { target, 0, NoParent };
+
+        nodes.push_back(root);
+        visited.push_back(target);
+
+        u32     levelStart = 0;
+        u32     levelEnd = 1;
+
+        for (u32 depth = 1; depth <= maxDepth && levelStart < levelEnd; ++depth)
+        {
+            found.clear();
+
+            for (u32 i = levelStart; i < levelEnd; ++i)
+            {
+                u32     address = nodes[i].address;
+                u32     lowest = address >= maxOffset ? address - maxOffset : 0;
+
+                // Every pointer with a value in [lowest, address]: the buckets of the regions
+                // overlapping that range, from the region holding lowest or the next one
+                auto    first = std::upper_bound(_regions.begin(), _regions.end(), lowest,
+                    [](u32 value, const Region &region) { return (value < region.address); });
+
+                if (first != _regions.begin() && lowest - (first - 1)->address < (first - 1)->size)
+                    --first;
+
+                for (auto target = first; target != _regions.end() && target->address <= address; ++target)
+                {
+                    u32     start = lowest > target->address ? lowest : target->address;
+                    u32     end = address - target->address < target->size ? address : target->address + target->size - 1;
+                    u32     from = _buckets[BucketOf(*target, start)];
+                    u32     to = _buckets[BucketOf(*target, end) + 1];
+
+                    for (u32 j = from; j < to; ++j)
+                    {
+                        u32     location = _locations[j];
+                        const Region *region = FindRegion(location);
+                        u32     value = Read32(region->data + (location - region->address));
+
+                        if (value < lowest || value > address)
+                            continue;
+
+                        Node    node = { location, address - value, i };
+
+                        if (!region->isStatic)
+                        {
+                            found.push_back(node);
+                            continue;
+                        }
+
+                        PointerPath path;
+
+                        path.base = node.address;
+                        path.depth = 0;
+                        for (const Node *n = &node; n->parent != NoParent; n = &nodes[n->parent])
+                            path.offsets[path.depth++] = n->offset;
+
+                        out.push_back(path);
+                        if (++results >= maxResults)
+                            return (results);
+                    }
+                }
+            }
+
+            if (depth == maxDepth)
+                break;
+
+            // Keep the first way found to reach each location
+            std::stable_sort(found.begin(), found.end());
+
+            levelStart = nodes.size();
+            for (u32 i = 0; i < found.size(); ++i)
+            {
+                if (i > 0 && found[i].address == found[i - 1].address)
+                    continue;
+                if (std::binary_search(visited.begin(), visited.end(), found[i].address))
+                    continue;
+                nodes.push_back(found[i]);
+            }
+            levelEnd = nodes.size();
+
+            u32     middle = visited.size();
+
+            for (u32 i = levelStart; i < levelEnd; ++i)
+                visited.push_back(nodes[i].address);
+            std::inplace_merge(visited.begin(), visited.begin() + middle, visited.end());
+        }
+
+        return (results);
+    }
+
+    bool    PointerScanner::Resolve(const PointerPath &path, u32 &address) const
+    {
+        address = path.base;
+
+        for (u32 i = 0; i < path.depth; ++i)
+        {
+            const Region *region = FindRegion(address);
+
+            if (region == nullptr || (address & 3) || address + 4 > region->address + region->size)
+                return (false);
+
+            address = Read32(region->data + (address - region->address)) + path.offsets[i];
+        }
+
+        return (true);
+    }
+
+    u32     PointerScanner::Rescan(std::vector<PointerPath> &paths, u32 target) const
+    {
+        u32     kept = 0;
+
+        for (const PointerPath &path : paths)
+        {
+            u32     address;
+
+            if (Resolve(path, address) && address == target)
+                paths[kept++] = path;
+        }
+
+        paths.resize(kept);
+        return (kept);
+    }
+
+    u32     PointerScanner::IndexSize(void) const
+    {
+        return (_locations.size());
+    }
+
+    u32     PointerScanner::MemoryUsage(void) const
+    {
+        return ((_locations.capacity() + _buckets.capacity()) * sizeof(u32));
+    }
+
+    void    PointerScanner::Serialize(const std::vector<PointerPath> &paths, u32 target, std::vector<u8> &out)
+    {
+        FileHeader  header = { FileMagic, FileVersion, target, static_cast<u32>(paths.size()) };
+
+        out.resize(sizeof(header));
+        std::memcpy(out.data(), &header, sizeof(header));
+
+        for (const PointerPath &path : paths)
+        {
+            Append32(out, path.base);
+            Append32(out, path.depth);
+            for (u32 i = 0; i < path.depth; ++i)
+                Append32(out, path.offsets[i]);
+        }
+    }
+
+    bool    PointerScanner::Deserialize(const u8 *data, u32 size, std::vector<PointerPath> &paths, u32 &target)
+    {
+        FileHeader  header;
+        const u8    *end = data + size;
+
+        if (size < sizeof(header))
+            return (false);
+
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != FileMagic || header.version != FileVersion)
+            return (false);
+
+        data += sizeof(header);
+
+        // A path takes 8 bytes at least, a damaged count mustn't reserve more than the file holds
+        if (header.count > static_cast<u32>(end - data) / 8)
+            return (false);
+
+        paths.clear();
+        paths.reserve(header.count);
+
+        for (u32 i = 0; i < header.count; ++i)
+        {
+            PointerPath path;
+
+            if (end - data < 8)
+                return (false);
+
+            path.base = Read32(data);
+            path.depth = Read32(data + 4);
+            data += 8;
+
+            if (path.depth > PointerPath::MaxDepth || static_cast<u32>(end - data) < path.depth * 4)
+                return (false);
+
+            for (u32 j = 0; j < path.depth; ++j, data += 4)
+                path.offsets[j] = Read32(data);
+
+            paths.push_back(path);
+        }
+
+        target = header.target;
+        return (true);
+    }
+
+    bool    PointerScanner::Save(const std::string &path, const std::vector<PointerPath> &paths, u32 target)
+    {
+        std::vector<u8>     buffer;
+
+        Serialize(paths, target, buffer);
+        return (WriteFile(path, buffer.data(), buffer.size()));
+    }
+
+    bool    PointerScanner::Load(const std::string &path, std::vector<PointerPath> &paths, u32 &target)
+    {
+        std::vector<u8>     buffer;
+
+        return (ReadFile(path, buffer) && Deserialize(buffer.data(), buffer.size(), paths, target));
+    }
+
+    const PointerScanner::Region    *PointerScanner::FindRegion(u32 address) const
+    {
+        auto    it = std::upper_bound(_regions.begin(), _regions.end(), address,
+            [](u32 value, const Region &region) { return (value < region.address); });
+
+        if (it == _regions.begin())
+            return (nullptr);
+
+        --it;
+        return (address - it->address < it->size ? &*it : nullptr);
+    }
+}
@@ -0,0 +1,469 @@
+#include <3ds.h>
+#include "Helpers/PoolAllocator.hpp"
+#include "Helpers/Format.hpp"
+#include "Helpers/OSDManager.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <new>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        const u8    LargeClass = 0xFF;
+        const u32   MaxOverlayLines = 3 + static_cast<u32>(MemoryTag::Count);
+
+        struct Header
+        {
+            u32     size;       ///< Size requested
+            u8      sizeClass;  ///< LargeClass for the blocks taken from the heap
+            u8      tag;
+            u16     padding;
+        };
+
+        // At the start of every slab, the slabs are aligned on SlabSize so a block finds its slab
+        struct Slab
+        {
+            Slab    *next;      ///< In the list of the slabs of the class with free blocks
+            Slab    *prev;
+            void    *free;      ///< Blocks freed in the slab
+            u32     fresh;      ///< Offset of the first block never used
+            u16     used;
+            u8      sizeClass;
+            bool    listed;
+        };
+
+        struct Pool
+        {
+            Slab    *slabs;     ///< The slabs with free blocks
+            u32     empty;      ///< Amount of slabs of the list without used blocks
+            u32     used;       ///< Amount of blocks used
+            u32     slabCount;
+        };
+
+        const u32   FirstBlock = (sizeof(Slab) + 7) & ~7;
+
+        // Size of the blocks of each class, headers included
+        const u32   g_classSizes[PoolAllocator::ClassCount] =
+        {
+            16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512
+        };
+
+        // Class of a block of (index * 8) bytes
+        const u8    g_classes[PoolAllocator::MaxPooledSize / 8 + 2] =
+        {
+            0, 0, 0, 1, 2, 3, 3, 4, 4,
+            5, 5, 5, 5, 6, 6, 6, 6,
+            7, 7, 7, 7, 7, 7, 7, 7,
+            8, 8, 8, 8, 8, 8, 8, 8,
+            9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9,
+            10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10
+        };
+
+        const char  *g_tagNames[static_cast<u32>(MemoryTag::Count)] =
+        {
+            "General", "OSD", "Menu", "Search", "Cheats", "Settings"
+        };
+
+        const StringID  g_lineIds[MaxOverlayLines] =
+        {
+            "heap_0"_id, "heap_1"_id, "heap_2"_id, "heap_3"_id, "heap_4"_id,
+            "heap_5"_id, "heap_6"_id, "heap_7"_id, "heap_8"_id
+        };
+
+        // Everything here is constant initialized: operator new runs before the static constructors
+        LightLock       g_lock = 1;     ///< As set by LightLock_Init
+        Pool            g_pools[PoolAllocator::ClassCount];
+        HeapStats       g_stats;
+        u8              g_tag = 0;
+
+        bool            g_overlay = false;
+        u32             g_overlayX = 0;
+        u32             g_overlayY = 0;
+        u32             g_overlayLines = 0;
+        u32             g_frames = 0;
+
+        inline Header   *HeaderOf(const void *block)
+        {
+            return (reinterpret_cast<Header *>(reinterpret_cast<uintptr_t>(block) - PoolAllocator::HeaderSize));
+        }
+
+        inline Slab     *SlabOf(const Header *header)
+        {
+            return (reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(header) & ~static_cast<uintptr_t>(PoolAllocator::SlabSize - 1)));
+        }
+
+        void    Link(Pool &pool, Slab *slab)
+        {
+            slab->prev = nullptr;
+            slab->next = pool.slabs;
+            if (pool.slabs)
+                pool.slabs->prev = slab;
+            pool.slabs = slab;
+            slab->listed = true;
+        }
+
+        void    Unlink(Pool &pool, Slab *slab)
+        {
+            if (slab->prev)
+                slab->prev->next = slab->next;
+            else
+                pool.slabs = slab->next;
+            if (slab->next)
+                slab->next->prev = slab->prev;
+            slab->listed = false;
+        }
+
+        void    ReleaseSlab(Pool &pool, Slab *slab)
+        {
+            Unlink(pool, slab);
+            --pool.slabCount;
+            g_stats.poolReserved -= PoolAllocator::SlabSize;
+            std::free(slab);
+        }
+
+        Header  *AllocatePooled(u32 sizeClass)
+        {
+            Pool    &pool = g_pools[sizeClass];
+            Slab    *slab = pool.slabs;
+            u32     blockSize = g_classSizes[sizeClass];
+            Header  *header;
+
+            if (slab == nullptr)
+            {
+                slab = static_cast<Slab *>(memalign(PoolAllocator::SlabSize, PoolAllocator::SlabSize));
+                if (slab == nullptr)
+                    return (nullptr);
+
+                slab->free = nullptr;
+                slab->fresh = FirstBlock;
+                slab->used = 0;
+                slab->sizeClass = sizeClass;
+                Link(pool, slab);
+                ++pool.empty;
+                ++pool.slabCount;
+                g_stats.poolReserved += PoolAllocator::SlabSize;
+            }
+
+            if (slab->free)
+            {
+                header = static_cast<Header *>(slab->free);
+                slab->free = *reinterpret_cast<void **>(header);
+            }
+            else
+            {
+                header = reinterpret_cast<Header *>(reinterpret_cast<u8 *>(slab) + slab->fresh);
+                slab->fresh += blockSize;
+            }
+
+            if (slab->used++ == 0)
+                --pool.empty;
+            ++pool.used;
+            g_stats.poolUsed += blockSize;
+
+            // Full, it leaves the list until a block is freed
+            if (slab->free == nullptr && slab->fresh + blockSize > PoolAllocator::SlabSize)
+                Unlink(pool, slab);
+
+            header->sizeClass = sizeClass;
+            return (header);
+        }
+
+        void    FreePooled(Header *header)
+        {
+            Slab    *slab = SlabOf(header);
+            Pool    &pool = g_pools[slab->sizeClass];
+
+            *reinterpret_cast<void **>(header) = slab->free;
+            slab->free = header;
+            --pool.used;
+            g_stats.poolUsed -= g_classSizes[slab->sizeClass];
+
+            if (!slab->listed)
+                Link(pool, slab);
+
+            if (--slab->used)
+                return;
+
+            // Keep one empty slab so a class used in bursts doesn't go back and forth to the heap
+            if (pool.empty)
+                ReleaseSlab(pool, slab);
+            else
+                ++pool.empty;
+        }
+
+        // The statistics as text, MaxOverlayLines at most, without allocating
+        u32     FormatStats(const HeapStats &stats, FixedString<64> *lines)
+        {
+            u32     count = 0;
+
+            lines[count++].Append("Heap     live ").AppendDecimal(stats.live, 7)
+                .Append(" peak ").AppendDecimal(stats.peak, 7).Append(" n ").AppendDecimal(stats.count);
+            lines[count++].Append("Pools    used ").AppendDecimal(stats.poolUsed, 7)
+                .Append(" of ").AppendDecimal(stats.poolReserved, 7).Append(" frag ").AppendDecimal(stats.fragmentation).Append('%');
+            lines[count++].Append("Large ").AppendDecimal(stats.large, 7).Append(" heap free ").AppendDecimal(stats.heapFree, 7)
+                .Append(" of ").AppendDecimal(stats.heapSize, 7).Append(" fail ").AppendDecimal(stats.failures);
+
+            for (u32 i = 0; i < static_cast<u32>(MemoryTag::Count); ++i)
+            {
+                const MemoryTagStats    &tag = stats.tags[i];
+
+                if (tag.peak == 0)
+                    continue;
+
+                lines[count].Append(g_tagNames[i]);
+                for (u32 pad = lines[count].size(); pad < 9; ++pad)
+                    lines[count].Append(' ');
+                lines[count++].Append("live ").AppendDecimal(tag.live, 7).Append(" peak ").AppendDecimal(tag.peak, 7)
+                    .Append(" n ").AppendDecimal(tag.count);
+            }
+
+            return (count);
+        }
+
+        void    RefreshOverlay(void)
+        {
+            HeapStats           stats;
+            FixedString<64>     lines[MaxOverlayLines];
+
+            PoolAllocator::GetStats(stats);
+
+            u32     count = FormatStats(stats, lines);
+
+            for (u32 i = 0; i < count; ++i)
+            {
+                OSDManager[g_lineIds[i]] = lines[i].ToString();
+                OSDManager[g_lineIds[i]].SetPos(g_overlayX, g_overlayY + i * 10).Enable();
+            }
+
+            for (u32 i = count; i < g_overlayLines; ++i)
+                OSDManager.Remove(g_lineIds[i]);
+
+            g_overlayLines = count;
+        }
+
+        // With -fno-exceptions operator new can't throw, and its callers don't test for nullptr
+        void    OutOfMemory(std::size_t size) __attribute__((noreturn));
+
+        void    OutOfMemory(std::size_t size)
+        {
+            HeapStats           stats;
+            FixedString<64>     lines[MaxOverlayLines + 1];
+
+            PoolAllocator::GetStats(stats);
+
+            u32     count = FormatStats(stats, lines + 1);
+
+            lines[0].Append("Out of memory: ").AppendDecimal(static_cast<u32>(size)).Append(" bytes for ")
+                .Append(g_tagNames[g_tag]);
+            for (u32 i = 0; i <= count; ++i)
+                svcOutputDebugString(lines[i].c_str(), lines[i].size());
+
+            svcBreak(USERBREAK_PANIC);
+        }
+    }
+
+    void    *PoolAllocator::Allocate(u32 size)
+    {
+        Header  *header;
+
+        LightLock_Lock(&g_lock);
+
+        if (size <= MaxPooledSize)
+            header = AllocatePooled(g_classes[(size + HeaderSize + 7) / 8]);
+        else if (size > 0xFFFFFFFF - HeaderSize)
+            header = nullptr;
+        else
+        {
+            header = static_cast<Header *>(std::malloc(HeaderSize + size));
+            if (header)
+            {
+                header->sizeClass = LargeClass;
+                g_stats.large += HeaderSize + size;
+            }
+        }
+
+        if (header == nullptr)
+        {
+            ++g_stats.failures;
+            LightLock_Unlock(&g_lock);
+            return (nullptr);
+        }
+
+        MemoryTagStats  &tag = g_stats.tags[g_tag];
+
+        header->size = size;
+        header->tag = g_tag;
+
+        g_stats.live += size;
+        ++g_stats.count;
+        if (g_stats.live > g_stats.peak)
+            g_stats.peak = g_stats.live;
+
+        tag.live += size;
+        ++tag.count;
+        if (tag.live > tag.peak)
+            tag.peak = tag.live;
+
+        LightLock_Unlock(&g_lock);
+        return (reinterpret_cast<u8 *>(header) + HeaderSize);
+    }
+
+    void    PoolAllocator::Free(void *block)
+    {
+        if (block == nullptr)
+            return;
+
+        Header          *header = HeaderOf(block);
+        MemoryTagStats  &tag = g_stats.tags[header->tag];
+
+        LightLock_Lock(&g_lock);
+
+        g_stats.live -= header->size;
+        --g_stats.count;
+        tag.live -= header->size;
+        --tag.count;
+
+        if (header->sizeClass == LargeClass)
+        {
+            g_stats.large -= HeaderSize + header->size;
+            std::free(header);
+        }
+        else
+            FreePooled(header);
+
+        LightLock_Unlock(&g_lock);
+    }
+
+    u32     PoolAllocator::SizeOf(const void *block)
+    {
+        return (block ? HeaderOf(block)->size : 0);
+    }
+
+    MemoryTag   PoolAllocator::SetTag(MemoryTag tag)
+    {
+        MemoryTag   previous = static_cast<MemoryTag>(g_tag);
+
+        g_tag = static_cast<u8>(tag);
+        return (previous);
+    }
+
+    const char  *PoolAllocator::TagName(MemoryTag tag)
+    {
+        return (tag < MemoryTag::Count ? g_tagNames[static_cast<u32>(tag)] : "");
+    }
+
+    void    PoolAllocator::GetStats(HeapStats &out)
+    {
+        // mallinfo takes the lock of the heap, not while holding the pools
+        struct mallinfo     info = mallinfo();
+
+        LightLock_Lock(&g_lock);
+        out = g_stats;
+        LightLock_Unlock(&g_lock);
+
+        u32     taken = out.poolReserved + out.large;
+
+        out.heapSize = info.arena;
+        out.heapFree = info.fordblks;
+        out.fragmentation = taken ? static_cast<u64>(taken - out.live) * 100 / taken : 0;
+    }
+
+    void    PoolAllocator::Trim(void)
+    {
+        LightLock_Lock(&g_lock);
+
+        for (Pool &pool : g_pools)
+        {
+            for (Slab *slab = pool.slabs; slab && pool.empty; )
+            {
+                Slab    *next = slab->next;
+
+                if (slab->used == 0)
+                {
+                    ReleaseSlab(pool, slab);
+                    --pool.empty;
+                }
+                slab = next;
+            }
+        }
+
+        LightLock_Unlock(&g_lock);
+    }
+
+    void    PoolAllocator::ShowOverlay(u32 posX, u32 posY)
+    {
+        g_overlay = true;
+        g_overlayX = posX;
+        g_overlayY = posY;
+        g_frames = 0;
+        RefreshOverlay();
+    }
+
+    void    PoolAllocator::HideOverlay(void)
+    {
+        g_overlay = false;
+        for (u32 i = 0; i < g_overlayLines; ++i)
+            OSDManager.Remove(g_lineIds[i]);
+        g_overlayLines = 0;
+    }
+
+    bool    PoolAllocator::IsOverlayShown(void)
+    {
+        return (g_overlay);
+    }
+
+    void    PoolAllocator::OnFrame(void)
+    {
+        if (!g_overlay || ++g_frames < OverlayPeriod)
+            return;
+
+        g_frames = 0;
+        RefreshOverlay();
+    }
+}
+
+void    *operator new(std::size_t size)
+{
+    void    *block = size <= 0xFFFFFFFF ? CTRPluginFramework::PoolAllocator::Allocate(size) : nullptr;
+
+    if (block == nullptr)
+        CTRPluginFramework::OutOfMemory(size);
+    return (block);
+}
+
+void    *operator new[](std::size_t size)
+{
+    return (operator new(size));
+}
+
+void    *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return (size <= 0xFFFFFFFF ? CTRPluginFramework::PoolAllocator::Allocate(size) : nullptr);
+}
+
+void    *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return (size <= 0xFFFFFFFF ? CTRPluginFramework::PoolAllocator::Allocate(size) : nullptr);
+}
+
+void    operator delete(void *block) noexcept
+{
+    CTRPluginFramework::PoolAllocator::Free(block);
+}
+
+void    operator delete[](void *block) noexcept
+{
+    CTRPluginFramework::PoolAllocator::Free(block);
+}
+
+void    operator delete(void *block, const std::nothrow_t &) noexcept
+{
+    CTRPluginFramework::PoolAllocator::Free(block);
+}
+
+void    operator delete[](void *block, const std::nothrow_t &) noexcept
+{
+    CTRPluginFramework::PoolAllocator::Free(block);
+}
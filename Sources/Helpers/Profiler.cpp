@@ -0,0 +1,443 @@
+#include "Helpers/Profiler.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/Format.hpp"
+#include "Helpers/OSDManager.hpp"
+#include <3ds.h>
+#include <algorithm>
+
+namespace CTRPluginFramework
+{
+    // std::min takes its arguments by reference, the constants need a definition
+    const u32   Profiler::MaxThreads;
+    const u32   Profiler::RingSize;
+    const u32   Profiler::MaxZones;
+    const u32   Profiler::MaxNames;
+    const u32   Profiler::NameSize;
+    const u32   Profiler::OverlayPeriod;
+
+    namespace
+    {
+        // 4 buckets per power of two, values below 4 ticks have their own bucket
+        const u32   HistogramBuckets = 128;
+        const u32   MaxOverlayLines = 8;
+        const u32   BarWidth = 10;
+
+        struct Ring
+        {
+            u32             owner;      ///< Thread local storage of the writer, 0 when free
+            u32             head;       ///< Amount of records written, only increases
+            u32             tail;       ///< Amount of records collected
+            ProfileRecord   records[Profiler::RingSize];
+        };
+
+        // The names are copied once, the records and the zones point to the copies
+        struct Name
+        {
+            u32     id;
+            char    text[Profiler::NameSize];
+        };
+
+        struct Zone
+        {
+            u32         id;
+            const char  *name;
+            u32         count;
+            u32         min;
+            u32         max;
+            u64         total;
+            u16         histogram[HistogramBuckets];
+        };
+
+        Ring        g_rings[Profiler::MaxThreads];
+        Zone        g_zones[Profiler::MaxZones];
+        u32         g_zoneCount = 0;
+        Name        g_names[Profiler::MaxNames];
+        u32         g_nameCount = 0;
+        u64         g_windowStart = 0;
+
+        bool        g_overlay = false;
+        u32         g_overlayCount = 0;
+        u32         g_overlayX = 0;
+        u32         g_overlayY = 0;
+        u32         g_overlayLines = 0;
+        u32         g_frames = 0;
+
+        const StringID  g_lineIds[MaxOverlayLines] =
+        {
+            "profiler_0"_id, "profiler_1"_id, "profiler_2"_id, "profiler_3"_id,
+            "profiler_4"_id, "profiler_5"_id, "profiler_6"_id, "profiler_7"_id
+        };
+
+        Ring    *GetRing(void)
+        {
+            u32     tls = static_cast<u32>(reinterpret_cast<uintptr_t>(getThreadLocalStorage()));
+
+            for (Ring &ring : g_rings)
+            {
+                u32     owner = __atomic_load_n(&ring.owner, __ATOMIC_ACQUIRE);
+
+                if (owner == tls)
+                    return (&ring);
+
+                u32     expected = 0;
+
+                if (owner == 0 && __atomic_compare_exchange_n(&ring.owner, &expected, tls, false,
+                                                              __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                    return (&ring);
+            }
+
+            // More threads than rings, the record is dropped
+            return (nullptr);
+        }
+
+        u32     Bucket(u32 ticks)
+        {
+            if (ticks < 4)
+                return (ticks);
+
+            u32     exponent = 31 - __builtin_clz(ticks);
+
+            return ((exponent - 1) * 4 + ((ticks >> (exponent - 2)) & 3));
+        }
+
+        // Smallest value of a bucket
+        u32     BucketFloor(u32 bucket)
+        {
+            if (bucket < 4)
+                return (bucket);
+
+            u32     exponent = bucket / 4 + 1;
+
+            return ((4 + (bucket & 3)) << (exponent - 2));
+        }
+
+        const char  *FindName(u32 id)
+        {
+            for (u32 i = 0; i < g_nameCount; ++i)
+                if (g_names[i].id == id)
+                    return (g_names[i].text);
+            return (nullptr);
+        }
+
+        // The copy of the name of a record, made while the name is still valid
+        const char  *CopyName(const ProfileRecord &record)
+        {
+            const char  *name = FindName(record.id);
+
+            if (name != nullptr)
+                return (name);
+
+            if (g_nameCount >= Profiler::MaxNames)
+                return (nullptr);
+
+            Name    &copy = g_names[g_nameCount++];
+
+            copy.id = record.id;
+            std::strncpy(copy.text, record.name, Profiler::NameSize - 1);
+            copy.text[Profiler::NameSize - 1] = '\0';
+            return (copy.text);
+        }
+
+        Zone    *FindZone(const ProfileRecord &record)
+        {
+            for (u32 i = 0; i < g_zoneCount; ++i)
+                if (g_zones[i].id == record.id)
+                    return (&g_zones[i]);
+
+            const char  *name = CopyName(record);
+
+            if (g_zoneCount >= Profiler::MaxZones || name == nullptr)
+                return (nullptr);
+
+            Zone    &zone = g_zones[g_zoneCount++];
+
+            std::memset(&zone, 0, sizeof(Zone));
+            zone.id = record.id;
+            zone.name = name;
+            zone.min = 0xFFFFFFFF;
+            return (&zone);
+        }
+
+        void    Accumulate(const ProfileRecord &record)
+        {
+            Zone    *zone = FindZone(record);
+
+            if (zone == nullptr)
+                return;
+
+            u16     &bucket = zone->histogram[Bucket(record.duration)];
+
+            ++zone->count;
+            zone->total += record.duration;
+            zone->min = std::min(zone->min, record.duration);
+            zone->max = std::max(zone->max, record.duration);
+            if (bucket != 0xFFFF)
+                ++bucket;
+        }
+
+        // Upper bound of the bucket holding the 99th percentile
+        u32     Percentile99(const Zone &zone)
+        {
+            u32     rank = zone.count - zone.count / 100;
+            u32     seen = 0;
+
+            for (u32 i = 0; i < HistogramBuckets; ++i)
+            {
+                seen += zone.histogram[i];
+                if (seen >= rank)
+                    return (std::min(zone.max, BucketFloor(i + 1)));
+            }
+
+            return (zone.max);
+        }
+
+        void    AppendCsvName(std::string &out, const char *name)
+        {
+            out += '"';
+            for (; *name; ++name)
+            {
+                if (*name == '"')
+                    out += '"';
+                out += *name;
+            }
+            out += '"';
+        }
+
+        void    AppendJsonName(std::string &out, const char *name)
+        {
+            out += '"';
+            for (; *name; ++name)
+            {
+                if (*name == '"' || *name == '\\')
+                    out += '\\';
+                if (static_cast<u8>(*name) >= 0x20)
+                    out += *name;
+            }
+            out += '"';
+        }
+
+        void    AppendDecimal(std::string &out, u64 value)
+        {
+            char    buffer[24];
+
+            out.append(buffer, FormatDecimal(buffer, value));
+        }
+
+        void    RefreshOverlay(void)
+        {
+            std::vector<ZoneStats>  stats;
+            u32     window = TicksToMicroseconds(GetTicks() - g_windowStart);
+            u32     count;
+
+            Profiler::GetStats(stats);
+            count = std::min<u32>(stats.size(), g_overlayCount);
+
+            for (u32 i = 0; i < count; ++i)
+            {
+                const ZoneStats     &zone = stats[i];
+                FixedString<64>     line;
+                u32                 bar = window ? static_cast<u64>(zone.total) * BarWidth / window : 0;
+
+                line.Append(zone.name, std::min<u32>(std::strlen(zone.name), 12));
+                for (u32 pad = line.size(); pad < 13; ++pad)
+                    line.Append(' ');
+                line.AppendDecimal(zone.average, 5).Append("us p99 ").AppendDecimal(zone.p99, 5).Append("us ");
+                for (u32 j = 0; j < BarWidth; ++j)
+                    line.Append(j < bar ? '#' : '.');
+
+                OSDManager[g_lineIds[i]] = line.ToString();
+                OSDManager[g_lineIds[i]].SetPos(g_overlayX, g_overlayY + i * 10).Enable();
+            }
+
+            for (u32 i = count; i < g_overlayLines; ++i)
+                OSDManager.Remove(g_lineIds[i]);
+
+            g_overlayLines = count;
+        }
+    }
+
+    void    Profiler::Record(const char *name, u64 start, u64 end)
+    {
+        Record(name, StringID::Compute(name, std::strlen(name)), start, end);
+    }
+
+    void    Profiler::Record(const char *name, u32 id, u64 start, u64 end)
+    {
+        Ring    *ring = GetRing();
+
+        if (ring == nullptr)
+            return;
+
+        u32             head = ring->head;
+        ProfileRecord   &record = ring->records[head % RingSize];
+        u64             duration = end - start;
+
+        record.name = name;
+        record.id = id;
+        record.start = start;
+        record.duration = duration > 0xFFFFFFFF ? 0xFFFFFFFF : duration;
+
+        // Publish the record to Collect
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    }
+
+    void    Profiler::Collect(void)
+    {
+        if (g_windowStart == 0)
+            g_windowStart = GetTicks();
+
+        for (Ring &ring : g_rings)
+        {
+            u32     head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+            u32     tail = ring.tail;
+
+            // The writer lapped the collector, the oldest records are lost
+            if (head - tail > RingSize)
+                tail = head - RingSize;
+
+            for (; tail != head; ++tail)
+                Accumulate(ring.records[tail % RingSize]);
+
+            ring.tail = head;
+        }
+    }
+
+    void    Profiler::GetStats(std::vector<ZoneStats> &out)
+    {
+        out.clear();
+        out.reserve(g_zoneCount);
+
+        for (u32 i = 0; i < g_zoneCount; ++i)
+        {
+            const Zone  &zone = g_zones[i];
+            ZoneStats   stats;
+
+            if (zone.count == 0)
+                continue;
+
+            stats.name = zone.name;
+            stats.count = zone.count;
+            stats.min = TicksToMicroseconds(zone.min);
+            stats.average = TicksToMicroseconds(zone.total / zone.count);
+            stats.p99 = TicksToMicroseconds(Percentile99(zone));
+            stats.max = TicksToMicroseconds(zone.max);
+            stats.total = TicksToMicroseconds(zone.total);
+            out.push_back(stats);
+        }
+
+        std::sort(out.begin(), out.end(), [](const ZoneStats &left, const ZoneStats &right)
+        {
+            return (left.total > right.total);
+        });
+    }
+
+    void    Profiler::Reset(void)
+    {
+        g_zoneCount = 0;
+        g_windowStart = GetTicks();
+    }
+
+    void    Profiler::ShowOverlay(u32 count, u32 posX, u32 posY)
+    {
+        g_overlay = true;
+        g_overlayCount = std::min(count, MaxOverlayLines);
+        g_overlayX = posX;
+        g_overlayY = posY;
+        g_frames = 0;
+        Reset();
+    }
+
+    void    Profiler::HideOverlay(void)
+    {
+        g_overlay = false;
+        for (u32 i = 0; i < g_overlayLines; ++i)
+            OSDManager.Remove(g_lineIds[i]);
+        g_overlayLines = 0;
+    }
+
+    bool    Profiler::IsOverlayShown(void)
+    {
+        return (g_overlay);
+    }
+
+    void    Profiler::OnFrame(void)
+    {
+        Collect();
+
+        if (!g_overlay || ++g_frames < OverlayPeriod)
+            return;
+
+        g_frames = 0;
+        RefreshOverlay();
+        Reset();
+    }
+
+    bool    Profiler::DumpCsv(const std::string &path)
+    {
+        std::vector<ZoneStats>  stats;
+        std::string             out("zone,count,min_us,avg_us,p99_us,max_us,total_us\n");
+
+        Collect();
+        GetStats(stats);
+
+        for (const ZoneStats &zone : stats)
+        {
+            AppendCsvName(out, zone.name);
+            for (u32 value : { zone.count, zone.min, zone.average, zone.p99, zone.max, zone.total })
+            {
+                out += ',';
+                AppendDecimal(out, value);
+            }
+            out += '\n';
+        }
+
+        return (WriteFile(path, out.data(), out.size()));
+    }
+
+    bool    Profiler::DumpChromeTrace(const std::string &path)
+    {
+        std::string     out("{\"traceEvents\":[");
+        u64             origin = ~0ull;
+        bool            first = true;
+
+        // The names of the records are only valid until they're collected, the copies are used
+        Collect();
+
+        // Timestamps are relative to the oldest record
+        for (const Ring &ring : g_rings)
+        {
+            u32     head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+            u32     count = std::min(head, RingSize);
+
+            for (u32 i = head - count; i != head; ++i)
+                origin = std::min(origin, ring.records[i % RingSize].start);
+        }
+
+        for (u32 thread = 0; thread < MaxThreads; ++thread)
+        {
+            const Ring  &ring = g_rings[thread];
+            u32         head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+            u32         count = std::min(head, RingSize);
+
+            for (u32 i = head - count; i != head; ++i)
+            {
+                const ProfileRecord &record = ring.records[i % RingSize];
+                const char          *name = FindName(record.id);
+
+                out += first ? "\n{\"name\":" : ",\n{\"name\":";
+                first = false;
+                AppendJsonName(out, name != nullptr ? name : "?");
+                out += ",\"ph\":\"X\",\"pid\":0,\"tid\":";
+                AppendDecimal(out, thread);
+                out += ",\"ts\":";
+                AppendDecimal(out, (record.start - origin) / TicksPerMicrosecond);
+                out += ",\"dur\":";
+                AppendDecimal(out, TicksToMicroseconds(record.duration));
+                out += '}';
+            }
+        }
+
+        out += "\n]}\n";
+        return (WriteFile(path, out.data(), out.size()));
+    }
+}
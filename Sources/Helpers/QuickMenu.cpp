@@ -1,11 +1,14 @@
 #include <CTRPluginFramework/Menu/PluginMenu.hpp>
 #include "Helpers/QuickMenu.hpp"
+#include "Helpers/Format.hpp"
+#include "Helpers/Profiler.hpp"
+#include "Helpers/PoolAllocator.hpp"
 #include <algorithm>
 
 namespace CTRPluginFramework
 {
     QuickMenuItem::QuickMenuItem(const std::string &name_, const ItemType itemType_) :
-        name(name_), itemType(itemType_)
+        name(name_), id(name_), itemType(itemType_)
     {
     }
 
@@ -59,18 +62,60 @@ namespace CTRPluginFramework
         items.erase(std::remove(items.begin(), items.end(), item), items.end());
     }
 
+    // Integer compares only, the names are never touched
+    static std::vector<QuickMenuItem *>::const_iterator  FindItem(const std::vector<QuickMenuItem *> &items, StringID id)
+    {
+        return (std::find_if(items.begin(), items.end(), [id](const QuickMenuItem *item) { return (item->id == id); }));
+    }
+
+    static void     RemoveItem(std::vector<QuickMenuItem *> &items, StringID id)
+    {
+        auto it = FindItem(items, id);
+
+        if (it == items.end())
+            return;
+
+        // QuickMenuItem has no virtual destructor
+        if ((*it)->itemType == QuickMenuItem::ItemType::SubMenu)
+            delete static_cast<QuickMenuSubMenu *>(*it);
+        else
+            delete static_cast<QuickMenuEntry *>(*it);
+
+        items.erase(it);
+    }
+
+    void    QuickMenuSubMenu::operator-=(StringID id)
+    {
+        RemoveItem(items, id);
+    }
+
+    QuickMenuItem   *QuickMenuSubMenu::Find(StringID id) const
+    {
+        auto it = FindItem(items, id);
+
+        return (it != items.end() ? *it : nullptr);
+    }
+
     QuickMenu   QuickMenu::_instance(Key::Start);
 
+    namespace
+    {
+        // Search values with this bit are indexes in _searchEntries, not nodes
+        const u32   SearchEntryFlag = 0x80000000;
+
+        // Results listed while typing
+        const u32   SearchPreview = 5;
+    }
+
     QuickMenu::QuickMenu(u32 hotkey) :
         _hotkey(hotkey, Seconds(0.5f)),
-        _subMenuOpened(nullptr)
+        _dirty(true), _count(0), _searchNode(InvalidNode)
     {
+        NewNode(InvalidNode, "", QuickMenuItem::ItemType::SubMenu);
     }
 
     QuickMenu::~QuickMenu()
     {
-        for (QuickMenuItem *item : _root)
-            delete item;
     }
 
     QuickMenu &QuickMenu::GetInstance(void)
@@ -78,31 +123,428 @@ namespace CTRPluginFramework
         return (_instance);
     }
 
+    u32     QuickMenu::Intern(const std::string &name, StringID id)
+    {
+        // Items sharing a name share its storage, the names are never removed
+        auto    it = _interned.find(id.Value());
+
+        if (it != _interned.end())
+        {
+            if (name.compare(&_names[it->second]) == 0)
+                return (it->second);
+
+            // Two names with the same hash: Find can't tell them apart
+#ifdef HELPERS_DEBUG
+            svcBreak(USERBREAK_ASSERT);
+#endif
+        }
+
+        u32     offset = _names.size();
+
+        // A colliding name gets its own copy, the first one keeps the id
+        _names.append(name.c_str(), name.size() + 1);
+        _interned.emplace(id.Value(), offset);
+        return (offset);
+    }
+
+    u32     QuickMenu::NewNode(u32 parent, const std::string &name, QuickMenuItem::ItemType type)
+    {
+        if (parent != InvalidNode && !IsSubMenu(parent))
+            return (InvalidNode);
+
+        StringID    id(name);
+        u32         offset = Intern(name, id);
+        u32         index;
+
+        if (!_free.empty())
+        {
+            index = _free.back();
+            _free.pop_back();
+        }
+        else
+        {
+            index = _nodes.size();
+            _nodes.push_back(Node());
+        }
+
+        Node    &node = _nodes[index];
+
+        node.id = id;
+        node.name = offset;
+        node.parent = parent;
+        node.firstChild = InvalidNode;
+        node.lastChild = InvalidNode;
+        node.nextSibling = InvalidNode;
+        node.children = 0;
+        node.childCount = 0;
+        node.options = 0;
+        node.used = true;
+        node.itemType = type;
+        node.methodType = QuickMenuEntry::MethodType::VOID;
+        node.voidMethod = nullptr;
+        node.methodArg = nullptr;
+
+        if (parent != InvalidNode)
+        {
+            Node    &owner = _nodes[parent];
+
+            if (owner.lastChild != InvalidNode)
+                _nodes[owner.lastChild].nextSibling = index;
+            else
+                owner.firstChild = index;
+            owner.lastChild = index;
+            ++_count;
+        }
+
+        _dirty = true;
+        return (index);
+    }
+
+    u32     QuickMenu::AddSubMenu(u32 parent, const std::string &name)
+    {
+        return (NewNode(parent, name, QuickMenuItem::ItemType::SubMenu));
+    }
+
+    u32     QuickMenu::AddEntry(u32 parent, const std::string &name, VoidMethod method)
+    {
+        u32     index = NewNode(parent, name, QuickMenuItem::ItemType::Entry);
+
+        if (index != InvalidNode)
+            _nodes[index].voidMethod = method;
+        return (index);
+    }
+
+    u32     QuickMenu::AddEntry(u32 parent, const std::string &name, ArgMethod method, void *arg)
+    {
+        u32     index = NewNode(parent, name, QuickMenuItem::ItemType::Entry);
+
+        if (index != InvalidNode)
+        {
+            Node    &node = _nodes[index];
+
+            node.methodType = QuickMenuEntry::MethodType::ARG;
+            node.argMethod = method;
+            node.methodArg = arg;
+        }
+        return (index);
+    }
+
+    u32     QuickMenu::Add(u32 parent, QuickMenuItem *item)
+    {
+        if (item == nullptr)
+            return (InvalidNode);
+
+        u32     index;
+
+        if (item->itemType == QuickMenuItem::ItemType::SubMenu)
+        {
+            QuickMenuSubMenu    *subMenu = static_cast<QuickMenuSubMenu *>(item);
+
+            index = AddSubMenu(parent, subMenu->name);
+            if (index != InvalidNode)
+            {
+                // The children are destroyed with the submenu
+                for (QuickMenuItem *child : subMenu->items)
+                    Add(index, child);
+                subMenu->items.clear();
+            }
+            delete subMenu;
+        }
+        else
+        {
+            QuickMenuEntry      *entry = static_cast<QuickMenuEntry *>(item);
+
+            if (entry->methodType == QuickMenuEntry::MethodType::VOID)
+                index = AddEntry(parent, entry->name, entry->voidMethod);
+            else
+                index = AddEntry(parent, entry->name, entry->argMethod, entry->methodArg);
+            delete entry;
+        }
+
+        return (index);
+    }
+
     void    QuickMenu::operator+=(QuickMenuItem* item)
     {
-        _root.push_back(item);
+        Add(Root, item);
+    }
+
+    void    QuickMenu::Remove(u32 index)
+    {
+        if (index == Root || index >= _nodes.size() || !_nodes[index].used)
+            return;
+
+        Node    &node = _nodes[index];
+        Node    &parent = _nodes[node.parent];
+        u32     previous = InvalidNode;
+
+        // Unlink it from its siblings
+        for (u32 child = parent.firstChild; child != index; child = _nodes[child].nextSibling)
+            previous = child;
+
+        if (previous != InvalidNode)
+            _nodes[previous].nextSibling = node.nextSibling;
+        else
+            parent.firstChild = node.nextSibling;
+        if (parent.lastChild == index)
+            parent.lastChild = previous;
+
+        // Then free it with its children
+        std::vector<u32>    pending(1, index);
+
+        while (!pending.empty())
+        {
+            u32     current = pending.back();
+
+            pending.pop_back();
+            for (u32 child = _nodes[current].firstChild; child != InvalidNode; child = _nodes[child].nextSibling)
+                pending.push_back(child);
+
+            if (current == _searchNode)
+                _searchNode = InvalidNode;
+
+            _nodes[current].used = false;
+            _free.push_back(current);
+            --_count;
+        }
+
+        _dirty = true;
+    }
+
+    void    QuickMenu::operator-=(StringID id)
+    {
+        Remove(Find(id));
+    }
+
+    // Integer compares only, the names are never touched
+    u32     QuickMenu::Find(StringID id, u32 parent) const
+    {
+        if (!IsSubMenu(parent))
+            return (InvalidNode);
+
+        for (u32 child = _nodes[parent].firstChild; child != InvalidNode; child = _nodes[child].nextSibling)
+            if (_nodes[child].id == id)
+                return (child);
+
+        return (InvalidNode);
+    }
+
+    const char  *QuickMenu::GetName(u32 node) const
+    {
+        if (node >= _nodes.size() || !_nodes[node].used)
+            return (nullptr);
+
+        return (_names.c_str() + _nodes[node].name);
+    }
+
+    bool    QuickMenu::IsSubMenu(u32 node) const
+    {
+        return (node < _nodes.size() && _nodes[node].used
+                && _nodes[node].itemType == QuickMenuItem::ItemType::SubMenu);
+    }
+
+    u32     QuickMenu::Count(void) const
+    {
+        return (_count);
+    }
+
+    void    QuickMenu::Rebuild(void)
+    {
+        _children.clear();
+        _options.clear();
+
+        for (u32 index = 0; index < _nodes.size(); ++index)
+        {
+            Node    &node = _nodes[index];
+
+            if (!node.used || node.itemType != QuickMenuItem::ItemType::SubMenu)
+                continue;
+
+            node.children = _children.size();
+            node.childCount = 0;
+            node.options = _options.size();
+            _options.push_back(StringVector());
+
+            for (u32 child = node.firstChild; child != InvalidNode; child = _nodes[child].nextSibling)
+            {
+                _children.push_back(child);
+                ++node.childCount;
+            }
+        }
+
+        if (_searchNode != InvalidNode)
+        {
+            _search.Clear();
+            for (u32 index = Root + 1; index < _nodes.size(); ++index)
+                if (_nodes[index].used && index != _searchNode)
+                    _search.Add(_names.c_str() + _nodes[index].name, index);
+
+            for (u32 i = 0; i < _searchEntries.size(); ++i)
+                _search.Add(_searchEntries[i]->Name(), SearchEntryFlag | i);
+
+            _search.Build();
+        }
+
+        _dirty = false;
+    }
+
+    const StringVector  &QuickMenu::Options(u32 index)
+    {
+        const Node      &node = _nodes[index];
+        StringVector    &options = _options[node.options];
+
+        if (options.size() != node.childCount)
+        {
+            options.reserve(node.childCount);
+            for (u32 i = 0; i < node.childCount; ++i)
+                options.push_back(_names.c_str() + _nodes[_children[node.children + i]].name);
+        }
+
+        return (options);
+    }
+
+    void    QuickMenu::EnableSearch(const std::string &label)
+    {
+        if (_searchNode == InvalidNode)
+            _searchNode = AddEntry(Root, label, static_cast<VoidMethod>(nullptr));
     }
 
-    void    QuickMenu::operator-=(QuickMenuItem* item)
+    void    QuickMenu::AddSearchFolder(const MenuFolder &folder)
     {
-        _root.erase(std::remove(_root.begin(), _root.end(), item), _root.end());
+        for (MenuEntry *entry : folder.GetEntryList())
+            _searchEntries.push_back(entry);
+        for (MenuFolder *child : folder.GetFolderList())
+            AddSearchFolder(*child);
+    }
+
+    void    QuickMenu::AddSearchEntries(const PluginMenu &menu)
+    {
+        for (MenuEntry *entry : menu.GetEntryList())
+            _searchEntries.push_back(entry);
+        for (MenuFolder *folder : menu.GetFolderList())
+            AddSearchFolder(*folder);
+
+        _dirty = true;
+    }
+
+    void    QuickMenu::Execute(u32 index)
+    {
+        const Node  &node = _nodes[index];
+
+        if (node.methodType == QuickMenuEntry::MethodType::VOID)
+        {
+            if (node.voidMethod != nullptr)
+                node.voidMethod();
+        }
+        else if (node.argMethod != nullptr)
+            node.argMethod(node.methodArg);
+    }
+
+    void    QuickMenu::OnSearchEvent(Keyboard &keyboard, KeyboardEvent &event)
+    {
+        if (event.type != KeyboardEvent::CharacterAdded && event.type != KeyboardEvent::CharacterRemoved
+            && event.type != KeyboardEvent::InputWasCleared)
+            return;
+
+        QuickMenu               &menu = GetInstance();
+        const std::vector<u32>  &results = menu._search.Search(keyboard.GetInput());
+        std::string             &message = keyboard.GetMessage();
+        FixedString<16>         count;
+
+        count.AppendDecimal(static_cast<u32>(results.size()));
+        message = "Search\n";
+        message += count.c_str();
+        message += " results";
+
+        // Preview the first results
+        for (u32 i = 0; i < results.size() && i < SearchPreview; ++i)
+        {
+            u32     value = menu._search.Value(results[i]);
+
+            message += "\n";
+            message += value & SearchEntryFlag ? menu._searchEntries[value & ~SearchEntryFlag]->Name()
+                                               : menu.GetName(value);
+        }
+    }
+
+    u32     QuickMenu::Search(void)
+    {
+        MemoryTagScope  scope(MemoryTag::Menu);
+
+        Keyboard        keyboard("Search\n");
+        std::string     input;
+
+        keyboard.OnKeyboardEvent(OnSearchEvent);
+        if (keyboard.Open(input) < 0)
+            return (InvalidNode);
+
+        std::vector<u32>    results = _search.Search(input);
+        StringVector        options;
+
+        if (results.empty())
+            return (InvalidNode);
+
+        // Show where each item lives
+        options.reserve(results.size());
+        for (u32 item : results)
+        {
+            u32     value = _search.Value(item);
+
+            if (value & SearchEntryFlag)
+            {
+                MenuEntry   *entry = _searchEntries[value & ~SearchEntryFlag];
+
+                options.push_back(entry->Name() + (entry->IsActivated() ? " (on)" : " (off)"));
+            }
+            else if (_nodes[value].parent == Root)
+                options.push_back(GetName(value));
+            else
+                options.push_back(std::string(GetName(value)) + " - " + GetName(_nodes[value].parent));
+        }
+
+        Keyboard    list;
+
+        list.Populate(options);
+
+        int     choice = list.Open();
+
+        if (choice < 0)
+            return (InvalidNode);
+
+        u32     value = _search.Value(results[choice]);
+
+        if (value & SearchEntryFlag)
+        {
+            MenuEntry   *entry = _searchEntries[value & ~SearchEntryFlag];
+
+            if (entry->IsActivated())
+                entry->Disable();
+            else
+                entry->Enable();
+            return (InvalidNode);
+        }
+
+        if (IsSubMenu(value))
+            return (value);
+
+        Execute(value);
+        return (InvalidNode);
     }
 
     void    QuickMenu::operator()(void)
     {
+        PROFILE_ZONE("QuickMenu");
+
         if (!_hotkey())
             return;
 
-        Keyboard        keyboard;
-        StringVector    options;
+        if (_dirty)
+            Rebuild();
 
-        // Create our list of options
-        for (auto *item : _root)
-            options.push_back(item->name);
+        Keyboard    keyboard;
+        u32         current = Root;
 
-        // Pass it to our keyboard 
-        keyboard.Populate(options);
-        options.clear();
+        keyboard.Populate(Options(Root));
         while (true)
         {
             int userChoice = keyboard.Open();
@@ -110,60 +552,49 @@ namespace CTRPluginFramework
             // If user selected an item
             if (userChoice >= 0)
             {
-                QuickMenuItem *selected = _subMenuOpened ? _subMenuOpened->items[userChoice] : _root[userChoice];
+                const Node  &menu = _nodes[current];
 
-                // If the selected item is an entry, execute the function
-                if (selected->itemType == QuickMenuItem::ItemType::Entry)
-                {
-                    QuickMenuEntry *entry = static_cast<QuickMenuEntry *>(selected);
+                if (static_cast<u32>(userChoice) >= menu.childCount)
+                    continue;
+
+                u32         selected = _children[menu.children + userChoice];
+                const Node  &node = _nodes[selected];
 
-                    if (entry->methodType == QuickMenuEntry::MethodType::VOID)
-                        entry->voidMethod();
-                    else
-                        entry->argMethod(entry->methodArg);
-                }
                 // If it's a submenu, open it
-                else
+                if (node.itemType == QuickMenuItem::ItemType::SubMenu)
+                    current = selected;
+                // Else if it's the search, open the submenu found
+                else if (selected == _searchNode)
                 {
-                    QuickMenuSubMenu *entry = static_cast<QuickMenuSubMenu *>(selected);
+                    u32     found = Search();
 
-                    if (_subMenuOpened != nullptr)
-                        _submenus.push(_subMenuOpened);
-                    _subMenuOpened = entry;
+                    if (found != InvalidNode)
+                        current = found;
+                }
+                // Else the selected item is an entry, execute the function
+                else
+                    Execute(selected);
 
-                    // Refresh our list of options
-                    for (QuickMenuItem *item : _subMenuOpened->items)
-                        options.push_back(item->name);
-                    keyboard.Populate(options);
-                    options.clear();
+                // The function may have edited the menu
+                if (_dirty)
+                {
+                    Rebuild();
+                    if (!IsSubMenu(current))
+                        current = Root;
                 }
             }
             // Else if user pressed B
             else
             {
-                // If we're inside a submenu, close it
-                if (_subMenuOpened != nullptr)
-                {
-                    // If we have a parent, open it
-                    if (_submenus.size())
-                    {
-                        _subMenuOpened = _submenus.top();
-                        _submenus.pop();
-                    }
-                    // Else open root
-                    else
-                        _subMenuOpened = nullptr;
-
-                    // Refresh out list of options
-                    for (auto *item : (_subMenuOpened ? _subMenuOpened->items : _root))
-                        options.push_back(item->name);
-                    keyboard.Populate(options);
-                    options.clear();
-                }
-                // Else if we're on root, close quickmenu
-                else
+                // If we're on root, close quickmenu
+                if (current == Root)
                     break;
-            }           
+
+                // Else open the parent
+                current = _nodes[current].parent;
+            }
+
+            keyboard.Populate(Options(current));
         }
     }
 
@@ -0,0 +1,247 @@
+#include "Helpers/RegionMap.hpp"
+#include "CTRPluginFramework.hpp"
+#include "csvc.h"
+#include <algorithm>
+
+namespace CTRPluginFramework
+{
+    namespace
+    {
+        const u32   FirstAddress = 0x00100000;
+        const u32   LastAddress = 0x40000000;
+        const u32   PermMask = MEMPERM_READ | MEMPERM_WRITE | MEMPERM_EXECUTE;
+        const u32   WatcherStackSize = 0x1000;
+
+        class ProcessSource : public RegionSource
+        {
+        public:
+            void    Enumerate(std::vector<MemoryRegion> &out) override
+            {
+                MemInfo     info;
+                PageInfo    page;
+                u32         address = FirstAddress;
+
+                while (address < LastAddress)
+                {
+                    if (R_FAILED(svcQueryMemory(&info, &page, address)) || info.size == 0)
+                        break;
+
+                    if ((info.perm & MEMPERM_READ) && info.state != MEMSTATE_FREE
+                        && info.state != MEMSTATE_RESERVED && info.state != MEMSTATE_IO)
+                    {
+                        MemoryRegion    region = { info.base_addr, info.base_addr + info.size, info.perm & PermMask };
+
+                        out.push_back(region);
+                    }
+
+                    address = info.base_addr + info.size;
+                }
+            }
+        };
+
+        // Wait for the kernel to signal a change of the memory layout
+        void    WatchMemoryChanges(void *arg)
+        {
+            RegionMap   *map = static_cast<RegionMap *>(arg);
+            Handle      event = 0;
+
+            if (R_FAILED(svcControlProcess(Process::GetHandle(), PROCESSOP_GET_ON_MEMORY_CHANGE_EVENT,
+                                           reinterpret_cast<uintptr_t>(&event), 0)))
+                return;
+
+            while (R_SUCCEEDED(svcWaitSynchronization(event, U64_MAX)))
+            {
+                svcClearEvent(event);
+                map->Invalidate();
+            }
+
+            svcCloseHandle(event);
+        }
+    }
+
+#ifdef HELPERS_DEBUG
+    void    (*RegionMap::AcquireHook)(bool pinned) = nullptr;
+#endif
+
+    RegionSource    &RegionSource::Process(void)
+    {
+        static ProcessSource    source;
+
+        return (source);
+    }
+
+    RegionMap::RegionMap(RegionSource &source) :
+        _source(source), _snapshot(nullptr), _readers{ 0, 0 }, _epoch(0), _generation(1)
+    {
+        LightLock_Init(&_lock);
+        _snapshot = Enumerate(_generation);
+    }
+
+    RegionMap::~RegionMap(void)
+    {
+        delete _snapshot;
+    }
+
+    RegionMap   &RegionMap::Game(void)
+    {
+        static RegionMap    map(RegionSource::Process());
+        static Thread       watcher = threadCreate(WatchMemoryChanges, &map, WatcherStackSize, 0x18, -2, true);
+
+        (void)watcher;
+        return (map);
+    }
+
+    RegionMap::Snapshot     *RegionMap::Enumerate(u32 generation)
+    {
+        Snapshot                    *snapshot = new Snapshot{ generation, std::vector<MemoryRegion>() };
+        std::vector<MemoryRegion>   &regions = snapshot->regions;
+
+        _source.Enumerate(regions);
+
+        // Merge the contiguous regions with the same permissions, fewer steps for the searches
+        u32     count = 0;
+
+        for (const MemoryRegion &region : regions)
+        {
+            if (count && regions[count - 1].end == region.start && regions[count - 1].perm == region.perm)
+                regions[count - 1].end = region.end;
+            else
+                regions[count++] = region;
+        }
+
+        regions.resize(count);
+        regions.shrink_to_fit();
+        return (snapshot);
+    }
+
+    const RegionMap::Snapshot   *RegionMap::Acquire(u32 &slot) const
+    {
+        // Counted before the snapshot is read: Invalidate publishes, changes the epoch, then waits
+        // for the count of the previous epoch, so the snapshot read here can't be freed meanwhile.
+        // The epoch may change between its read and the count, the check would then be counted
+        // in a slot the next Invalidate doesn't wait for: it counts itself again
+        for (;;)
+        {
+            u32     epoch = __atomic_load_n(&_epoch, __ATOMIC_SEQ_CST);
+
+#ifdef HELPERS_DEBUG
+            if (AcquireHook != nullptr)
+                AcquireHook(false);
+#endif
+            slot = epoch & 1;
+            __atomic_add_fetch(&_readers[slot], 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&_epoch, __ATOMIC_SEQ_CST) == epoch)
+                break;
+            __atomic_sub_fetch(&_readers[slot], 1, __ATOMIC_SEQ_CST);
+        }
+
+        const Snapshot  *snapshot = __atomic_load_n(&_snapshot, __ATOMIC_SEQ_CST);
+
+#ifdef HELPERS_DEBUG
+        if (AcquireHook != nullptr)
+            AcquireHook(true);
+#endif
+        return (snapshot);
+    }
+
+    void    RegionMap::Release(u32 slot) const
+    {
+        __atomic_sub_fetch(&_readers[slot], 1, __ATOMIC_SEQ_CST);
+    }
+
+    const MemoryRegion  *RegionMap::Lookup(const Snapshot &snapshot, u32 address)
+    {
+        const std::vector<MemoryRegion>     &regions = snapshot.regions;
+
+        auto    it = std::upper_bound(regions.begin(), regions.end(), address,
+            [](u32 value, const MemoryRegion &region) { return (value < region.start); });
+
+        if (it == regions.begin() || address >= (it - 1)->end)
+            return (nullptr);
+
+        return (&*(it - 1));
+    }
+
+    bool    RegionMap::Check(u32 address, u32 size, u32 perm)
+    {
+        bool    valid = true;
+        u32     last = address + (size ? size - 1 : 0);
+        u32     slot;
+
+        if (last < address)
+            return (false);
+
+        const Snapshot      *snapshot = Acquire(slot);
+        const MemoryRegion  *region = Lookup(*snapshot, address);
+        const MemoryRegion  *end = snapshot->regions.data() + snapshot->regions.size();
+
+        // The range may go on in the next regions if they're contiguous
+        while (valid)
+        {
+            if (region == nullptr || (region->perm & perm) != perm)
+                valid = false;
+            else if (last < region->end)
+                break;
+            else if (region + 1 == end || region[1].start != region->end)
+                valid = false;
+            else
+                ++region;
+        }
+
+        Release(slot);
+        return (valid);
+    }
+
+    bool    RegionMap::IsReadable(u32 address, u32 size)
+    {
+        return (Check(address, size, MEMPERM_READ));
+    }
+
+    bool    RegionMap::IsWritable(u32 address, u32 size)
+    {
+        return (Check(address, size, MEMPERM_READ | MEMPERM_WRITE));
+    }
+
+    bool    RegionMap::Find(u32 address, MemoryRegion &out)
+    {
+        u32                 slot;
+        const Snapshot      *snapshot = Acquire(slot);
+        const MemoryRegion  *region = Lookup(*snapshot, address);
+
+        if (region)
+            out = *region;
+
+        Release(slot);
+        return (region != nullptr);
+    }
+
+    void    RegionMap::Invalidate(void)
+    {
+        LightLock_Lock(&_lock);
+
+        Snapshot    *previous = _snapshot;
+        Snapshot    *snapshot = Enumerate(previous->generation + 1);
+        u32         slot = _epoch & 1;
+
+        __atomic_store_n(&_snapshot, snapshot, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&_epoch, _epoch + 1, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&_generation, snapshot->generation, __ATOMIC_RELEASE);
+
+        // The checks are short, but may be preempted by this thread: sleep rather than spin
+        while (__atomic_load_n(&_readers[slot], __ATOMIC_SEQ_CST) != 0)
+            svcSleepThread(100000);
+
+        delete previous;
+        LightLock_Unlock(&_lock);
+    }
+
+    std::vector<MemoryRegion>   RegionMap::GetRegions(void)
+    {
+        u32                         slot;
+        const Snapshot              *snapshot = Acquire(slot);
+        std::vector<MemoryRegion>   regions(snapshot->regions);
+
+        Release(slot);
+        return (regions);
+    }
+}
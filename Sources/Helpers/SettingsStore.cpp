@@ -0,0 +1,442 @@
+#include "Helpers/SettingsStore.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace CTRPluginFramework
+{
+    SettingsStore   SettingsStore::_instance;
+
+    namespace
+    {
+        const u32   Magic = 0x54455343; ///< CSET
+        const u32   Version = 1;
+
+        // A record with this bit in its size removes the key
+        const u32   RemovedFlag = 0x80000000;
+
+        // A single value can't be larger, so a corrupted size is never allocated
+        const u32   MaxValueSize = 0x10000;
+
+        struct FileHeader
+        {
+            u32     magic;
+            u32     version;
+            u32     count;
+            u32     logStart;   ///< End of the indexed values, start of the records
+            u32     checksum;   ///< Of the index
+        };
+
+        struct IndexEntry
+        {
+            u32     key;
+            u32     offset;
+            u32     size;
+            u32     checksum;
+        };
+
+        struct RecordHeader
+        {
+            u32     key;
+            u32     size;
+            u32     checksum;   ///< Of the key, the size and the data
+        };
+
+        // FNV-1a, like the other caches of the plugin
+        u32     Checksum(const void *data, u32 size, u32 hash = StringID::OffsetBasis)
+        {
+            const u8    *bytes = static_cast<const u8 *>(data);
+
+            while (size--)
+                hash = (hash ^ *bytes++) * StringID::Prime;
+
+            return (hash);
+        }
+
+        u32     RecordChecksum(u32 key, u32 size, const void *data)
+        {
+            u32     hash = Checksum(&key, 4);
+
+            hash = Checksum(&size, 4, hash);
+            return (Checksum(data, size & ~RemovedFlag, hash));
+        }
+
+        bool    WriteEmpty(const std::string &path)
+        {
+            FileHeader  header = { Magic, Version, 0, sizeof(FileHeader), Checksum(nullptr, 0) };
+
+            return (WriteFile(path, &header, sizeof(header)));
+        }
+
+        // The hash of "Entry/" followed by the name of the entry
+        StringID    EntryKey(MenuEntry *entry)
+        {
+            const std::string   &name = entry->Name();
+
+            return (StringID(Checksum(name.data(), name.size(), Checksum("Entry/", 6))));
+        }
+    }
+
+    SettingsStore::SettingsStore(void) :
+        _open(false), _dataSize(0), _logStart(sizeof(FileHeader)), _logEnd(sizeof(FileHeader))
+    {
+    }
+
+    SettingsStore   &SettingsStore::GetInstance(void)
+    {
+        return (_instance);
+    }
+
+    bool    SettingsStore::ReadAt(u32 offset, void *out, u32 size)
+    {
+        return (_open && _file.Seek(offset, File::SET) == 0 && _file.Read(out, size) == 0);
+    }
+
+    bool    SettingsStore::Open(const std::string &path)
+    {
+        MemoryTagScope  scope(MemoryTag::Settings);
+
+        FileHeader  header;
+
+        Close();
+        _path = path;
+        _values.clear();
+        _dataSize = 0;
+        _logStart = _logEnd = sizeof(FileHeader);
+
+        // A compaction cut by a crash left the file in path.tmp or path.bak
+        if (!RecoverFile(path) && !WriteEmpty(path))
+            return (false);
+
+        if (File::Open(_file, path, File::READ | File::WRITE) != 0)
+            return (false);
+
+        _open = true;
+
+        u32                         fileSize = _file.GetSize();
+        std::vector<IndexEntry>     index;
+
+        // Start over from an empty file if the header or the index is damaged
+        if (!ReadAt(0, &header, sizeof(header)) || header.magic != Magic || header.version != Version
+            || header.logStart < sizeof(header) || header.logStart > fileSize
+            || header.count > (header.logStart - sizeof(header)) / sizeof(IndexEntry))
+            return (Reset());
+
+        index.resize(header.count);
+        if (header.count && (!ReadAt(sizeof(header), index.data(), header.count * sizeof(IndexEntry))
+                             || Checksum(index.data(), header.count * sizeof(IndexEntry)) != header.checksum))
+            return (Reset());
+
+        // The index is sorted, the values are read when they're requested
+        _values.resize(header.count);
+        for (u32 i = 0; i < header.count; ++i)
+        {
+            Value   &value = _values[i];
+
+            value.key = index[i].key;
+            value.offset = index[i].offset;
+            value.size = index[i].size;
+            value.checksum = index[i].checksum;
+            value.loaded = false;
+            _dataSize += value.size;
+        }
+
+        _logStart = _logEnd = header.logStart;
+
+        // Replay the records, a damaged one is the end of the log
+        RecordHeader    record;
+        std::vector<u8> data;
+
+        while (_logEnd + sizeof(record) <= fileSize && ReadAt(_logEnd, &record, sizeof(record)))
+        {
+            u32     size = record.size & ~RemovedFlag;
+            u32     offset = _logEnd + sizeof(record);
+
+            if (size > MaxValueSize || offset + size > fileSize)
+                break;
+
+            data.resize(size);
+            if ((size && !ReadAt(offset, data.data(), size))
+                || RecordChecksum(record.key, record.size, data.data()) != record.checksum)
+                break;
+
+            if (record.size & RemovedFlag)
+            {
+                Value   *value = Find(record.key);
+
+                if (value != nullptr)
+                    _values.erase(_values.begin() + (value - _values.data()));
+            }
+            else
+            {
+                Value   &value = Insert(record.key);
+
+                value.offset = offset;
+                value.size = size;
+                value.checksum = Checksum(data.data(), size);
+                value.loaded = true;
+                value.data = data;
+            }
+
+            _logEnd = offset + size;
+        }
+
+        if (LogSize() > CompactThreshold && LogSize() > _dataSize)
+            Compact();
+
+        return (_open);
+    }
+
+    bool    SettingsStore::Reset(void)
+    {
+        _file.Close();
+        _open = false;
+        _values.clear();
+        _dataSize = 0;
+        _logStart = _logEnd = sizeof(FileHeader);
+
+        if (!WriteEmpty(_path))
+            return (false);
+
+        _open = File::Open(_file, _path, File::READ | File::WRITE) == 0;
+        return (_open);
+    }
+
+    void    SettingsStore::Close(void)
+    {
+        if (!_open)
+            return;
+
+        if (LogSize() > CompactThreshold && LogSize() > _dataSize)
+            Compact();
+
+        _file.Close();
+        _open = false;
+    }
+
+    SettingsStore::Value    *SettingsStore::Find(u32 key)
+    {
+        std::vector<Value>::iterator    it = std::lower_bound(_values.begin(), _values.end(), key,
+            [](const Value &value, u32 k) { return (value.key < k); });
+
+        return (it != _values.end() && it->key == key ? &*it : nullptr);
+    }
+
+    SettingsStore::Value    &SettingsStore::Insert(u32 key)
+    {
+        std::vector<Value>::iterator    it = std::lower_bound(_values.begin(), _values.end(), key,
+            [](const Value &value, u32 k) { return (value.key < k); });
+
+        if (it == _values.end() || it->key != key)
+        {
+            Value   value;
+
+            value.key = key;
+            value.offset = 0;
+            value.size = 0;
+            value.checksum = 0;
+            value.loaded = true;
+            it = _values.insert(it, value);
+        }
+
+        return (*it);
+    }
+
+    bool    SettingsStore::Load(Value &value)
+    {
+        if (value.loaded)
+            return (true);
+
+        if (value.size > MaxValueSize)
+            return (false);
+
+        value.data.resize(value.size);
+        if ((value.size && !ReadAt(value.offset, value.data.data(), value.size))
+            || Checksum(value.data.data(), value.size) != value.checksum)
+        {
+            value.data.clear();
+            return (false);
+        }
+
+        value.loaded = true;
+        return (true);
+    }
+
+    bool    SettingsStore::Get(StringID key, void *out, u32 size)
+    {
+        Value   *value = Find(key.Value());
+
+        if (value == nullptr || value->size != size || !Load(*value))
+            return (false);
+
+        std::memcpy(out, value->data.data(), size);
+        return (true);
+    }
+
+    bool    SettingsStore::Get(StringID key, std::string &out)
+    {
+        Value   *value = Find(key.Value());
+
+        if (value == nullptr || !Load(*value))
+            return (false);
+
+        out.assign(reinterpret_cast<const char *>(value->data.data()), value->size);
+        return (true);
+    }
+
+    bool    SettingsStore::Append(u32 key, u32 size, const void *data)
+    {
+        if (!_open)
+            return (false);
+
+        RecordHeader    record = { key, size, RecordChecksum(key, size, data) };
+        u32             length = size & ~RemovedFlag;
+
+        // A record cut by a crash fails its checksum and ends the log on the next Open
+        if (_file.Seek(_logEnd, File::SET) != 0 || _file.Write(&record, sizeof(record)) != 0
+            || (length && _file.Write(data, length) != 0) || _file.Flush() != 0)
+            return (false);
+
+        _logEnd += sizeof(record) + length;
+        return (true);
+    }
+
+    bool    SettingsStore::Set(StringID key, const void *data, u32 size)
+    {
+        MemoryTagScope  scope(MemoryTag::Settings);
+
+        if (size > MaxValueSize)
+            return (false);
+
+        Value   *value = Find(key.Value());
+
+        // Nothing to write if the value didn't change
+        if (value != nullptr && value->size == size && Load(*value)
+            && std::memcmp(value->data.data(), data, size) == 0)
+            return (true);
+
+        u32     offset = _logEnd + sizeof(RecordHeader);
+        bool    saved = Append(key.Value(), size, data);
+        Value   &entry = Insert(key.Value());
+
+        entry.offset = offset;
+        entry.size = size;
+        entry.checksum = Checksum(data, size);
+        entry.loaded = true;
+        entry.data.assign(static_cast<const u8 *>(data), static_cast<const u8 *>(data) + size);
+        return (saved);
+    }
+
+    bool    SettingsStore::Set(StringID key, const std::string &value)
+    {
+        return (Set(key, value.data(), value.size()));
+    }
+
+    bool    SettingsStore::Remove(StringID key)
+    {
+        Value   *value = Find(key.Value());
+
+        if (value == nullptr)
+            return (true);
+
+        _values.erase(_values.begin() + (value - _values.data()));
+        return (Append(key.Value(), RemovedFlag, nullptr));
+    }
+
+    bool    SettingsStore::SaveEntry(MenuEntry *entry)
+    {
+        return (Set(EntryKey(entry), static_cast<u8>(entry->IsActivated())));
+    }
+
+    void    SettingsStore::RestoreEntries(MenuFolder &folder)
+    {
+        for (MenuEntry *entry : folder.GetEntryList())
+            if (GetOr(EntryKey(entry), static_cast<u8>(0)))
+                entry->Enable();
+
+        for (MenuFolder *child : folder.GetFolderList())
+            RestoreEntries(*child);
+    }
+
+    bool    SettingsStore::Has(StringID key) const
+    {
+        std::vector<Value>::const_iterator  it = std::lower_bound(_values.begin(), _values.end(), key.Value(),
+            [](const Value &value, u32 k) { return (value.key < k); });
+
+        return (it != _values.end() && it->key == key.Value());
+    }
+
+    bool    SettingsStore::Compact(void)
+    {
+        MemoryTagScope  scope(MemoryTag::Settings);
+
+        if (_path.empty())
+            return (false);
+
+        // Every value must be in memory before the file is replaced
+        for (u32 i = 0; i < _values.size();)
+        {
+            if (Load(_values[i]))
+                ++i;
+            else
+                _values.erase(_values.begin() + i);
+        }
+
+        u32                 count = _values.size();
+        u32                 offset = sizeof(FileHeader) + count * sizeof(IndexEntry);
+        std::vector<u8>     out(offset);
+        IndexEntry          *index = reinterpret_cast<IndexEntry *>(out.data() + sizeof(FileHeader));
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            const Value     &value = _values[i];
+
+            index[i].key = value.key;
+            index[i].offset = offset;
+            index[i].size = value.size;
+            index[i].checksum = value.checksum;
+            offset += value.size;
+        }
+
+        for (const Value &value : _values)
+            out.insert(out.end(), value.data.begin(), value.data.end());
+
+        index = reinterpret_cast<IndexEntry *>(out.data() + sizeof(FileHeader));
+
+        FileHeader  header = { Magic, Version, count, offset, Checksum(index, count * sizeof(IndexEntry)) };
+
+        std::memcpy(out.data(), &header, sizeof(header));
+
+        if (_open)
+        {
+            _file.Close();
+            _open = false;
+        }
+
+        bool    written = WriteFile(_path, out.data(), out.size());
+
+        if (written)
+        {
+            for (u32 i = 0; i < count; ++i)
+                _values[i].offset = index[i].offset;
+
+            _dataSize = offset - sizeof(FileHeader) - count * sizeof(IndexEntry);
+            _logStart = _logEnd = offset;
+        }
+
+        // The old file is still there if the write failed
+        _open = File::Open(_file, _path, File::READ | File::WRITE) == 0;
+        return (written && _open);
+    }
+
+    u32     SettingsStore::Count(void) const
+    {
+        return (_values.size());
+    }
+
+    u32     SettingsStore::LogSize(void) const
+    {
+        return (_logEnd - _logStart);
+    }
+}
@@ -0,0 +1,382 @@
+#include "Helpers/Signature.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/Format.hpp"
+#include "Helpers/StringID.hpp"
+#include <3ds.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    Signature   *Signature::_first = nullptr;
+
+    namespace
+    {
+        const u32   CacheMagic = 0x43474953; ///< SIGC
+        const u32   CacheVersion = 1;
+        const u32   CodeAddress = 0x00100000;
+
+        struct CacheHeader
+        {
+            u32     magic;
+            u32     version;
+            u64     titleId;
+            u32     codeHash;
+            u32     count;
+        };
+
+        struct CacheEntry
+        {
+            u32     key;
+            u32     address;
+        };
+
+        struct CompiledPattern
+        {
+            std::vector<u8>     bytes;
+            std::vector<u8>     mask;       ///< 0xFF for the bytes to compare
+            u32                 anchor;     ///< Offset of the first two known bytes
+            Signature           *owner;
+        };
+
+        // A pattern to test when its two anchor bytes are found
+        struct Candidate
+        {
+            u16     key;
+            u16     pattern;
+
+            bool    operator<(const Candidate &right) const
+            {
+                return (key < right.key);
+            }
+        };
+
+        int     HexDigit(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return (c - '0');
+            if (c >= 'A' && c <= 'F')
+                return (c - 'A' + 10);
+            if (c >= 'a' && c <= 'f')
+                return (c - 'a' + 10);
+            return (-1);
+        }
+
+        bool    Parse(const char *str, CompiledPattern &pattern)
+        {
+            pattern.bytes.clear();
+            pattern.mask.clear();
+
+            while (*str)
+            {
+                if (*str == ' ')
+                {
+                    ++str;
+                    continue;
+                }
+
+                if (*str == '?')
+                {
+                    str += str[1] == '?' ? 2 : 1;
+                    pattern.bytes.push_back(0);
+                    pattern.mask.push_back(0);
+                    continue;
+                }
+
+                int     high = HexDigit(str[0]);
+                int     low = high < 0 ? -1 : HexDigit(str[1]);
+
+                if (low < 0)
+                    return (false);
+
+                pattern.bytes.push_back((high << 4) | low);
+                pattern.mask.push_back(0xFF);
+                str += 2;
+            }
+
+            for (u32 i = 0; i + 1 < pattern.mask.size(); ++i)
+            {
+                if (pattern.mask[i] && pattern.mask[i + 1])
+                {
+                    pattern.anchor = i;
+                    return (true);
+                }
+            }
+
+            // Two consecutive known bytes are needed to be found in the single pass
+            return (false);
+        }
+
+        bool    Matches(const CompiledPattern &pattern, const u8 *code)
+        {
+            for (u32 i = 0; i < pattern.bytes.size(); ++i)
+                if ((code[i] & pattern.mask[i]) != pattern.bytes[i])
+                    return (false);
+
+            return (true);
+        }
+
+        bool    ReadWord(const u8 *code, u32 address, u32 size, u32 at, u32 &value)
+        {
+            if (size < 4 || at < address || at - address > size - 4)
+                return (false);
+
+            std::memcpy(&value, code + (at - address), 4);
+            return (true);
+        }
+
+        bool    Resolve(SignatureType type, const u8 *code, u32 address, u32 size, u32 at, u32 &out)
+        {
+            u32     insn;
+
+            if (type == SignatureType::Address)
+            {
+                out = at;
+                return (true);
+            }
+
+            if (!ReadWord(code, address, size, at, insn))
+                return (false);
+
+            switch (type)
+            {
+            case SignatureType::ArmBranch:
+                // B / BL / BLX, the H bit of BLX selects the halfword
+                if ((insn & 0x0E000000) != 0x0A000000)
+                    return (false);
+                out = at + 8 + (static_cast<s32>(insn << 8) >> 6);
+                if ((insn >> 28) == 0xF)
+                    out += (insn >> 23) & 2;
+                return (true);
+            case SignatureType::LdrLiteral:
+            {
+                // LDR Rd, [PC, #+/-imm12]
+                if ((insn & 0x0F7F0000) != 0x051F0000)
+                    return (false);
+
+                u32     literal = at + 8;
+
+                literal = insn & (1 << 23) ? literal + (insn & 0xFFF) : literal - (insn & 0xFFF);
+                return (ReadWord(code, address, size, literal, out));
+            }
+            default:
+                out = insn;
+                return (true);
+            }
+        }
+
+        // FNV-1a on words, the code is always word aligned
+        u32     HashCode(const u8 *code, u32 size)
+        {
+            const u32   *words = reinterpret_cast<const u32 *>(code);
+            u32         hash = StringID::OffsetBasis ^ size;
+
+            for (u32 i = 0; i < size / 4; ++i)
+                hash = (hash ^ words[i]) * StringID::Prime;
+
+            return (hash);
+        }
+
+        std::string     CachePath(u64 titleId)
+        {
+            char    buffer[17];
+
+            FormatHex(buffer, titleId, 16);
+            return (std::string("Signatures_") + buffer + ".bin");
+        }
+    }
+
+    Signature::Signature(const char *pattern, s32 offset, SignatureType type) :
+        Signature(pattern, offset, type, AutoRegion(0, 0))
+    {
+    }
+
+    Signature::Signature(const char *pattern, s32 offset, SignatureType type, const AutoRegion &fallback) :
+        _next(_first), _pattern(pattern), _offset(offset), _type(type),
+        _resolved(false), _address(0), _fallback(fallback.Usa, fallback.Eur)
+    {
+        _first = this;
+    }
+
+    Signature::~Signature(void)
+    {
+        Signature   **link = &_first;
+
+        while (*link != nullptr && *link != this)
+            link = &(*link)->_next;
+        if (*link != nullptr)
+            *link = _next;
+    }
+
+    u32     Signature::operator()(void) const
+    {
+        if (_resolved)
+            return (_address);
+        return (_fallback());
+    }
+
+    bool    Signature::IsResolved(void) const
+    {
+        return (_resolved);
+    }
+
+    const char  *Signature::Pattern(void) const
+    {
+        return (_pattern);
+    }
+
+    u32     Signature::Key(void) const
+    {
+        u32     key = StringID::Compute(_pattern, std::strlen(_pattern));
+
+        key = (key ^ static_cast<u32>(_offset)) * StringID::Prime;
+        return ((key ^ static_cast<u32>(_type)) * StringID::Prime);
+    }
+
+    u32     Signature::ResolveAll(void)
+    {
+        if (_first == nullptr)
+            return (0);
+
+        MemInfo     info;
+        PageInfo    page;
+
+        if (R_FAILED(svcQueryMemory(&info, &page, CodeAddress)))
+            return (0);
+
+        const u8    *code = reinterpret_cast<const u8 *>(CodeAddress);
+        u32         size = info.base_addr + info.size - CodeAddress;
+        u64         titleId = Process::GetTitleID();
+        u32         codeHash = HashCode(code, size);
+        std::string path = CachePath(titleId);
+        std::vector<u8> cache;
+        u32         resolved = 0;
+        u32         total = 0;
+
+        // Take the addresses found on a previous boot of the same code
+        if (ReadFile(path, cache) && cache.size() >= sizeof(CacheHeader))
+        {
+            CacheHeader header;
+
+            std::memcpy(&header, cache.data(), sizeof(header));
+
+            if (header.magic == CacheMagic && header.version == CacheVersion && header.titleId == titleId
+                && header.codeHash == codeHash && cache.size() >= sizeof(header) + header.count * sizeof(CacheEntry))
+            {
+                const CacheEntry *entries = reinterpret_cast<const CacheEntry *>(cache.data() + sizeof(header));
+
+                for (Signature *signature = _first; signature != nullptr; signature = signature->_next)
+                {
+                    u32     key = signature->Key();
+
+                    for (u32 i = 0; i < header.count; ++i)
+                    {
+                        if (entries[i].key == key)
+                        {
+                            signature->_address = entries[i].address;
+                            signature->_resolved = true;
+                            ++resolved;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (Signature *signature = _first; signature != nullptr; signature = signature->_next)
+            ++total;
+
+        if (resolved == total)
+            return (resolved);
+
+        resolved += ResolveAll(code, CodeAddress, size);
+
+        // Save the cache
+        std::vector<u8> buffer(sizeof(CacheHeader));
+        CacheHeader     header = { CacheMagic, CacheVersion, titleId, codeHash, 0 };
+
+        for (Signature *signature = _first; signature != nullptr; signature = signature->_next)
+        {
+            if (!signature->_resolved)
+                continue;
+
+            CacheEntry  entry = { signature->Key(), signature->_address };
+            u32         offset = buffer.size();
+
+            buffer.resize(offset + sizeof(entry));
+            std::memcpy(buffer.data() + offset, &entry, sizeof(entry));
+            ++header.count;
+        }
+
+        std::memcpy(buffer.data(), &header, sizeof(header));
+        WriteFile(path, buffer.data(), buffer.size());
+        return (resolved);
+    }
+
+    u32     Signature::ResolveAll(const u8 *code, u32 address, u32 size)
+    {
+        std::vector<CompiledPattern>    patterns;
+        std::vector<Candidate>          candidates;
+        std::vector<u32>                anchors(0x10000 / 32, 0);
+
+        for (Signature *signature = _first; signature != nullptr; signature = signature->_next)
+        {
+            CompiledPattern pattern;
+
+            if (signature->_resolved || !Parse(signature->_pattern, pattern))
+                continue;
+
+            u16         key = pattern.bytes[pattern.anchor] | (pattern.bytes[pattern.anchor + 1] << 8);
+            Candidate   candidate = { key, static_cast<u16>(patterns.size()) };
+
+            pattern.owner = signature;
+            patterns.push_back(pattern);
+            candidates.push_back(candidate);
+            anchors[key >> 5] |= 1u << (key & 31);
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        u32     remaining = patterns.size();
+        u32     resolved = 0;
+
+        // Single pass: a bitmap of the anchors rejects most positions with one test
+        for (u32 i = 0; i + 1 < size && remaining > 0; ++i)
+        {
+            u32     key = code[i] | (code[i + 1] << 8);
+
+            if (!((anchors[key >> 5] >> (key & 31)) & 1))
+                continue;
+
+            Candidate   search = { static_cast<u16>(key), 0 };
+
+            for (auto it = std::lower_bound(candidates.begin(), candidates.end(), search);
+                 it != candidates.end() && it->key == key; ++it)
+            {
+                CompiledPattern &pattern = patterns[it->pattern];
+                Signature   *signature = pattern.owner;
+
+                if (pattern.owner == nullptr || i < pattern.anchor)
+                    continue;
+
+                u32     start = i - pattern.anchor;
+
+                if (start + pattern.bytes.size() > size || !Matches(pattern, code + start))
+                    continue;
+
+                // First match wins, the pattern isn't tested anymore
+                pattern.owner = nullptr;
+                --remaining;
+
+                if (Resolve(signature->_type, code, address, size, address + start + signature->_offset, signature->_address))
+                {
+                    signature->_resolved = true;
+                    ++resolved;
+                }
+            }
+        }
+
+        return (resolved);
+    }
+}
@@ -1,6 +1,7 @@
-#include <cstdio>
+#include <cstring>
 #include <string>
 #include <types.h>
+#include "Helpers/Format.hpp"
 
 namespace CTRPluginFramework
 {
@@ -8,47 +9,41 @@ namespace CTRPluginFramework
     {
         char  buffer[3];
 
-        sprintf(buffer, "%02X", x);
-        return (std::string(buffer));
+        return (std::string(buffer, FormatHex(buffer, static_cast<u32>(x), 2)));
     }
 
     std::string     Hex(u16 x)
     {
         char  buffer[5];
 
-        sprintf(buffer, "%04X", x);
-        return (std::string(buffer));
+        return (std::string(buffer, FormatHex(buffer, static_cast<u32>(x), 4)));
     }
 
     std::string     Hex(u32 x)
     {
         char  buffer[9];
 
-        sprintf(buffer, "%08X", x);
-        return (std::string(buffer));
+        return (std::string(buffer, FormatHex(buffer, x, 8)));
     }
 
     std::string     Hex(u64 x)
     {
         char  buffer[17];
 
-        sprintf(buffer, "%016llX", x);
-        return (std::string(buffer));
+        return (std::string(buffer, FormatHex(buffer, x, 16)));
     }
 
     std::string     Hex(float x)
     {
         char  buffer[9];
 
-        sprintf(buffer, "%08X", (u32)x);
-        return (std::string(buffer));
+        return (std::string(buffer, FormatFloatBits(buffer, x)));
     }
 
     std::string     Hex(double x)
     {
         char  buffer[17];
 
-        sprintf(buffer, "%016llX", (u64)x);
-        return (std::string(buffer));
+        return (std::string(buffer, FormatFloatBits(buffer, x)));
     }
 }
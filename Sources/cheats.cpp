@@ -2,5 +2,120 @@
 
 namespace CTRPluginFramework
 {
+    namespace
+    {
+        // Compiled when their entry is first enabled, indexed like the codes of the database
+        std::vector<ARProgram>  g_programs;
+        std::vector<bool>       g_saved;    ///< If the code was enabled when its entry was last saved
+        ARMemory                g_memory;
 
+        struct Hotkey
+        {
+            const char  *name;
+            u32         keys;
+        };
+
+        // The hotkeys offered by QuickMenuHotkey
+        const Hotkey    g_hotkeys[] =
+        {
+            { "Start", Key::Start },
+            { "Select", Key::Select },
+            { "L + R", Key::L | Key::R },
+            { "ZL + ZR", Key::ZL | Key::ZR },
+            { "L + Down", Key::L | Key::DPadDown }
+        };
+    }
+
+    void    ActionReplayEntry(MenuEntry *entry)
+    {
+        PROFILE_ZONE("ActionReplay");
+
+        CheatDatabase           &database = CheatDatabase::GetInstance();
+        std::vector<CheatCode>  &codes = database.GetCodes();
+        CheatCode               *code = CheatDatabase::FromEntry(entry);
+
+        if (g_programs.size() != codes.size())
+        {
+            g_programs.resize(codes.size());
+            g_saved.resize(codes.size(), false);
+        }
+
+        u32     index = code - codes.data();
+
+        // Saved as it changes, a crash doesn't lose which codes were enabled. Not on WasJustActivated:
+        // the FrameScheduler may run the entry after the menu has reset it
+        if (g_saved[index] != entry->IsActivated())
+        {
+            g_saved[index] = entry->IsActivated();
+            SettingsStore::GetInstance().SaveEntry(entry);
+        }
+
+        // The FrameScheduler calls the entry once more after it's disabled
+        if (!entry->IsActivated())
+            return;
+
+        ARProgram   &program = g_programs[index];
+
+        if (!program.IsValid())
+        {
+            u32         count;
+            const u32   *words = database.Compile(*code, count);
+
+            if (words == nullptr || !program.Compile(words, count))
+            {
+                entry->Disable();
+                return;
+            }
+        }
+
+        program.Execute(g_memory, InputDispatcher::GetInstance().Held());
+    }
+
+    void    QuickMenuHotkey(MenuEntry *entry)
+    {
+        std::vector<std::string>    options;
+
+        for (const Hotkey &hotkey : g_hotkeys)
+            options.push_back(hotkey.name);
+
+        Keyboard    keyboard(options);
+        int         choice = keyboard.Open();
+
+        if (choice < 0)
+            return;
+
+        QuickMenu::GetInstance().ChangeHotkey(g_hotkeys[choice].keys);
+        SettingsStore::GetInstance().Set("QuickMenu/Hotkey"_id, g_hotkeys[choice].keys);
+    }
+
+    u32     SavedQuickMenuHotkey(void)
+    {
+        return (SettingsStore::GetInstance().GetOr("QuickMenu/Hotkey"_id, static_cast<u32>(Key::Start)));
+    }
+
+    void    HeapStatistics(MenuEntry *entry)
+    {
+        if (PoolAllocator::IsOverlayShown())
+            PoolAllocator::HideOverlay();
+        else
+            PoolAllocator::ShowOverlay();
+    }
+
+#ifdef PROFILER_ENABLED
+    void    ProfilerOverlay(MenuEntry *entry)
+    {
+        if (Profiler::IsOverlayShown())
+            Profiler::HideOverlay();
+        else
+            Profiler::ShowOverlay();
+    }
+
+    void    ProfilerDump(MenuEntry *entry)
+    {
+        if (Profiler::DumpCsv("Profiler.csv") && Profiler::DumpChromeTrace("Profiler.json"))
+            OSD::Notify("Profiler.csv and Profiler.json written");
+        else
+            OSD::Notify("The profiler files couldn't be written", Color::Red);
+    }
+#endif
 }
@@ -1,6 +1,7 @@
 #include <3ds.h>
 #include "csvc.h"
 #include <CTRPluginFramework.hpp>
+#include "cheats.hpp"
 
 #include <vector>
 
@@ -10,28 +11,73 @@ namespace CTRPluginFramework {
 // This function is called before main and before the game starts
 // Useful to do code edits safely
 void PatchProcess(FwkSettings &settings) {
-
+  // Find the addresses of the declared signatures before the game runs
+  Signature::ResolveAll();
 
 }
 
 // This function is called when the process exits
 // Useful to save settings, undo patchs or clean up things
 void OnProcessExit(void) {
+  // Restore the original code of every applied patch
+  PatchBatch::RevertAll();
+  // Merge the settings written during the session
+  SettingsStore::GetInstance().Close();
 
-  
+}
 
+// This function is called once per frame
+static void OnNewFrame(Time frameTime) {
+  FrameGeneration::NextFrame();
+  InputDispatcher::GetInstance().Update();
+  FreezeTable::GetInstance().Apply();
+  FrameScheduler::GetInstance().Run();
+  EntryState::Collect();
+  PoolAllocator::OnFrame();
+  PROFILE_FRAME();
 }
 
 void InitMenu(PluginMenu &menu)
 {
-
+  MemoryTagScope scope(MemoryTag::Menu);
+
+  // Only the codes of the running title are kept, they're compiled when enabled
+  CheatDatabase &database = CheatDatabase::GetInstance();
+
+  if (database.LoadFile("CheatDatabase.txt", Process::GetTitleID()))
+  {
+    MenuFolder *folder = new MenuFolder("Action Replay");
+
+    database.Populate(*folder, ActionReplayEntry);
+    // Enable the codes that were enabled when the plugin last ran
+    SettingsStore::GetInstance().RestoreEntries(*folder);
+    // The codes run from the scheduler, within the frame budget
+    FrameScheduler::GetInstance().Add(*folder, ActionReplayEntry);
+    menu += folder;
+  }
+
+  menu += new MenuEntry("Heap statistics", nullptr, HeapStatistics,
+                        "Show the memory used by the plugin, per tag, on the top screen");
+  menu += new MenuEntry("QuickMenu hotkey", nullptr, QuickMenuHotkey,
+                        "Choose the keys held to open the QuickMenu");
+#ifdef PROFILER_ENABLED
+  menu += new MenuEntry("Profiler overlay", nullptr, ProfilerOverlay,
+                        "Show the most expensive profiled zones on the top screen");
+  menu += new MenuEntry("Profiler dump", nullptr, ProfilerDump,
+                        "Write the profiled zones to Profiler.csv and Profiler.json");
+#endif
 
 }
 
 int main(void) {
   PluginMenu menu{ "ctrpf plugin", 0, 7, 4 };
 
+  // Only the index is read, the values are loaded when the cheats ask for them
+  SettingsStore::GetInstance().Open("Settings.bin");
+  QuickMenu::GetInstance().ChangeHotkey(SavedQuickMenuHotkey());
+
   menu.SynchronizeWithFrame(true);
+  menu.OnNewFrame = OnNewFrame;
 
   InitMenu(menu);
 
@@ -0,0 +1,365 @@
+#include "Test.hpp"
+#include "Helpers/ActionReplay.hpp"
+#include "Helpers/CheatDatabase.hpp"
+#include <random>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   Base = 0x08000000;
+    const u32   Size = 0x100000;
+
+    /**
+     * Codes written like the published Gateway ones: plain writes, pointer codes (B) with their
+     * D2 terminator, hotkey conditions (DD), loops filling tables with the D6 to D8 writes,
+     * masked 16 bits conditions, register arithmetic and copies. Their addresses are in the
+     * simulated memory, where the pointers of Memory lead to
+     */
+    const char  Corpus[] =
+        "@0004000000030000 Corpus\n"
+        "[Infinite Health]\n"
+        "0801A2C4 000003E7\n"
+        "[Max Money]\n"
+        "0801A2D0 05F5E0FF\n"
+        "[Infinite Items]\n"
+        "B8000100 00000000\n"
+        "000001F4 00000063\n"
+        "000001F8 00000063\n"
+        "000001FC 00000063\n"
+        "D2000000 00000000\n"
+        "#Movement\n"
+        "[Moon Jump (Hold A)]\n"
+        "DD000000 00000001\n"
+        "B8000104 00000000\n"
+        "10000048 00004000\n"
+        "D0000000 00000000\n"
+        "D2000000 00000000\n"
+        "[Speed Boost (Hold R)]\n"
+        "DD000000 00000100\n"
+        "D3000000 08020000\n"
+        "D9000000 00000040\n"
+        "D4000000 00000100\n"
+        "D6000000 00000040\n"
+        "D2000000 00000000\n"
+        "[Walk Through Walls (L+Up / L+Down)]\n"
+        "DD000000 00000240\n"
+        "28021010 00000001\n"
+        "D0000000 00000000\n"
+        "DD000000 00000280\n"
+        "28021010 00000000\n"
+        "D2000000 00000000\n"
+        "[Teleport Save/Load Slot]\n"
+        "DD000000 00000204\n"
+        "D3000000 08021100\n"
+        "D9000000 00000000\n"
+        "D3000000 08021200\n"
+        "D6000000 00000000\n"
+        "D2000000 00000000\n"
+        "DD000000 00000208\n"
+        "D3000000 08021200\n"
+        "D9000000 00000000\n"
+        "D3000000 08021100\n"
+        "D6000000 00000000\n"
+        "D2000000 00000000\n"
+        "#Items\n"
+        "[All Items x99]\n"
+        "D3000000 08040000\n"
+        "D5000000 00000063\n"
+        "C0000000 0000007F\n"
+        "D8000000 00000000\n"
+        "DC000000 00000003\n"
+        "D2000000 00000000\n"
+        "[Unlock All Costumes]\n"
+        "D5000000 FFFFFFFF\n"
+        "C0000000 00000010\n"
+        "D6000000 08041000\n"
+        "D1000000 00000000\n"
+        "D2000000 00000000\n"
+        "[Item Slot Fix (If Empty)]\n"
+        "D3000000 08042000\n"
+        "C0000000 00000040\n"
+        "9000000C 0000FFFF\n"
+        "1000000C 00000001\n"
+        "D0000000 00000000\n"
+        "DC000000 00000010\n"
+        "D1000000 00000000\n"
+        "D2000000 00000000\n"
+        "#Battle\n"
+        "[One Hit Kill]\n"
+        "B8000108 00000000\n"
+        "6000002C 00000000\n"
+        "0000002C 00000001\n"
+        "D2000000 00000000\n"
+        "[Freeze Enemies]\n"
+        "48023000 000000FF\n"
+        "28023000 00000000\n"
+        "D0000000 00000000\n"
+        "[Rapid Fire (Hold B)]\n"
+        "DD000000 00000002\n"
+        "78023100 00FF0005\n"
+        "18023100 00000000\n"
+        "D2000000 00000000\n"
+        "[Level Up On Select]\n"
+        "DD000000 00000004\n"
+        "D3000000 08023200\n"
+        "DA000000 00000000\n"
+        "D4000000 00000001\n"
+        "D7000000 00000000\n"
+        "D2000000 00000000\n"
+        "[Stat Copy]\n"
+        "D3000000 08023300\n"
+        "DB000000 00000000\n"
+        "D3000000 08023310\n"
+        "C0000000 00000008\n"
+        "D8000000 00000000\n"
+        "D1000000 00000000\n"
+        "D2000000 00000000\n"
+        "#Misc\n"
+        "[Camera Zoom]\n"
+        "A8024000 00000000\n"
+        "88024002 0000FFFF\n"
+        "08024004 42C80000\n"
+        "D0000000 00000000\n"
+        "D0000000 00000000\n"
+        "[Timer Freeze Pointer]\n"
+        "B810010C 00000000\n"
+        "3000000C 00001000\n"
+        "0000000C 00000E10\n"
+        "D0000000 00000000\n"
+        "D2000000 00000000\n"
+        "[Name Patch]\n"
+        "E8025000 0000000E\n"
+        "00410043 00450052\n"
+        "00500020 00410041\n"
+        "[Save Anywhere]\n"
+        "08026000 E3A00001\n"
+        "08026004 E12FFF1E\n";
+
+    // Random bytes, with a few pointers in the memory and a null one
+    std::vector<u8>     Memory(u32 seed)
+    {
+        std::mt19937    rng(seed);
+        std::vector<u8> memory(Size);
+
+        for (u8 &byte : memory)
+            byte = rng() % 4 == 0 ? rng() : rng() % 3;
+
+        const u32   pointers[][2] =
+        {
+            { 0x100, Base + 0x30000 },
+            { 0x104, Base + 0x31000 },
+            { 0x108, seed & 1 ? Base + 0x32000 : 0 },
+            { 0x10C, Base + 0x33000 }
+        };
+
+        for (const auto &pointer : pointers)
+            std::memcpy(&memory[pointer[0]], &pointer[1], 4);
+        return (memory);
+    }
+
+    struct Code
+    {
+        std::vector<u32>    words;
+        ARProgram           program;
+    };
+
+    std::vector<Code>   LoadCorpus(void)
+    {
+        CheatDatabase       &database = CheatDatabase::GetInstance();
+        std::vector<Code>   codes;
+
+        CHECK(database.Load(Corpus, sizeof(Corpus) - 1));
+        CHECK(database.Select(0x0004000000030000ull));
+
+        for (CheatCode &code : database.GetCodes())
+        {
+            u32         count;
+            const u32   *words = database.Compile(code, count);
+
+            CHECK(words != nullptr);
+            if (words == nullptr)
+                continue;
+
+            codes.emplace_back();
+            codes.back().words.assign(words, words + count);
+            CHECK(codes.back().program.Compile(words, count));
+        }
+
+        database.Clear();
+        return (codes);
+    }
+
+    // A random code, valid or not, with some of its addresses outside of the memory
+    std::vector<u32>    RandomCode(std::mt19937 &rng)
+    {
+        auto    random = [&rng](u32 range) { return (static_cast<u32>(rng() % range)); };
+        auto    address = [&]() -> u32
+        {
+            u32     kind = random(10);
+
+            if (kind == 0)
+                return (random(0x0FFFFFFF));
+            if (kind == 1)
+                return (Base + 0x1000 - random(4));
+            return (Base + random(0x1000));
+        };
+        auto    small = [&]() -> u32 { return (random(3) == 0 ? rng() : random(8)); };
+
+        std::vector<u32>    words;
+        u32                 lines = 1 + random(25);
+        bool                loop = false;
+
+        for (u32 i = 0; i < lines; ++i)
+        {
+            u32     type = random(24);
+
+            switch (type)
+            {
+            case 0: case 1: case 2:
+                words.push_back((type << 28) | (address() & 0x0FFFFFFF));
+                words.push_back(rng());
+                break;
+            case 3:
+            {
+                u32     condition = 3 + random(8);
+
+                words.push_back((condition << 28) | (random(2) ? address() & 0x0FFFFFFF : random(64)));
+                words.push_back(condition >= 7 ? (random(2) ? 0 : rng() & 0xFFFF0000) | random(4) : small());
+                break;
+            }
+            case 4:
+                words.push_back(0xB0000000 | (random(2) ? address() & 0x0FFFFFFF : random(0x1000)));
+                words.push_back(0);
+                break;
+            case 5:
+                if (!loop)
+                {
+                    words.push_back(0xC0000000);
+                    words.push_back(random(4));
+                    loop = true;
+                }
+                break;
+            case 6: words.push_back(0xD0000000); words.push_back(0); break;
+            case 7: words.push_back(0xD1000000); words.push_back(0); loop = false; break;
+            case 8: words.push_back(0xD2000000); words.push_back(0); loop = false; break;
+            case 9: words.push_back(0xD3000000); words.push_back(random(2) ? Base + random(0x1000) : random(64)); break;
+            case 10: words.push_back(0xD4000000); words.push_back(small()); break;
+            case 11: words.push_back(0xD5000000); words.push_back(rng()); break;
+            case 12: case 13: case 14: case 15: case 16: case 17:
+                words.push_back(0xD6000000 + ((type - 12) << 24));
+                words.push_back(random(2) ? random(64) : Base + random(0x1000));
+                break;
+            case 18: words.push_back(0xDC000000); words.push_back(random(16)); break;
+            case 19: words.push_back(0xDD000000); words.push_back(random(4)); break;
+            case 20:
+            {
+                u32     size = random(20);
+
+                words.push_back(0xE0000000 | (random(2) ? random(64) : address() & 0x0FFFFFFF));
+                words.push_back(size);
+                for (u32 k = 0; k < (size + 7) / 8 * 2; ++k)
+                    words.push_back(rng());
+                break;
+            }
+            default:
+                words.push_back(address() & 0x0FFFFFFF);
+                words.push_back(rng());
+                break;
+            }
+        }
+        return (words);
+    }
+}
+
+TEST(ActionReplayMatchesTheInterpreter)
+{
+    std::mt19937    rng(1);
+    std::vector<u8> initial = Memory(1);
+    u32             valid = 0;
+
+    for (u32 i = 0; i < 20000; ++i)
+    {
+        std::vector<u32>    words = RandomCode(rng);
+        ARProgram           program;
+
+        if (!program.Compile(words.data(), words.size()))
+            continue;
+
+        std::vector<u8>     expected = initial;
+        std::vector<u8>     actual = initial;
+        ARMemory            reference(expected.data(), Base, Size);
+        ARMemory            memory(actual.data(), Base, Size);
+        u32                 keys = rng() % 4;
+
+        ARProgram::Interpret(words.data(), words.size(), reference, keys);
+        program.Execute(memory, keys);
+        CHECK(actual == expected);
+        ++valid;
+    }
+
+    // Most random codes are valid, so every code type is compared
+    CHECK(valid > 10000);
+}
+
+TEST(ActionReplayRunsTheCorpus)
+{
+    std::vector<Code>   codes = LoadCorpus();
+    const u32           keys[] = { 0, A, B, R, Select, L | DPadUp, L | DPadDown, L | Start, L | Select, A | R };
+
+    CHECK(codes.size() == 19);
+
+    for (u32 seed = 0; seed < 4; ++seed)
+    {
+        std::vector<u8>     expected = Memory(seed);
+        std::vector<u8>     actual = expected;
+        ARMemory            reference(expected.data(), Base, Size);
+        ARMemory            memory(actual.data(), Base, Size);
+
+        // Every code once per frame, the memory they change carries to the next frames
+        for (u32 frame = 0; frame < 30; ++frame)
+        {
+            u32     held = keys[frame % (sizeof(keys) / sizeof(*keys))];
+
+            for (Code &code : codes)
+            {
+                ARProgram::Interpret(code.words.data(), code.words.size(), reference, held);
+                code.program.Execute(memory, held);
+            }
+            CHECK(actual == expected);
+        }
+    }
+}
+
+// 100 codes per frame, the heavy users of the plugin
+BENCH(ActionReplayFrame)
+{
+    std::vector<Code>   corpus = LoadCorpus();
+    std::vector<Code *> codes;
+    std::vector<u8>     bytes = Memory(1);
+    ARMemory            memory(bytes.data(), Base, Size);
+    const u32           frames = 5000;
+
+    while (codes.size() < 100)
+        codes.push_back(&corpus[codes.size() % corpus.size()]);
+
+    Tests::Stopwatch    interpret;
+
+    for (u32 frame = 0; frame < frames; ++frame)
+        for (Code *code : codes)
+            ARProgram::Interpret(code->words.data(), code->words.size(), memory, frame & 0x3FF);
+
+    double  interpreted = interpret.Seconds() / frames;
+
+    Tests::Stopwatch    execute;
+
+    for (u32 frame = 0; frame < frames; ++frame)
+        for (Code *code : codes)
+            code->program.Execute(memory, frame & 0x3FF);
+
+    double  executed = execute.Seconds() / frames;
+
+    std::printf("  100 codes per frame: interpreted %.2f us, compiled %.2f us (x%.2f)\n", interpreted * 1e6,
+                executed * 1e6, interpreted / executed);
+}
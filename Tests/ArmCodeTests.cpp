@@ -0,0 +1,231 @@
+#include "Test.hpp"
+#include "Helpers/ArmCode.hpp"
+#include <cstring>
+
+using namespace CTRPluginFramework;
+
+// The expected outputs were recorded from the relocator and checked by disassembling
+// them with llvm-mc (-triple=armv6k / thumbv6k)
+namespace
+{
+    const u32   From = 0x00120000;
+
+    template <u32 N>
+    bool    SameWords(const u32 *out, u32 size, const u32 (&expected)[N])
+    {
+        return (size == N && std::memcmp(out, expected, sizeof(expected)) == 0);
+    }
+
+    template <u32 N>
+    bool    SameHalfwords(const u16 *out, u32 size, const u16 (&expected)[N])
+    {
+        return (size == N && std::memcmp(out, expected, sizeof(expected)) == 0);
+    }
+
+    // The word loaded by the ARM ldr rd, [pc, #imm] at out[index]
+    u32     ArmLiteral(const u32 *out, u32 index)
+    {
+        u32     insn = out[index];
+        s32     offset = insn & 0x00800000 ? insn & 0xFFF : -static_cast<s32>(insn & 0xFFF);
+
+        return (out[index + 2 + offset / 4]);
+    }
+
+    // The word loaded by the Thumb ldr rd, [pc, #imm] at out[index], out aligned to 4
+    u32     ThumbLiteral(const u16 *out, u32 index)
+    {
+        u32     at = ((index * 2 + 4) & ~3u) + (out[index] & 0xFF) * 4;
+
+        return (out[at / 2] | (out[at / 2 + 1] << 16));
+    }
+}
+
+TEST(ArmCodeEncodesBranches)
+{
+    CHECK(ArmCode::Branch(From, From + 8) == 0xEA000000);
+    CHECK(ArmCode::Branch(From, From, true) == 0xEBFFFFFE);
+    CHECK(ArmCode::BranchTarget(ArmCode::Branch(From, 0x00130000, true), From) == 0x00130000);
+    CHECK(ArmCode::BranchTarget(ArmCode::Branch(0x00130000, From), 0x00130000) == From);
+
+    // Out of range or misaligned
+    CHECK(ArmCode::Branch(0x00100000, 0x08000000) == 0);
+    CHECK(ArmCode::Branch(From, From + 2) == 0);
+
+    // blx with the H bit: halfword destination, Thumb
+    CHECK(ArmCode::BranchTarget(0xFBFFBFFD, From + 4) == 0x00110003);
+    CHECK(ArmCode::BranchTarget(0xE92D4010, From) == 0);
+
+    CHECK(ArmCode::LoadLiteral(15, -4) == 0xE51FF004);
+    CHECK(ArmCode::LoadLiteral(0, 0x10, 0x0) == 0x059F0010);
+}
+
+TEST(ArmRelocationRewritesBranches)
+{
+    u32     out[32];
+
+    // push {r4, lr}; bl 0x00130000
+    const u32   call[] = { 0xE92D4010, 0xEB003FFD };
+    const u32   callOut[] =
+    {
+        0xE92D4010,     // push {r4, lr}
+        0xE28FE000,     // add lr, pc, #0
+        0xE59FF000,     // ldr pc, =0x00130000
+        0xE59FF000,     // ldr pc, =0x00120008
+        0x00130000,
+        0x00120008
+    };
+
+    CHECK(SameWords(out, ArmCode::RelocateArm(call, From, 2, out, 32, true), callOut));
+    CHECK(ArmLiteral(out, 2) == 0x00130000);
+    CHECK(ArmLiteral(out, 3) == From + 8);
+
+    // beq 0x00120100; blx 0x00110002
+    const u32   branches[] = { 0x0A00003E, 0xFBFFBFFD };
+    const u32   branchesOut[] =
+    {
+        0x059FF008,     // ldreq pc, =0x00120100
+        0xE28FE000,     // add lr, pc, #0
+        0xE59FF004,     // ldr pc, =0x00110003
+        0xE59FF004,     // ldr pc, =0x00120008
+        0x00120100,
+        0x00110003,
+        0x00120008
+    };
+
+    CHECK(SameWords(out, ArmCode::RelocateArm(branches, From, 2, out, 32, true), branchesOut));
+    CHECK(ArmLiteral(out, 0) == 0x00120100);
+    CHECK(ArmLiteral(out, 2) == 0x00110003);
+
+    // Without the jump back
+    CHECK(ArmCode::RelocateArm(call, From, 2, out, 32, false) == 4);
+    CHECK(ArmLiteral(out, 2) == 0x00130000);
+}
+
+TEST(ArmRelocationRewritesPcRelativeData)
+{
+    u32     out[32];
+
+    // ldr r0, [pc, #0x10]; add r1, pc, #0x20; ldrb r2, [pc, #-4]; sub r3, pc, #8
+    const u32   loads[] = { 0xE59F0010, 0xE28F1020, 0xE55F2004, 0xE24F3008 };
+    const u32   loadsOut[] =
+    {
+        0xE59F0014,     // ldr r0, =0x00120018
+        0xE5900000,     // ldr r0, [r0]
+        0xE59F1010,     // ldr r1, =0x0012002C
+        0xE59F2010,     // ldr r2, =0x0012000C
+        0xE5D22000,     // ldrb r2, [r2]
+        0xE59F300C,     // ldr r3, =0x0012000C
+        0xE59FF00C,     // ldr pc, =0x00120010
+        0x00120018,
+        0x0012002C,
+        0x0012000C,
+        0x0012000C,
+        0x00120010
+    };
+
+    CHECK(SameWords(out, ArmCode::RelocateArm(loads, From, 4, out, 32, true), loadsOut));
+    CHECK(ArmLiteral(out, 0) == From + 8 + 0x10);
+    CHECK(ArmLiteral(out, 2) == From + 4 + 8 + 0x20);
+    CHECK(ArmLiteral(out, 3) == From + 8 + 8 - 4);
+    CHECK(ArmLiteral(out, 5) == From + 12 + 8 - 8);
+
+    // The instructions not reading pc are copied as they are
+    const u32   plain[] = { 0xE92D4FF0, 0xE24DD01C, 0xE1A04000, 0xE5901004, 0xE3510000 };
+    u32         size = ArmCode::RelocateArm(plain, From, 5, out, 32, false);
+
+    CHECK(size == 5 && std::memcmp(out, plain, sizeof(plain)) == 0);
+}
+
+TEST(ArmRelocationRefusesOtherPcReads)
+{
+    u32     out[32];
+    const u32   refused[] =
+    {
+        0xE1A0000F,     // mov r0, pc
+        0xE08F0001,     // add r0, pc, r1
+        0xE59FF004,     // ldr pc, [pc, #4]
+        0xE29F0004,     // adds r0, pc, #4
+        0xE79F0001,     // ldr r0, [pc, r1]
+        0xE89F0003,     // ldm pc, {r0, r1}
+    };
+
+    for (u32 insn : refused)
+    {
+        const u32   code[] = { 0xE92D4010, insn };
+
+        CHECK(ArmCode::RelocateArm(code, From, 2, out, 32, true) == 0);
+    }
+
+    // Too small for the literals
+    const u32   call[] = { 0xE92D4010, 0xEB003FFD };
+
+    CHECK(ArmCode::RelocateArm(call, From, 2, out, 5, true) == 0);
+    CHECK(ArmCode::RelocateArm(call, From, 2, out, 6, true) == 6);
+}
+
+TEST(ThumbRelocationRewritesPcRelative)
+{
+    u16     out[64];
+    u32     consumed;
+
+    // At 0x00120002: ldr r0, [pc, #4]; add r1, pc, #8; beq 0x00120012; b 0x0011FF0C; bl 0x0013000C
+    const u16   code[] = { 0x4801, 0xA102, 0xD004, 0xE780, 0xF00F, 0xFFFF, 0x0000, 0x0000 };
+    const u16   codeOut[] =
+    {
+        0x480A, 0x6800,                         // ldr r0, =0x00120008; ldr r0, [r0]
+        0x490A,                                 // ldr r1, =0x00120010
+        0xD103,                                 // bne over the jump
+        0xB403, 0x480A, 0x9001, 0xBD01,         // jump 0x00120013
+        0xB403, 0x4809, 0x9001, 0xBD01,         // jump 0x0011FF0D
+        0xF000, 0xF804,                         // bl veneer
+        0xB403, 0x4807, 0x9001, 0xBD01,         // jump back 0x0012000F
+        0xB403, 0x4806, 0x9001, 0xBD01,         // veneer: jump 0x0013000D
+        0x0008, 0x0012, 0x0010, 0x0012, 0x0013, 0x0012, 0xFF0D, 0x0011,
+        0x000F, 0x0012, 0x000D, 0x0013
+    };
+
+    u32     size = ArmCode::RelocateThumb(code, From + 2, 12, out, 64, true, consumed);
+
+    CHECK(consumed == 12);
+    CHECK(SameHalfwords(out, size, codeOut));
+    CHECK(ThumbLiteral(out, 0) == 0x00120008);
+    CHECK(ThumbLiteral(out, 2) == 0x00120010);
+    CHECK(ThumbLiteral(out, 5) == (0x00120012 | 1));
+    CHECK(ThumbLiteral(out, 9) == (0x0011FF0C | 1));
+    CHECK(ThumbLiteral(out, 15) == ((From + 2 + 12) | 1));
+    CHECK(ThumbLiteral(out, 19) == (0x0013000C | 1));
+
+    // The same ldr from an address aligned to 4 reads the same word
+    const u16   aligned[] = { 0x4801, 0x46C0 };
+
+    size = ArmCode::RelocateThumb(aligned, From, 4, out, 64, false, consumed);
+    CHECK(size > 0 && ThumbLiteral(out, 0) == 0x00120008);
+
+    // A BL pair crossing the size is copied whole, blx drops the Thumb bit
+    const u16   call[] = { 0xB510, 0xF00F, 0xEFFE };
+
+    size = ArmCode::RelocateThumb(call, From, 4, out, 64, false, consumed);
+    CHECK(consumed == 6);
+    CHECK(size > 0 && out[0] == 0xB510);
+    CHECK(ThumbLiteral(out, 4) == 0x00130000);
+}
+
+TEST(ThumbRelocationRefusesOtherPcReads)
+{
+    u16     out[64];
+    u32     consumed;
+    const u16   refused[][2] =
+    {
+        { 0x4678, 0x46C0 },     // mov r0, pc
+        { 0x4487, 0x46C0 },     // add pc, r0
+        { 0xF000, 0x46C0 },     // half of a BL pair
+    };
+
+    for (const u16 (&code)[2] : refused)
+        CHECK(ArmCode::RelocateThumb(code, From, 4, out, 64, true, consumed) == 0);
+
+    // Too small for the literal
+    const u16   tooSmall[] = { 0x4801, 0x46C0 };
+
+    CHECK(ArmCode::RelocateThumb(tooSmall, From, 4, out, 4, true, consumed) == 0);
+}
@@ -0,0 +1,166 @@
+#include "Test.hpp"
+#include "Helpers/CheatDatabase.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const char  *Path = "CheatDatabase.txt";
+
+    void    RemoveFiles(void)
+    {
+        std::remove(Path);
+        std::remove("CheatDatabase.txt.idx");
+        std::remove("CheatDatabase.txt.idx.tmp");
+        std::remove("CheatDatabase.txt.idx.bak");
+    }
+
+    void    Save(const std::string &text)
+    {
+        FILE    *file = std::fopen(Path, "wb");
+
+        std::fwrite(text.data(), 1, text.size(), file);
+        std::fclose(file);
+    }
+
+    bool    Exists(const char *path)
+    {
+        FILE    *file = std::fopen(path, "rb");
+
+        if (file != nullptr)
+            std::fclose(file);
+        return (file != nullptr);
+    }
+
+    // A section of a title with some codes, the size of the database of a large game
+    std::string     Section(u64 titleId, u32 codes, const char *prefix = "Code")
+    {
+        char        line[64];
+        std::string text;
+
+        std::snprintf(line, sizeof(line), "@%016llX Title\n#Category\n", static_cast<unsigned long long>(titleId));
+        text += line;
+        for (u32 i = 0; i < codes; ++i)
+        {
+            std::snprintf(line, sizeof(line), "[%s %u]\n{A note}\n", prefix, i);
+            text += line;
+            std::snprintf(line, sizeof(line), "%08X %08X\nD2000000 00000000\n", 0x20000000 + i * 4, i);
+            text += line;
+        }
+        return (text);
+    }
+
+    // The names of the codes loaded, to compare two loads
+    std::string     Names(CheatDatabase &database)
+    {
+        std::string     names;
+
+        for (CheatCode &code : database.GetCodes())
+            names += code.name.ToString() + ";";
+        return (names);
+    }
+}
+
+TEST(CheatDatabaseIndexesTheFile)
+{
+    CheatDatabase   &database = CheatDatabase::GetInstance();
+    std::string     text = Section(0x0004000000030000ull, 3) + Section(0x0004000000055D00ull, 4)
+                           + Section(0x0004000000030000ull, 2, "More");
+
+    RemoveFiles();
+    Save(text);
+
+    // The first load scans the file and saves the index
+    CHECK(database.LoadFile(Path, 0x0004000000030000ull));
+    CHECK(Exists("CheatDatabase.txt.idx"));
+
+    std::string     scanned = Names(database);
+
+    CHECK(database.GetCodes().size() == 5);
+
+    // The next ones read the sections through the index
+    CHECK(database.LoadFile(Path, 0x0004000000030000ull));
+    CHECK(Names(database) == scanned);
+    CHECK(database.LoadFile(Path, 0x0004000000055D00ull));
+    CHECK(database.GetCodes().size() == 4);
+    CHECK(!database.LoadFile(Path, 0x0004000000099900ull));
+
+    u32     words = 0;
+
+    CHECK(database.LoadFile(Path, 0x0004000000030000ull));
+    CHECK(database.Compile(database.GetCodes()[4], words) != nullptr && words == 4);
+
+    // Sections swapped without changing the size: the index is checked and built again
+    std::string     first = Section(0x0004000000030000ull, 3);
+    std::string     second = Section(0x0004000000055D00ull, 3);
+
+    Save(first + second);
+    CHECK(database.LoadFile(Path, 0x0004000000030000ull));
+    Save(second + first);
+    CHECK(database.LoadFile(Path, 0x0004000000055D00ull));
+    CHECK(database.GetCodes().size() == 3);
+    CHECK(database.LoadFile(Path, 0x0004000000030000ull));
+    CHECK(database.GetCodes().size() == 3);
+
+    // A damaged index is ignored
+    FILE    *index = std::fopen("CheatDatabase.txt.idx", "r+b");
+
+    std::fseek(index, 20, SEEK_SET);
+    std::fputc(0x7F, index);
+    std::fclose(index);
+    CHECK(database.LoadFile(Path, 0x0004000000055D00ull));
+    CHECK(database.GetCodes().size() == 3);
+
+    // So is a count whose size in bytes wraps around 32 bits to the size of the sections
+    u32     count;
+
+    index = std::fopen("CheatDatabase.txt.idx", "r+b");
+    std::fseek(index, 12, SEEK_SET);
+    CHECK(std::fread(&count, 4, 1, index) == 1);
+    count += 0x10000000;
+    std::fseek(index, 12, SEEK_SET);
+    std::fwrite(&count, 4, 1, index);
+    std::fclose(index);
+    CHECK(database.LoadFile(Path, 0x0004000000030000ull));
+    CHECK(database.GetCodes().size() == 3);
+
+    database.Clear();
+    RemoveFiles();
+}
+
+// A 2 MB database of 400 titles, loaded for one of them
+BENCH(CheatDatabaseLoadFile)
+{
+    CheatDatabase   &database = CheatDatabase::GetInstance();
+    std::string     text;
+
+    for (u32 title = 0; title < 400; ++title)
+        text += Section(0x0004000000030000ull + (title << 8), 90);
+
+    RemoveFiles();
+    Save(text);
+
+    u64                 titleId = 0x0004000000030000ull + (300 << 8);
+    Tests::Stopwatch    scan;
+
+    database.LoadFile(Path, titleId);
+
+    double  scanned = scan.Seconds();
+    double  indexed = 0.0;
+    u32     runs = 20;
+
+    for (u32 i = 0; i < runs; ++i)
+    {
+        Tests::Stopwatch    load;
+
+        database.LoadFile(Path, titleId);
+        indexed += load.Seconds();
+    }
+
+    std::printf("  %.2f MB, %u codes: first load %.2f ms, with the index %.3f ms\n", text.size() / 1048576.0,
+                static_cast<u32>(database.GetCodes().size()), scanned * 1000.0, indexed / runs * 1000.0);
+    database.Clear();
+    RemoveFiles();
+}
@@ -0,0 +1,108 @@
+#include "Test.hpp"
+#include "Helpers/MenuEntryHelpers.hpp"
+#include <cstring>
+#include <new>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    // Too large for the size classes, allocated on the heap
+    struct Large
+    {
+        u32     values[256];
+    };
+
+    // The entries need a game function to be toggled
+    void    Cheat(MenuEntry *)
+    {
+    }
+
+    void    Collect(void)
+    {
+        for (u32 i = 0; i < EntryState::CollectPeriod; ++i)
+            EntryState::Collect();
+    }
+}
+
+TEST(EntryStateKeepsTheStatesOfTheMenu)
+{
+    PluginMenu  menu;
+    MenuFolder  *folder = new MenuFolder("Folder");
+    MenuEntry   *small = new MenuEntry("Small", Cheat);
+    MenuEntry   *large = new MenuEntry("Large", Cheat);
+    u32         states = EntryState::GetStats().states;
+
+    menu += folder;
+    *folder += small;
+    *folder += large;
+    small->Enable();
+    large->Enable();
+
+    *GetArg<u32>(small, 5) += 1;
+    GetArg<Large>(large)->values[255] = 7;
+    CHECK(*GetArg<u32>(small) == 6);
+    CHECK(GetArg<Large>(large)->values[255] == 7);
+    CHECK(EntryState::GetStats().states == states + 2);
+    CHECK(EntryState::GetStats().heap >= sizeof(Large));
+
+    // Enabled, then disabled for two passes
+    Collect();
+    CHECK(EntryState::GetStats().states == states + 2);
+    small->Disable();
+    large->Disable();
+    Collect();
+    CHECK(EntryState::GetStats().states == states + 2);
+    Collect();
+    CHECK(EntryState::GetStats().states == states);
+    CHECK(small->GetArg() == nullptr);
+    CHECK(large->GetArg() == nullptr);
+}
+
+TEST(EntryStateDropsTheDeletedEntries)
+{
+    PluginMenu  menu;
+    u32         states = EntryState::GetStats().states;
+
+    // An entry deleted without Release, whose memory is then reused
+    alignas(MenuEntry) u8   memory[sizeof(MenuEntry)];
+    MenuEntry               *deleted = new (memory) MenuEntry("Deleted", Cheat);
+
+    deleted->Enable();
+    GetArg<u32>(deleted);
+    GetArg<Large>(deleted);
+    deleted->~MenuEntry();
+    std::memset(memory, 0xFF, sizeof(memory));
+
+    // The entry isn't read nor written
+    Collect();
+    CHECK(EntryState::GetStats().states == states);
+    for (u8 byte : memory)
+        CHECK(byte == 0xFF);
+
+    // An entry kept out of the menu gets a new state
+    MenuEntry   kept("Kept", Cheat);
+
+    kept.Enable();
+    *GetArg<u32>(&kept, 3) = 10;
+    Collect();
+    CHECK(EntryState::GetStats().states == states);
+    CHECK(*GetArg<u32>(&kept, 3) == 3);
+    ReleaseArg(&kept);
+    CHECK(EntryState::GetStats().states == states);
+    CHECK(kept.GetArg() == nullptr);
+
+    // Its block given to another entry before the next lookup
+    MenuEntry   other("Other", Cheat);
+    u32         *state = GetArg<u32>(&kept, 3);
+
+    Collect();
+    CHECK(GetArg<u32>(&other, 7) == state);
+    CHECK(kept.GetArg() == state);
+    CHECK(*GetArg<u32>(&kept, 3) == 3);
+    CHECK(*GetArg<u32>(&other) == 7);
+    CHECK(GetArg<u32>(&kept) != state);
+    ReleaseArg(&kept);
+    ReleaseArg(&other);
+    CHECK(EntryState::GetStats().states == states);
+}
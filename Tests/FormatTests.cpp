@@ -0,0 +1,271 @@
+#include "Test.hpp"
+#include "Helpers/Format.hpp"
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    // Values around the digit boundaries as well as random ones
+    u64     NextValue(std::mt19937_64 &random, u32 i)
+    {
+        static const u64    edges[] = { 0, 1, 9, 10, 99, 100, 0xFF, 0x100, 999999999, 1000000000, 0x7FFFFFFF,
+                                        0x80000000, 0xFFFFFFFF, 0x100000000, 9999999999999999999ull,
+                                        0x7FFFFFFFFFFFFFFF, 0xFFFFFFFFFFFFFFFF };
+        u64     value = random();
+
+        if (i < sizeof(edges) / sizeof(edges[0]))
+            return (edges[i]);
+        return (value >> (random() % 64));
+    }
+
+    // The value written by FormatFloat and snprintf differ at most by one unit of the last decimal
+    bool    CloseEnough(const char *formatted, const char *expected, u32 precision)
+    {
+        double  a = std::atof(formatted);
+        double  b = std::atof(expected);
+
+        return (std::strlen(formatted) == std::strlen(expected)
+                && std::fabs(a - b) <= std::pow(10.0, -static_cast<int>(precision)) * 1.01 + std::fabs(b) * 1e-15);
+    }
+}
+
+TEST(FormatHexMatchesSnprintf)
+{
+    std::mt19937_64     random(1);
+    char                formatted[32];
+    char                expected[32];
+
+    for (u32 i = 0; i < 100000; ++i)
+    {
+        u64     value = NextValue(random, i);
+        u32     digits = random() % 9;
+
+        FormatHex(formatted, static_cast<u32>(value), digits);
+        std::snprintf(expected, sizeof(expected), "%0*" PRIX32, digits, static_cast<u32>(value));
+        CHECK(std::strcmp(formatted, expected) == 0);
+
+        digits = random() % 17;
+        FormatHex(formatted, value, digits);
+        std::snprintf(expected, sizeof(expected), "%0*" PRIX64, digits, value);
+        CHECK(std::strcmp(formatted, expected) == 0);
+    }
+}
+
+TEST(FormatDecimalMatchesSnprintf)
+{
+    std::mt19937_64     random(2);
+    char                formatted[64];
+    char                expected[64];
+    u32                 length;
+
+    for (u32 i = 0; i < 100000; ++i)
+    {
+        u64     value = NextValue(random, i);
+        u32     width = random() % 24;
+
+        length = FormatDecimal(formatted, static_cast<u32>(value), width);
+        std::snprintf(expected, sizeof(expected), "%*" PRIu32, width, static_cast<u32>(value));
+        CHECK(std::strcmp(formatted, expected) == 0 && length == std::strlen(expected));
+
+        FormatDecimal(formatted, static_cast<s32>(value), width);
+        std::snprintf(expected, sizeof(expected), "%*" PRId32, width, static_cast<s32>(value));
+        CHECK(std::strcmp(formatted, expected) == 0);
+
+        FormatDecimal(formatted, static_cast<s32>(value), width, '0');
+        std::snprintf(expected, sizeof(expected), "%0*" PRId32, width, static_cast<s32>(value));
+        CHECK(std::strcmp(formatted, expected) == 0);
+
+        FormatDecimal(formatted, value, width);
+        std::snprintf(expected, sizeof(expected), "%*" PRIu64, width, value);
+        CHECK(std::strcmp(formatted, expected) == 0);
+
+        FormatDecimal(formatted, static_cast<s64>(value), width, '0');
+        std::snprintf(expected, sizeof(expected), "%0*" PRId64, width, static_cast<s64>(value));
+        CHECK(std::strcmp(formatted, expected) == 0);
+    }
+
+    // The width is clamped
+    CHECK(FormatDecimal(formatted, 5u, 100) == FormatMaxWidth);
+}
+
+TEST(FormatFloatMatchesSnprintf)
+{
+    std::mt19937    random(3);
+    char            formatted[128];
+    char            expected[128];
+
+    for (u32 i = 0; i < 100000; ++i)
+    {
+        u32     bits = random();
+        float   value;
+
+        std::memcpy(&value, &bits, sizeof(value));
+        if (!std::isfinite(value) || std::fabs(value) >= 1e15f)
+            continue;
+
+        u32     precision = random() % 7;
+        u32     width = random() % 16;
+
+        FormatFloat(formatted, value, precision, width);
+        std::snprintf(expected, sizeof(expected), "%*.*f", width, precision, static_cast<double>(value));
+        CHECK(CloseEnough(formatted, expected, precision));
+    }
+
+    // Exactly representable values don't depend on the rounding
+    const double    exact[] = { 0.0, 0.5, -0.25, 1.125, 1234.5, -99.75, 1e9, 4294967296.0 };
+
+    for (double value : exact)
+    {
+        FormatFloat(formatted, value, 3, 12);
+        std::snprintf(expected, sizeof(expected), "%12.3f", value);
+        CHECK(std::strcmp(formatted, expected) == 0);
+    }
+}
+
+TEST(FormatEdgeCases)
+{
+    char    formatted[128];
+
+    FormatDecimal(formatted, static_cast<s32>(INT32_MIN));
+    CHECK(std::strcmp(formatted, "-2147483648") == 0);
+    FormatDecimal(formatted, static_cast<s64>(INT64_MIN));
+    CHECK(std::strcmp(formatted, "-9223372036854775808") == 0);
+    FormatFloat(formatted, -9.9996, 3);
+    CHECK(std::strcmp(formatted, "-10.000") == 0);
+    FormatFloat(formatted, 0.0 / 0.0, 2, 6);
+    CHECK(std::strcmp(formatted, "   nan") == 0);
+    FormatFloat(formatted, -1.0 / 0.0, 2);
+    CHECK(std::strcmp(formatted, "-inf") == 0);
+    FormatFloat(formatted, 3.4e38, 3);
+    CHECK(std::strcmp(formatted, "3.400e+38") == 0);
+    FormatFloat(formatted, 1e300, 2);
+    CHECK(std::strcmp(formatted, "1.00e+300") == 0);
+    FormatFloat(formatted, -1.7976931348623157e308, 1);
+    CHECK(std::strcmp(formatted, "-1.8e+308") == 0);
+    FormatFloat(formatted, 9.999e99, 2);
+    CHECK(std::strcmp(formatted, "1.00e+100") == 0);
+    FormatFloat(formatted, 1.5, 20);
+    CHECK(std::strcmp(formatted, "1.500000000") == 0);
+    FormatFloatBits(formatted, 1.0f);
+    CHECK(std::strcmp(formatted, "3F800000") == 0);
+    FormatFloatBits(formatted, -2.0);
+    CHECK(std::strcmp(formatted, "C000000000000000") == 0);
+
+    FixedString<8>  fixed("abc");
+
+    fixed.AppendDecimal(123456u);
+    CHECK(fixed.ToString() == "abc12345" && fixed.size() == 8);
+}
+
+TEST(HexDumpMatchesReference)
+{
+    u8      data[75];
+    char    dump[2048];
+
+    for (u32 i = 0; i < sizeof(data); ++i)
+        data[i] = i * 7 + 0x1A;
+
+    for (u32 bytesPerRow : { 8u, 16u, 32u })
+    {
+        for (bool ascii : { false, true })
+        {
+            std::string     expected;
+            char            part[16];
+
+            for (u32 offset = 0; offset < sizeof(data); offset += bytesPerRow)
+            {
+                std::snprintf(part, sizeof(part), "%08X  ", 0x08000000 + offset);
+                expected += part;
+                for (u32 i = 0; i < bytesPerRow; ++i)
+                {
+                    if (offset + i < sizeof(data))
+                        std::snprintf(part, sizeof(part), "%02X ", data[offset + i]);
+                    else
+                        std::strcpy(part, "   ");
+                    expected += part;
+                }
+                if (ascii)
+                {
+                    expected += ' ';
+                    for (u32 i = 0; i < bytesPerRow; ++i)
+                    {
+                        u8  byte = offset + i < sizeof(data) ? data[offset + i] : ' ';
+
+                        expected += byte >= 0x20 && byte < 0x7F ? static_cast<char>(byte) : '.';
+                    }
+                }
+                expected += '\n';
+            }
+
+            u32     length = HexDump(dump, sizeof(dump), data, sizeof(data), 0x08000000, bytesPerRow, ascii);
+
+            CHECK(length == expected.size() && expected == dump);
+
+            // Only the complete rows fitting in the buffer are written
+            u32     rowSize = HexDumpRowSize(bytesPerRow, ascii);
+
+            length = HexDump(dump, rowSize * 2, data, sizeof(data), 0x08000000, bytesPerRow, ascii);
+            CHECK(length == rowSize && expected.compare(0, rowSize, dump) == 0);
+        }
+    }
+}
+
+BENCH(FormatAgainstSnprintf)
+{
+    const u32       iterations = 2000000;
+    std::mt19937    random(4);
+    std::vector<u32>    values(4096);
+    char            buffer[128];
+
+    for (u32 &value : values)
+        value = random() >> (random() % 32);
+
+    struct Case
+    {
+        const char  *name;
+        double      ours;
+        double      reference;
+    };
+
+    Tests::Stopwatch    watch;
+    Case                cases[3];
+
+    watch = Tests::Stopwatch();
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(FormatHex(buffer, values[i & 4095], 8));
+    cases[0].ours = watch.Seconds();
+    watch = Tests::Stopwatch();
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(std::snprintf(buffer, sizeof(buffer), "%08" PRIX32, values[i & 4095]));
+    cases[0].reference = watch.Seconds();
+    cases[0].name = "hex";
+
+    watch = Tests::Stopwatch();
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(FormatDecimal(buffer, values[i & 4095], 6));
+    cases[1].ours = watch.Seconds();
+    watch = Tests::Stopwatch();
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(std::snprintf(buffer, sizeof(buffer), "%6" PRIu32, values[i & 4095]));
+    cases[1].reference = watch.Seconds();
+    cases[1].name = "decimal";
+
+    watch = Tests::Stopwatch();
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(FormatFloat(buffer, values[i & 4095] / 1000.0, 2));
+    cases[2].ours = watch.Seconds();
+    watch = Tests::Stopwatch();
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(std::snprintf(buffer, sizeof(buffer), "%.2f", values[i & 4095] / 1000.0));
+    cases[2].reference = watch.Seconds();
+    cases[2].name = "float";
+
+    std::printf("    %-8s %10s %10s\n", "", "Format ns", "snprintf ns");
+    for (const Case &c : cases)
+        std::printf("    %-8s %10.1f %10.1f\n", c.name, c.ours * 1e9 / iterations, c.reference * 1e9 / iterations);
+}
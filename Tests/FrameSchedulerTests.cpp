@@ -0,0 +1,203 @@
+#include "Test.hpp"
+#include "Helpers/FrameScheduler.hpp"
+#include "Helpers/Ticks.hpp"
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    u32     g_calls[4];
+    u32     g_costs[4];     ///< Microseconds taken by the tasks
+
+    template <u32 Index>
+    void    Count(MenuEntry *)
+    {
+        ++g_calls[Index];
+        Fake::AdvanceTicks(MicrosecondsToTicks(g_costs[Index]));
+    }
+
+    MenuEntry   *g_added = nullptr;
+
+    // Schedules an entry, then removes itself
+    void    AddOther(MenuEntry *entry)
+    {
+        FrameScheduler  &scheduler = FrameScheduler::GetInstance();
+
+        ++g_calls[0];
+
+        // Enough tasks to move the array of the scheduler
+        for (u32 i = 0; i < 64; ++i)
+            scheduler.Add(g_added, Count<1>);
+        scheduler.Remove(entry);
+    }
+
+    void    Reset(void)
+    {
+        for (u32 i = 0; i < 4; ++i)
+            g_calls[i] = g_costs[i] = 0;
+        Fake::SetTicks(0);
+    }
+}
+
+TEST(FrameSchedulerOwnsTheGameFunction)
+{
+    FrameScheduler  &scheduler = FrameScheduler::GetInstance();
+    MenuEntry       entry("Entry", Count<0>);
+
+    Reset();
+    scheduler.Add(&entry, Count<0>, TaskRate::EveryFrames(2));
+
+    // The menu calls the trampoline, the entry can still be toggled
+    FuncPointer     trampoline = entry.GetGameFunc();
+
+    CHECK(trampoline != nullptr && trampoline != Count<0>);
+
+    // Not called while the entry is disabled
+    scheduler.Run();
+    CHECK(g_calls[0] == 0);
+
+    entry.Enable();
+    CHECK(entry.IsActivated());
+    for (u32 frame = 0; frame < 10; ++frame)
+    {
+        entry.Execute();
+        scheduler.Run();
+    }
+    CHECK(g_calls[0] == 5);
+
+    // One last call once disabled, by the scheduler only
+    entry.Disable();
+    entry.Execute();
+    scheduler.Run();
+    entry.Execute();
+    scheduler.Run();
+    CHECK(g_calls[0] == 6);
+
+    // Switched off and on between two frames: the last call, then it starts over
+    entry.Enable();
+    scheduler.Run();
+    CHECK(g_calls[0] == 7);
+    entry.Disable();
+    entry.Execute();
+    entry.Enable();
+    entry.Execute();
+    scheduler.Run();
+    CHECK(g_calls[0] == 9);
+    CHECK(entry.GetGameFunc() == trampoline);
+
+    scheduler.Remove(&entry);
+    CHECK(entry.GetGameFunc() == Count<0>);
+    scheduler.Run();
+    CHECK(g_calls[0] == 9);
+}
+
+TEST(FrameSchedulerSchedulesAFolder)
+{
+    FrameScheduler  &scheduler = FrameScheduler::GetInstance();
+    MenuFolder      folder("Folder");
+    MenuFolder      *subfolder = new MenuFolder("Subfolder");
+    MenuEntry       *entries[] = { new MenuEntry("A", Count<2>), new MenuEntry("B", Count<2>), new MenuEntry("C", Count<2>) };
+
+    Reset();
+    folder.Append(entries[0]);
+    folder.Append(subfolder);
+    subfolder->Append(entries[1]);
+    subfolder->Append(entries[2]);
+
+    scheduler.Add(folder, Count<2>);
+    for (MenuEntry *entry : entries)
+    {
+        CHECK(entry->GetGameFunc() != Count<2>);
+        entry->Enable();
+        CHECK(entry->IsActivated());
+    }
+
+    scheduler.Run();
+    CHECK(g_calls[2] == 3);
+
+    for (MenuEntry *entry : entries)
+    {
+        scheduler.Remove(entry);
+        CHECK(entry->GetGameFunc() == Count<2>);
+    }
+}
+
+TEST(FrameSchedulerDefersChangesMadeByTasks)
+{
+    FrameScheduler  &scheduler = FrameScheduler::GetInstance();
+    MenuEntry       entry("Adds", AddOther);
+    MenuEntry       added("Added", Count<1>);
+
+    Reset();
+    g_added = &added;
+    scheduler.Add(&entry, AddOther);
+    entry.Enable();
+    added.Enable();
+
+    // The added tasks start on the next frame, the removal is applied at the end of this one
+    scheduler.Run();
+    CHECK(g_calls[0] == 1);
+    CHECK(g_calls[1] == 0);
+    CHECK(entry.GetGameFunc() == AddOther);
+    CHECK(added.GetGameFunc() != nullptr && added.GetGameFunc() != Count<1>);
+
+    scheduler.Run();
+    CHECK(g_calls[0] == 1);
+    CHECK(g_calls[1] == 64);
+
+    std::vector<TaskStats>  stats;
+
+    scheduler.GetStats(stats);
+    CHECK(stats.size() == 64);
+
+    scheduler.Remove(&added);
+    scheduler.GetStats(stats);
+    CHECK(stats.empty());
+    CHECK(added.GetGameFunc() == Count<1>);
+}
+
+TEST(FrameSchedulerDefersHeavyTasksOverTheBudget)
+{
+    FrameScheduler  &scheduler = FrameScheduler::GetInstance();
+    MenuEntry       light("Light");
+    MenuEntry       heavy("Heavy");
+    MenuEntry       other("Other");
+
+    Reset();
+    scheduler.SetBudget(2000);
+    scheduler.Add(&light, Count<0>, TaskRate::EveryFrame(), TaskCost::Light);
+    scheduler.Add(&heavy, Count<1>, TaskRate::EveryFrame(), TaskCost::Heavy);
+    scheduler.Add(&other, Count<2>, TaskRate::EveryFrame(), TaskCost::Heavy);
+    light.Enable();
+    heavy.Enable();
+    other.Enable();
+
+    // Only one heavy task fits per frame, they take turns
+    g_costs[0] = 100;
+    g_costs[1] = 1500;
+    g_costs[2] = 1500;
+    for (u32 frame = 0; frame < 20; ++frame)
+        scheduler.Run();
+
+    CHECK(g_calls[0] == 20);
+    CHECK(g_calls[1] == 10 && g_calls[2] == 10);
+    CHECK(scheduler.FramesOverBudget() == 0);
+
+    std::vector<TaskStats>  stats;
+
+    scheduler.GetStats(stats);
+    CHECK(stats.size() == 3);
+    CHECK(stats[1].max == 1500 && stats[1].deferrals == 10);
+
+    // The light task now takes the whole budget: a heavy task still runs every MaxDeferrals + 1 frames
+    g_costs[0] = 2000;
+    g_calls[1] = g_calls[2] = 0;
+    for (u32 frame = 0; frame < 9 * 4; ++frame)
+        scheduler.Run();
+
+    CHECK(g_calls[1] >= 4 && g_calls[2] >= 4);
+
+    scheduler.Remove(&light);
+    scheduler.Remove(&heavy);
+    scheduler.Remove(&other);
+}
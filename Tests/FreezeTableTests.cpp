@@ -0,0 +1,208 @@
+#include "Test.hpp"
+#include "Helpers/FreezeTable.hpp"
+#include <cstring>
+#include <random>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   HeapBase = 0x08000000;
+    const u32   OtherBase = 0x08100000;
+
+    u32     Word(const u8 *memory, u32 offset)
+    {
+        u32     value;
+
+        std::memcpy(&value, memory + offset, 4);
+        return (value);
+    }
+
+    bool    g_enabled = true;
+
+    bool    IsEnabled(void)
+    {
+        return (g_enabled);
+    }
+}
+
+TEST(FreezeTableMergesAndWritesChangesOnly)
+{
+    FreezeTable &table = FreezeTable::GetInstance();
+    u8          *heap = Fake::Map(HeapBase, 0x1000);
+
+    CHECK(heap != nullptr);
+    if (heap == nullptr)
+        return;
+
+    table.Add(HeapBase + 0x10, 0x11111111);
+    table.Add(HeapBase + 0x14, 0x2222, 2);
+    table.Add(HeapBase + 0x16, 0x33, 1);
+    table.Add(HeapBase + 0x17, 0x44, 1);
+    table.Add(HeapBase + 0x100, 0x55555555);
+
+    // The last lock on an address wins
+    u32     last = table.Add(HeapBase + 0x100, 0x66666666);
+
+    CHECK(table.Count() == 6);
+    CHECK(table.RunCount() == 2);
+    CHECK(table.Apply() == 12);
+    CHECK(Word(heap, 0x10) == 0x11111111);
+    CHECK(Word(heap, 0x14) == 0x44332222);
+    CHECK(Word(heap, 0x100) == 0x66666666);
+
+    // Nothing differs
+    CHECK(table.Apply() == 0);
+
+    heap[0x15] = 0;
+    CHECK(table.Apply() == 4);
+    CHECK(Word(heap, 0x14) == 0x44332222);
+
+    table.Remove(last);
+    CHECK(table.Apply() == 4);
+    CHECK(Word(heap, 0x100) == 0x55555555);
+
+    // The runs of a condition are only written while it holds
+    table.Add(HeapBase + 0x200, 0x77777777, 4, IsEnabled);
+    g_enabled = false;
+    CHECK(table.Apply() == 0);
+    g_enabled = true;
+    CHECK(table.Apply() == 4);
+
+    table.Clear();
+    CHECK(table.Count() == 0 && table.RunCount() == 0);
+}
+
+TEST(FreezeTableSkipsMemoryWhichIsNotWritable)
+{
+    FreezeTable &table = FreezeTable::GetInstance();
+    u8          *heap = Fake::Map(HeapBase, 0x1000);
+
+    CHECK(heap != nullptr);
+    if (heap == nullptr)
+        return;
+
+    table.Add(HeapBase + 0x10, 0x11111111);
+    table.Add(OtherBase + 0x10, 0x22222222);
+    table.Add(0x00000100, 0x33333333);
+    table.Add(HeapBase + 0xFFC, 0x44444444);
+
+    // Only the runs in the heap are written
+    CHECK(table.Apply() == 8);
+    CHECK(Word(heap, 0x10) == 0x11111111);
+
+    // The regions are only queried again when the layout changes
+    u32     queries = Fake::QueryCount();
+
+    heap[0x10] = 0;
+    CHECK(table.Apply() == 4);
+    CHECK(Fake::QueryCount() == queries);
+
+    u8      *other = Fake::Map(OtherBase, 0x1000);
+
+    CHECK(other != nullptr);
+    if (other != nullptr)
+    {
+        CHECK(table.Apply() == 4);
+        CHECK(Word(other, 0x10) == 0x22222222);
+    }
+
+    // Read only
+    Fake::SetPermissions(HeapBase, MEMPERM_READ);
+    heap[0x10] = 0;
+    CHECK(table.Apply() == 0);
+    CHECK(heap[0x10] == 0);
+
+    Fake::Unmap(OtherBase);
+    Fake::SetPermissions(HeapBase, MEMPERM_READ | MEMPERM_WRITE);
+    CHECK(table.Apply() == 4);
+
+    table.Clear();
+}
+
+TEST(FreezeTableAppliesToACopy)
+{
+    FreezeTable     &table = FreezeTable::GetInstance();
+    std::vector<u8> copy(0x100);
+
+    table.Add(HeapBase + 0x10, 0x11111111);
+    table.Add(HeapBase + 0xFE, 0x2222, 2);
+    table.Add(HeapBase + 0x104, 0x33333333);
+    table.Add(HeapBase - 4, 0x44444444);
+
+    CHECK(table.Apply(copy.data(), HeapBase, copy.size()) == 6);
+    CHECK(Word(copy.data(), 0x10) == 0x11111111);
+    CHECK(copy[0xFE] == 0x22 && copy[0xFF] == 0x22);
+
+    table.Clear();
+}
+
+// The table against the plain loop it replaces: every lock written each frame
+BENCH(FreezeTableApply)
+{
+    const u32   size = 4 << 20;
+    u8          *heap = Fake::Map(HeapBase, size);
+
+    if (heap == nullptr)
+        return;
+
+    FreezeTable &table = FreezeTable::GetInstance();
+
+    for (u32 count : { 100u, 1000u, 10000u })
+    {
+        std::mt19937        random(count);
+        std::vector<u32>    addresses(count);
+        std::vector<u32>    values(count);
+        u32                 frames = 2000000 / count;
+
+        u32                 structure = 0;
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            // Fields of structures, four locks per structure
+            if (i % 4 == 0)
+                structure = (random() % (size / 64)) * 64;
+            addresses[i] = HeapBase + structure + (i % 4) * 4;
+            values[i] = random();
+            table.Add(addresses[i], values[i]);
+        }
+
+        table.Apply();
+
+        Tests::Stopwatch    plain;
+
+        for (u32 frame = 0; frame < frames; ++frame)
+        {
+            for (u32 i = 0; i < count; ++i)
+                *reinterpret_cast<vu32 *>(static_cast<uintptr_t>(addresses[i])) = values[i];
+            Tests::KeepAlive(heap[frame % size]);
+        }
+
+        double  plainTime = plain.Seconds();
+
+        Tests::Stopwatch    steady;
+
+        for (u32 frame = 0; frame < frames; ++frame)
+            Tests::KeepAlive(table.Apply());
+
+        double  steadyTime = steady.Seconds();
+
+        // The game changed a tenth of the values since the last frame
+        Tests::Stopwatch    changing;
+        u32                 written = 0;
+
+        for (u32 frame = 0; frame < frames; ++frame)
+        {
+            for (u32 i = frame % 10; i < count; i += 10)
+                heap[addresses[i] - HeapBase] ^= 1;
+            written += table.Apply();
+        }
+
+        double  changingTime = changing.Seconds();
+
+        std::printf("    %5u locks, %u runs: plain %7.0f ns, table %7.0f ns, a tenth changed %7.0f ns (%u bytes)\n",
+                    count, table.RunCount(), plainTime * 1e9 / frames, steadyTime * 1e9 / frames,
+                    changingTime * 1e9 / frames, written / frames);
+        table.Clear();
+    }
+}
@@ -0,0 +1,68 @@
+#include "GameMemory.hpp"
+#include <cstring>
+#include <random>
+
+namespace Tests
+{
+    void    FillGameMemory(u8 *data, u32 size, u32 seed, u32 pointerBase, u32 pointerRange, u8 *kinds)
+    {
+        std::mt19937    random(seed);
+
+        for (u32 offset = 0; offset < size; offset += 0x1000)
+        {
+            u8      *page = data + offset;
+            u32     length = size - offset < 0x1000 ? size - offset : 0x1000;
+            u32     kind = random() % 100;
+
+            if (kinds != nullptr)
+                kinds[offset / 0x1000] = kind < 45 ? ZeroPage : kind < 55 ? FilledPage : kind < 80 ? StructurePage
+                                         : kind < 92 ? FloatPage : RandomPage;
+
+            if (kind < 45)
+                std::memset(page, 0, length);
+            else if (kind < 55)
+                std::memset(page, 0xFF, length);
+            else if (kind < 80)
+            {
+                // Structures of 8 words: a pointer, small counters, padding
+                for (u32 i = 0; i + 4 <= length; i += 4)
+                {
+                    u32     word = i / 4;
+                    u32     value = word % 8 == 0 ? pointerBase + (random() % (pointerRange / 4)) * 4
+                                    : word % 8 < 4 ? random() % 100 : 0;
+
+                    std::memcpy(page + i, &value, 4);
+                }
+            }
+            else if (kind < 92)
+            {
+                for (u32 i = 0; i + 4 <= length; i += 4)
+                {
+                    float   value = (i / 4) % 4 == 3 ? 1.f : (random() % 1000) / 10.f;
+
+                    std::memcpy(page + i, &value, 4);
+                }
+            }
+            else
+            {
+                for (u32 i = 0; i < length; ++i)
+                    page[i] = random();
+            }
+        }
+    }
+
+    void    MutateWords(u8 *data, u32 size, u32 count, u32 seed)
+    {
+        std::mt19937    random(seed);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            u32     offset = (random() % (size / 4)) * 4;
+            u32     value;
+
+            std::memcpy(&value, data + offset, 4);
+            value += static_cast<s32>(random() % 3) - 1;
+            std::memcpy(data + offset, &value, 4);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef TESTS_GAMEMEMORY_HPP
+#define TESTS_GAMEMEMORY_HPP
+
+#include "types.h"
+
+namespace Tests
+{
+    enum PageKind : u8
+    {
+        ZeroPage, FilledPage, StructurePage, FloatPage, RandomPage, PageKinds
+    };
+
+    /**
+     * Fill a buffer with pages looking like a game heap: zero pages, 0xFF pages, structures of
+     * small integers and pointers into [pointerBase, pointerBase + pointerRange), float arrays
+     * and random bytes. The same seed gives the same memory.
+     * \param kinds If not null, receives the PageKind of each 4 KB page
+     */
+    void    FillGameMemory(u8 *data, u32 size, u32 seed, u32 pointerBase = 0x08000000, u32 pointerRange = 0x400000,
+                           u8 *kinds = nullptr);
+
+    /**
+     * Add -1, 0 or 1 to count random aligned words, like a game updating some counters
+     */
+    void    MutateWords(u8 *data, u32 size, u32 count, u32 seed);
+}
+
+#endif
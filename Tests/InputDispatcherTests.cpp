@@ -0,0 +1,181 @@
+#include "Test.hpp"
+#include "Helpers/HoldKey.hpp"
+#include "Helpers/InputDispatcher.hpp"
+#include "Helpers/KeySequence.hpp"
+#include <functional>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u64   FrameTicks = SYSCLOCK_ARM11 / 60;
+
+    struct Step
+    {
+        u32     keys;
+        u32     frames;
+    };
+
+    // Feed the dispatcher the keys of a script, 60 frames per second, and poll after each frame
+    class Script
+    {
+    public:
+        Script(void) : _ticks(0)
+        {
+            // Release what a previous test left down
+            InputDispatcher::GetInstance().Update(0, _ticks);
+        }
+
+        // Return the frames where poll returned true, counted from 1
+        std::vector<u32>    Play(const std::vector<Step> &steps, std::function<bool(void)> poll)
+        {
+            std::vector<u32>    frames;
+            u32                 frame = 0;
+
+            for (const Step &step : steps)
+            {
+                for (u32 i = 0; i < step.frames; ++i)
+                {
+                    _ticks += FrameTicks;
+                    InputDispatcher::GetInstance().Update(step.keys, _ticks);
+                    if (poll && poll())
+                        frames.push_back(frame + 1);
+                    ++frame;
+                }
+            }
+
+            return (frames);
+        }
+
+    private:
+        u64     _ticks;
+    };
+
+    u32     g_callbacks = 0;
+
+    void    CountCallback(void *)
+    {
+        ++g_callbacks;
+    }
+
+    // Removes its own binding
+    void    RemoveCallback(void *arg)
+    {
+        ++g_callbacks;
+        InputDispatcher::GetInstance().Remove(*static_cast<u32 *>(arg));
+    }
+}
+
+TEST(InputDispatcherFiresCombosOnThePressCompletingThem)
+{
+    InputDispatcher &dispatcher = InputDispatcher::GetInstance();
+    Script          script;
+    u32             handle = dispatcher.AddCombo(L | R | A);
+
+    std::vector<u32>    fires = script.Play({ { L, 3 }, { L | R, 3 }, { L | R | A, 5 }, { L | R, 1 }, { L | R | A, 1 },
+                                              { R | A, 2 }, { L | R | A, 2 } },
+                                            [handle]() { return (InputDispatcher::GetInstance().Fired(handle)); });
+
+    CHECK((fires == std::vector<u32>{ 7, 13, 16 }));
+    dispatcher.Remove(handle);
+    CHECK(!dispatcher.Fired(handle));
+}
+
+TEST(HoldKeyFiresEveryHoldTime)
+{
+    Script      script;
+    HoldKey     hold(L | R, Seconds(1.f));
+
+    // Held 2.5 seconds, released, then held again for 1.5 seconds: fires a second after the press
+    std::vector<u32>    fires = script.Play({ { L | R, 150 }, { L, 10 }, { L | R, 90 } },
+                                            [&hold]() { return (hold()); });
+
+    CHECK((fires == std::vector<u32>{ 61, 121, 221 }));
+
+    // New keys reset the hold
+    hold = X;
+    fires = script.Play({ { L | R, 70 }, { X, 61 } }, [&hold]() { return (hold()); });
+    CHECK((fires == std::vector<u32>{ 131 }));
+}
+
+TEST(HoldKeyForgetsAFireNotReadDuringItsFrame)
+{
+    Script      script;
+    HoldKey     hold(Y, Seconds(0.5f));
+    u32         frame = 0;
+
+    // Fires on frame 31, only polled from the next frame on
+    std::vector<u32>    fires = script.Play({ { Y, 40 }, { 0, 20 } },
+                                            [&hold, &frame]() { return (++frame > 31 && hold()); });
+
+    CHECK(fires.empty());
+
+    // Polled twice in the frame: reported once
+    u32     reads = 0;
+
+    script.Play({ { Y, 31 } }, [&hold, &reads]() { reads += hold(); reads += hold(); return (false); });
+    CHECK(reads == 1);
+}
+
+TEST(InputDispatcherArmsAHoldRemappedToHeldKeys)
+{
+    InputDispatcher &dispatcher = InputDispatcher::GetInstance();
+    Script          script;
+    u32             handle = dispatcher.AddHold(ZL, Seconds(0.5f), false);
+    auto            poll = [handle]() { return (InputDispatcher::GetInstance().Fired(handle)); };
+
+    // Remapped while its new keys are held: counts from the change
+    CHECK(script.Play({ { L | R, 10 } }, poll).empty());
+    CHECK(dispatcher.SetKeys(handle, L | R));
+    CHECK((script.Play({ { L | R, 40 } }, poll) == std::vector<u32>{ 30 }));
+
+    // Remapped to keys not all held: waits for the press
+    CHECK(dispatcher.SetKeys(handle, L | A));
+    CHECK(script.Play({ { L | R, 40 } }, poll).empty());
+    CHECK((script.Play({ { L | A, 40 } }, poll) == std::vector<u32>{ 31 }));
+
+    dispatcher.Remove(handle);
+}
+
+TEST(KeySequenceFiresWithinTheTimeout)
+{
+    Script          script;
+    KeySequence     sequence({ DPadUp, DPadUp, DPadDown, A }, Seconds(0.5f));
+    auto            poll = [&sequence]() { return (sequence()); };
+
+    // Each key pressed for a few frames, 10 frames between them
+    CHECK((script.Play({ { DPadUp, 5 }, { 0, 10 }, { DPadUp, 5 }, { 0, 10 }, { DPadDown, 5 }, { 0, 10 }, { A, 5 }, { 0, 5 } },
+                       poll) == std::vector<u32>{ 46 }));
+
+    // Too slow between two keys
+    CHECK(script.Play({ { DPadUp, 5 }, { 0, 10 }, { DPadUp, 5 }, { 0, 40 }, { DPadDown, 5 }, { 0, 10 }, { A, 5 } },
+                      poll).empty());
+
+    // A wrong key restarts, the third up starts again from the first step
+    CHECK((script.Play({ { DPadUp, 2 }, { B, 2 }, { DPadUp, 2 }, { 0, 2 }, { DPadUp, 2 }, { 0, 2 }, { DPadUp, 2 },
+                         { DPadDown, 2 }, { A, 2 } }, poll) == std::vector<u32>{ 17 }));
+}
+
+TEST(InputDispatcherDoubleTapAndCallbacks)
+{
+    InputDispatcher &dispatcher = InputDispatcher::GetInstance();
+    Script          script;
+    u32             count = dispatcher.Count();
+    u32             tap = dispatcher.AddDoubleTap(B, Seconds(0.3f), CountCallback);
+    u32             once = dispatcher.AddCombo(X, RemoveCallback, &once);
+
+    g_callbacks = 0;
+
+    // Within 0.3 seconds, then too slow
+    script.Play({ { B, 3 }, { 0, 5 }, { B, 3 }, { 0, 30 }, { B, 3 }, { 0, 30 }, { B, 3 } }, nullptr);
+    CHECK(g_callbacks == 1);
+
+    // The callback removing its binding runs once
+    script.Play({ { X, 2 }, { 0, 2 }, { X, 2 } }, nullptr);
+    CHECK(g_callbacks == 2);
+    CHECK(dispatcher.Count() == count + 1);
+
+    dispatcher.Remove(tap);
+    CHECK(dispatcher.Count() == count);
+}
@@ -0,0 +1,167 @@
+#include "Test.hpp"
+#include "Helpers/HoldKey.hpp"
+#include "Helpers/InputRecorder.hpp"
+#include "Helpers/KeySequence.hpp"
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u64   FrameTicks = SYSCLOCK_ARM11 / 60;
+    const u32   FrameCount = 3000;
+
+    // The keys of a player pressing things for a few frames at a time
+    std::vector<u32>    MakeScript(u32 seed)
+    {
+        const u32           choices[] = { 0, 0, L, L, DPadUp, DPadDown, A, L | R, R };
+        std::vector<u32>    keys;
+        std::mt19937        random(seed);
+
+        while (keys.size() < FrameCount)
+        {
+            // Now and then the key sequence, a few frames per key
+            if (random() % 8 == 0)
+            {
+                for (u32 key : { u32(DPadUp), 0u, u32(DPadDown), 0u, u32(A) })
+                    keys.insert(keys.end(), 2 + random() % 6, key);
+            }
+            else
+                keys.insert(keys.end(), 1 + random() % 40, choices[random() % 9]);
+        }
+
+        keys.resize(FrameCount);
+        return (keys);
+    }
+
+    /**
+     * Run the frame loop of the plugin: update the dispatcher from the fake controller, poll
+     * the bindings and note which fired, then let the frame time pass
+     * \param frameTime The ticks of each frame
+     * \return One byte per frame, a bit per binding
+     */
+    std::vector<u8>     Simulate(const std::vector<u32> &keys, std::function<u64(u32)> frameTime)
+    {
+        InputDispatcher     &dispatcher = InputDispatcher::GetInstance();
+        HoldKey             hold(L, Seconds(0.5f));
+        KeySequence         sequence({ DPadUp, DPadDown, A }, Seconds(0.4f));
+        u32                 combo = dispatcher.AddCombo(L | R);
+        std::vector<u8>     fires;
+
+        Fake::SetTicks(1000000);
+        for (u32 frame = 0; frame < keys.size(); ++frame)
+        {
+            Fake::SetKeys(keys[frame]);
+            dispatcher.Update();
+            fires.push_back(hold() | sequence() << 1 | dispatcher.Fired(combo) << 2);
+            Fake::AdvanceTicks(frameTime(frame));
+        }
+
+        dispatcher.Remove(combo);
+
+        // Release the keys for the next run
+        Fake::SetKeys(0);
+        dispatcher.Update();
+        return (fires);
+    }
+
+    u32     Count(const std::vector<u8> &fires, u8 bit)
+    {
+        u32     count = 0;
+
+        for (u8 fire : fires)
+            count += (fire & bit) != 0;
+        return (count);
+    }
+}
+
+TEST(InputReplayFiresOnTheRecordedFrames)
+{
+    InputDispatcher     &dispatcher = InputDispatcher::GetInstance();
+    InputRecorder       recorder;
+    std::vector<u32>    keys = MakeScript(15);
+    std::vector<u8>     data;
+
+    // Recorded at a steady 60 frames per second
+    recorder.Start();
+    dispatcher.SetRecorder(&recorder);
+
+    std::vector<u8>     live = Simulate(keys, [](u32) { return (FrameTicks); });
+
+    dispatcher.SetRecorder(nullptr);
+    recorder.Stop();
+
+    CHECK(recorder.FrameCount() == FrameCount + 1);
+    CHECK(recorder.FrameTicks() == FrameTicks);
+    CHECK(Count(live, 1) > 10 && Count(live, 2) > 0 && Count(live, 4) > 10);
+
+    recorder.Serialize(data);
+
+    // Played while the game runs at 30 frames per second, then with a random frame time
+    std::mt19937    random(4);
+    InputReplay     replay;
+
+    CHECK(replay.SetData(data));
+    dispatcher.SetSource(&replay);
+
+    std::vector<u8>     slow = Simulate(keys, [](u32) { return (FrameTicks * 2); });
+
+    replay.Rewind();
+
+    std::vector<u8>     jittery = Simulate(keys, [&random](u32) { return (FrameTicks / 2 + random() % (FrameTicks * 2)); });
+
+    dispatcher.SetSource(nullptr);
+
+    CHECK(slow == live);
+    CHECK(jittery == live);
+    CHECK(replay.Finished());
+}
+
+TEST(InputReplayIsDeterministic)
+{
+    InputDispatcher     &dispatcher = InputDispatcher::GetInstance();
+    InputRecorder       recorder;
+    std::vector<u32>    keys = MakeScript(16);
+    std::mt19937        random(5);
+
+    // Recorded with a frame time varying between 15 and 45 ms
+    recorder.Start();
+    dispatcher.SetRecorder(&recorder);
+    Simulate(keys, [&random](u32) { return (FrameTicks * (90 + random() % 180) / 100); });
+    dispatcher.SetRecorder(nullptr);
+
+    CHECK(recorder.Save("replay.bin"));
+
+    InputReplay     first;
+    InputReplay     second;
+
+    CHECK(first.Load("replay.bin"));
+    CHECK(second.Load("replay.bin"));
+    CHECK(first.FrameCount() == recorder.FrameCount());
+
+    dispatcher.SetSource(&first);
+
+    std::vector<u8>     a = Simulate(keys, [](u32) { return (FrameTicks); });
+
+    dispatcher.SetSource(&second);
+
+    std::vector<u8>     b = Simulate(keys, [&random](u32) { return (FrameTicks * (1 + random() % 3)); });
+
+    dispatcher.SetSource(nullptr);
+    std::remove("replay.bin");
+
+    CHECK(a == b);
+    CHECK(Count(a, 1) > 0);
+
+    // About 2 bytes per change of the keys
+    std::vector<u8>     data;
+    u32                 changes = 0;
+
+    for (u32 i = 1; i < keys.size(); ++i)
+        changes += keys[i] != keys[i - 1];
+    recorder.Serialize(data);
+    CHECK(data.size() < 12 + changes * 4);
+}
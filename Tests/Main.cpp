@@ -0,0 +1,66 @@
+#include "Test.hpp"
+#include <cstring>
+#include <vector>
+
+namespace Tests
+{
+    namespace
+    {
+        struct TestCase
+        {
+            const char  *name;
+            TestFunc    func;
+            bool        benchmark;
+        };
+
+        std::vector<TestCase>   &Registry(void)
+        {
+            static std::vector<TestCase>    tests;
+
+            return (tests);
+        }
+
+        u32     g_failures = 0;
+    }
+
+    Registrar::Registrar(const char *name, TestFunc func, bool benchmark)
+    {
+        Registry().push_back({ name, func, benchmark });
+    }
+
+    void    Fail(const char *file, int line, const char *expression)
+    {
+        std::printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+        ++g_failures;
+    }
+}
+
+// Usage: tests [bench] [name filter]
+int     main(int argc, char **argv)
+{
+    bool        benchmark = argc > 1 && std::strcmp(argv[1], "bench") == 0;
+    const char  *filter = argc > 1 + benchmark ? argv[1 + benchmark] : nullptr;
+    u32         failed = 0;
+    u32         run = 0;
+
+    for (const Tests::TestCase &test : Tests::Registry())
+    {
+        if (test.benchmark != benchmark || (filter != nullptr && std::strstr(test.name, filter) == nullptr))
+            continue;
+
+        u32     before = Tests::g_failures;
+
+        std::printf("%s\n", test.name);
+        std::fflush(stdout);
+        test.func();
+        Fake::UnmapAll();
+        Fake::UseRealTicks();
+        Fake::SetKeys(0);
+
+        failed += Tests::g_failures != before;
+        ++run;
+    }
+
+    std::printf("%u run, %u failed\n", run, failed);
+    return (failed != 0);
+}
@@ -0,0 +1,294 @@
+#include "Test.hpp"
+#include "GameMemory.hpp"
+#include "Helpers/MemorySearch.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   Base = 0x08000000;
+
+    // The plain loop MemorySearch must agree with
+    class Reference
+    {
+    public:
+        Reference(const std::vector<u8> &memory, SearchType type) :
+            _memory(memory), _type(type), _width(type == SearchType::U8 ? 1 : type == SearchType::U16 ? 2 : 4),
+            _alive(memory.size() / _width, false), _previous(memory) {}
+
+        template <typename Test>
+        void    First(Test test)
+        {
+            for (u32 i = 0; i < _alive.size(); ++i)
+                _alive[i] = test(Value(_memory, i));
+            _previous = _memory;
+        }
+
+        template <typename Test>
+        void    Next(Test test)
+        {
+            for (u32 i = 0; i < _alive.size(); ++i)
+                _alive[i] = _alive[i] && test(Value(_memory, i), Value(_previous, i));
+            _previous = _memory;
+        }
+
+        void    Filter(SearchFilter filter)
+        {
+            bool    isFloat = _type == SearchType::Float;
+
+            Next([filter, isFloat](u32 current, u32 previous)
+            {
+                float   a;
+                float   b;
+
+                std::memcpy(&a, &current, 4);
+                std::memcpy(&b, &previous, 4);
+                switch (filter)
+                {
+                case SearchFilter::Changed: return (current != previous);
+                case SearchFilter::Unchanged: return (current == previous);
+                case SearchFilter::Increased: return (isFloat ? a > b : current > previous);
+                default: return (isFloat ? a < b : current < previous);
+                }
+            });
+        }
+
+        // Compare with every result of the search, values included
+        bool    Matches(const MemorySearch &search) const
+        {
+            std::vector<SearchHit>  hits;
+            u32                     count = 0;
+
+            for (bool alive : _alive)
+                count += alive;
+            if (search.ResultCount() != count || search.GetResults(0, count, hits) != count)
+                return (false);
+
+            u32     hit = 0;
+
+            for (u32 i = 0; i < _alive.size(); ++i)
+            {
+                if (!_alive[i])
+                    continue;
+                if (hits[hit].address != Base + i * _width || hits[hit].value != Value(_memory, i))
+                    return (false);
+                ++hit;
+            }
+
+            return (true);
+        }
+
+    private:
+        u32     Value(const std::vector<u8> &memory, u32 index) const
+        {
+            u32     value = 0;
+
+            std::memcpy(&value, memory.data() + index * _width, _width);
+            return (value);
+        }
+
+        const std::vector<u8>   &_memory;
+        SearchType              _type;
+        u32                     _width;
+        std::vector<bool>       _alive;
+        std::vector<u8>         _previous;
+    };
+
+    bool    InFloatRange(u32 bits, float min, float max)
+    {
+        float   value;
+
+        std::memcpy(&value, &bits, 4);
+        return (value >= min && value <= max);
+    }
+
+    const SearchType    Types[] = { SearchType::U8, SearchType::U16, SearchType::U32, SearchType::Float };
+    const SearchFilter  Filters[] = { SearchFilter::Unchanged, SearchFilter::Changed, SearchFilter::Increased,
+                                      SearchFilter::Decreased, SearchFilter::Unchanged };
+}
+
+TEST(MemorySearchUnknownScanMatchesReference)
+{
+    std::vector<u8>     memory(0x100000);
+
+    Tests::FillGameMemory(memory.data(), memory.size(), 1);
+    for (SearchType type : Types)
+    {
+        MemorySearch    search;
+        Reference       reference(memory, type);
+        u32             seed = 10;
+
+        search.AddRegion(Base, memory.data(), memory.size());
+        search.UnknownScan(type);
+        reference.First([](u32) { return (true); });
+        CHECK(reference.Matches(search));
+
+        for (SearchFilter filter : Filters)
+        {
+            Tests::MutateWords(memory.data(), memory.size(), 20000, seed++);
+            search.Filter(filter);
+            reference.Filter(filter);
+            CHECK(reference.Matches(search));
+        }
+    }
+}
+
+TEST(MemorySearchExactAndRangeMatchReference)
+{
+    std::vector<u8>     memory(0x80000);
+
+    Tests::FillGameMemory(memory.data(), memory.size(), 2);
+    for (SearchType type : Types)
+    {
+        MemorySearch    search;
+        Reference       reference(memory, type);
+        u32             mask = type == SearchType::U8 ? 0xFF : type == SearchType::U16 ? 0xFFFF : 0xFFFFFFFF;
+
+        search.AddRegion(Base, memory.data(), memory.size());
+        if (type == SearchType::Float)
+        {
+            search.RangeScan(type, SearchValue(10.f), SearchValue(50.f));
+            reference.First([](u32 value) { return (InFloatRange(value, 10.f, 50.f)); });
+        }
+        else
+        {
+            search.RangeScan(type, 5, 60);
+            reference.First([](u32 value) { return (value >= 5 && value <= 60); });
+        }
+        CHECK(reference.Matches(search));
+
+        Tests::MutateWords(memory.data(), memory.size(), 30000, 3);
+        search.Filter(SearchFilter::Changed);
+        reference.Filter(SearchFilter::Changed);
+        CHECK(reference.Matches(search));
+
+        // A new first scan, exact this time
+        Reference   exact(memory, type);
+        u32         value = type == SearchType::Float ? SearchValue(1.f) : 0x2A & mask;
+
+        search.ExactScan(type, value);
+        exact.First([value](u32 current) { return (current == value); });
+        CHECK(exact.Matches(search));
+        CHECK(search.ResultCount() != 0);
+
+        Tests::MutateWords(memory.data(), memory.size(), 30000, 4);
+        search.FilterExact(value);
+        exact.Next([value](u32 current, u32) { return (current == value); });
+        CHECK(exact.Matches(search));
+
+        if (type != SearchType::Float)
+        {
+            search.FilterRange(0x29 & mask, 0x2B & mask);
+            exact.Next([mask](u32 current, u32) { return (current >= (0x29 & mask) && current <= (0x2B & mask)); });
+            CHECK(exact.Matches(search));
+        }
+    }
+}
+
+TEST(MemorySearchSwapFileMatchesReference)
+{
+    std::vector<u8>     memory(0x200000);
+    MemorySearch        search;
+    Reference           reference(memory, SearchType::U32);
+    u32                 seed = 20;
+
+    Tests::FillGameMemory(memory.data(), memory.size(), 8);
+    CHECK(search.SetSwapFile("MemorySearch.swap"));
+    search.AddRegion(Base, memory.data(), memory.size());
+    search.UnknownScan(SearchType::U32);
+    reference.First([](u32) { return (true); });
+    CHECK(reference.Matches(search));
+    CHECK(search.FileUsage() > MemorySnapshot::BlockSize);
+
+    for (SearchFilter filter : Filters)
+    {
+        Tests::MutateWords(memory.data(), memory.size(), 20000, seed++);
+        search.Filter(filter);
+        reference.Filter(filter);
+        CHECK(reference.Matches(search));
+    }
+
+    CHECK(search.SetSwapFile(""));
+    CHECK(search.ResultCount() == 0 && search.FileUsage() == 0);
+    std::remove("MemorySearch.swap.0");
+    std::remove("MemorySearch.swap.1");
+}
+
+TEST(MemorySearchSeveralRegions)
+{
+    std::vector<u8>     first(0x30000, 0);
+    std::vector<u8>     second(0x8004, 0);
+    MemorySearch        search;
+    std::vector<SearchHit>  hits;
+    u32                 value = 1234;
+
+    std::memcpy(first.data() + 0x2FFFC, &value, 4);
+    std::memcpy(second.data() + 0x8000, &value, 4);
+    search.AddRegion(0x00100000, first.data(), first.size());
+    search.AddRegion(0x14000000, second.data(), second.size());
+
+    CHECK(search.ExactScan(SearchType::U32, value) == 2);
+    CHECK(search.GetResults(0, 10, hits) == 2);
+    CHECK(hits[0].address == 0x0012FFFC && hits[1].address == 0x14008000);
+
+    // The results are appended
+    CHECK(search.GetResults(1, 10, hits) == 1 && hits.size() == 3 && hits[2].address == 0x14008000);
+
+    search.Reset();
+    CHECK(search.ResultCount() == 0);
+}
+
+// Scan speed and result memory on 64 MB of synthetic game memory
+BENCH(MemorySearchThroughput)
+{
+    const u32           size = 64 << 20;
+    const double        megabytes = size / 1048576.0;
+    std::vector<u8>     memory(size);
+
+    Tests::FillGameMemory(memory.data(), size, 5);
+
+    auto    report = [megabytes](const char *name, const MemorySearch &search, double seconds)
+    {
+        std::printf("    %-22s %10u results %8.2f MB %8.2f MB in files %8.0f MB/s\n", name, search.ResultCount(),
+                    search.MemoryUsage() / 1048576.0, search.FileUsage() / 1048576.0, megabytes / seconds);
+    };
+
+    // The last pass keeps the previous values in swap files
+    for (u32 pass = 0; pass < 3; ++pass)
+    {
+        SearchType          type = pass == 0 ? SearchType::U8 : SearchType::U32;
+        MemorySearch        search;
+
+        if (pass == 2)
+            search.SetSwapFile("MemorySearch.swap");
+
+        Tests::Stopwatch    watch;
+
+        std::printf("    %s%s\n", type == SearchType::U8 ? "u8" : "u32", pass == 2 ? ", swap files" : "");
+        search.AddRegion(Base, memory.data(), size);
+        search.ExactScan(type, 42);
+        report("exact", search, watch.Seconds());
+
+        watch = Tests::Stopwatch();
+        search.RangeScan(type, 10, 20);
+        report("range", search, watch.Seconds());
+
+        watch = Tests::Stopwatch();
+        search.UnknownScan(type);
+        report("unknown", search, watch.Seconds());
+
+        for (u32 i = 0; i < 3; ++i)
+        {
+            Tests::MutateWords(memory.data(), size, 5000, 6 + i);
+            watch = Tests::Stopwatch();
+            search.Filter(i == 1 ? SearchFilter::Changed : SearchFilter::Unchanged);
+            report(i == 1 ? "changed" : "unchanged", search, watch.Seconds());
+        }
+        search.SetSwapFile("");
+    }
+    std::remove("MemorySearch.swap.0");
+    std::remove("MemorySearch.swap.1");
+}
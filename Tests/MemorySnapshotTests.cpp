@@ -0,0 +1,123 @@
+#include "Test.hpp"
+#include "GameMemory.hpp"
+#include "Helpers/MemorySnapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   PageSize = MemorySnapshot::PageSize;
+
+    bool    SamePage(const MemorySnapshot &snapshot, u32 page, const u8 *expected)
+    {
+        u8      out[PageSize];
+
+        return (snapshot.Read(page, out) == PageSize && std::memcmp(out, expected, PageSize) == 0);
+    }
+}
+
+TEST(MemorySnapshotKeepsThePagesInAFile)
+{
+    const u32       size = 0x200000;
+    std::vector<u8> memory(size);
+    MemorySnapshot  inMemory;
+    MemorySnapshot  onFile;
+    MemorySnapshot  copy;
+    std::mt19937    rng(1);
+
+    Tests::FillGameMemory(memory.data(), size, 7);
+    CHECK(onFile.SetFile("MemorySnapshot.0"));
+    CHECK(copy.SetFile("MemorySnapshot.1"));
+
+    for (u32 offset = 0; offset < size; offset += PageSize)
+    {
+        CHECK(inMemory.Add(memory.data() + offset, PageSize) == offset / PageSize);
+        CHECK(onFile.Add(memory.data() + offset, PageSize) == offset / PageSize);
+    }
+
+    // Only the last block and the read cache stay in memory
+    CHECK(onFile.LogicalSize() == size);
+    CHECK(onFile.FileUsage() > MemorySnapshot::BlockSize);
+    CHECK(onFile.MemoryUsage() < inMemory.MemoryUsage() / 2);
+
+    for (u32 page = 0; page < size / PageSize; ++page)
+        CHECK(SamePage(onFile, page, memory.data() + page * PageSize));
+    for (u32 i = 0; i < 200; ++i)
+    {
+        u32     page = rng() % (size / PageSize);
+
+        CHECK(SamePage(onFile, page, memory.data() + page * PageSize));
+    }
+
+    // Copied from a file to another, then swapped like MemorySearch does
+    for (u32 page = 0; page < size / PageSize; ++page)
+        copy.Copy(onFile, page);
+    copy.Swap(onFile);
+    copy.Clear();
+    CHECK(copy.LogicalSize() == 0 && copy.FileUsage() == 0);
+    for (u32 page = 0; page < size / PageSize; ++page)
+        CHECK(SamePage(onFile, page, memory.data() + page * PageSize));
+
+    // The file is written again from the start after a Clear
+    copy.Add(memory.data() + 0x10000, PageSize);
+    CHECK(SamePage(copy, 0, memory.data() + 0x10000));
+
+    CHECK(onFile.SetFile(""));
+    CHECK(copy.SetFile(""));
+    std::remove("MemorySnapshot.0");
+    std::remove("MemorySnapshot.1");
+}
+
+// Compression of each kind of page of 64 MB of synthetic game memory, in memory and with a file
+BENCH(MemorySnapshotCompression)
+{
+    const u32           size = 64 << 20;
+    const u32           pages = size / PageSize;
+    const char          *names[] = { "zero", "0xFF", "structures", "floats", "random" };
+    std::vector<u8>     memory(size);
+    std::vector<u8>     kinds(pages);
+    std::vector<u8>     out(PageSize);
+
+    Tests::FillGameMemory(memory.data(), size, 5, 0x08000000, 0x400000, kinds.data());
+
+    for (u32 kind = 0; kind < Tests::PageKinds; ++kind)
+    {
+        MemorySnapshot  snapshot;
+        u32             empty = snapshot.MemoryUsage();
+
+        for (u32 page = 0; page < pages; ++page)
+            if (kinds[page] == kind)
+                snapshot.Add(memory.data() + page * PageSize, PageSize);
+
+        std::printf("    %-10s %6.2f MB -> %6.2f MB (%5.1f%%)\n", names[kind], snapshot.LogicalSize() / 1048576.0,
+                    (snapshot.MemoryUsage() - empty) / 1048576.0,
+                    (snapshot.MemoryUsage() - empty) * 100.0 / snapshot.LogicalSize());
+    }
+
+    for (bool file : { false, true })
+    {
+        MemorySnapshot      snapshot;
+        Tests::Stopwatch    add;
+
+        if (file)
+            snapshot.SetFile("MemorySnapshot.0");
+        for (u32 page = 0; page < pages; ++page)
+            snapshot.Add(memory.data() + page * PageSize, PageSize);
+
+        double              added = add.Seconds();
+        Tests::Stopwatch    read;
+
+        for (u32 page = 0; page < pages; ++page)
+            snapshot.Read(page, out.data());
+
+        std::printf("    %-10s 64 MB -> %6.2f MB in memory, %6.2f MB in the file: add %5.0f MB/s, read %5.0f MB/s\n",
+                    file ? "file" : "memory", snapshot.MemoryUsage() / 1048576.0, snapshot.FileUsage() / 1048576.0,
+                    64 / added, 64 / read.Seconds());
+        snapshot.SetFile("");
+    }
+    std::remove("MemorySnapshot.0");
+}
@@ -0,0 +1,180 @@
+#include "Test.hpp"
+#include "Helpers/MenuSearch.hpp"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    // Cheat-like names: "Infinite Health P2", "Speed x4 (Hold R)"...
+    std::vector<std::string>    Names(u32 count, u32 seed)
+    {
+        static const char   *words[] =
+        {
+            "Infinite", "Health", "Speed", "Jump", "Moon", "Gravity", "Money", "Max", "Items", "Ammo",
+            "Walk", "Through", "Walls", "Teleport", "Save", "Slot", "Unlock", "All", "Costumes", "Timer",
+            "Freeze", "Enemies", "One", "Hit", "Kill", "Rapid", "Fire", "Camera", "Zoom", "Hold"
+        };
+        std::mt19937                rng(seed);
+        std::vector<std::string>    names;
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            std::string     name;
+            u32             length = 2 + rng() % 3;
+
+            for (u32 j = 0; j < length; ++j)
+            {
+                if (j)
+                    name += ' ';
+                name += words[rng() % (sizeof(words) / sizeof(*words))];
+            }
+
+            switch (rng() % 4)
+            {
+            case 0: name += " P" + std::to_string(1 + rng() % 4); break;
+            case 1: name += " x" + std::to_string(2 << rng() % 3) + " (Hold R)"; break;
+            default: break;
+            }
+            names.push_back(name);
+        }
+        return (names);
+    }
+
+    std::string     Lower(std::string str)
+    {
+        for (char &c : str)
+            if (c >= 'A' && c <= 'Z')
+                c += 'a' - 'A';
+        return (str);
+    }
+
+    // What the search promises, one name at a time
+    std::vector<u32>    Scan(const std::vector<std::string> &names, const std::string &query)
+    {
+        std::vector<std::string>    words;
+        std::string                 lower = Lower(query);
+
+        for (u32 i = 0, start = 0; i <= lower.size(); ++i)
+        {
+            if (i == lower.size() || lower[i] == ' ')
+            {
+                if (i > start)
+                    words.push_back(lower.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+
+        std::vector<u32>    results;
+
+        for (u32 item = 0; item < names.size(); ++item)
+        {
+            std::string     name = Lower(names[item]);
+            bool            match = true;
+
+            for (const std::string &word : words)
+                match = match && name.find(word) != std::string::npos;
+            if (match)
+                results.push_back(item);
+        }
+        return (results);
+    }
+
+    void    Fill(MenuSearch &search, const std::vector<std::string> &names)
+    {
+        search.Clear();
+        for (u32 i = 0; i < names.size(); ++i)
+            search.Add(names[i], i * 3);
+        search.Build();
+    }
+}
+
+TEST(MenuSearchMatchesTheScan)
+{
+    std::vector<std::string>    names = Names(2000, 1);
+    std::mt19937                rng(2);
+    MenuSearch                  search;
+
+    Fill(search, names);
+    CHECK(search.Count() == names.size());
+    CHECK(search.Value(10) == 30);
+
+    for (u32 round = 0; round < 200; ++round)
+    {
+        // A part of a name, with a typo now and then, typed one key at a time then erased
+        const std::string   &name = names[rng() % names.size()];
+        u32                 start = rng() % name.size();
+        std::string         query = name.substr(start, 1 + rng() % 12);
+
+        if (rng() % 5 == 0)
+            query[rng() % query.size()] = 'q';
+        if (rng() % 3 == 0)
+            query = "  " + query + " ";
+
+        for (u32 length = 0; length <= query.size(); ++length)
+            CHECK(search.Search(query.substr(0, length)) == Scan(names, query.substr(0, length)));
+        for (u32 length = query.size(); length-- > 0;)
+            CHECK(search.Search(query.substr(0, length)) == Scan(names, query.substr(0, length)));
+    }
+
+    CHECK(search.Search("SPEED x4") == Scan(names, "speed x4"));
+    CHECK(search.Search("e") == Scan(names, "e"));
+    CHECK(search.Search("zzz").empty());
+}
+
+// The size of a large cheat list, see QuickMenu
+BENCH(MenuSearchKeystrokes)
+{
+    std::vector<std::string>    names = Names(5000, 3);
+    MenuSearch                  search;
+    Tests::Stopwatch            build;
+
+    Fill(search, names);
+
+    double  built = build.Seconds();
+    double  total = 0.0;
+    double  worst = 0.0;
+    double  scan = 0.0;
+    u32     keys = 0;
+    u32     found = 0;
+    const char  *queries[] = { "infinite health", "speed x4", "moon jump", "walk through walls", "max money p2" };
+
+    for (const char *query : queries)
+    {
+        std::string     typed(query);
+
+        for (u32 length = 1; length <= typed.size(); ++length, ++keys)
+        {
+            Tests::Stopwatch    key;
+
+            found += search.Search(typed.substr(0, length)).size();
+
+            double  seconds = key.Seconds();
+
+            total += seconds;
+            worst = std::max(worst, seconds);
+        }
+
+        Tests::Stopwatch    naive;
+
+        Tests::KeepAlive(Scan(names, typed).size());
+        scan += naive.Seconds();
+    }
+
+    search.Search("speed");
+
+    Tests::Stopwatch    fresh;
+
+    found += search.Search("a").size();
+
+    double  letter = fresh.Seconds();
+
+    Tests::KeepAlive(found);
+    std::printf("  %u names: build %.2f ms\n", static_cast<u32>(names.size()), built * 1000.0);
+    std::printf("  keystroke: %.1f us average, %.1f us worst over %u keys\n", total / keys * 1e6, worst * 1e6, keys);
+    std::printf("  fresh one letter query: %.1f us, naive scan: %.1f us per query\n", letter * 1e6,
+                scan / (sizeof(queries) / sizeof(*queries)) * 1e6);
+}
@@ -0,0 +1,138 @@
+#include "Test.hpp"
+#include "Helpers/OSDManager.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    std::string     ItemName(u32 index)
+    {
+        return ("item" + std::to_string(index));
+    }
+
+    bool    AnyPixelSet(Fake::Framebuffer &framebuffer, u32 posX, u32 posY, u32 width, u32 height)
+    {
+        for (u32 x = posX; x < posX + width; ++x)
+            for (u32 y = posY; y < posY + height; ++y)
+                if (*framebuffer.Pixel(x, y) != 0)
+                    return (true);
+        return (false);
+    }
+}
+
+TEST(OSDManagerDrawsPublishedItems)
+{
+    Fake::Framebuffer   top(true);
+
+    OSDManager["first"] = std::make_tuple(true, std::string("first"), 10u, 20u, true);
+    OSDManager["second"] = std::make_tuple(false, std::string("second"), 10u, 40u, true);
+
+    Fake::RunOSD(top.GetScreen());
+    CHECK(AnyPixelSet(top, 10, 20, 30, 10));
+    CHECK(!AnyPixelSet(top, 10, 40, 36, 10));
+
+    // A disabled item isn't drawn anymore and its area is reported dirty
+    OSDManager["first"].Disable();
+    top.Fill(0);
+    Fake::RunOSD(top.GetScreen());
+    CHECK(!AnyPixelSet(top, 10, 20, 30, 10));
+    CHECK(OSDManager.GetDirtyRects(true).size() == 1);
+
+    OSDManager.Remove("first");
+    OSDManager.Remove("second");
+}
+
+TEST(OSDManagerIgnoresRemovedHandles)
+{
+    Fake::Framebuffer   top(true);
+    OSDMI               item = OSDManager["removed"];
+
+    OSDManager.Remove("removed");
+    item = std::make_tuple(true, std::string("ghost"), 0u, 0u, true);
+
+    Fake::RunOSD(top.GetScreen());
+    CHECK(!AnyPixelSet(top, 0, 0, 30, 10));
+}
+
+TEST(OSDManagerGrowsPastTheInitialItems)
+{
+    Fake::Framebuffer   top(true);
+    const u32           count = _OSDManager::InitialItems * 2 + 10;
+
+    for (u32 i = 0; i < count; ++i)
+        OSDManager["grow" + ItemName(i)] = std::make_tuple(false, std::string("x"), 0u, 0u, true);
+
+    // The last item and a first one both work after the storage grew
+    OSDManager["grow" + ItemName(count - 1)] = std::make_tuple(true, std::string("last"), 10u, 100u, true);
+    OSDManager["grow" + ItemName(3)] = std::make_tuple(true, std::string("third"), 10u, 150u, true);
+    Fake::RunOSD(top.GetScreen());
+    CHECK(AnyPixelSet(top, 10, 100, 30, 10));
+    CHECK(AnyPixelSet(top, 10, 150, 30, 10));
+
+    for (u32 i = 0; i < count; ++i)
+        OSDManager.Remove("grow" + ItemName(i));
+    top.Fill(0);
+    Fake::RunOSD(top.GetScreen());
+    CHECK(!AnyPixelSet(top, 10, 100, 30, 10));
+}
+
+// The callback time with N items while M threads keep changing them
+BENCH(OSDManagerWriterContention)
+{
+    const u32   itemCounts[] = { 8, 32, 64 };
+    const u32   writerCounts[] = { 0, 1, 2, 4 };
+    const u32   frames = 2000;
+
+    Fake::Framebuffer   top(true);
+
+    std::printf("    %6s %8s %14s %16s\n", "items", "writers", "callback us", "writes/s");
+    for (u32 items : itemCounts)
+    {
+        for (u32 i = 0; i < items; ++i)
+            OSDManager[ItemName(i)] = std::make_tuple(true, ItemName(i), 10 + (i % 4) * 90, (i / 4) * 12 % 230, true);
+
+        for (u32 writers : writerCounts)
+        {
+            std::atomic<bool>           running(true);
+            std::atomic<u32>            writes(0);
+            std::vector<std::thread>    threads;
+
+            for (u32 w = 0; w < writers; ++w)
+            {
+                threads.emplace_back([&, w]()
+                {
+                    u32     count = 0;
+
+                    while (running.load(std::memory_order_relaxed))
+                    {
+                        u32     index = (count * writers + w) % items;
+
+                        OSDManager[ItemName(index)] = ItemName(index) + ":" + std::to_string(count % 1000);
+                        ++count;
+                    }
+
+                    writes += count;
+                });
+            }
+
+            Tests::Stopwatch    watch;
+
+            for (u32 frame = 0; frame < frames; ++frame)
+                Fake::RunOSD(top.GetScreen());
+
+            double  seconds = watch.Seconds();
+
+            running = false;
+            for (std::thread &thread : threads)
+                thread.join();
+
+            std::printf("    %6u %8u %14.2f %16.0f\n", items, writers, seconds * 1e6 / frames, writes / seconds);
+        }
+
+        for (u32 i = 0; i < items; ++i)
+            OSDManager.Remove(ItemName(i));
+    }
+}
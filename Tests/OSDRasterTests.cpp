@@ -0,0 +1,194 @@
+#include "Test.hpp"
+#include "Helpers/OSDManager.hpp"
+#include "Helpers/OSDRaster.hpp"
+#include <cstring>
+#include <random>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const GSPGPU_FramebufferFormat  Formats[] =
+    {
+        GSP_RGBA8_OES, GSP_BGR8_OES, GSP_RGB565_OES, GSP_RGB5_A1_OES, GSP_RGBA4_OES
+    };
+
+    RasterSurface   SurfaceOf(Fake::Framebuffer &framebuffer)
+    {
+        const Screen    &screen = framebuffer.GetScreen();
+        u8              *origin = framebuffer.Pixel(0, 0);
+
+        return (RasterSurface{ origin, static_cast<s32>(framebuffer.Pixel(1, 0) - origin),
+                               static_cast<s32>(framebuffer.Pixel(0, 1) - origin), framebuffer.Width(),
+                               framebuffer.Height(), screen.BytesPerPixel, static_cast<u32>(screen.Format) });
+    }
+
+    bool    SameBox(Fake::Framebuffer &a, Fake::Framebuffer &b, u32 posX, u32 posY, u32 width, u32 height)
+    {
+        u32     bpp = a.GetScreen().BytesPerPixel;
+
+        for (u32 x = posX; x < posX + width && x < a.Width(); ++x)
+            for (u32 y = posY; y < posY + height && y < a.Height(); ++y)
+                if (std::memcmp(a.Pixel(x, y), b.Pixel(x, y), bpp) != 0)
+                    return (false);
+        return (true);
+    }
+
+    bool    Contains(const DirtyRect &outer, const DirtyRect &inner)
+    {
+        return (inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width
+                && inner.y + inner.height <= outer.y + outer.height);
+    }
+
+    bool    Overlaps(const DirtyRect &a, const DirtyRect &b)
+    {
+        return (a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height);
+    }
+}
+
+// A captured text blitted on a blank framebuffer gives back what Screen::Draw drew
+TEST(TextBitmapBlitMatchesDraw)
+{
+    for (GSPGPU_FramebufferFormat format : Formats)
+    {
+        Fake::Framebuffer   drawn(true, format);
+        Fake::Framebuffer   blitted(true, format);
+        RasterSurface       surface = SurfaceOf(drawn);
+        u8                  foreground[4];
+        u8                  background[4];
+        TextBitmap          bitmap;
+        std::string         text = "Coins: 9999";
+        u32                 width = text.size() * Screen::FontWidth;
+
+        EncodePixel(format, 255, 255, 255, 255, foreground);
+        EncodePixel(format, 0, 0, 0, 255, background);
+
+        drawn.GetScreen().Draw(text, 37, 101);
+        CHECK(bitmap.Capture(surface, 37, 101, width, Screen::FontHeight, foreground, background));
+        CHECK(bitmap.Width() == width && bitmap.Height() == Screen::FontHeight);
+        CHECK(bitmap.Format() == static_cast<u32>(format));
+
+        bitmap.Blit(SurfaceOf(blitted), 37, 101);
+        CHECK(SameBox(drawn, blitted, 0, 0, drawn.Width(), drawn.Height()));
+
+        // Somewhere else, the same as drawing there
+        drawn.Fill(0);
+        blitted.Fill(0);
+        drawn.GetScreen().Draw(text, 200, 3);
+        bitmap.Blit(SurfaceOf(blitted), 200, 3);
+        CHECK(SameBox(drawn, blitted, 0, 0, drawn.Width(), drawn.Height()));
+    }
+}
+
+TEST(TextBitmapClipsToTheSurface)
+{
+    Fake::Framebuffer   framebuffer(false);
+    RasterSurface       surface = SurfaceOf(framebuffer);
+    u8                  foreground[4];
+    u8                  background[4];
+    TextBitmap          bitmap;
+
+    EncodePixel(surface.format, 255, 255, 255, 255, foreground);
+    EncodePixel(surface.format, 0, 0, 0, 255, background);
+
+    framebuffer.GetScreen().Draw("clipped", 300, 235);
+    CHECK(bitmap.Capture(surface, 300, 235, 42, Screen::FontHeight, foreground, background));
+    CHECK(bitmap.Width() == 20 && bitmap.Height() == 5);
+    CHECK(!bitmap.Capture(surface, 320, 0, 10, 10, foreground, background));
+    CHECK(bitmap.IsEmpty());
+
+    // A bitmap of another format isn't blitted
+    Fake::Framebuffer   other(false, GSP_RGBA8_OES);
+
+    framebuffer.GetScreen().Draw("text", 0, 0);
+    CHECK(bitmap.Capture(surface, 0, 0, 24, Screen::FontHeight, foreground, background));
+    bitmap.Blit(SurfaceOf(other), 0, 0);
+    for (u8 byte : other.left)
+        CHECK(byte == 0);
+}
+
+TEST(DirtyRegionMergesTouchingRects)
+{
+    DirtyRegion     region;
+
+    region.Add(DirtyRect{ 0, 0, 10, 10 });
+    region.Add(DirtyRect{ 50, 50, 10, 10 });
+    CHECK(region.Rects().size() == 2);
+
+    // Empty rects are ignored
+    region.Add(DirtyRect{ 20, 20, 0, 5 });
+    CHECK(region.Rects().size() == 2);
+
+    // Bridging both merges everything in one pass
+    region.Add(DirtyRect{ 5, 5, 50, 50 });
+    CHECK(region.Rects().size() == 1);
+    CHECK(region.Rects()[0].x == 0 && region.Rects()[0].y == 0);
+    CHECK(region.Rects()[0].width == 60 && region.Rects()[0].height == 60);
+
+    region.Clear();
+    CHECK(region.IsEmpty());
+}
+
+// Whatever the order, every rect added is covered and the merged rects don't touch
+TEST(DirtyRegionCoversRandomRects)
+{
+    std::mt19937    random(7);
+
+    for (u32 round = 0; round < 200; ++round)
+    {
+        DirtyRegion             region;
+        std::vector<DirtyRect>  added;
+
+        for (u32 i = 0; i < 12; ++i)
+        {
+            DirtyRect   rect = { static_cast<u32>(random() % 380), static_cast<u32>(random() % 220),
+                                 static_cast<u32>(1 + random() % 40), static_cast<u32>(1 + random() % 20) };
+
+            added.push_back(rect);
+            region.Add(rect);
+        }
+
+        const std::vector<DirtyRect>    &rects = region.Rects();
+
+        for (const DirtyRect &rect : added)
+        {
+            bool    covered = false;
+
+            for (const DirtyRect &merged : rects)
+                covered |= Contains(merged, rect);
+            CHECK(covered);
+        }
+
+        for (u32 i = 0; i < rects.size(); ++i)
+            for (u32 j = i + 1; j < rects.size(); ++j)
+                CHECK(!Overlaps(rects[i], rects[j]));
+    }
+}
+
+// The retained callback blits the cached bitmaps: same pixels as drawing every item again
+TEST(OSDManagerRetainedMatchesImmediate)
+{
+    Fake::Framebuffer   retained(true, GSP_BGR8_OES, true);
+    Fake::Framebuffer   immediate(true, GSP_BGR8_OES, true);
+
+    for (u32 i = 0; i < 6; ++i)
+        OSDManager["raster" + std::to_string(i)] = std::make_tuple(true, "Item #" + std::to_string(i * 37),
+                                                                    12 + i * 50, 10 + i * 30, true);
+
+    OSDManager.SetRetainedMode(false);
+    Fake::RunOSD(immediate.GetScreen());
+
+    OSDManager.SetRetainedMode(true);
+    Fake::RunOSD(retained.GetScreen());
+    CHECK(!OSDManager.GetDirtyRects(true).empty());
+
+    // Nothing changed: the second frame only blits
+    retained.Fill(0);
+    Fake::RunOSD(retained.GetScreen());
+    CHECK(OSDManager.GetDirtyRects(true).empty());
+    CHECK(retained.left == immediate.left);
+    CHECK(retained.right == immediate.right);
+
+    for (u32 i = 0; i < 6; ++i)
+        OSDManager.Remove("raster" + std::to_string(i));
+}
@@ -0,0 +1,301 @@
+#include "Test.hpp"
+#include "Helpers/PatchBatch.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   CodeBase = 0x00100000;
+    const u32   CodeSize = 0x10000;
+
+    // The entries need a game function to be toggled
+    void    Cheat(MenuEntry *)
+    {
+    }
+
+    struct Range
+    {
+        u32     address;
+        u32     size;
+    };
+
+    // A code area in a vector, recording the writes and the cache maintenance
+    class RecordingTarget : public PatchTarget
+    {
+    public:
+        RecordingTarget(void) : memory(CodeSize), writes(0), failAt(0)
+        {
+            for (u32 i = 0; i < CodeSize; ++i)
+                memory[i] = static_cast<u8>(i * 7 + 3);
+        }
+
+        bool    Read(u32 address, void *out, u32 size) override
+        {
+            if (!Contains(address, size))
+                return (false);
+
+            std::memcpy(out, &memory[address - CodeBase], size);
+            return (true);
+        }
+
+        bool    Write(u32 address, const void *data, u32 size) override
+        {
+            if (!Contains(address, size) || (failAt && address == failAt))
+                return (false);
+
+            std::memcpy(&memory[address - CodeBase], data, size);
+            ++writes;
+            return (true);
+        }
+
+        void    Flush(u32 address, u32 size) override
+        {
+            flushes.push_back({ address, size });
+        }
+
+        u32     Word(u32 address) const
+        {
+            u32     value;
+
+            std::memcpy(&value, &memory[address - CodeBase], 4);
+            return (value);
+        }
+
+        bool    Contains(u32 address, u32 size) const
+        {
+            return (address >= CodeBase && address - CodeBase + size <= CodeSize);
+        }
+
+        // If a flushed range covers [address, address + size)
+        bool    Flushed(u32 address, u32 size) const
+        {
+            for (const Range &range : flushes)
+                if (address >= range.address && address + size <= range.address + range.size)
+                    return (true);
+            return (false);
+        }
+
+        std::vector<u8>     memory;
+        std::vector<Range>  flushes;
+        u32                 writes;
+        u32                 failAt;     ///< Write fails at this address, 0 for none
+    };
+}
+
+TEST(PatchBatchWritesOnlyOnApply)
+{
+    RecordingTarget     target;
+    std::vector<u8>     before(target.memory);
+    PatchBatch          batch(target);
+
+    batch.Add(CodeBase + 0x100, 0xE1A00000).Add(CodeBase + 0x200, 0xE12FFF1E);
+
+    CHECK(batch.EditCount() == 2);
+    CHECK(!batch.IsApplied());
+    CHECK(target.memory == before);
+    CHECK(target.writes == 0);
+
+    CHECK(batch.Apply());
+    CHECK(batch.IsApplied());
+    CHECK(target.Word(CodeBase + 0x100) == 0xE1A00000);
+    CHECK(target.Word(CodeBase + 0x200) == 0xE12FFF1E);
+
+    // Staging is refused while applied, Apply again does nothing
+    batch.Add(CodeBase + 0x300, 0);
+    CHECK(batch.EditCount() == 2);
+    CHECK(batch.Apply());
+    CHECK(target.writes == 2);
+
+    batch.Revert();
+    CHECK(!batch.IsApplied());
+    CHECK(target.memory == before);
+}
+
+TEST(PatchBatchChecksEveryOriginalFirst)
+{
+    RecordingTarget     target;
+    std::vector<u8>     before(target.memory);
+    u32                 original = target.Word(CodeBase + 0x400);
+
+    {
+        PatchBatch  batch(target);
+
+        // The first edit is fine, the second expects the wrong bytes
+        batch.Add(CodeBase + 0x100, 0xE1A00000, target.Word(CodeBase + 0x100));
+        batch.Add(CodeBase + 0x400, 0xE1A00000, original + 1);
+
+        CHECK(!batch.Apply());
+        CHECK(target.writes == 0);
+        CHECK(target.flushes.empty());
+    }
+
+    {
+        PatchBatch  batch(target);
+
+        // Overlapping edits
+        batch.Add(CodeBase + 0x100, 0xE1A00000).Add(CodeBase + 0x102, 0xE1A00000);
+        CHECK(!batch.Apply());
+        CHECK(target.writes == 0);
+    }
+
+    {
+        PatchBatch  batch(target);
+
+        // Out of the target
+        batch.Add(CodeBase + 0x100, 0xE1A00000).Add(CodeBase + CodeSize, 0xE1A00000);
+        CHECK(!batch.Apply());
+        CHECK(target.writes == 0);
+    }
+
+    CHECK(target.memory == before);
+}
+
+TEST(PatchBatchUndoesAFailedWrite)
+{
+    RecordingTarget     target;
+    std::vector<u8>     before(target.memory);
+    PatchBatch          batch(target);
+
+    // Added out of order, applied by address: the failing write comes third
+    batch.Add(CodeBase + 0x300, 1).Add(CodeBase + 0x100, 2).Add(CodeBase + 0x200, 3).Add(CodeBase + 0x400, 4);
+    target.failAt = CodeBase + 0x300;
+
+    CHECK(!batch.Apply());
+    CHECK(!batch.IsApplied());
+    CHECK(target.memory == before);
+
+    // Only what was written and undone is flushed
+    CHECK(target.flushes.size() == 1 && target.Flushed(CodeBase + 0x100, 4) && target.Flushed(CodeBase + 0x200, 4));
+    CHECK(!target.Flushed(CodeBase + 0x300, 4) && !target.Flushed(CodeBase + 0x400, 4));
+    CHECK(batch.FlushCount() == 0);
+
+    target.failAt = 0;
+    CHECK(batch.Apply());
+    CHECK(target.Word(CodeBase + 0x100) == 2 && target.Word(CodeBase + 0x400) == 4);
+}
+
+TEST(PatchBatchCoalescesTheFlushes)
+{
+    RecordingTarget     target;
+    PatchBatch          batch(target);
+
+    // Three clusters: words a few bytes apart, a gap just inside CoalesceGap, then far away
+    for (u32 i = 0; i < 16; ++i)
+        batch.Add(CodeBase + 0x1000 + i * 8, i);
+    batch.Add(CodeBase + 0x1000 + 15 * 8 + 4 + PatchBatch::CoalesceGap, 0xAA);
+    batch.Add(CodeBase + 0x4000, 0xBB);
+    batch.Add(CodeBase + 0x4000 + 4 + PatchBatch::CoalesceGap + 4, 0xCC);
+    batch.Add(CodeBase + 0x8000, 0xDD);
+
+    CHECK(batch.Apply());
+    CHECK(batch.FlushCount() == 4);
+    CHECK(target.flushes.size() == 4);
+
+    // Every edit is in a flushed range
+    for (u32 i = 0; i < 16; ++i)
+        CHECK(target.Flushed(CodeBase + 0x1000 + i * 8, 4));
+    CHECK(target.Flushed(CodeBase + 0x1000 + 15 * 8 + 4 + PatchBatch::CoalesceGap, 4));
+    CHECK(target.Flushed(CodeBase + 0x4000, 4));
+    CHECK(target.Flushed(CodeBase + 0x8000, 4));
+
+    // Revert flushes the same ranges
+    target.flushes.clear();
+    batch.Revert();
+    CHECK(target.flushes.size() == 4);
+    CHECK(target.Flushed(CodeBase + 0x1000, 16 * 8));
+}
+
+TEST(PatchBatchRevertAllRestoresEveryBatch)
+{
+    RecordingTarget     target;
+    std::vector<u8>     before(target.memory);
+    PatchBatch          first(target);
+    PatchBatch          second(target);
+    PatchBatch          *third = new PatchBatch(target);
+
+    first.Add(CodeBase + 0x100, 1);
+    second.Add(CodeBase + 0x200, 2);
+    third->Add(CodeBase + 0x300, 3);
+
+    CHECK(first.Apply() && second.Apply() && third->Apply());
+
+    // The destructor reverts and unlinks
+    delete third;
+    CHECK(std::memcmp(&target.memory[0x300], &before[0x300], 4) == 0);
+
+    PatchBatch::RevertAll();
+    CHECK(!first.IsApplied() && !second.IsApplied());
+    CHECK(target.memory == before);
+
+    // Clear drops the edits, the batch can be staged again
+    first.Clear();
+    CHECK(first.EditCount() == 0);
+    CHECK(!first.Apply());
+    first.Add(CodeBase + 0x100, 5);
+    CHECK(first.Apply());
+    CHECK(target.Word(CodeBase + 0x100) == 5);
+    first.Clear();
+    CHECK(target.memory == before);
+}
+
+TEST(PatchBatchChecksTheGameMemory)
+{
+    u8      *code = Fake::Map(CodeBase, 0x1000, MEMPERM_READ | MEMPERM_EXECUTE, MEMSTATE_CODE);
+    u8      *heap = Fake::Map(0x08000000, 0x1000);
+
+    CHECK(code != nullptr && heap != nullptr);
+    if (code == nullptr || heap == nullptr)
+        return;
+
+    {
+        PatchBatch  batch;
+
+        // The code isn't writable
+        batch.Add(0x08000010, 1).Add(CodeBase + 0x10, 2);
+        CHECK(!batch.Apply());
+        CHECK(heap[0x10] == 0);
+    }
+
+    {
+        PatchBatch  batch;
+
+        // Nothing mapped there
+        batch.Add(0x08000010, 1).Add(0x08001000, 2);
+        CHECK(!batch.Apply());
+    }
+
+    {
+        PatchBatch  batch;
+        u32         value = 0x12345678;
+
+        batch.Add(0x08000010, &value, 4, heap + 0x10).Add(0x08000FFC, 0xE1A00000);
+        CHECK(batch.Apply());
+        CHECK(std::memcmp(heap + 0x10, &value, 4) == 0);
+
+        // TogglePatch reverts when the entry is disabled
+        MenuEntry   entry("Patch", Cheat);
+
+        entry.Enable();
+        TogglePatch(&entry, batch);
+        CHECK(batch.IsApplied());
+        entry.Disable();
+        TogglePatch(&entry, batch);
+        CHECK(!batch.IsApplied());
+        CHECK(heap[0x10] == 0);
+    }
+
+    {
+        PatchBatch  batch;
+        MenuEntry   entry("Patch", Cheat);
+
+        // The entry is disabled when the batch can't be applied
+        Fake::SetPermissions(0x08000000, MEMPERM_READ);
+        batch.Add(0x08000010, 1);
+        entry.Enable();
+        TogglePatch(&entry, batch);
+        CHECK(!entry.IsActivated());
+        CHECK(heap[0x10] == 0);
+    }
+}
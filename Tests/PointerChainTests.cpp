@@ -0,0 +1,124 @@
+#include "Test.hpp"
+#include "Helpers/PointerChain.hpp"
+#include <cstring>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   HeapBase = 0x10000000;
+    const u32   ReadOnlyBase = 0x10001000;
+
+    void    Set(u8 *memory, u32 offset, u32 value)
+    {
+        std::memcpy(memory + offset, &value, 4);
+    }
+
+    u32     Word(const u8 *memory, u32 offset)
+    {
+        u32     value;
+
+        std::memcpy(&value, memory + offset, 4);
+        return (value);
+    }
+}
+
+TEST(PointerChainFollowsThePointers)
+{
+    u8      *heap = Fake::Map(HeapBase, 0x1000);
+    u8      *readOnly = Fake::Map(ReadOnlyBase, 0x1000, MEMPERM_READ);
+
+    CHECK(heap != nullptr && readOnly != nullptr);
+    if (heap == nullptr || readOnly == nullptr)
+        return;
+
+    // *(*0x10000000 + 0x10) + 0x48
+    Set(heap, 0x000, HeapBase + 0x100);
+    Set(heap, 0x110, HeapBase + 0x200);
+    Set(heap, 0x248, 1234);
+
+    PointerChain<u32, HeapBase, 0x10, 0x48>    chain;
+
+    static_assert(PointerChain<u32, HeapBase, 0x10, 0x48>::Depth == 2, "One hop per offset");
+    CHECK(chain.Get() == 1234);
+    CHECK(chain.Pointer() == reinterpret_cast<u32 *>(static_cast<uintptr_t>(HeapBase + 0x248)));
+
+    // Followed once per frame, without querying the kernel
+    u32     queries = Fake::QueryCount();
+
+    for (u32 i = 0; i < 100; ++i)
+        CHECK(chain.Get() == 1234);
+    CHECK(Fake::QueryCount() == queries);
+    CHECK(chain.Modify([](u32 &value) { value += 1; }));
+    CHECK(Word(heap, 0x248) == 1235);
+
+    Set(heap, 0x110, HeapBase + 0x300);
+    Set(heap, 0x348, 77);
+    CHECK(chain.Get() == 1235);
+    FrameGeneration::NextFrame();
+    CHECK(chain.Get() == 77);
+    CHECK(chain.Write(78) && Word(heap, 0x348) == 78);
+
+    // A null pointer breaks the chain
+    Set(heap, 0x110, 0);
+    FrameGeneration::NextFrame();
+    CHECK(!chain.Write(5));
+    CHECK(chain.Get(9) == 9);
+    CHECK(chain.Pointer() == nullptr);
+
+    // Ending in read only memory
+    Set(heap, 0x110, ReadOnlyBase + 0x40 - 0x48);
+    Set(readOnly, 0x40, 55);
+    FrameGeneration::NextFrame();
+    CHECK(chain.Get() == 55);
+    CHECK(!chain.Write(1));
+    CHECK(!chain.Modify([](u32 &value) { value = 1; }));
+    CHECK(Word(readOnly, 0x40) == 55);
+
+    // Ending across the end of the mapped memory, or through an unaligned pointer
+    Set(heap, 0x110, ReadOnlyBase + 0xFFE - 0x48);
+    FrameGeneration::NextFrame();
+    CHECK(!chain.Resolve());
+    Set(heap, 0x110, HeapBase + 0x200);
+    Set(heap, 0x000, HeapBase + 0x101);
+    FrameGeneration::NextFrame();
+    CHECK(!chain.Resolve());
+
+    // Invalidate follows the chain again in the same frame
+    Set(heap, 0x000, HeapBase + 0x100);
+    CHECK(!chain.Resolve());
+    chain.Invalidate();
+    CHECK(chain.Get() == 1235);
+}
+
+TEST(PointerChainCachedForTheLayout)
+{
+    u8      *heap = Fake::Map(HeapBase, 0x1000);
+
+    CHECK(heap != nullptr);
+    if (heap == nullptr)
+        return;
+
+    Set(heap, 0x000, HeapBase + 0x100);
+    Set(heap, 0x110, HeapBase + 0x200);
+    Set(heap, 0x248, 10);
+    Set(heap, 0x348, 20);
+
+    PointerChain<u32, HeapBase, 0x10, 0x48>     chain(ChainCache::Layout);
+    PointerChain<u32, HeapBase + 0x248>         direct(ChainCache::Layout);
+
+    CHECK(chain.Get() == 10);
+    CHECK(direct.Write(11) && chain.Get() == 11);
+
+    // A pointer changed in place isn't noticed until the layout changes
+    Set(heap, 0x110, HeapBase + 0x300);
+    FrameGeneration::NextFrame();
+    CHECK(chain.Get() == 11);
+
+    Fake::SetPermissions(HeapBase, MEMPERM_READ);
+    CHECK(chain.Get() == 20);
+    CHECK(!chain.Write(21) && !direct.Write(12));
+
+    Fake::Unmap(HeapBase);
+    CHECK(chain.Get(7) == 7 && direct.Get(7) == 7);
+}
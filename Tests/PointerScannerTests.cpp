@@ -0,0 +1,262 @@
+#include "Test.hpp"
+#include "GameMemory.hpp"
+#include "Helpers/PointerScanner.hpp"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   StaticBase = 0x00300000;
+    const u32   HeapBase = 0x08000000;
+
+    struct Area
+    {
+        u32                 address;
+        std::vector<u8>     data;
+        bool                isStatic;
+
+        u32     Read(u32 at) const
+        {
+            u32     value;
+
+            std::memcpy(&value, data.data() + (at - address), 4);
+            return (value);
+        }
+
+        void    Write(u32 at, u32 value)
+        {
+            std::memcpy(data.data() + (at - address), &value, 4);
+        }
+
+        bool    Contains(u32 at) const
+        {
+            return (at >= address && at - address < data.size());
+        }
+    };
+
+    // A static area and a heap full of pointers into the heap
+    struct Heap
+    {
+        Heap(u32 heapSize, u32 staticSize, u32 seed)
+        {
+            heap = { HeapBase, std::vector<u8>(heapSize), false };
+            statics = { StaticBase, std::vector<u8>(staticSize), true };
+            Tests::FillGameMemory(heap.data.data(), heapSize, seed, HeapBase, heapSize);
+            Tests::FillGameMemory(statics.data.data(), staticSize, seed + 1, HeapBase, heapSize);
+        }
+
+        void    AddTo(PointerScanner &scanner)
+        {
+            scanner.AddRegion(heap.address, heap.data.data(), heap.data.size(), false);
+            scanner.AddRegion(statics.address, statics.data.data(), statics.data.size(), true);
+        }
+
+        Area    *AreaOf(u32 at)
+        {
+            return (heap.Contains(at) ? &heap : statics.Contains(at) ? &statics : nullptr);
+        }
+
+        Area    heap;
+        Area    statics;
+    };
+
+    // The amount of chains the scan must find, counted level by level with a plain sorted index
+    u32     CountChains(Heap &memory, u32 target, u32 maxDepth, u32 maxOffset)
+    {
+        std::vector<std::pair<u32, u32>>    index;      ///< value, location
+
+        for (Area *area : { &memory.heap, &memory.statics })
+            for (u32 offset = 0; offset < area->data.size(); offset += 4)
+            {
+                u32     value = area->Read(area->address + offset);
+
+                if (memory.AreaOf(value) != nullptr)
+                    index.emplace_back(value, area->address + offset);
+            }
+        std::sort(index.begin(), index.end());
+
+        std::vector<u32>    level(1, target);
+        std::vector<u32>    visited(1, target);
+        u32                 count = 0;
+
+        for (u32 depth = 1; depth <= maxDepth && !level.empty(); ++depth)
+        {
+            std::vector<u32>    next;
+
+            for (u32 address : level)
+            {
+                auto    it = std::lower_bound(index.begin(), index.end(),
+                                              std::make_pair(address >= maxOffset ? address - maxOffset : 0, 0u));
+
+                for (; it != index.end() && it->first <= address; ++it)
+                {
+                    if (memory.statics.Contains(it->second))
+                        ++count;
+                    else
+                        next.push_back(it->second);
+                }
+            }
+
+            std::sort(next.begin(), next.end());
+            next.erase(std::unique(next.begin(), next.end()), next.end());
+            level.clear();
+            for (u32 address : next)
+                if (!std::binary_search(visited.begin(), visited.end(), address))
+                    level.push_back(address);
+            visited.insert(visited.end(), level.begin(), level.end());
+            std::sort(visited.begin(), visited.end());
+        }
+
+        return (count);
+    }
+
+    bool    Follow(Heap &memory, const PointerPath &path, u32 &address)
+    {
+        address = path.base;
+        for (u32 i = 0; i < path.depth; ++i)
+        {
+            Area    *area = memory.AreaOf(address);
+
+            if (area == nullptr)
+                return (false);
+            address = area->Read(address) + path.offsets[i];
+        }
+        return (true);
+    }
+}
+
+TEST(PointerScannerFindsPlantedChain)
+{
+    Heap            memory(0x100000, 0x10000, 1);
+    PointerScanner  scanner;
+    u32             first = HeapBase + 0x1000;
+    u32             second = HeapBase + 0x80000;
+    u32             target = HeapBase + 0xC0040;
+
+    // statics + 0x100 -> first (+0x10) -> second (+0x24) -> target - 8
+    memory.statics.Write(StaticBase + 0x100, first);
+    memory.heap.Write(first + 0x10, second);
+    memory.heap.Write(second + 0x24, target - 8);
+    memory.AddTo(scanner);
+
+    std::vector<PointerPath>    paths;
+    bool                        planted = false;
+
+    // Nothing is found before the index is built
+    CHECK(scanner.Scan(target, 3, 0x100, 100, paths) == 0);
+    CHECK(scanner.BuildIndex() == scanner.IndexSize());
+    CHECK(scanner.MemoryUsage() < scanner.IndexSize() * 4 + 0x10000);
+
+    scanner.Scan(target, 3, 0x100, 100000, paths);
+    for (const PointerPath &path : paths)
+    {
+        u32     address;
+
+        CHECK(scanner.Resolve(path, address) && address == target);
+        planted |= path.base == StaticBase + 0x100 && path.depth == 3 && path.offsets[0] == 0x10
+                   && path.offsets[1] == 0x24 && path.offsets[2] == 8;
+    }
+    CHECK(planted);
+    CHECK(paths.size() == CountChains(memory, target, 3, 0x100));
+
+    // Save and load, then break the chain
+    std::vector<u8>             file;
+    std::vector<PointerPath>    loaded;
+    u32                         loadedTarget;
+
+    PointerScanner::Serialize(paths, target, file);
+    CHECK(PointerScanner::Deserialize(file.data(), file.size(), loaded, loadedTarget));
+    CHECK(loadedTarget == target && loaded.size() == paths.size());
+    CHECK(!PointerScanner::Deserialize(file.data(), file.size() - 1, loaded, loadedTarget));
+
+    // A damaged count is refused before anything is reserved
+    u32     count = 0xFFFFFFFF;
+
+    std::memcpy(file.data() + 12, &count, 4);
+    CHECK(!PointerScanner::Deserialize(file.data(), file.size(), loaded, loadedTarget));
+    count = paths.size() + 1;
+    std::memcpy(file.data() + 12, &count, 4);
+    CHECK(!PointerScanner::Deserialize(file.data(), file.size(), loaded, loadedTarget));
+
+    memory.heap.Write(second + 0x24, 0);
+    CHECK(scanner.Rescan(loaded, target) < paths.size());
+}
+
+// The chains found on random heaps, against a plain sorted index of (value, location)
+TEST(PointerScannerMatchesReference)
+{
+    std::mt19937    random(2);
+
+    for (u32 round = 0; round < 4; ++round)
+    {
+        Heap            memory(0x40000, 0x4000, 10 + round);
+        PointerScanner  scanner;
+
+        memory.AddTo(scanner);
+        scanner.BuildIndex();
+
+        for (u32 i = 0; i < 8; ++i)
+        {
+            std::vector<PointerPath>    paths;
+            u32     target = HeapBase + (random() % 0x40000 & ~3u);
+            u32     depth = 1 + random() % 3;
+            u32     maxOffset = 0x40 << (random() % 5);
+
+            scanner.Scan(target, depth, maxOffset, 0xFFFFFFFF, paths);
+            CHECK(paths.size() == CountChains(memory, target, depth, maxOffset));
+            for (const PointerPath &path : paths)
+            {
+                u32     address;
+
+                CHECK(Follow(memory, path, address) && address == target);
+            }
+        }
+
+        // A word changed since the index was built isn't followed anymore
+        std::vector<PointerPath>    before;
+        std::vector<PointerPath>    after;
+        u32                         target = HeapBase + 0x2000;
+
+        scanner.Scan(target, 1, 0x1000, 0xFFFFFFFF, before);
+        for (const PointerPath &path : before)
+            memory.statics.Write(path.base, 0x12345678);
+        scanner.Scan(target, 1, 0x1000, 0xFFFFFFFF, after);
+        CHECK(after.empty());
+    }
+}
+
+// Index size and speed on a heap the size of a game's
+BENCH(PointerScannerSyntheticHeap)
+{
+    const u32       heapSize = 48 << 20;
+    Heap            memory(heapSize, 2 << 20, 3);
+    PointerScanner  scanner;
+    std::mt19937    random(4);
+
+    memory.AddTo(scanner);
+
+    Tests::Stopwatch    build;
+    u32                 pointers = scanner.BuildIndex();
+    double              seconds = build.Seconds();
+
+    std::printf("    %u MB, %u pointers: build %.1f ms (%.0f MB/s), index %.2f MB, %.2f bytes per pointer\n",
+                (heapSize + (2 << 20)) >> 20, pointers, seconds * 1e3, ((heapSize + (2 << 20)) >> 20) / seconds,
+                scanner.MemoryUsage() / 1048576.0, static_cast<double>(scanner.MemoryUsage()) / pointers);
+
+    for (u32 depth = 2; depth <= 4; ++depth)
+    {
+        std::vector<PointerPath>    paths;
+        Tests::Stopwatch            scan;
+
+        for (u32 i = 0; i < 4; ++i)
+            scanner.Scan(HeapBase + (random() % heapSize & ~3u), depth, 0x200, 100000, paths);
+
+        std::printf("    depth %u, offset 0x200: %.1f ms per scan, %u chains\n", depth,
+                    scan.Seconds() * 1e3 / 4, static_cast<u32>(paths.size()));
+    }
+}
@@ -0,0 +1,250 @@
+#include "Test.hpp"
+#include "Helpers/PoolAllocator.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    struct Block
+    {
+        u8      *data;
+        u32     size;
+        u8      pattern;
+    };
+
+    // Mostly small blocks like strings and map nodes, some larger than the pools
+    u32     RandomSize(std::mt19937 &rng)
+    {
+        u32     kind = rng() % 10;
+
+        if (kind < 7)
+            return (1 + rng() % 64);
+        if (kind < 9)
+            return (65 + rng() % (PoolAllocator::MaxPooledSize - 64));
+        return (PoolAllocator::MaxPooledSize + 1 + rng() % 4096);
+    }
+
+    bool    Intact(const Block &block)
+    {
+        for (u32 i = 0; i < block.size; ++i)
+            if (block.data[i] != static_cast<u8>(block.pattern + i))
+                return (false);
+        return (true);
+    }
+
+    // Allocate and free blocks at random, up to window live at once, every block checked before it's freed
+    bool    Stress(u32 seed, u32 operations, u32 window)
+    {
+        std::mt19937        rng(seed);
+        std::vector<Block>  blocks;
+        bool                intact = true;
+
+        blocks.reserve(window);
+        for (u32 i = 0; i < operations; ++i)
+        {
+            if (blocks.size() < window && (blocks.empty() || rng() % 5 < 3))
+            {
+                Block   block = { nullptr, RandomSize(rng), static_cast<u8>(rng()) };
+
+                block.data = static_cast<u8 *>(PoolAllocator::Allocate(block.size));
+                intact = intact && block.data != nullptr && (reinterpret_cast<uintptr_t>(block.data) & 7) == 0
+                         && PoolAllocator::SizeOf(block.data) == block.size;
+                for (u32 k = 0; k < block.size; ++k)
+                    block.data[k] = block.pattern + k;
+                blocks.push_back(block);
+                continue;
+            }
+
+            u32     index = rng() % blocks.size();
+
+            intact = intact && Intact(blocks[index]);
+            PoolAllocator::Free(blocks[index].data);
+            blocks[index] = blocks.back();
+            blocks.pop_back();
+        }
+
+        for (Block &block : blocks)
+        {
+            intact = intact && Intact(block);
+            PoolAllocator::Free(block.data);
+        }
+        return (intact);
+    }
+
+    // Run func in a child process with its error output in path, return the signal that ended it
+    template <typename Func>
+    int     RunForked(const char *path, Func func)
+    {
+        std::fflush(stdout);
+
+        pid_t   pid = fork();
+        int     status = 0;
+
+        if (pid == 0)
+        {
+            // Unbuffered, abort doesn't flush
+            freopen(path, "w", stderr);
+            setvbuf(stderr, nullptr, _IONBF, 0);
+            func();
+            _exit(0);
+        }
+
+        waitpid(pid, &status, 0);
+        return (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    }
+}
+
+TEST(PoolAllocatorKeepsTheBlocks)
+{
+    HeapStats   before;
+    HeapStats   after;
+
+    PoolAllocator::GetStats(before);
+    {
+        MemoryTagScope  scope(MemoryTag::Settings);
+
+        CHECK(Stress(1, 200000, 4000));
+    }
+    PoolAllocator::GetStats(after);
+    CHECK(after.live == before.live && after.count == before.count);
+    CHECK(after.tags[static_cast<u32>(MemoryTag::Settings)].live == before.tags[static_cast<u32>(MemoryTag::Settings)].live);
+    CHECK(after.tags[static_cast<u32>(MemoryTag::Settings)].peak > 4000 * 16);
+    CHECK(after.poolUsed == before.poolUsed && after.large == before.large);
+
+    // The empty slabs kept by the pools go back to the heap
+    PoolAllocator::Trim();
+    PoolAllocator::GetStats(after);
+    CHECK(after.poolReserved <= before.poolReserved);
+}
+
+TEST(PoolAllocatorSharedByThreads)
+{
+    HeapStats           before;
+    HeapStats           after;
+    bool                intact[4] = {};
+    std::vector<std::thread>    threads;
+
+    threads.reserve(4);
+    PoolAllocator::GetStats(before);
+    for (u32 i = 0; i < 4; ++i)
+        threads.emplace_back([i, &intact]() { intact[i] = Stress(10 + i, 100000, 1000); });
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (bool threadIntact : intact)
+        CHECK(threadIntact);
+    PoolAllocator::GetStats(after);
+    CHECK(after.live == before.live && after.count == before.count);
+    CHECK(after.poolUsed == before.poolUsed && after.large == before.large);
+}
+
+TEST(PoolAllocatorBreaksWhenFull)
+{
+    HeapStats   before;
+    HeapStats   after;
+    const char  *path = "PoolAllocator.log";
+
+    // The nothrow versions let the caller handle it
+    PoolAllocator::GetStats(before);
+    CHECK(operator new(0xFFFFFFFCu, std::nothrow) == nullptr);
+    CHECK(PoolAllocator::Allocate(0xFFFFFFFC) == nullptr);
+    PoolAllocator::GetStats(after);
+    CHECK(after.failures == before.failures + 2);
+
+    // operator new writes the statistics and breaks, the heap of the child is limited to fill it
+    CHECK(RunForked(path, []()
+    {
+        rlimit          limit = { 2048u << 20, 2048u << 20 };
+        MemoryTagScope  scope(MemoryTag::Search);
+
+        setrlimit(RLIMIT_AS, &limit);
+        for (;;)
+            std::memset(operator new(64 << 20), 0, 4096);
+    }) == SIGABRT);
+
+    std::ifstream       file(path);
+    std::stringstream   log;
+
+    log << file.rdbuf();
+    CHECK(log.str().find("Out of memory: 67108864 bytes for Search") != std::string::npos);
+    CHECK(log.str().find("Heap     live") != std::string::npos);
+    CHECK(log.str().find("svcBreak(0)") != std::string::npos);
+    std::remove(path);
+}
+
+// The same allocations and frees through the pools and through the malloc of the host
+BENCH(PoolAllocatorAgainstMalloc)
+{
+    const u32           operations = 2000000;
+    const u32           window = 4000;
+    std::mt19937        rng(3);
+    std::vector<u32>    sizes(operations);
+    std::vector<u32>    frees(operations);
+    std::vector<void *> blocks(window, nullptr);
+
+    // Each step frees a random slot, then fills it again
+    for (u32 i = 0; i < operations; ++i)
+    {
+        sizes[i] = RandomSize(rng);
+        frees[i] = rng() % window;
+    }
+
+    auto    run = [&](void *(*allocate)(u32), void (*release)(void *))
+    {
+        Tests::Stopwatch    watch;
+
+        for (u32 i = 0; i < operations; ++i)
+        {
+            void    *&slot = blocks[frees[i]];
+
+            release(slot);
+            slot = allocate(sizes[i]);
+            static_cast<u8 *>(slot)[0] = i;
+        }
+
+        double  seconds = watch.Seconds();
+
+        for (void *&slot : blocks)
+        {
+            release(slot);
+            slot = nullptr;
+        }
+        return (seconds);
+    };
+
+    double      pooled = run([](u32 size) { return (PoolAllocator::Allocate(size)); },
+                             [](void *block) { PoolAllocator::Free(block); });
+    double      host = run([](u32 size) { return (std::malloc(size)); }, [](void *block) { std::free(block); });
+    HeapStats   before;
+    HeapStats   after;
+
+    // What the pools take from the heap with the window live
+    PoolAllocator::Trim();
+    PoolAllocator::GetStats(before);
+    for (u32 i = 0; i < window; ++i)
+        blocks[i] = PoolAllocator::Allocate(sizes[i]);
+    PoolAllocator::GetStats(after);
+    for (void *&block : blocks)
+        PoolAllocator::Free(block);
+
+    u32     requested = after.live - before.live;
+    u32     taken = after.poolReserved - before.poolReserved + after.large - before.large;
+
+    std::printf("    %u allocations and frees, %u live: pools %.1f ns, host malloc %.1f ns per pair\n", operations,
+                window, pooled * 1e9 / operations, host * 1e9 / operations);
+    std::printf("    with the window live: %u bytes requested, %u taken from the heap (%.1f%% lost)\n", requested, taken,
+                (taken - requested) * 100.0 / taken);
+}
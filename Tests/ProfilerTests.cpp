@@ -0,0 +1,182 @@
+#include "Test.hpp"
+#include "Helpers/Profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const char  *ZoneA = "ZoneA";
+    const char  *ZoneB = "ZoneB";
+
+    // Record a zone taking microseconds, one after the other
+    void    RecordZone(const char *name, u32 microseconds)
+    {
+        static u64  clock = 1;
+        u64         start = clock;
+
+        clock += MicrosecondsToTicks(microseconds);
+        Profiler::Record(name, start, clock);
+    }
+
+    const ZoneStats     *Find(const std::vector<ZoneStats> &stats, const char *name)
+    {
+        for (const ZoneStats &zone : stats)
+            if (std::strcmp(zone.name, name) == 0)
+                return (&zone);
+        return (nullptr);
+    }
+}
+
+TEST(ProfilerAggregatesTheZones)
+{
+    std::vector<ZoneStats>  stats;
+    std::vector<u32>        durations;
+    std::mt19937            random(13);
+
+    Profiler::Collect();
+    Profiler::Reset();
+
+    // Mostly short runs with a few long ones
+    for (u32 i = 0; i < 1000; ++i)
+        durations.push_back(i % 50 == 0 ? 5000 + random() % 1000 : 100 + random() % 100);
+
+    // Collected every 100 records, like once per frame
+    for (u32 i = 0; i < durations.size(); ++i)
+    {
+        RecordZone(ZoneA, durations[i]);
+        RecordZone(ZoneB, 10);
+        if (i % 100 == 99)
+            Profiler::Collect();
+    }
+
+    Profiler::GetStats(stats);
+    CHECK(stats.size() == 2);
+
+    const ZoneStats     *a = Find(stats, ZoneA);
+    const ZoneStats     *b = Find(stats, ZoneB);
+
+    CHECK(a != nullptr && b != nullptr);
+    if (a == nullptr || b == nullptr)
+        return;
+
+    // The most expensive first
+    CHECK(stats[0].name == a->name && std::strcmp(a->name, ZoneA) == 0);
+
+    u64     total = 0;
+
+    for (u32 duration : durations)
+        total += duration;
+    std::sort(durations.begin(), durations.end());
+
+    CHECK(a->count == 1000);
+    CHECK(a->min == durations.front() && a->max == durations.back());
+    CHECK(a->total == total);
+    CHECK(a->average == total / 1000);
+
+    // The p99 comes from a histogram with 4 buckets per power of two: within 25% of the exact one
+    u32     p99 = durations[durations.size() - durations.size() / 100 - 1];
+
+    CHECK(a->p99 >= p99 && a->p99 <= p99 + p99 / 4 + 1);
+    CHECK(b->count == 1000 && b->min == 10 && b->max == 10 && b->p99 == 10);
+
+    // Reset forgets the zones, not the rings
+    Profiler::Reset();
+    Profiler::GetStats(stats);
+    CHECK(stats.empty());
+}
+
+TEST(ProfilerKeysTheZonesByName)
+{
+    std::vector<ZoneStats>  stats;
+    std::string             name("Moon Jump");
+    std::string             same(name);
+
+    Profiler::Collect();
+    Profiler::Reset();
+
+    // Names that aren't literals, like the ones of the menu entries: the same text is the same zone
+    RecordZone(name.c_str(), 10);
+    RecordZone(same.c_str(), 10);
+    {
+        ProfileZone     zone(name);
+    }
+
+    // Copied when collected, the strings can change afterwards
+    Profiler::Collect();
+    name = "Infinite Health";
+    same.clear();
+    Profiler::GetStats(stats);
+    CHECK(stats.size() == 1);
+    CHECK(stats.size() == 1 && std::strcmp(stats[0].name, "Moon Jump") == 0 && stats[0].count == 3);
+
+    Profiler::Reset();
+}
+
+TEST(ProfilerKeepsTheLastRingOfRecords)
+{
+    std::vector<ZoneStats>  stats;
+
+    Profiler::Collect();
+    Profiler::Reset();
+
+    // The writer laps the collector: the oldest records are lost
+    for (u32 i = 0; i < Profiler::RingSize * 3; ++i)
+        RecordZone(ZoneA, i < Profiler::RingSize * 2 ? 1000 : 100);
+
+    Profiler::Collect();
+    Profiler::GetStats(stats);
+    CHECK(stats.size() == 1);
+    CHECK(stats[0].count == Profiler::RingSize);
+    CHECK(stats[0].max == 100);
+
+    Profiler::Reset();
+}
+
+TEST(ProfilerCollectsEveryThread)
+{
+    std::vector<ZoneStats>  stats;
+
+    Profiler::Collect();
+    Profiler::Reset();
+
+    // Two more threads, each with its ring
+    std::thread     first([]() { for (u32 i = 0; i < 500; ++i) Profiler::Record(ZoneA, 0, 268); });
+    std::thread     second([]() { for (u32 i = 0; i < 500; ++i) Profiler::Record(ZoneB, 0, 2 * 268); });
+
+    first.join();
+    second.join();
+    for (u32 i = 0; i < 500; ++i)
+        Profiler::Record(ZoneA, 0, 268);
+
+    Profiler::Collect();
+    Profiler::GetStats(stats);
+
+    const ZoneStats     *a = Find(stats, ZoneA);
+    const ZoneStats     *b = Find(stats, ZoneB);
+
+    CHECK(a != nullptr && a->count == 1000 && a->average == 1);
+    CHECK(b != nullptr && b->count == 500 && b->average == 2);
+
+    CHECK(Profiler::DumpCsv("profiler.csv"));
+
+    FILE    *file = std::fopen("profiler.csv", "r");
+    char    line[128] = {};
+
+    CHECK(file != nullptr);
+    if (file != nullptr)
+    {
+        CHECK(std::fgets(line, sizeof(line), file) != nullptr);
+        CHECK(std::string(line) == "zone,count,min_us,avg_us,p99_us,max_us,total_us\n");
+        CHECK(std::fgets(line, sizeof(line), file) != nullptr);
+        CHECK(std::string(line) == "\"ZoneA\",1000,1,1,1,1,1000\n");
+        std::fclose(file);
+    }
+
+    std::remove("profiler.csv");
+    Profiler::Reset();
+}
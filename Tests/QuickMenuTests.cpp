@@ -0,0 +1,136 @@
+#include "Test.hpp"
+#include "Helpers/InputDispatcher.hpp"
+#include "Helpers/QuickMenu.hpp"
+#include "Helpers/Ticks.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    u32     g_executed = 0;
+
+    void    CountExecution(void)
+    {
+        ++g_executed;
+    }
+
+    // Hold the hotkey long enough to open the menu, the keyboard of the tests is cancelled at once
+    void    Open(QuickMenu &menu)
+    {
+        InputDispatcher &dispatcher = InputDispatcher::GetInstance();
+        static u64      ticks = 1ull << 40;
+
+        dispatcher.Update(0, ticks += 1000);
+        dispatcher.Update(Start, ticks += 1000);
+        dispatcher.Update(Start, ticks += MicrosecondsToTicks(600000));
+        menu();
+        dispatcher.Update(0, ticks += 1000);
+    }
+}
+
+TEST(QuickMenuSharesTheNames)
+{
+    QuickMenu   &menu = QuickMenu::GetInstance();
+    u32         count = menu.Count();
+    u32         first = menu.AddSubMenu(QuickMenu::Root, "Player");
+    u32         second = menu.AddSubMenu(QuickMenu::Root, "Vehicle");
+    u32         speeds[] =
+    {
+        menu.AddEntry(first, "Speed", CountExecution),
+        menu.AddEntry(second, "Speed", CountExecution),
+        menu.AddEntry(second, "Jump", CountExecution)
+    };
+
+    CHECK(menu.Count() == count + 5);
+    CHECK(menu.Find("Speed"_id, first) == speeds[0]);
+    CHECK(menu.Find("Speed"_id, second) == speeds[1]);
+    CHECK(menu.Find("Jump"_id, first) == QuickMenu::InvalidNode);
+    CHECK(std::strcmp(menu.GetName(speeds[2]), "Jump") == 0);
+
+    // One copy of each name, kept after its items are gone
+    const char  *name = menu.GetName(speeds[0]);
+
+    CHECK(menu.GetName(speeds[1]) == name);
+    menu.Remove(first);
+    CHECK(menu.GetName(speeds[0]) == nullptr);
+    CHECK(menu.Count() == count + 3);
+
+    u32     again = menu.AddEntry(QuickMenu::Root, "Speed", CountExecution);
+
+    CHECK(menu.GetName(again) == name);
+
+    // Entries can't have children
+    CHECK(menu.AddEntry(again, "Child", CountExecution) == QuickMenu::InvalidNode);
+
+    Open(menu);
+    menu.Remove(again);
+    menu.Remove(second);
+    CHECK(menu.Count() == count);
+    CHECK(g_executed == 0);
+}
+
+TEST(QuickMenuCopiesTheItems)
+{
+    QuickMenu           &menu = QuickMenu::GetInstance();
+    u32                 count = menu.Count();
+    QuickMenuSubMenu    *tools = new QuickMenuSubMenu("Tools");
+
+    *tools += new QuickMenuEntry("Teleport", CountExecution);
+    *tools += new QuickMenuSubMenu("Items", { new QuickMenuEntry("Potion", CountExecution) });
+
+    menu += tools;
+
+    u32     node = menu.Find("Tools"_id);
+    u32     items = menu.Find("Items"_id, node);
+
+    CHECK(menu.IsSubMenu(node) && menu.IsSubMenu(items));
+    CHECK(!menu.IsSubMenu(menu.Find("Teleport"_id, node)));
+    CHECK(std::strcmp(menu.GetName(menu.Find("Potion"_id, items)), "Potion") == 0);
+    CHECK(menu.Count() == count + 4);
+
+    Open(menu);
+    menu -= "Tools"_id;
+    CHECK(menu.Count() == count);
+    CHECK(menu.Find("Tools"_id) == QuickMenu::InvalidNode);
+}
+
+// Adding the items then opening the menu, which builds the children and the root options
+BENCH(QuickMenuBuild)
+{
+    QuickMenu   &menu = QuickMenu::GetInstance();
+
+    for (u32 count : { 1000u, 5000u, 20000u })
+    {
+        std::vector<std::string>    names;
+        std::vector<u32>            submenus;
+
+        for (u32 i = 0; i < count; ++i)
+            names.push_back("Cheat number " + std::to_string(i));
+
+        Tests::Stopwatch    add;
+
+        // 50 entries per submenu, a name used twice out of four
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (i % 50 == 0)
+                submenus.push_back(menu.AddSubMenu(QuickMenu::Root, "Folder " + std::to_string(i / 50)));
+            menu.AddEntry(submenus.back(), names[i % 4 == 3 ? i - 1 : i], CountExecution);
+        }
+
+        double  addTime = add.Seconds();
+
+        Tests::Stopwatch    open;
+
+        Open(menu);
+
+        double  openTime = open.Seconds();
+
+        std::printf("    %5u items: add %7.2f ms (%4.0f ns per item), first open %6.2f ms\n",
+                    count, addTime * 1e3, addTime * 1e9 / count, openTime * 1e3);
+
+        for (u32 submenu : submenus)
+            menu.Remove(submenu);
+    }
+}
@@ -0,0 +1,196 @@
+#include "Test.hpp"
+#include "Helpers/RegionMap.hpp"
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   RX = MEMPERM_READ | MEMPERM_EXECUTE;
+    const u32   RW = MEMPERM_READ | MEMPERM_WRITE;
+
+    class FakeSource : public RegionSource
+    {
+    public:
+        void    Enumerate(std::vector<MemoryRegion> &out) override
+        {
+            ++calls;
+            out.insert(out.end(), regions.begin(), regions.end());
+        }
+
+        std::vector<MemoryRegion>   regions;
+        u32                         calls = 0;
+    };
+
+    // What Check promises, one byte at a time
+    bool    Scan(const std::vector<MemoryRegion> &regions, u32 address, u32 size, u32 perm)
+    {
+        for (u64 byte = address; byte < static_cast<u64>(address) + (size ? size : 1); ++byte)
+        {
+            bool    found = false;
+
+            for (const MemoryRegion &region : regions)
+                found = found || (byte >= region.start && byte < region.end && (region.perm & perm) == perm);
+            if (!found)
+                return (false);
+        }
+        return (true);
+    }
+}
+
+TEST(RegionMapMatchesTheScan)
+{
+    FakeSource      source;
+
+    source.regions =
+    {
+        { 0x00100000, 0x00200000, RX }, { 0x00200000, 0x00300000, RX }, { 0x00300000, 0x00310000, RW },
+        { 0x00400000, 0x00500000, RW }, { 0x00500000, 0x00501000, MEMPERM_READ }, { 0x00501000, 0x00502000, RW }
+    };
+
+    RegionMap       map(source);
+    MemoryRegion    region;
+
+    // Enumerated once, the contiguous regions with the same permissions merged
+    CHECK(source.calls == 1);
+    CHECK(map.GetRegions().size() == 5);
+    CHECK(map.Find(0x00150000, region) && region.start == 0x00100000 && region.end == 0x00300000);
+    CHECK(!map.Find(0x00350000, region));
+
+    CHECK(map.IsReadable(0x00100000) && !map.IsWritable(0x00100000));
+    CHECK(map.IsReadable(0x002FFFF0, 0x20) && !map.IsWritable(0x002FFFF0, 0x20));
+    CHECK(map.IsReadable(0x0030FFFF, 1) && !map.IsReadable(0x0030FFFF, 2));
+    CHECK(map.IsReadable(0x004FFFF0, 0x2010) && !map.IsWritable(0x004FFFF0, 0x20));
+    CHECK(!map.IsReadable(0x000FFFFF) && !map.IsReadable(0xFFFFFFFF, 2));
+
+    std::mt19937    rng(1);
+
+    for (u32 i = 0; i < 100000; ++i)
+    {
+        u32     address = 0x000F0000 + rng() % 0x420000;
+        u32     size = rng() % 0x40;
+        u32     perm = rng() % 2 ? static_cast<u32>(MEMPERM_READ) : RW;
+
+        CHECK(map.Check(address, size, perm) == Scan(source.regions, address, size, perm));
+    }
+    CHECK(source.calls == 1);
+
+    // Invalidate publishes the new regions at once
+    u32     generation = map.Generation();
+
+    source.regions.erase(source.regions.begin() + 3);
+    CHECK(map.IsWritable(0x00400000));
+    map.Invalidate();
+    CHECK(map.Generation() != generation);
+    CHECK(source.calls == 2);
+    CHECK(!map.IsWritable(0x00400000));
+}
+
+TEST(RegionMapChecksWhileInvalidated)
+{
+    FakeSource          source;
+    const MemoryRegion  first = { 0x00100000, 0x00200000, RW };
+    const MemoryRegion  second = { 0x00300000, 0x00400000, MEMPERM_READ };
+
+    source.regions = { first };
+
+    RegionMap           map(source);
+    bool                stop = false;
+    bool                consistent[4] = { true, true, true, true };
+    std::vector<std::thread>    readers;
+
+    // Each read sees one layout or the other, never a mix nor a freed one
+    for (u32 i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&map, &stop, &consistent, &first, &second, i]()
+        {
+            auto    same = [](const MemoryRegion &a, const MemoryRegion &b)
+            {
+                return (a.start == b.start && a.end == b.end && a.perm == b.perm);
+            };
+
+            while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE))
+            {
+                std::vector<MemoryRegion>   regions = map.GetRegions();
+                MemoryRegion                region;
+
+                if (regions.size() != 1 || (!same(regions[0], first) && !same(regions[0], second)))
+                    consistent[i] = false;
+                if (map.Find(0x00180000, region) && !same(region, first))
+                    consistent[i] = false;
+                if (map.IsReadable(0x00380000, 0x100) && map.Find(0x00380000, region) && !same(region, second))
+                    consistent[i] = false;
+            }
+        });
+    }
+
+    for (u32 i = 0; i < 2000; ++i)
+    {
+        source.regions = { i & 1 ? first : second };
+        map.Invalidate();
+    }
+
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+    for (std::thread &reader : readers)
+        reader.join();
+
+    for (bool readerConsistent : consistent)
+        CHECK(readerConsistent);
+    CHECK(map.IsWritable(0x00180000));
+}
+
+TEST(RegionMapCountsTheCheckInTheEpochItRead)
+{
+    static FakeSource   source;
+    static RegionMap    *map;
+    static bool         paused;
+    static bool         freed;
+    static std::thread  invalidator;
+    const MemoryRegion  first = { 0x00100000, 0x00200000, RW };
+
+    source.regions = { first };
+
+    RegionMap   instance(source);
+
+    map = &instance;
+    paused = false;
+    __atomic_store_n(&freed, false, __ATOMIC_SEQ_CST);
+
+    // The check is preempted by an Invalidate between reading the epoch and counting itself,
+    // then a second Invalidate starts while it reads the snapshot
+    RegionMap::AcquireHook = [](bool pinned)
+    {
+        if (!pinned && !paused)
+        {
+            paused = true;
+            source.regions = { { 0x00300000, 0x00400000, RW } };
+            map->Invalidate();
+        }
+        else if (pinned && paused && !invalidator.joinable())
+        {
+            source.regions = { { 0x00500000, 0x00600000, RW } };
+            invalidator = std::thread([]()
+            {
+                map->Invalidate();
+                __atomic_store_n(&freed, true, __ATOMIC_SEQ_CST);
+            });
+
+            // It must wait for the check
+            svcSleepThread(50000000);
+            if (__atomic_load_n(&freed, __ATOMIC_SEQ_CST))
+                paused = false;
+        }
+    };
+
+    MemoryRegion    region;
+
+    CHECK(map->Find(0x00380000, region) && region.start == 0x00300000);
+    RegionMap::AcquireHook = nullptr;
+    CHECK(invalidator.joinable());
+    if (invalidator.joinable())
+        invalidator.join();
+    CHECK(paused);
+    CHECK(map->IsWritable(0x00580000) && !map->IsReadable(0x00380000));
+}
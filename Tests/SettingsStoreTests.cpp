@@ -0,0 +1,168 @@
+#include "Test.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/SettingsStore.hpp"
+#include <cstdio>
+#include <unistd.h>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const char  *Path = "Settings.bin";
+
+    // The entries need a game function to be toggled
+    void    Cheat(MenuEntry *)
+    {
+    }
+
+    void    RemoveFiles(void)
+    {
+        std::remove(Path);
+        std::remove("Settings.bin.tmp");
+        std::remove("Settings.bin.bak");
+    }
+
+    long    FileSize(const char *path)
+    {
+        FILE    *file = std::fopen(path, "rb");
+        long    size;
+
+        if (file == nullptr)
+            return (-1);
+        std::fseek(file, 0, SEEK_END);
+        size = std::ftell(file);
+        std::fclose(file);
+        return (size);
+    }
+}
+
+TEST(SettingsStoreAppendsAndCompacts)
+{
+    SettingsStore   &store = SettingsStore::GetInstance();
+    u32             value = 0;
+    std::string     text;
+
+    RemoveFiles();
+    CHECK(store.Open(Path));
+    CHECK(!store.Get("a"_id, value));
+    CHECK(store.Set("a"_id, static_cast<u32>(5)));
+    CHECK(store.Set("b"_id, std::string("hello")));
+
+    // An unchanged value isn't written again
+    u32     logSize = store.LogSize();
+
+    CHECK(store.Set("a"_id, static_cast<u32>(5)));
+    CHECK(store.LogSize() == logSize);
+
+    store.Close();
+    CHECK(store.Open(Path));
+    CHECK(store.GetOr("a"_id, static_cast<u32>(0)) == 5);
+    CHECK(store.Get("b"_id, text) && text == "hello");
+    CHECK(store.Compact());
+    CHECK(store.LogSize() == 0);
+
+    CHECK(store.Remove("b"_id));
+    store.Set("c"_id, static_cast<u32>(9));
+    store.Close();
+    CHECK(store.Open(Path));
+    CHECK(!store.Has("b"_id));
+    CHECK(store.GetOr("c"_id, static_cast<u32>(0)) == 9);
+
+    // Compacted on close once the records outgrow the values
+    for (u32 i = 0; i < 2000; ++i)
+        store.Set("x"_id, i);
+    CHECK(store.LogSize() > SettingsStore::CompactThreshold);
+    store.Close();
+    CHECK(store.Open(Path));
+    CHECK(store.LogSize() == 0);
+    CHECK(store.GetOr("x"_id, static_cast<u32>(0)) == 1999);
+
+    // A record cut by a crash ends the log
+    store.Set("d"_id, static_cast<u32>(7));
+    store.Set("e"_id, static_cast<u32>(8));
+    store.Close();
+    CHECK(truncate(Path, FileSize(Path) - 2) == 0);
+    CHECK(store.Open(Path));
+    CHECK(store.GetOr("d"_id, static_cast<u32>(0)) == 7);
+    CHECK(!store.Has("e"_id));
+    store.Close();
+    RemoveFiles();
+}
+
+TEST(SettingsStoreRecoversACutCompaction)
+{
+    SettingsStore   &store = SettingsStore::GetInstance();
+    std::vector<u8> old;
+
+    RemoveFiles();
+    CHECK(store.Open(Path));
+    store.Set("a"_id, static_cast<u32>(1));
+    CHECK(store.Compact());
+    CHECK(ReadFile(Path, old));
+    store.Set("a"_id, static_cast<u32>(2));
+    CHECK(store.Compact());
+    store.Close();
+
+    // Cut after the old file was moved aside: the new file is complete in path.tmp
+    CHECK(std::rename(Path, "Settings.bin.tmp") == 0);
+    CHECK(WriteFile("Settings.bin.bak", old.data(), old.size()));
+    CHECK(store.Open(Path));
+    CHECK(store.GetOr("a"_id, static_cast<u32>(0)) == 2);
+    CHECK(FileSize("Settings.bin.tmp") < 0 && FileSize("Settings.bin.bak") < 0);
+    store.Close();
+
+    // Cut while writing path.tmp, before the old file was moved: the old file stays
+    FILE    *partial = std::fopen("Settings.bin.tmp", "wb");
+
+    std::fputs("CSE", partial);
+    std::fclose(partial);
+    CHECK(store.Open(Path));
+    CHECK(store.GetOr("a"_id, static_cast<u32>(0)) == 2);
+    store.Close();
+
+    // Cut with the old file aside and no path.tmp: the old file is put back
+    std::remove("Settings.bin.tmp");
+    CHECK(std::rename(Path, "Settings.bin.bak") == 0);
+    CHECK(store.Open(Path));
+    CHECK(store.GetOr("a"_id, static_cast<u32>(0)) == 2);
+    store.Close();
+    RemoveFiles();
+}
+
+TEST(SettingsStoreRestoresTheEntries)
+{
+    SettingsStore   &store = SettingsStore::GetInstance();
+    MenuFolder      folder("Codes");
+    MenuFolder      *category = new MenuFolder("Category");
+    MenuEntry       *first = new MenuEntry("Infinite Health", Cheat);
+    MenuEntry       *second = new MenuEntry("Moon Jump", Cheat);
+
+    RemoveFiles();
+    CHECK(store.Open(Path));
+    folder += first;
+    folder += category;
+    *category += second;
+
+    first->Enable();
+    second->Enable();
+    CHECK(store.SaveEntry(first));
+    CHECK(store.SaveEntry(second));
+    first->Disable();
+    CHECK(store.SaveEntry(first));
+    store.Close();
+
+    MenuFolder  again("Codes");
+    MenuFolder  *otherCategory = new MenuFolder("Category");
+    MenuEntry   *health = new MenuEntry("Infinite Health", Cheat);
+    MenuEntry   *jump = new MenuEntry("Moon Jump", Cheat);
+
+    again += health;
+    again += otherCategory;
+    *otherCategory += jump;
+    CHECK(store.Open(Path));
+    store.RestoreEntries(again);
+    CHECK(!health->IsActivated());
+    CHECK(jump->IsActivated());
+    store.Close();
+    RemoveFiles();
+}
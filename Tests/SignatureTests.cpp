@@ -0,0 +1,231 @@
+#include "Test.hpp"
+#include "Helpers/FileIO.hpp"
+#include "Helpers/Signature.hpp"
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    const u32   CodeAddress = 0x00100000;
+
+    // Words looking like ARM code: a few instruction forms with random registers and immediates
+    void    FillCode(u8 *code, u32 size, u32 seed)
+    {
+        static const u32    forms[] = { 0xE59F0000, 0xE5900000, 0xE5800000, 0xE1A00000, 0xE3500000,
+                                        0xE2800000, 0xEB000000, 0x0A000000, 0xE92D4000, 0xE8BD8000 };
+        std::mt19937        random(seed);
+
+        for (u32 i = 0; i + 4 <= size; i += 4)
+        {
+            u32     form = forms[random() % 10];
+            u32     word = form | (form >= 0xEB000000 || form == 0x0A000000 ? random() & 0xFFFFFF
+                                                                              : random() & 0xFFFF);
+
+            std::memcpy(code + i, &word, 4);
+        }
+    }
+
+    struct Pattern
+    {
+        std::string         text;
+        std::vector<u8>     bytes;
+        std::vector<u8>     mask;
+    };
+
+    // A pattern taken from the code, the first two bytes known and some others wildcards
+    Pattern     MakePattern(const u8 *code, u32 at, u32 length, std::mt19937 &random)
+    {
+        static const char   digits[] = "0123456789ABCDEF";
+        Pattern             pattern;
+
+        for (u32 i = 0; i < length; ++i)
+        {
+            bool    known = i < 2 || random() % 4 != 0;
+
+            if (!pattern.text.empty())
+                pattern.text += ' ';
+            pattern.text += known ? std::string({ digits[code[at + i] >> 4], digits[code[at + i] & 15] }) : "??";
+            pattern.bytes.push_back(known ? code[at + i] : 0);
+            pattern.mask.push_back(known ? 0xFF : 0);
+        }
+
+        return (pattern);
+    }
+
+    // The first match searched the plain way
+    s64     FindFirst(const Pattern &pattern, const u8 *code, u32 size)
+    {
+        for (u32 start = 0; start + pattern.bytes.size() <= size; ++start)
+        {
+            u32     i = 0;
+
+            while (i < pattern.bytes.size() && (code[start + i] & pattern.mask[i]) == pattern.bytes[i])
+                ++i;
+            if (i == pattern.bytes.size())
+                return (start);
+        }
+
+        return (-1);
+    }
+
+    void    Write32(u8 *code, u32 offset, u32 value)
+    {
+        std::memcpy(code + offset, &value, 4);
+    }
+}
+
+TEST(SignatureResolvesEachType)
+{
+    std::vector<u8>     code(0x10000, 0);
+
+    FillCode(code.data(), code.size(), 1);
+
+    // BL to +0x100 from 0x2000, LDR r1, [pc, #0x20] at 0x3000, a pointer at 0x4004, BLX with the H bit
+    const u8    marker[] = { 0xDE, 0xAD, 0xBE, 0xEF, 0x13, 0x37 };
+
+    std::memcpy(code.data() + 0x1FFA, marker, 6);
+    Write32(code.data(), 0x2000, 0xEB000000 | ((0x100 - 8) >> 2));
+    std::memcpy(code.data() + 0x2FFA, marker, 6);
+    code[0x2FFF] = 0x38;
+    Write32(code.data(), 0x3000, 0xE59F1020);
+    Write32(code.data(), 0x3028, 0x0812345C);
+    std::memcpy(code.data() + 0x3FFA, marker, 6);
+    code[0x3FFF] = 0x39;
+    Write32(code.data(), 0x4004, 0x08ABCDEF);
+    std::memcpy(code.data() + 0x4FFA, marker, 6);
+    code[0x4FFF] = 0x3A;
+    Write32(code.data(), 0x5000, 0xFB000010);
+
+    Signature   address("DE AD BE EF 13 37", 6);
+    Signature   branch("DE AD BE EF 13 37", 6, SignatureType::ArmBranch);
+    Signature   literal("DE AD ?? EF 13 38", 6, SignatureType::LdrLiteral);
+    Signature   pointer("DE AD BE ?? 13 39", 10, SignatureType::Pointer);
+    Signature   exchange("DE AD BE EF 13 3A", 6, SignatureType::ArmBranch);
+    Signature   missing("DE AD BE EF 13 3B", 6, SignatureType::Address, AutoRegion(0x1234, 0x1234));
+    Signature   invalid("D? AD", 0);
+
+    CHECK(Signature::ResolveAll(code.data(), CodeAddress, code.size()) == 5);
+    CHECK(address() == CodeAddress + 0x2000);
+    CHECK(branch() == CodeAddress + 0x2100);
+    CHECK(literal() == 0x0812345C);
+    CHECK(pointer() == 0x08ABCDEF);
+    CHECK(exchange() == CodeAddress + 0x5000 + 8 + 0x40 + 2);
+    CHECK(!missing.IsResolved() && missing() == 0x1234);
+    CHECK(!invalid.IsResolved());
+
+    // The resolved ones aren't searched again
+    CHECK(Signature::ResolveAll(code.data(), CodeAddress, code.size()) == 0);
+}
+
+// Every signature gets the first match a plain search finds
+TEST(SignatureMatchesPlainSearch)
+{
+    std::mt19937        random(2);
+    std::vector<u8>     code(0x40000);
+
+    FillCode(code.data(), code.size(), 3);
+
+    std::vector<Pattern>                        patterns;
+    std::vector<std::unique_ptr<Signature>>     signatures;
+
+    for (u32 i = 0; i < 300; ++i)
+        patterns.push_back(MakePattern(code.data(), random() % (code.size() - 32), 4 + random() % 12, random));
+    for (const Pattern &pattern : patterns)
+        signatures.emplace_back(new Signature(pattern.text.c_str()));
+
+    Signature::ResolveAll(code.data(), CodeAddress, code.size());
+    for (u32 i = 0; i < patterns.size(); ++i)
+    {
+        s64     first = FindFirst(patterns[i], code.data(), code.size());
+
+        CHECK(signatures[i]->IsResolved() && (*signatures[i])() == CodeAddress + first);
+    }
+}
+
+// The process version reads the code at 0x00100000 and caches the addresses per title
+TEST(SignatureCachesTheAddresses)
+{
+    u8      *code = Fake::Map(CodeAddress, 0x20000, MEMPERM_READ | MEMPERM_EXECUTE, MEMSTATE_CODE);
+
+    CHECK(code != nullptr);
+    if (code == nullptr)
+        return;
+
+    FillCode(code, 0x20000, 4);
+    Write32(code, 0x8000, 0x11223344);
+    Fake::SetTitleId(0x000400000ABCDE00);
+    std::remove("Signatures_000400000ABCDE00.bin");
+
+    {
+        Signature   found("44 33 22 11", 0);
+
+        CHECK(Signature::ResolveAll() == 1);
+        CHECK(found() == CodeAddress + 0x8000);
+    }
+
+    // Move the cached address: a new signature takes it from the file without searching
+    std::vector<u8>     cache;
+    u32                 moved = CodeAddress + 0x9000;
+
+    CHECK(ReadFile("Signatures_000400000ABCDE00.bin", cache) && cache.size() == 32);
+    std::memcpy(cache.data() + 28, &moved, 4);
+    CHECK(WriteFile("Signatures_000400000ABCDE00.bin", cache.data(), cache.size()));
+
+    {
+        Signature   cached("44 33 22 11", 0);
+
+        CHECK(Signature::ResolveAll() == 1 && cached() == moved);
+    }
+
+    // Different code, the cache is ignored
+    code[0] ^= 1;
+
+    Signature   searched("44 33 22 11", 0);
+
+    CHECK(Signature::ResolveAll() == 1 && searched() == CodeAddress + 0x8000);
+    std::remove("Signatures_000400000ABCDE00.bin");
+}
+
+// One pass for every signature against one plain search per signature
+BENCH(SignatureMultiPatternScan)
+{
+    const u32           size = 4 << 20;
+    std::mt19937        random(5);
+    std::vector<u8>     code(size);
+
+    FillCode(code.data(), size, 6);
+
+    for (u32 count : { 10u, 100u, 500u })
+    {
+        std::vector<Pattern>                        patterns;
+        std::vector<std::unique_ptr<Signature>>     signatures;
+
+        // Patterns from the whole code, some from the end so the pass goes through everything
+        for (u32 i = 0; i < count; ++i)
+            patterns.push_back(MakePattern(code.data(), (i == 0 ? size - 64 : random() % (size - 32)), 12, random));
+        for (const Pattern &pattern : patterns)
+            signatures.emplace_back(new Signature(pattern.text.c_str()));
+
+        Tests::Stopwatch    single;
+
+        Signature::ResolveAll(code.data(), CodeAddress, size);
+
+        double              singleSeconds = single.Seconds();
+        Tests::Stopwatch    plain;
+        s64                 sum = 0;
+
+        for (const Pattern &pattern : patterns)
+            sum += FindFirst(pattern, code.data(), size);
+        Tests::KeepAlive(sum);
+
+        double  plainSeconds = plain.Seconds();
+
+        std::printf("    %3u signatures in 4 MB: single pass %7.2f ms, one search each %8.2f ms\n", count,
+                    singleSeconds * 1e3, plainSeconds * 1e3);
+    }
+}
@@ -0,0 +1,142 @@
+#include "Test.hpp"
+#include "Helpers/OSDManager.hpp"
+#include "Helpers/QuickMenu.hpp"
+#include "Helpers/StringID.hpp"
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace CTRPluginFramework;
+
+namespace
+{
+    // Two names with the same FNV-1a hash, 0x2A84A142
+    const char  *CollidingFirst = "item139599";
+    const char  *CollidingSecond = "item322382";
+
+    // Run func in a child process, return the signal that ended it, 0 if it exited
+    template <typename Func>
+    int     RunForked(Func func)
+    {
+        std::fflush(stdout);
+
+        pid_t   pid = fork();
+        int     status = 0;
+
+        if (pid == 0)
+        {
+            // The expected crash isn't a failure, keep its report out of the output
+            freopen("/dev/null", "w", stderr);
+            func();
+            _exit(0);
+        }
+
+        waitpid(pid, &status, 0);
+        return (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    }
+}
+
+TEST(StringIDLiteralMatchesRuntimeHash)
+{
+    static_assert(""_id.Value() == StringID::OffsetBasis, "The hash of an empty string is the offset basis");
+    static_assert("a"_id.Value() == 0xE40C292C, "FNV-1a of \"a\"");
+
+    CHECK("hp_display"_id == StringID(std::string("hp_display")));
+    CHECK("hp_display"_id != "hp_displaY"_id);
+    CHECK(StringID::Compute(CollidingFirst, 10) == StringID::Compute(CollidingSecond, 10));
+    CHECK(std::string("hp_display"_id.Source(), "hp_display"_id.Length()) == "hp_display");
+}
+
+TEST(OSDManagerSameNameSharesTheItem)
+{
+    std::string     name = "shared";
+
+    CHECK(RunForked([&]()
+    {
+        OSDManager["shared"_id] = "literal";
+        OSDManager[name] = "runtime";
+        OSDManager[StringID("shared"_id.Value())] = "raw id";
+        OSDManager.Remove(name);
+    }) == 0);
+}
+
+TEST(OSDManagerBreaksOnCollision)
+{
+    CHECK(RunForked([]()
+    {
+        OSDManager[CollidingFirst] = "first";
+        OSDManager[CollidingSecond] = "second";
+    }) == SIGABRT);
+
+    CHECK(RunForked([]()
+    {
+        OSDManager[CollidingFirst] = "first";
+        OSDManager.Remove(CollidingSecond);
+    }) == SIGABRT);
+}
+
+TEST(QuickMenuBreaksOnCollision)
+{
+    CHECK(RunForked([]()
+    {
+        QuickMenu   &menu = QuickMenu::GetInstance();
+
+        menu.AddEntry(QuickMenu::Root, "item", nullptr);
+        menu.AddEntry(QuickMenu::Root, std::string("item"), nullptr);
+    }) == 0);
+
+    CHECK(RunForked([]()
+    {
+        QuickMenu   &menu = QuickMenu::GetInstance();
+
+        menu.AddSubMenu(QuickMenu::Root, CollidingFirst);
+        menu.AddEntry(QuickMenu::Root, CollidingSecond, nullptr);
+    }) == SIGABRT);
+}
+
+// OSDManager lookups by a compile time id against the same lookups hashing a string each time
+BENCH(StringIDLookup)
+{
+    const u32       iterations = 2000000;
+    std::string     names[16];
+    double          seconds;
+
+    for (u32 i = 0; i < 16; ++i)
+    {
+        names[i] = "benchmark_item_" + std::to_string(i);
+        OSDManager[names[i]] = names[i];
+    }
+
+    Tests::Stopwatch    hash;
+    u32                 sum = 0;
+
+    for (u32 i = 0; i < iterations; ++i)
+        sum += StringID::Compute(names[i & 15].c_str(), names[i & 15].size());
+    Tests::KeepAlive(sum);
+    seconds = hash.Seconds();
+    std::printf("    runtime hash        %6.1f ns\n", seconds * 1e9 / iterations);
+
+    Tests::Stopwatch    literal;
+
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(OSDManager["benchmark_item_7"_id]);
+    seconds = literal.Seconds();
+    std::printf("    lookup by _id       %6.1f ns\n", seconds * 1e9 / iterations);
+
+    Tests::Stopwatch    runtime;
+
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(OSDManager[names[7]]);
+    seconds = runtime.Seconds();
+    std::printf("    lookup by string    %6.1f ns\n", seconds * 1e9 / iterations);
+
+    Tests::Stopwatch    built;
+
+    for (u32 i = 0; i < iterations; ++i)
+        Tests::KeepAlive(OSDManager["benchmark_item_" + std::to_string(i & 15)]);
+    seconds = built.Seconds();
+    std::printf("    lookup by new name  %6.1f ns\n", seconds * 1e9 / iterations);
+
+    for (u32 i = 0; i < 16; ++i)
+        OSDManager.Remove(names[i]);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file 3ds.h
+ * @brief The part of libctru used by the helpers, for the host tests \n
+ * The svc calls are implemented in Stubs.cpp over the fake process of Fake.hpp
+ */
+#pragma once
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYSCLOCK_ARM11      268111856
+
+#define R_SUCCEEDED(res)    ((res) >= 0)
+#define R_FAILED(res)       ((res) < 0)
+
+#define CUR_PROCESS_HANDLE  0xFFFF8001
+
+typedef s32 LightLock;
+
+static inline void  LightLock_Init(LightLock *lock)
+{
+    __atomic_store_n(lock, 1, __ATOMIC_RELEASE);
+}
+
+static inline void  LightLock_Lock(LightLock *lock)
+{
+    s32     expected = 1;
+
+    while (!__atomic_compare_exchange_n(lock, &expected, 0, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        expected = 1;
+}
+
+static inline void  LightLock_Unlock(LightLock *lock)
+{
+    __atomic_store_n(lock, 1, __ATOMIC_RELEASE);
+}
+
+typedef enum
+{
+    MEMOP_FREE = 1,
+    MEMOP_ALLOC = 3,
+} MemOp;
+
+typedef enum
+{
+    MEMPERM_READ = 1,
+    MEMPERM_WRITE = 2,
+    MEMPERM_EXECUTE = 4,
+} MemPerm;
+
+typedef enum
+{
+    MEMSTATE_FREE = 0,
+    MEMSTATE_RESERVED = 1,
+    MEMSTATE_IO = 2,
+    MEMSTATE_STATIC = 3,
+    MEMSTATE_CODE = 4,
+    MEMSTATE_PRIVATE = 5,
+} MemState;
+
+typedef struct
+{
+    u32     base_addr;
+    u32     size;
+    u32     perm;
+    u32     state;
+} MemInfo;
+
+typedef struct
+{
+    u32     flags;
+} PageInfo;
+
+typedef enum
+{
+    GSP_RGBA8_OES = 0,
+    GSP_BGR8_OES = 1,
+    GSP_RGB565_OES = 2,
+    GSP_RGB5_A1_OES = 3,
+    GSP_RGBA4_OES = 4,
+} GSPGPU_FramebufferFormat;
+
+typedef enum
+{
+    USERBREAK_PANIC = 0,
+    USERBREAK_ASSERT = 1,
+    USERBREAK_USER = 2,
+} UserBreakType;
+
+typedef struct Thread_tag   *Thread;
+
+/// The fake system tick, see Fake::SetTicks
+u64     svcGetSystemTick(void);
+
+Result  svcQueryMemory(MemInfo *info, PageInfo *out, u32 addr);
+Result  svcQueryProcessMemory(MemInfo *info, PageInfo *out, Handle process, u32 addr);
+Result  svcWaitSynchronization(Handle handle, s64 nanoseconds);
+Result  svcClearEvent(Handle handle);
+Result  svcCloseHandle(Handle handle);
+Result  svcGetThreadId(u32 *threadId, Handle handle);
+void    svcBreak(UserBreakType reason) __attribute__((noreturn));
+void    svcSleepThread(s64 nanoseconds);
+/// Written to stderr
+Result  svcOutputDebugString(const char *str, s32 length);
+
+/// Runs the entrypoint on a host thread
+Thread  threadCreate(ThreadFunc entrypoint, void *arg, size_t stackSize, int prio, int coreId, bool detached);
+
+void    *getThreadLocalStorage(void);
+
+#ifdef __cplusplus
+}
+#endif
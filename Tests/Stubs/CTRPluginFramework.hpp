@@ -0,0 +1,351 @@
+/**
+ * The part of CTRPluginFramework used by the helpers, for the host tests \n
+ * The classes keep the signatures of the framework, their state is in plain members the
+ * tests can look at. The implementation is in Stubs.cpp, driven by Fake.hpp.
+ */
+#pragma once
+
+#include <3ds.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace CTRPluginFramework
+{
+    enum Key
+    {
+        A = 1,
+        B = 1 << 1,
+        Select = 1 << 2,
+        Start = 1 << 3,
+        DPadRight = 1 << 4,
+        DPadLeft = 1 << 5,
+        DPadUp = 1 << 6,
+        DPadDown = 1 << 7,
+        R = 1 << 8,
+        L = 1 << 9,
+        X = 1 << 10,
+        Y = 1 << 11,
+        ZL = 1 << 14,
+        ZR = 1 << 15,
+        Touchpad = 1 << 20,
+        CStickRight = 1 << 24,
+        CStickLeft = 1 << 25,
+        CStickUp = 1 << 26,
+        CStickDown = 1 << 27,
+        CPadRight = 1 << 28,
+        CPadLeft = 1 << 29,
+        CPadUp = 1 << 30,
+        CPadDown = 1u << 31
+    };
+
+    class Time
+    {
+    public:
+        Time(void) : _microseconds(0) {}
+
+        float   AsSeconds(void) const { return (_microseconds / 1000000.f); }
+        s32     AsMilliseconds(void) const { return (static_cast<s32>(_microseconds / 1000)); }
+        s64     AsMicroseconds(void) const;
+
+        static const Time   Zero;
+
+    private:
+        friend Time     Seconds(float amount);
+        friend Time     Milliseconds(int amount);
+        friend Time     Microseconds(s64 amount);
+
+        explicit Time(s64 microseconds) : _microseconds(microseconds) {}
+
+        s64     _microseconds;
+    };
+
+    Time    Seconds(float amount);
+    Time    Milliseconds(int amount);
+    Time    Microseconds(s64 amount);
+
+    // Measures the fake system tick
+    class Clock
+    {
+    public:
+        Clock(void);
+
+        Time    GetElapsedTime(void) const;
+        bool    HasTimePassed(Time time) const;
+        Time    Restart(void);
+
+    private:
+        u64     _start;
+    };
+
+    class Color
+    {
+    public:
+        Color(u8 red = 0, u8 green = 0, u8 blue = 0, u8 alpha = 255) :
+            r(red), g(green), b(blue), a(alpha) {}
+
+        u8      r;
+        u8      g;
+        u8      b;
+        u8      a;
+
+        static const Color  Black;
+        static const Color  White;
+        static const Color  Red;
+        static const Color  Green;
+        static const Color  Blue;
+        static const Color  Yellow;
+        static const Color  Orange;
+        static const Color  Gray;
+    };
+
+    /**
+     * A screen drawing in a software framebuffer laid out like the console's: column after
+     * column, each from the bottom row up, see Fake::Framebuffer
+     */
+    class Screen
+    {
+    public:
+        bool        IsTop;
+        bool        Is3DEnabled;
+        u32         BytesPerPixel;
+        GSPGPU_FramebufferFormat    Format;
+        u8          *LeftFramebuffer;
+        u8          *RightFramebuffer;
+
+        /**
+         * Draw with the fake font: every character is a FontWidth x FontHeight cell whose
+         * pixels depend on the character only
+         * \return The x after the text
+         */
+        u32     Draw(const std::string &text, u32 posX, u32 posY, const Color &foreground = Color::White,
+                     const Color &background = Color::Black) const;
+        void    DrawRect(u32 posX, u32 posY, u32 width, u32 height, const Color &color, bool filled = true) const;
+        u8      *GetFramebufferAddress(u32 posX, u32 posY, bool right = false) const;
+
+        static const u32    Height = 240;
+        static const u32    FontWidth = 6;
+        static const u32    FontHeight = 10;
+    };
+
+    using OSDCallback = bool (*)(const Screen &);
+
+    class OSD
+    {
+    public:
+        static void     Run(OSDCallback callback);
+        static void     Stop(OSDCallback callback);
+        static float    GetTextWidth(bool systemFont, const std::string &text);
+        static int      Notify(const std::string &text, const Color &foreground = Color::White,
+                               const Color &background = Color::Black);
+    };
+
+    // The keys are set by Fake::SetKeys
+    class Controller
+    {
+    public:
+        static u32      GetKeysDown(bool withHold = false);
+        static u32      GetKeysPressed(void);
+        static bool     IsKeyDown(Key key);
+        static bool     IsKeysDown(u32 keys);
+        static bool     IsKeyPressed(Key key);
+        static void     Update(void);
+    };
+
+    class MenuEntry;
+    using FuncPointer = void (*)(MenuEntry *);
+
+    class MenuEntry
+    {
+    public:
+        MenuEntry(const std::string &name, FuncPointer gameFunc = nullptr, const std::string &note = "");
+        MenuEntry(const std::string &name, FuncPointer gameFunc, FuncPointer menuFunc, const std::string &note = "");
+
+        void            *GetArg(void) const { return (_arg); }
+        void            SetArg(void *arg) { _arg = arg; }
+        bool            IsActivated(void) const { return (_activated); }
+        bool            WasJustActivated(void) const { return (_justActivated); }
+        void            Enable(void);
+        void            Disable(void);
+        std::string     &Name(void) { return (_name); }
+        std::string     &Note(void) { return (_note); }
+        void            SetGameFunc(FuncPointer func) { _gameFunc = func; }
+
+        // Not in the framework: what the menu would do for the entry once per frame, the game
+        // function is called while activated then once more
+        FuncPointer     GetGameFunc(void) const { return (_gameFunc); }
+        void            Execute(void);
+
+    private:
+        std::string     _name;
+        std::string     _note;
+        FuncPointer     _gameFunc;
+        FuncPointer     _menuFunc;
+        void            *_arg;
+        bool            _activated;
+        bool            _justActivated;
+        bool            _justDeactivated;
+    };
+
+    class MenuFolder
+    {
+    public:
+        explicit MenuFolder(const std::string &name, const std::string &note = "");
+        ~MenuFolder(void);
+
+        void    Append(MenuEntry *entry);
+        void    Append(MenuFolder *folder);
+        void    operator+=(MenuEntry *entry) { Append(entry); }
+        void    operator+=(MenuFolder *folder) { Append(folder); }
+
+        std::vector<MenuEntry *>    GetEntryList(void) const { return (_entries); }
+        std::vector<MenuFolder *>   GetFolderList(void) const { return (_folders); }
+        std::string     &Name(void) { return (_name); }
+
+    private:
+        std::string                 _name;
+        std::string                 _note;
+        std::vector<MenuEntry *>    _entries;
+        std::vector<MenuFolder *>   _folders;
+    };
+
+    class PluginMenu
+    {
+    public:
+        using FrameCallback = void (*)(Time);
+
+        PluginMenu(std::string name = "", u32 major = 0, u32 minor = 0, u32 revision = 0, std::string about = "");
+        ~PluginMenu(void);
+
+        void    SynchronizeWithFrame(bool) {}
+        int     Run(void) { return (0); }
+
+        void    Append(MenuEntry *entry) { _entries.push_back(entry); }
+        void    Append(MenuFolder *folder) { _folders.push_back(folder); }
+        void    operator+=(MenuEntry *entry) { Append(entry); }
+        void    operator+=(MenuFolder *folder) { Append(folder); }
+
+        std::vector<MenuEntry *>    GetEntryList(void) const { return (_entries); }
+        std::vector<MenuFolder *>   GetFolderList(void) const { return (_folders); }
+
+        static PluginMenu   *GetRunningInstance(void);
+
+        FrameCallback   OnNewFrame;
+
+    private:
+        std::vector<MenuEntry *>    _entries;
+        std::vector<MenuFolder *>   _folders;
+    };
+
+    struct KeyboardEvent
+    {
+        enum EventType
+        {
+            CharacterAdded,
+            CharacterRemoved,
+            InputWasCleared,
+            SelectionChanged,
+            KeyPressed,
+            KeyDown,
+            KeyReleased
+        };
+
+        EventType   type;
+        u32         codepoint;
+        u32         selectedIndex;
+    };
+
+    // Every Open is cancelled, a keyboard isn't displayed in the tests
+    class Keyboard
+    {
+    public:
+        using OnEventCallback = void (*)(Keyboard &, KeyboardEvent &);
+
+        explicit Keyboard(const std::string &text = "");
+        explicit Keyboard(const std::vector<std::string> &options);
+
+        void            IsHexadecimal(bool) {}
+        void            Populate(const std::vector<std::string> &options, bool = true) { _options = options; }
+        void            OnKeyboardEvent(OnEventCallback callback) { _callback = callback; }
+        std::string     &GetMessage(void) { return (_message); }
+        std::string     &GetInput(void) { return (_input); }
+        void            Close(void) {}
+
+        int     Open(void) { return (-1); }
+        int     Open(u8 &, u8) { return (-1); }
+        int     Open(u16 &, u16) { return (-1); }
+        int     Open(u32 &, u32) { return (-1); }
+        int     Open(float &, float) { return (-1); }
+        int     Open(std::string &) { return (-1); }
+        int     Open(std::string &, const std::string &) { return (-1); }
+
+        bool    DisplayTopScreen;
+
+    private:
+        std::string                 _message;
+        std::string                 _input;
+        std::vector<std::string>    _options;
+        OnEventCallback             _callback;
+    };
+
+    // A host file, the paths are relative to the working directory of the tests
+    class File
+    {
+    public:
+        enum Mode
+        {
+            READ = 1,
+            WRITE = 1 << 1,
+            CREATE = 1 << 2,
+            APPEND = 1 << 3,
+            TRUNCATE = 1 << 4,
+            SYNC = 1 << 5,
+            RW = READ | WRITE,
+            RWC = READ | WRITE | CREATE
+        };
+
+        enum SeekPos
+        {
+            CUR,
+            SET,
+            END
+        };
+
+        File(void) : _handle(nullptr) {}
+        ~File(void) { Close(); }
+
+        File(const File &) = delete;
+        File &operator=(const File &) = delete;
+
+        static int  Open(File &output, const std::string &path, int mode = RW);
+        static int  Exists(const std::string &path);
+        static int  Remove(const std::string &path);
+        static int  Rename(const std::string &oldPath, const std::string &newPath);
+
+        int     Read(void *buffer, u32 length) const;
+        int     Write(const void *data, u32 length) const;
+        int     Seek(s64 offset, SeekPos origin = CUR) const;
+        u64     Tell(void) const;
+        u64     GetSize(void) const;
+        int     Flush(void) const;
+        int     Close(void) const;
+        bool    IsOpen(void) const { return (_handle != nullptr); }
+
+    private:
+        mutable FILE    *_handle;
+    };
+
+    // The title id is set by Fake::SetTitleId, the addresses are checked against the fake memory
+    class Process
+    {
+    public:
+        static u64      GetTitleID(void);
+        static Handle   GetHandle(void);
+        static bool     CheckAddress(u32 address, u32 perm = MEMPERM_READ | MEMPERM_WRITE);
+    };
+
+    namespace Utils
+    {
+        std::string     Format(const char *format, ...);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef TESTS_FAKE_HPP
+#define TESTS_FAKE_HPP
+
+#include "CTRPluginFramework.hpp"
+#include <vector>
+
+/**
+ * The fake process behind the stubs \n
+ * The game memory is mapped at its real addresses so the helpers can keep their u32 addresses,
+ * svcQueryMemory reports the mapped regions with their permissions. Map, Unmap and SetPermissions
+ * invalidate RegionMap::Game(), like the memory change event of the kernel.
+ */
+namespace Fake
+{
+    using namespace CTRPluginFramework;
+
+    /**
+     * Map zeroed memory at a fixed address, page aligned \n
+     * The memory stays writable for the tests whatever perm reports
+     * \return The memory, nullptr if the address is taken
+     */
+    u8      *Map(u32 address, u32 size, u32 perm = MEMPERM_READ | MEMPERM_WRITE, u32 state = MEMSTATE_PRIVATE);
+    void    Unmap(u32 address);
+    void    UnmapAll(void);
+
+    // Change what svcQueryMemory reports for a mapped region
+    void    SetPermissions(u32 address, u32 perm);
+
+    // Amount of svcQueryMemory calls since the start
+    u32     QueryCount(void);
+
+    /**
+     * Freeze the system tick at a value, until UseRealTicks \n
+     * By default the tick follows the host clock
+     */
+    void    SetTicks(u64 ticks);
+    void    AdvanceTicks(u64 ticks);
+    void    UseRealTicks(void);
+
+    void    SetKeys(u32 keys);
+    void    SetTitleId(u64 titleId);
+
+    // Call the callbacks given to OSD::Run, like the framework does once per frame and screen
+    void    RunOSD(const Screen &screen);
+    u32     OSDCallbackCount(void);
+
+    /**
+     * A software framebuffer, with a Screen drawing in it
+     */
+    class Framebuffer
+    {
+    public:
+        Framebuffer(bool top, GSPGPU_FramebufferFormat format = GSP_BGR8_OES, bool stereo = false);
+
+        Framebuffer(const Framebuffer &) = delete;
+        Framebuffer &operator=(const Framebuffer &) = delete;
+
+        u32     Width(void) const { return (_screen.IsTop ? 400 : 320); }
+        u32     Height(void) const { return (Screen::Height); }
+
+        // Fill both framebuffers with a byte
+        void    Fill(u8 value);
+
+        u8      *Pixel(u32 posX, u32 posY, bool right = false);
+
+        const Screen    &GetScreen(void) const { return (_screen); }
+
+        std::vector<u8>     left;
+        std::vector<u8>     right;
+
+    private:
+        Screen  _screen;
+    };
+}
+
+#endif
@@ -0,0 +1,697 @@
+#include "Fake.hpp"
+#include "csvc.h"
+#include "Helpers/OSDRaster.hpp"
+#include "Helpers/RegionMap.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+    using namespace CTRPluginFramework;
+
+    struct FakeRegion
+    {
+        u32     size;
+        u32     perm;
+        u32     state;
+    };
+
+    std::map<u32, FakeRegion>   g_regions;
+    std::mutex                  g_regionsLock;
+    u32                         g_queries = 0;
+
+    bool    g_frozenTicks = false;
+    u64     g_ticks = 0;
+    u32     g_keys = 0;
+    u64     g_titleId = 0x0004000000055D00;
+
+    std::vector<OSDCallback>    g_callbacks;
+
+    const u32   PageSize = 0x1000;
+    const u32   AddressSpaceEnd = 0x40000000;
+
+    u64     HostTicks(void)
+    {
+        using namespace std::chrono;
+
+        u64     nanoseconds = duration_cast<std::chrono::nanoseconds>(steady_clock::now().time_since_epoch()).count();
+
+        return (static_cast<u64>(static_cast<double>(nanoseconds) * SYSCLOCK_ARM11 / 1e9));
+    }
+
+    // Bit of the fake font for a character, deterministic and never empty for a printable one
+    bool    GlyphBit(char c, u32 column, u32 row)
+    {
+        if (c == ' ' || row == 0 || row == Screen::FontHeight - 1 || column == Screen::FontWidth - 1)
+            return (false);
+
+        u32     hash = static_cast<u8>(c) * 2654435761u ^ (column * 0x9E37 + row * 0x85EB);
+
+        return (((hash >> 13) & 3) != 0);
+    }
+}
+
+extern "C"
+{
+    u64     svcGetSystemTick(void)
+    {
+        return (g_frozenTicks ? g_ticks : HostTicks());
+    }
+
+    Result  svcQueryMemory(MemInfo *info, PageInfo *out, u32 addr)
+    {
+        std::lock_guard<std::mutex>     guard(g_regionsLock);
+
+        ++g_queries;
+        out->flags = 0;
+
+        auto    it = g_regions.upper_bound(addr);
+
+        if (it != g_regions.begin())
+        {
+            auto    previous = std::prev(it);
+
+            if (addr - previous->first < previous->second.size)
+            {
+                info->base_addr = previous->first;
+                info->size = previous->second.size;
+                info->perm = previous->second.perm;
+                info->state = previous->second.state;
+                return (0);
+            }
+        }
+
+        // The free gap up to the next region
+        u32     start = it == g_regions.begin() ? 0 : std::prev(it)->first + std::prev(it)->second.size;
+        u32     end = it == g_regions.end() ? AddressSpaceEnd : it->first;
+
+        if (addr >= AddressSpaceEnd)
+            return (-1);
+
+        info->base_addr = start;
+        info->size = end - start;
+        info->perm = 0;
+        info->state = MEMSTATE_FREE;
+        return (0);
+    }
+
+    Result  svcQueryProcessMemory(MemInfo *info, PageInfo *out, Handle, u32 addr)
+    {
+        return (svcQueryMemory(info, out, addr));
+    }
+
+    Result  svcWaitSynchronization(Handle, s64)
+    {
+        return (-1);
+    }
+
+    Result  svcClearEvent(Handle)
+    {
+        return (0);
+    }
+
+    Result  svcCloseHandle(Handle)
+    {
+        return (0);
+    }
+
+    Result  svcGetThreadId(u32 *threadId, Handle)
+    {
+        *threadId = static_cast<u32>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        return (0);
+    }
+
+    void    svcSleepThread(s64 nanoseconds)
+    {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nanoseconds));
+    }
+
+    Result  svcOutputDebugString(const char *str, s32 length)
+    {
+        std::fprintf(stderr, "%.*s\n", static_cast<int>(length), str);
+        return (0);
+    }
+
+    void    svcBreak(UserBreakType reason)
+    {
+        std::fprintf(stderr, "svcBreak(%d)\n", reason);
+        std::abort();
+    }
+
+    // Nothing signals the fake process, the watchers of RegionMap give up at once
+    Result  svcControlProcess(Handle, ProcessOp, u32, u32)
+    {
+        return (-1);
+    }
+
+    void    svcFlushDataCacheRange(void *, u32)
+    {
+    }
+
+    void    svcInvalidateInstructionCacheRange(void *, u32)
+    {
+    }
+
+    Thread  threadCreate(ThreadFunc entrypoint, void *arg, size_t, int, int, bool)
+    {
+        std::thread(entrypoint, arg).detach();
+        return (reinterpret_cast<Thread>(1));
+    }
+
+    void    *getThreadLocalStorage(void)
+    {
+        static thread_local u32     storage;
+
+        return (&storage);
+    }
+}
+
+namespace Fake
+{
+    namespace
+    {
+        // What the memory change event of the kernel does on the console
+        void    LayoutChanged(void)
+        {
+            RegionMap::Game().Invalidate();
+        }
+    }
+
+    u8      *Map(u32 address, u32 size, u32 perm, u32 state)
+    {
+        size = (size + PageSize - 1) & ~(PageSize - 1);
+
+        void    *memory = mmap(reinterpret_cast<void *>(static_cast<uintptr_t>(address)), size, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (memory == MAP_FAILED || memory != reinterpret_cast<void *>(static_cast<uintptr_t>(address)))
+        {
+            if (memory != MAP_FAILED)
+                munmap(memory, size);
+            return (nullptr);
+        }
+
+        {
+            std::lock_guard<std::mutex>     guard(g_regionsLock);
+
+            g_regions[address] = { size, perm, state };
+        }
+
+        LayoutChanged();
+        return (static_cast<u8 *>(memory));
+    }
+
+    void    Unmap(u32 address)
+    {
+        {
+            std::lock_guard<std::mutex>     guard(g_regionsLock);
+            auto    it = g_regions.find(address);
+
+            if (it == g_regions.end())
+                return;
+
+            munmap(reinterpret_cast<void *>(static_cast<uintptr_t>(address)), it->second.size);
+            g_regions.erase(it);
+        }
+
+        LayoutChanged();
+    }
+
+    void    UnmapAll(void)
+    {
+        {
+            std::lock_guard<std::mutex>     guard(g_regionsLock);
+
+            for (auto &region : g_regions)
+                munmap(reinterpret_cast<void *>(static_cast<uintptr_t>(region.first)), region.second.size);
+            g_regions.clear();
+        }
+
+        LayoutChanged();
+    }
+
+    void    SetPermissions(u32 address, u32 perm)
+    {
+        {
+            std::lock_guard<std::mutex>     guard(g_regionsLock);
+            auto    it = g_regions.find(address);
+
+            if (it != g_regions.end())
+                it->second.perm = perm;
+        }
+
+        LayoutChanged();
+    }
+
+    u32     QueryCount(void)
+    {
+        return (g_queries);
+    }
+
+    void    SetTicks(u64 ticks)
+    {
+        g_frozenTicks = true;
+        g_ticks = ticks;
+    }
+
+    void    AdvanceTicks(u64 ticks)
+    {
+        g_frozenTicks = true;
+        g_ticks += ticks;
+    }
+
+    void    UseRealTicks(void)
+    {
+        g_frozenTicks = false;
+    }
+
+    void    SetKeys(u32 keys)
+    {
+        g_keys = keys;
+    }
+
+    void    SetTitleId(u64 titleId)
+    {
+        g_titleId = titleId;
+    }
+
+    void    RunOSD(const Screen &screen)
+    {
+        std::vector<OSDCallback>    callbacks(g_callbacks);
+
+        for (OSDCallback callback : callbacks)
+            callback(screen);
+    }
+
+    u32     OSDCallbackCount(void)
+    {
+        return (g_callbacks.size());
+    }
+
+    Framebuffer::Framebuffer(bool top, GSPGPU_FramebufferFormat format, bool stereo)
+    {
+        u8      pixel[4];
+
+        _screen.IsTop = top;
+        _screen.Is3DEnabled = stereo;
+        _screen.Format = format;
+        _screen.BytesPerPixel = EncodePixel(format, 0, 0, 0, 0, pixel);
+
+        left.resize(Width() * Height() * _screen.BytesPerPixel);
+        right.resize(stereo ? left.size() : 0);
+
+        _screen.LeftFramebuffer = left.data();
+        _screen.RightFramebuffer = stereo ? right.data() : nullptr;
+    }
+
+    void    Framebuffer::Fill(u8 value)
+    {
+        std::fill(left.begin(), left.end(), value);
+        std::fill(right.begin(), right.end(), value);
+    }
+
+    u8      *Framebuffer::Pixel(u32 posX, u32 posY, bool right)
+    {
+        return (_screen.GetFramebufferAddress(posX, posY, right));
+    }
+}
+
+namespace CTRPluginFramework
+{
+    const Time  Time::Zero;
+
+    const Color     Color::Black(0, 0, 0);
+    const Color     Color::White(255, 255, 255);
+    const Color     Color::Red(255, 0, 0);
+    const Color     Color::Green(0, 255, 0);
+    const Color     Color::Blue(0, 0, 255);
+    const Color     Color::Yellow(255, 255, 0);
+    const Color     Color::Orange(255, 128, 0);
+    const Color     Color::Gray(128, 128, 128);
+
+    s64     Time::AsMicroseconds(void) const
+    {
+        return (_microseconds);
+    }
+
+    Time    Seconds(float amount)
+    {
+        return (Time(static_cast<s64>(amount * 1000000.f)));
+    }
+
+    Time    Milliseconds(int amount)
+    {
+        return (Time(static_cast<s64>(amount) * 1000));
+    }
+
+    Time    Microseconds(s64 amount)
+    {
+        return (Time(amount));
+    }
+
+    Clock::Clock(void) : _start(svcGetSystemTick())
+    {
+    }
+
+    Time    Clock::GetElapsedTime(void) const
+    {
+        return (Microseconds((svcGetSystemTick() - _start) / (SYSCLOCK_ARM11 / 1000000)));
+    }
+
+    bool    Clock::HasTimePassed(Time time) const
+    {
+        return (GetElapsedTime().AsMicroseconds() >= time.AsMicroseconds());
+    }
+
+    Time    Clock::Restart(void)
+    {
+        Time    elapsed = GetElapsedTime();
+
+        _start = svcGetSystemTick();
+        return (elapsed);
+    }
+
+    u8      *Screen::GetFramebufferAddress(u32 posX, u32 posY, bool right) const
+    {
+        u8      *base = right && RightFramebuffer != nullptr ? RightFramebuffer : LeftFramebuffer;
+
+        return (base + (posX * Height + (Height - 1 - posY)) * BytesPerPixel);
+    }
+
+    u32     Screen::Draw(const std::string &text, u32 posX, u32 posY, const Color &foreground,
+                         const Color &background) const
+    {
+        u32     width = IsTop ? 400 : 320;
+        u8      fg[4];
+        u8      bg[4];
+
+        EncodePixel(Format, foreground.r, foreground.g, foreground.b, foreground.a, fg);
+        EncodePixel(Format, background.r, background.g, background.b, background.a, bg);
+
+        for (char c : text)
+        {
+            for (u32 column = 0; column < FontWidth && posX + column < width; ++column)
+            {
+                for (u32 row = 0; row < FontHeight && posY + row < Height; ++row)
+                {
+                    const u8    *pixel = GlyphBit(c, column, row) ? fg : bg;
+
+                    std::memcpy(GetFramebufferAddress(posX + column, posY + row, false), pixel, BytesPerPixel);
+                    if (Is3DEnabled && RightFramebuffer != nullptr)
+                        std::memcpy(GetFramebufferAddress(posX + column, posY + row, true), pixel, BytesPerPixel);
+                }
+            }
+
+            posX += FontWidth;
+        }
+
+        return (posX);
+    }
+
+    void    Screen::DrawRect(u32 posX, u32 posY, u32 width, u32 height, const Color &color, bool filled) const
+    {
+        u8      pixel[4];
+
+        EncodePixel(Format, color.r, color.g, color.b, color.a, pixel);
+        for (u32 x = posX; x < posX + width; ++x)
+            for (u32 y = posY; y < posY + height; ++y)
+                if (filled || x == posX || y == posY || x == posX + width - 1 || y == posY + height - 1)
+                    std::memcpy(GetFramebufferAddress(x, y), pixel, BytesPerPixel);
+    }
+
+    void    OSD::Run(OSDCallback callback)
+    {
+        if (std::find(g_callbacks.begin(), g_callbacks.end(), callback) == g_callbacks.end())
+            g_callbacks.push_back(callback);
+    }
+
+    void    OSD::Stop(OSDCallback callback)
+    {
+        g_callbacks.erase(std::remove(g_callbacks.begin(), g_callbacks.end(), callback), g_callbacks.end());
+    }
+
+    float   OSD::GetTextWidth(bool, const std::string &text)
+    {
+        return (static_cast<float>(text.size() * Screen::FontWidth));
+    }
+
+    int     OSD::Notify(const std::string &, const Color &, const Color &)
+    {
+        return (0);
+    }
+
+    u32     Controller::GetKeysDown(bool)
+    {
+        return (g_keys);
+    }
+
+    u32     Controller::GetKeysPressed(void)
+    {
+        return (g_keys);
+    }
+
+    bool    Controller::IsKeyDown(Key key)
+    {
+        return ((g_keys & key) != 0);
+    }
+
+    bool    Controller::IsKeysDown(u32 keys)
+    {
+        return ((g_keys & keys) == keys);
+    }
+
+    bool    Controller::IsKeyPressed(Key key)
+    {
+        return ((g_keys & key) != 0);
+    }
+
+    void    Controller::Update(void)
+    {
+    }
+
+    MenuEntry::MenuEntry(const std::string &name, FuncPointer gameFunc, const std::string &note) :
+        _name(name), _note(note), _gameFunc(gameFunc), _menuFunc(nullptr), _arg(nullptr),
+        _activated(false), _justActivated(false), _justDeactivated(false)
+    {
+    }
+
+    MenuEntry::MenuEntry(const std::string &name, FuncPointer gameFunc, FuncPointer menuFunc, const std::string &note) :
+        _name(name), _note(note), _gameFunc(gameFunc), _menuFunc(menuFunc), _arg(nullptr),
+        _activated(false), _justActivated(false), _justDeactivated(false)
+    {
+    }
+
+    void    MenuEntry::Enable(void)
+    {
+        // Like the menu, an entry without a game function can't be toggled
+        if (_gameFunc == nullptr)
+            return;
+
+        _justActivated = !_activated;
+        _activated = true;
+    }
+
+    void    MenuEntry::Disable(void)
+    {
+        _justDeactivated = _activated;
+        _activated = false;
+        _justActivated = false;
+    }
+
+    void    MenuEntry::Execute(void)
+    {
+        if ((_activated || _justDeactivated) && _gameFunc != nullptr)
+            _gameFunc(this);
+        _justActivated = false;
+        _justDeactivated = false;
+    }
+
+    MenuFolder::MenuFolder(const std::string &name, const std::string &note) :
+        _name(name), _note(note)
+    {
+    }
+
+    MenuFolder::~MenuFolder(void)
+    {
+        for (MenuEntry *entry : _entries)
+            delete entry;
+        for (MenuFolder *folder : _folders)
+            delete folder;
+    }
+
+    void    MenuFolder::Append(MenuEntry *entry)
+    {
+        _entries.push_back(entry);
+    }
+
+    void    MenuFolder::Append(MenuFolder *folder)
+    {
+        _folders.push_back(folder);
+    }
+
+    namespace
+    {
+        PluginMenu  *g_runningMenu = nullptr;
+    }
+
+    PluginMenu::PluginMenu(std::string, u32, u32, u32, std::string) :
+        OnNewFrame(nullptr)
+    {
+        g_runningMenu = this;
+    }
+
+    PluginMenu::~PluginMenu(void)
+    {
+        for (MenuEntry *entry : _entries)
+            delete entry;
+        for (MenuFolder *folder : _folders)
+            delete folder;
+        if (g_runningMenu == this)
+            g_runningMenu = nullptr;
+    }
+
+    PluginMenu  *PluginMenu::GetRunningInstance(void)
+    {
+        return (g_runningMenu);
+    }
+
+    Keyboard::Keyboard(const std::string &text) :
+        DisplayTopScreen(false), _message(text), _callback(nullptr)
+    {
+    }
+
+    Keyboard::Keyboard(const std::vector<std::string> &options) :
+        DisplayTopScreen(false), _options(options), _callback(nullptr)
+    {
+    }
+
+    int     File::Open(File &output, const std::string &path, int mode)
+    {
+        const char  *flags;
+
+        output.Close();
+        if ((mode & CREATE) && (mode & TRUNCATE))
+            flags = mode & READ ? "w+b" : "wb";
+        else if (mode & WRITE)
+        {
+            flags = "r+b";
+            if ((mode & CREATE) && File::Exists(path) != 1)
+                flags = "w+b";
+        }
+        else
+            flags = "rb";
+
+        output._handle = std::fopen(path.c_str(), flags);
+        return (output._handle != nullptr ? 0 : -1);
+    }
+
+    int     File::Exists(const std::string &path)
+    {
+        return (access(path.c_str(), F_OK) == 0 ? 1 : 0);
+    }
+
+    int     File::Remove(const std::string &path)
+    {
+        return (std::remove(path.c_str()) == 0 ? 0 : -1);
+    }
+
+    int     File::Rename(const std::string &oldPath, const std::string &newPath)
+    {
+        // Like the console, an existing file isn't replaced
+        if (File::Exists(newPath) == 1)
+            return (-1);
+        return (std::rename(oldPath.c_str(), newPath.c_str()) == 0 ? 0 : -1);
+    }
+
+    int     File::Read(void *buffer, u32 length) const
+    {
+        return (_handle != nullptr && std::fread(buffer, 1, length, _handle) == length ? 0 : -1);
+    }
+
+    int     File::Write(const void *data, u32 length) const
+    {
+        return (_handle != nullptr && std::fwrite(data, 1, length, _handle) == length ? 0 : -1);
+    }
+
+    int     File::Seek(s64 offset, SeekPos origin) const
+    {
+        int     whence = origin == SET ? SEEK_SET : origin == END ? SEEK_END : SEEK_CUR;
+
+        return (_handle != nullptr && std::fseek(_handle, offset, whence) == 0 ? 0 : -1);
+    }
+
+    u64     File::Tell(void) const
+    {
+        return (_handle != nullptr ? std::ftell(_handle) : 0);
+    }
+
+    u64     File::GetSize(void) const
+    {
+        if (_handle == nullptr)
+            return (0);
+
+        long    position = std::ftell(_handle);
+        long    size;
+
+        std::fseek(_handle, 0, SEEK_END);
+        size = std::ftell(_handle);
+        std::fseek(_handle, position, SEEK_SET);
+        return (size);
+    }
+
+    int     File::Flush(void) const
+    {
+        return (_handle != nullptr && std::fflush(_handle) == 0 ? 0 : -1);
+    }
+
+    int     File::Close(void) const
+    {
+        if (_handle == nullptr)
+            return (-1);
+
+        std::fclose(_handle);
+        _handle = nullptr;
+        return (0);
+    }
+
+    u64     Process::GetTitleID(void)
+    {
+        return (g_titleId);
+    }
+
+    Handle  Process::GetHandle(void)
+    {
+        return (CUR_PROCESS_HANDLE);
+    }
+
+    bool    Process::CheckAddress(u32 address, u32 perm)
+    {
+        MemInfo     info;
+        PageInfo    page;
+
+        return (R_SUCCEEDED(svcQueryMemory(&info, &page, address)) && info.state != MEMSTATE_FREE
+                && (info.perm & perm) == perm);
+    }
+
+    namespace Utils
+    {
+        std::string     Format(const char *format, ...)
+        {
+            char        buffer[0x200];
+            va_list     args;
+
+            va_start(args, format);
+            std::vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            return (buffer);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef TESTS_TEST_HPP
+#define TESTS_TEST_HPP
+
+#include "Fake.hpp"
+#include <chrono>
+#include <cstdio>
+
+/**
+ * The host tests of the helpers \n
+ * TEST functions run with "make -C Tests", BENCH functions with "make -C Tests bench". A test
+ * carries on after a failed CHECK so every failure of a run is reported.
+ */
+namespace Tests
+{
+    using TestFunc = void (*)(void);
+
+    struct Registrar
+    {
+        Registrar(const char *name, TestFunc func, bool benchmark);
+    };
+
+    void    Fail(const char *file, int line, const char *expression);
+
+    // Wall clock seconds, for the benchmarks
+    class Stopwatch
+    {
+    public:
+        Stopwatch(void) : _start(std::chrono::steady_clock::now()) {}
+
+        double  Seconds(void) const
+        {
+            return (std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count());
+        }
+
+    private:
+        std::chrono::steady_clock::time_point   _start;
+    };
+
+    // Keep the compiler from dropping a computation whose result isn't used
+    template <typename T>
+    inline void     KeepAlive(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#define TEST(name) \
+    static void name(void); \
+    static Tests::Registrar name##Registrar(#name, name, false); \
+    static void name(void)
+
+#define BENCH(name) \
+    static void name(void); \
+    static Tests::Registrar name##Registrar(#name, name, true); \
+    static void name(void)
+
+#define CHECK(expression) \
+    do { if (!(expression)) Tests::Fail(__FILE__, __LINE__, #expression); } while (0)
+
+#endif